@@ -854,13 +854,56 @@ cso_restore_clip(struct cso_context *ctx)
    }
 }
 
+/**
+ * Return the hash key cso_set_vertex_elements() computes for the given
+ * vertex elements, for callers binding the same ones over and over.
+ */
+unsigned
+cso_hash_vertex_elements(unsigned count,
+                         const struct pipe_vertex_element *states)
+{
+   struct cso_velems_state velems_state;
+
+   /* Need to include the count into the stored state data too.
+    * Otherwise first few count pipe_vertex_elements could be identical
+    * even if count is different, and there's no guarantee the hash would
+    * be different in that case neither.
+    */
+   velems_state.count = count;
+   memcpy(velems_state.velems, states,
+          sizeof(struct pipe_vertex_element) * count);
+   return cso_construct_key((void*)&velems_state,
+                            sizeof(struct pipe_vertex_element) * count +
+                            sizeof(unsigned));
+}
+
 enum pipe_error
 cso_set_vertex_elements(struct cso_context *ctx,
                         unsigned count,
                         const struct pipe_vertex_element *states)
+{
+   if (ctx->vbuf) {
+      u_vbuf_set_vertex_elements(ctx->vbuf, count, states);
+      return PIPE_OK;
+   }
+
+   return cso_set_vertex_elements_hashed(ctx, count, states,
+                                         cso_hash_vertex_elements(count,
+                                                                  states));
+}
+
+/**
+ * Like cso_set_vertex_elements(), with the hash key of the vertex elements
+ * already known from cso_hash_vertex_elements().
+ */
+enum pipe_error
+cso_set_vertex_elements_hashed(struct cso_context *ctx,
+                               unsigned count,
+                               const struct pipe_vertex_element *states,
+                               unsigned hash_key)
 {
    struct u_vbuf *vbuf = ctx->vbuf;
-   unsigned key_size, hash_key;
+   unsigned key_size;
    struct cso_hash_iter iter;
    void *handle;
    struct cso_velems_state velems_state;
@@ -870,16 +913,10 @@ cso_set_vertex_elements(struct cso_context *ctx,
       return PIPE_OK;
    }
 
-   /* Need to include the count into the stored state data too.
-    * Otherwise first few count pipe_vertex_elements could be identical
-    * even if count is different, and there's no guarantee the hash would
-    * be different in that case neither.
-    */
    key_size = sizeof(struct pipe_vertex_element) * count + sizeof(unsigned);
    velems_state.count = count;
    memcpy(velems_state.velems, states,
           sizeof(struct pipe_vertex_element) * count);
-   hash_key = cso_construct_key((void*)&velems_state, key_size);
    iter = cso_find_state_template(ctx->cache, hash_key, CSO_VELEMENTS,
                                   (void*)&velems_state, key_size);
 
@@ -1401,6 +1438,28 @@ cso_draw_vbo(struct cso_context *cso,
    }
 }
 
+/**
+ * Draw num_draws primitives with the same state, in one go if the driver
+ * can.  See pipe_context::multi_draw_vbo.
+ */
+void
+cso_multi_draw_vbo(struct cso_context *cso,
+                   const struct pipe_draw_info *info,
+                   unsigned num_draws)
+{
+   struct u_vbuf *vbuf = cso->vbuf;
+   struct pipe_context *pipe = cso->pipe;
+   unsigned i;
+
+   if (!vbuf && pipe->multi_draw_vbo) {
+      pipe->multi_draw_vbo(pipe, info, num_draws);
+      return;
+   }
+
+   for (i = 0; i < num_draws; i++)
+      cso_draw_vbo(cso, &info[i]);
+}
+
 void
 cso_draw_arrays(struct cso_context *cso, uint mode, uint start, uint count)
 {
@@ -97,6 +97,12 @@ cso_single_sampler_done(struct cso_context *cso, unsigned shader_stage);
 enum pipe_error cso_set_vertex_elements(struct cso_context *ctx,
                                         unsigned count,
                                         const struct pipe_vertex_element *states);
+unsigned cso_hash_vertex_elements(unsigned count,
+                                  const struct pipe_vertex_element *states);
+enum pipe_error cso_set_vertex_elements_hashed(struct cso_context *ctx,
+                                               unsigned count,
+                                               const struct pipe_vertex_element *states,
+                                               unsigned hash_key);
 void cso_save_vertex_elements(struct cso_context *ctx);
 void cso_restore_vertex_elements(struct cso_context *ctx);
 
@@ -228,6 +234,11 @@ void
 cso_draw_vbo(struct cso_context *cso,
              const struct pipe_draw_info *info);
 
+void
+cso_multi_draw_vbo(struct cso_context *cso,
+                   const struct pipe_draw_info *info,
+                   unsigned num_draws);
+
 void
 cso_draw_arrays_instanced(struct cso_context *cso, uint mode,
                           uint start, uint count,
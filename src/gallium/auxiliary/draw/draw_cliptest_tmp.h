@@ -95,10 +95,13 @@ static boolean TAG(do_cliptest)( struct pt_post_vs *pvs,
          /* Do the hardwired planes first:
           */
          if (flags & DO_CLIP_XY_GUARD_BAND) {
-            if (-0.50 * position[0] + position[3] < 0) mask |= (1<<0);
-            if ( 0.50 * position[0] + position[3] < 0) mask |= (1<<1);
-            if (-0.50 * position[1] + position[3] < 0) mask |= (1<<2);
-            if ( 0.50 * position[1] + position[3] < 0) mask |= (1<<3);
+            /* plane[1] and plane[3] hold the inverse guard band size */
+            const float gb_x = position[0] * plane[1][0];
+            const float gb_y = position[1] * plane[3][1];
+            if (position[3] <  gb_x) mask |= (1<<0);
+            if (position[3] < -gb_x) mask |= (1<<1);
+            if (position[3] <  gb_y) mask |= (1<<2);
+            if (position[3] < -gb_y) mask |= (1<<3);
          }
          else if (flags & DO_CLIP_XY) {
             if (-position[0] + position[3] < 0) mask |= (1<<0);
@@ -147,6 +147,9 @@ boolean draw_init(struct draw_context *draw)
    draw->clip_xy = TRUE;
    draw->clip_z = TRUE;
 
+   draw->driver.guard_band_size[0] = 2.0f;
+   draw->driver.guard_band_size[1] = 2.0f;
+
    draw->pt.user.planes = (float (*) [DRAW_TOTAL_CLIP_PLANES][4]) &(draw->plane[0]);
    draw->pt.user.eltMax = ~0;
 
@@ -312,6 +315,31 @@ void draw_set_driver_clipping( struct draw_context *draw,
 }
 
 
+/**
+ * Set the size of the guard band used when the driver enabled guard band
+ * clipping with draw_set_driver_clipping().  The sizes are multiples of the
+ * viewport width and height, and must be at least one.
+ *
+ * Primitives which lie entirely within the guard band are not clipped and
+ * must be scissored to the viewport by the driver.  Only primitives
+ * crossing the guard band are clipped, against the guard band.
+ */
+void draw_set_guard_band_size( struct draw_context *draw,
+                               float size_x,
+                               float size_y )
+{
+   assert(size_x >= 1.0f && size_y >= 1.0f);
+
+   if (draw->driver.guard_band_size[0] != size_x ||
+       draw->driver.guard_band_size[1] != size_y) {
+      draw_do_flush( draw, DRAW_FLUSH_STATE_CHANGE );
+
+      draw->driver.guard_band_size[0] = size_x;
+      draw->driver.guard_band_size[1] = size_y;
+   }
+}
+
+
 /** 
  * Plug in the primitive rendering/rasterization stage (which is the last
  * stage in the drawing pipeline).
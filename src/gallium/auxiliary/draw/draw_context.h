@@ -252,6 +252,10 @@ draw_set_mapped_so_targets(struct draw_context *draw,
 void draw_vbo(struct draw_context *draw,
               const struct pipe_draw_info *info);
 
+void draw_multi_vbo(struct draw_context *draw,
+                    const struct pipe_draw_info *info,
+                    unsigned num_draws);
+
 
 /*******************************************************************************
  * Driver backend interface 
@@ -266,6 +270,10 @@ void draw_set_driver_clipping( struct draw_context *draw,
                                boolean guard_band_xy,
                                boolean bypass_clip_points);
 
+void draw_set_guard_band_size( struct draw_context *draw,
+                               float size_x,
+                               float size_y );
+
 void draw_set_force_passthrough( struct draw_context *draw, 
                                  boolean enable );
 
@@ -1157,6 +1157,7 @@ generate_clipmask(struct draw_llvm *llvm,
                   struct lp_type vs_type,
                   LLVMValueRef (*outputs)[TGSI_NUM_CHANNELS],
                   boolean clip_xy,
+                  boolean guard_band_xy,
                   boolean clip_z,
                   boolean clip_user,
                   boolean clip_halfz,
@@ -1217,7 +1218,58 @@ generate_clipmask(struct draw_llvm *llvm,
    }
 
    /* Cliptest, for hardwired planes */
-   if (clip_xy) {
+   if (clip_xy && guard_band_xy) {
+      /*
+       * Same tests as the cliptest code in draw_cliptest_tmp.h:
+       * planes[1][0] and planes[3][1] hold the inverse guard band size.
+       */
+      LLVMTypeRef vec_type = lp_build_vec_type(gallivm, f32_type);
+      LLVMValueRef planes_ptr = draw_jit_context_planes(gallivm, context_ptr);
+      LLVMValueRef indices[3];
+      LLVMValueRef gb_x, gb_y;
+
+      indices[0] = lp_build_const_int32(gallivm, 0);
+      indices[1] = lp_build_const_int32(gallivm, 1);
+      indices[2] = lp_build_const_int32(gallivm, 0);
+      plane_ptr = LLVMBuildGEP(builder, planes_ptr, indices, 3, "");
+      plane1 = LLVMBuildLoad(builder, plane_ptr, "plane_x");
+      gb_x = LLVMBuildFMul(builder, pos_x,
+                           lp_build_broadcast(gallivm, vec_type, plane1), "");
+
+      indices[1] = lp_build_const_int32(gallivm, 3);
+      indices[2] = lp_build_const_int32(gallivm, 1);
+      plane_ptr = LLVMBuildGEP(builder, planes_ptr, indices, 3, "");
+      plane1 = LLVMBuildLoad(builder, plane_ptr, "plane_y");
+      gb_y = LLVMBuildFMul(builder, pos_y,
+                           lp_build_broadcast(gallivm, vec_type, plane1), "");
+
+      /* plane 1 */
+      test = lp_build_compare(gallivm, f32_type, PIPE_FUNC_GREATER, gb_x, pos_w);
+      temp = shift;
+      test = LLVMBuildAnd(builder, test, temp, "");
+      mask = test;
+
+      /* plane 2 */
+      test = lp_build_compare(gallivm, f32_type, PIPE_FUNC_GREATER,
+                              LLVMBuildFNeg(builder, gb_x, ""), pos_w);
+      temp = LLVMBuildShl(builder, temp, shift, "");
+      test = LLVMBuildAnd(builder, test, temp, "");
+      mask = LLVMBuildOr(builder, mask, test, "");
+
+      /* plane 3 */
+      test = lp_build_compare(gallivm, f32_type, PIPE_FUNC_GREATER, gb_y, pos_w);
+      temp = LLVMBuildShl(builder, temp, shift, "");
+      test = LLVMBuildAnd(builder, test, temp, "");
+      mask = LLVMBuildOr(builder, mask, test, "");
+
+      /* plane 4 */
+      test = lp_build_compare(gallivm, f32_type, PIPE_FUNC_GREATER,
+                              LLVMBuildFNeg(builder, gb_y, ""), pos_w);
+      temp = LLVMBuildShl(builder, temp, shift, "");
+      test = LLVMBuildAnd(builder, test, temp, "");
+      mask = LLVMBuildOr(builder, mask, test, "");
+   }
+   else if (clip_xy) {
       /* plane 1 */
       test = lp_build_compare(gallivm, f32_type, PIPE_FUNC_GREATER, pos_x , pos_w);
       temp = shift;
@@ -1784,6 +1836,7 @@ draw_llvm_generate(struct draw_llvm *llvm, struct draw_llvm_variant *variant,
                                          vs_type,
                                          outputs,
                                          key->clip_xy,
+                                         key->guard_band_xy,
                                          key->clip_z,
                                          key->clip_user,
                                          key->clip_halfz,
@@ -1849,6 +1902,7 @@ draw_llvm_make_variant_key(struct draw_llvm *llvm, char *store)
 
    /* will have to rig this up properly later */
    key->clip_xy = llvm->draw->clip_xy;
+   key->guard_band_xy = llvm->draw->guard_band_xy;
    key->clip_z = llvm->draw->clip_z;
    key->clip_user = llvm->draw->clip_user;
    key->bypass_viewport = llvm->draw->identity_viewport;
@@ -1901,6 +1955,7 @@ draw_llvm_dump_variant_key(struct draw_llvm_variant_key *key)
 
    debug_printf("clamp_vertex_color = %u\n", key->clamp_vertex_color);
    debug_printf("clip_xy = %u\n", key->clip_xy);
+   debug_printf("guard_band_xy = %u\n", key->guard_band_xy);
    debug_printf("clip_z = %u\n", key->clip_z);
    debug_printf("clip_user = %u\n", key->clip_user);
    debug_printf("bypass_viewport = %u\n", key->bypass_viewport);
@@ -317,7 +317,8 @@ struct draw_llvm_variant_key
     * (and all padding gets zeroed).
     */
    unsigned ucp_enable:PIPE_MAX_CLIP_PLANES;
-   unsigned pad1:24-PIPE_MAX_CLIP_PLANES;
+   unsigned guard_band_xy:1;
+   unsigned pad1:23-PIPE_MAX_CLIP_PLANES;
 
    /* Variable number of vertex elements:
     */
@@ -218,6 +218,8 @@ struct draw_context
       boolean bypass_clip_z;
       boolean guard_band_xy;
       boolean bypass_clip_points;
+      /** guard band extents, as multiples of the viewport size */
+      float guard_band_size[2];
    } driver;
 
    boolean quads_always_flatshade_last;
@@ -447,26 +447,17 @@ resolve_draw_info(const struct pipe_draw_info *raw_info,
 }
 
 /**
- * Draw vertex arrays.
- * This is the main entrypoint into the drawing module.  If drawing an indexed
- * primitive, the draw_set_indexes() function should have already been called
- * to specify the element/index buffer information.
+ * Draw one primitive, with all its instances.
  */
-void
-draw_vbo(struct draw_context *draw,
-         const struct pipe_draw_info *info)
+static void
+draw_vbo_one(struct draw_context *draw,
+             const struct pipe_draw_info *info)
 {
    unsigned instance;
    unsigned index_limit;
    unsigned count;
-   unsigned fpstate = util_fpstate_get();
    struct pipe_draw_info resolved_info;
 
-   /* Make sure that denorms are treated like zeros. This is 
-    * the behavior required by D3D10. OpenGL doesn't care.
-    */
-   util_fpstate_set_denorms_to_zero(fpstate);
-
    resolve_draw_info(info, &resolved_info);
    info = &resolved_info;
 
@@ -524,16 +515,10 @@ draw_vbo(struct draw_context *draw,
       if (index_limit == 0) {
       /* one of the buffers is too small to do any valid drawing */
          debug_warning("draw: VBO too small to draw anything\n");
-         util_fpstate_set(fpstate);
          return;
       }
    }
 
-   /* If we're collecting stats then make sure we start from scratch */
-   if (draw->collect_statistics) {
-      memset(&draw->statistics, 0, sizeof(draw->statistics));
-   }
-
    draw->pt.max_index = index_limit - 1;
    draw->start_index = info->start;
 
@@ -562,6 +547,48 @@ draw_vbo(struct draw_context *draw,
          draw_pt_arrays(draw, info->mode, info->start, count);
       }
    }
+}
+
+
+/**
+ * Draw vertex arrays.
+ * This is the main entrypoint into the drawing module.  If drawing an indexed
+ * primitive, the draw_set_indexes() function should have already been called
+ * to specify the element/index buffer information.
+ */
+void
+draw_vbo(struct draw_context *draw,
+         const struct pipe_draw_info *info)
+{
+   draw_multi_vbo(draw, info, 1);
+}
+
+
+/**
+ * Draw num_draws primitives sharing the same state and buffers, as
+ * draw_vbo() would one after the other.  The pipeline isn't flushed or
+ * set up again between them unless the primitive type requires it.
+ */
+void
+draw_multi_vbo(struct draw_context *draw,
+               const struct pipe_draw_info *info,
+               unsigned num_draws)
+{
+   unsigned fpstate = util_fpstate_get();
+   unsigned i;
+
+   /* Make sure that denorms are treated like zeros. This is 
+    * the behavior required by D3D10. OpenGL doesn't care.
+    */
+   util_fpstate_set_denorms_to_zero(fpstate);
+
+   /* If we're collecting stats then make sure we start from scratch */
+   if (draw->collect_statistics) {
+      memset(&draw->statistics, 0, sizeof(draw->statistics));
+   }
+
+   for (i = 0; i < num_draws; i++)
+      draw_vbo_one(draw, &info[i]);
 
    /* If requested emit the pipeline statistics for this run */
    if (draw->collect_statistics) {
@@ -25,6 +25,8 @@
  *
  **************************************************************************/
 
+#include "util/u_cpu_detect.h"
+#include "util/u_debug.h"
 #include "util/u_math.h"
 #include "util/u_memory.h"
 #include "util/u_prim.h"
@@ -35,10 +37,42 @@
 #include "draw/draw_pt.h"
 #include "draw/draw_prim_assembler.h"
 #include "draw/draw_vs.h"
+#include "draw/draw_vs_threads.h"
 #include "draw/draw_llvm.h"
 #include "gallivm/lp_bld_init.h"
 
 
+/* Runs with fewer vertices than this are always shaded on the calling
+ * thread, and no worker thread gets fewer than the minimum chunk size;
+ * below that the synchronization costs more than it saves.  Runs are at
+ * most DRAW_VSPLIT_SEGMENT_SIZE (1024 by default) vertices long, so only
+ * full or nearly full segments are split.
+ */
+#define LLVM_VS_THREAD_MIN_VERTICES 512
+#define LLVM_VS_THREAD_MIN_CHUNK    128
+
+
+/**
+ * Number of extra threads used for vertex shading, never more than the
+ * number of other CPUs.  Off by default.
+ */
+static unsigned
+debug_get_option_draw_vs_threads(void)
+{
+   static boolean first = TRUE;
+   static unsigned value;
+
+   if (first) {
+      util_cpu_detect();
+
+      first = FALSE;
+      value = debug_get_num_option("DRAW_VS_THREADS", 0);
+      value = MIN2(value, util_cpu_caps.nr_cpus - 1);
+   }
+   return value;
+}
+
+
 struct llvm_middle_end {
    struct draw_pt_middle_end base;
    struct draw_context *draw;
@@ -56,6 +90,21 @@ struct llvm_middle_end {
 
    struct draw_llvm *llvm;
    struct draw_llvm_variant *current_variant;
+
+   /* worker threads for shading large runs, may be NULL */
+   struct draw_vs_threads *threads;
+};
+
+
+/**
+ * A vertex shader run split into per-thread chunks.
+ */
+struct llvm_vs_job {
+   struct llvm_middle_end *fpme;
+   const struct draw_fetch_info *fetch_info;
+   struct vertex_header *verts;
+   unsigned chunk;
+   unsigned clipped[DRAW_VS_MAX_THREADS + 1];
 };
 
 
@@ -341,6 +390,103 @@ emit(struct pt_emit *emit,
 }
 
 
+/**
+ * Fetch and shade count vertices, starting at the given offset into the
+ * fetch info, writing them to verts.  Returns non-zero if any of the
+ * vertices needs clipping.
+ */
+static unsigned
+llvm_vs_run_range(struct llvm_middle_end *fpme,
+                  const struct draw_fetch_info *fetch_info,
+                  struct vertex_header *verts,
+                  unsigned offset,
+                  unsigned count)
+{
+   struct draw_context *draw = fpme->draw;
+
+   if (fetch_info->linear)
+      return fpme->current_variant->jit_func( &fpme->llvm->jit_context,
+                                       verts,
+                                       draw->pt.user.vbuffer,
+                                       fetch_info->start + offset,
+                                       count,
+                                       fpme->vertex_size,
+                                       draw->pt.vertex_buffer,
+                                       draw->instance_id,
+                                       draw->start_index);
+   else
+      return fpme->current_variant->jit_func_elts( &fpme->llvm->jit_context,
+                                            verts,
+                                            draw->pt.user.vbuffer,
+                                            fetch_info->elts + offset,
+                                            draw->pt.user.eltMax,
+                                            count,
+                                            fpme->vertex_size,
+                                            draw->pt.vertex_buffer,
+                                            draw->instance_id,
+                                            draw->pt.user.eltBias);
+}
+
+
+static void
+llvm_vs_task(void *data, unsigned task)
+{
+   struct llvm_vs_job *job = (struct llvm_vs_job *) data;
+   struct llvm_middle_end *fpme = job->fpme;
+   unsigned offset = task * job->chunk;
+   unsigned count = MIN2(job->chunk, job->fetch_info->count - offset);
+   struct vertex_header *verts = (struct vertex_header *)
+      ((char *) job->verts + offset * fpme->vertex_size);
+
+   job->clipped[task] = llvm_vs_run_range(fpme, job->fetch_info,
+                                          verts, offset, count);
+}
+
+
+/**
+ * Run the vertex shader over all vertices of the fetch info.  Large runs
+ * are split into contiguous chunks which are shaded concurrently by the
+ * worker threads; as every chunk writes its own slice of verts the
+ * output is in order once all threads are done.
+ */
+static unsigned
+llvm_vs_run(struct llvm_middle_end *fpme,
+            const struct draw_fetch_info *fetch_info,
+            struct vertex_header *verts)
+{
+   const unsigned vector_length = lp_native_vector_width / 32;
+   struct llvm_vs_job job;
+   unsigned num_tasks, i;
+   unsigned clipped = 0;
+
+   if (!fpme->threads ||
+       fetch_info->count < LLVM_VS_THREAD_MIN_VERTICES) {
+      return llvm_vs_run_range(fpme, fetch_info, verts, 0, fetch_info->count);
+   }
+
+   num_tasks = MIN2(draw_vs_threads_max_tasks(fpme->threads),
+                    fetch_info->count / LLVM_VS_THREAD_MIN_CHUNK);
+
+   /* The jit code processes whole vectors and may write up to the next
+    * multiple of the vector length, so chunks must not share a vector.
+    */
+   job.chunk = align((fetch_info->count + num_tasks - 1) / num_tasks,
+                     vector_length);
+   num_tasks = (fetch_info->count + job.chunk - 1) / job.chunk;
+
+   job.fpme = fpme;
+   job.fetch_info = fetch_info;
+   job.verts = verts;
+
+   draw_vs_threads_run(fpme->threads, llvm_vs_task, &job, num_tasks);
+
+   for (i = 0; i < num_tasks; i++)
+      clipped |= job.clipped[i];
+
+   return clipped;
+}
+
+
 static void
 llvm_pipeline_generic(struct draw_pt_middle_end *middle,
                       const struct draw_fetch_info *fetch_info,
@@ -378,27 +524,7 @@ llvm_pipeline_generic(struct draw_pt_middle_end *middle,
       draw->statistics.vs_invocations += fetch_info->count;
    }
 
-   if (fetch_info->linear)
-      clipped = fpme->current_variant->jit_func( &fpme->llvm->jit_context,
-                                       llvm_vert_info.verts,
-                                       draw->pt.user.vbuffer,
-                                       fetch_info->start,
-                                       fetch_info->count,
-                                       fpme->vertex_size,
-                                       draw->pt.vertex_buffer,
-                                       draw->instance_id,
-                                       draw->start_index);
-   else
-      clipped = fpme->current_variant->jit_func_elts( &fpme->llvm->jit_context,
-                                            llvm_vert_info.verts,
-                                            draw->pt.user.vbuffer,
-                                            fetch_info->elts,
-                                            draw->pt.user.eltMax,
-                                            fetch_info->count,
-                                            fpme->vertex_size,
-                                            draw->pt.vertex_buffer,
-                                            draw->instance_id,
-                                            draw->pt.user.eltBias);
+   clipped = llvm_vs_run(fpme, fetch_info, llvm_vert_info.verts);
 
    /* Finished with fetch and vs:
     */
@@ -589,6 +715,8 @@ llvm_middle_end_destroy(struct draw_pt_middle_end *middle)
    if (fpme->post_vs)
       draw_pt_post_vs_destroy( fpme->post_vs );
 
+   draw_vs_threads_destroy( fpme->threads );
+
    FREE(middle);
 }
 
@@ -637,6 +765,8 @@ draw_pt_fetch_pipeline_or_emit_llvm(struct draw_context *draw)
 
    fpme->current_variant = NULL;
 
+   fpme->threads = draw_vs_threads_create( debug_get_option_draw_vs_threads() );
+
    return &fpme->base;
 
  fail:
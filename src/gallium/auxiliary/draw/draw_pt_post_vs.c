@@ -25,9 +25,11 @@
  *
  **************************************************************************/
 
+#include "util/u_cpu_detect.h"
 #include "util/u_memory.h"
 #include "util/u_math.h"
 #include "util/u_prim.h"
+#include "util/u_sse.h"
 #include "pipe/p_context.h"
 #include "draw/draw_context.h"
 #include "draw/draw_private.h"
@@ -51,6 +53,12 @@ struct pt_post_vs {
    boolean (*run)( struct pt_post_vs *pvs,
                    struct draw_vertex_info *info,
                    const struct draw_prim_info *prim_info );
+
+   /* templated version, used by the SIMD path for the cases it
+    * doesn't handle */
+   boolean (*run_scalar)( struct pt_post_vs *pvs,
+                          struct draw_vertex_info *info,
+                          const struct draw_prim_info *prim_info );
 };
 
 static INLINE void
@@ -87,6 +95,10 @@ dot4(const float *a, const float *b)
 #define TAG(x) x##_xy_gb_halfz_viewport
 #include "draw_cliptest_tmp.h"
 
+#define FLAGS (DO_CLIP_XY_GUARD_BAND | DO_CLIP_FULL_Z | DO_VIEWPORT)
+#define TAG(x) x##_xy_gb_fullz_viewport
+#include "draw_cliptest_tmp.h"
+
 #define FLAGS (DO_CLIP_FULL_Z | DO_VIEWPORT)
 #define TAG(x) x##_fullz_viewport
 #include "draw_cliptest_tmp.h"
@@ -116,6 +128,238 @@ dot4(const float *a, const float *b)
 
 
 
+#if defined(PIPE_ARCH_SSE)
+
+/**
+ * Clip test and viewport transform of four vertices at a time.
+ *
+ * Positions (and clip vertices) are transposed to structure-of-arrays
+ * form so the plane tests, the perspective divide and the viewport
+ * mapping run on four vertices per instruction.  The plane tests are
+ * done as direct comparisons, which are exact and give the same masks as
+ * the templated code.  Viewport indices and clip distances are left to
+ * the templated code.
+ */
+static boolean
+do_cliptest_sse( struct pt_post_vs *pvs,
+                 struct draw_vertex_info *info,
+                 const struct draw_prim_info *prim_info )
+{
+   struct draw_context *draw = pvs->draw;
+   const unsigned flags = pvs->flags;
+   const unsigned pos = draw_current_shader_position_output(draw);
+   const unsigned cv = draw_current_shader_clipvertex_output(draw);
+   const unsigned ef = draw->vs.edgeflag_output;
+   const boolean do_clip = (flags & (DO_CLIP_XY | DO_CLIP_XY_GUARD_BAND |
+                                     DO_CLIP_FULL_Z | DO_CLIP_HALF_Z |
+                                     DO_CLIP_USER)) != 0;
+   const boolean use_cv = (flags & DO_CLIP_USER) && cv != pos;
+   const __m128 zero = _mm_setzero_ps();
+   const __m128 gb_x = _mm_set1_ps(draw->plane[1][0]);
+   const __m128 gb_y = _mm_set1_ps(draw->plane[3][1]);
+   const __m128 one = _mm_set1_ps(1.0f);
+   const __m128 scale0 = _mm_set1_ps(draw->viewports[0].scale[0]);
+   const __m128 scale1 = _mm_set1_ps(draw->viewports[0].scale[1]);
+   const __m128 scale2 = _mm_set1_ps(draw->viewports[0].scale[2]);
+   const __m128 trans0 = _mm_set1_ps(draw->viewports[0].translate[0]);
+   const __m128 trans1 = _mm_set1_ps(draw->viewports[0].translate[1]);
+   const __m128 trans2 = _mm_set1_ps(draw->viewports[0].translate[2]);
+   unsigned ucp_enable = draw->rasterizer->clip_plane_enable;
+   unsigned need_pipeline = 0;
+   unsigned j;
+
+   if (draw_current_shader_uses_viewport_index(draw) ||
+       draw_current_shader_num_written_clipdistances(draw)) {
+      return pvs->run_scalar( pvs, info, prim_info );
+   }
+
+   for (j = 0; j < info->count; j += 4) {
+      const unsigned n = MIN2(info->count - j, 4);
+      struct vertex_header *out[4];
+      __m128 x, y, z, w;
+      __m128i mask = _mm_setzero_si128();
+      union m128i masks;
+      unsigned i;
+
+      for (i = 0; i < n; i++) {
+         out[i] = (struct vertex_header *)
+            ((char *) info->verts + (j + i) * info->stride);
+         initialize_vertex_header(out[i]);
+      }
+      /* pad a partial batch by replicating its first vertex */
+      for (; i < 4; i++)
+         out[i] = out[0];
+
+      x = _mm_loadu_ps(out[0]->data[pos]);
+      y = _mm_loadu_ps(out[1]->data[pos]);
+      z = _mm_loadu_ps(out[2]->data[pos]);
+      w = _mm_loadu_ps(out[3]->data[pos]);
+
+      if (do_clip) {
+         for (i = 0; i < n; i++) {
+            const float *clipvertex = use_cv ? out[i]->data[cv] :
+                                               out[i]->data[pos];
+            _mm_storeu_ps(out[i]->clip, _mm_loadu_ps(clipvertex));
+            _mm_storeu_ps(out[i]->pre_clip_pos, _mm_loadu_ps(out[i]->data[pos]));
+         }
+      }
+
+      _MM_TRANSPOSE4_PS(x, y, z, w);
+
+      /* Do the hardwired planes first:
+       */
+      if (flags & DO_CLIP_XY_GUARD_BAND) {
+         __m128 hx = _mm_mul_ps(x, gb_x);
+         __m128 hy = _mm_mul_ps(y, gb_y);
+         mask = _mm_or_si128(mask, _mm_and_si128(
+            _mm_castps_si128(_mm_cmplt_ps(w, hx)), _mm_set1_epi32(1<<0)));
+         mask = _mm_or_si128(mask, _mm_and_si128(
+            _mm_castps_si128(_mm_cmplt_ps(w, _mm_sub_ps(zero, hx))),
+            _mm_set1_epi32(1<<1)));
+         mask = _mm_or_si128(mask, _mm_and_si128(
+            _mm_castps_si128(_mm_cmplt_ps(w, hy)), _mm_set1_epi32(1<<2)));
+         mask = _mm_or_si128(mask, _mm_and_si128(
+            _mm_castps_si128(_mm_cmplt_ps(w, _mm_sub_ps(zero, hy))),
+            _mm_set1_epi32(1<<3)));
+      }
+      else if (flags & DO_CLIP_XY) {
+         mask = _mm_or_si128(mask, _mm_and_si128(
+            _mm_castps_si128(_mm_cmplt_ps(w, x)), _mm_set1_epi32(1<<0)));
+         mask = _mm_or_si128(mask, _mm_and_si128(
+            _mm_castps_si128(_mm_cmplt_ps(w, _mm_sub_ps(zero, x))),
+            _mm_set1_epi32(1<<1)));
+         mask = _mm_or_si128(mask, _mm_and_si128(
+            _mm_castps_si128(_mm_cmplt_ps(w, y)), _mm_set1_epi32(1<<2)));
+         mask = _mm_or_si128(mask, _mm_and_si128(
+            _mm_castps_si128(_mm_cmplt_ps(w, _mm_sub_ps(zero, y))),
+            _mm_set1_epi32(1<<3)));
+      }
+
+      /* Clip Z planes according to full cube, half cube or none.
+       */
+      if (flags & DO_CLIP_FULL_Z) {
+         mask = _mm_or_si128(mask, _mm_and_si128(
+            _mm_castps_si128(_mm_cmplt_ps(w, _mm_sub_ps(zero, z))),
+            _mm_set1_epi32(1<<4)));
+         mask = _mm_or_si128(mask, _mm_and_si128(
+            _mm_castps_si128(_mm_cmplt_ps(w, z)), _mm_set1_epi32(1<<5)));
+      }
+      else if (flags & DO_CLIP_HALF_Z) {
+         mask = _mm_or_si128(mask, _mm_and_si128(
+            _mm_castps_si128(_mm_cmplt_ps(z, zero)), _mm_set1_epi32(1<<4)));
+         mask = _mm_or_si128(mask, _mm_and_si128(
+            _mm_castps_si128(_mm_cmplt_ps(w, z)), _mm_set1_epi32(1<<5)));
+      }
+
+      if (flags & DO_CLIP_USER) {
+         __m128 cx = x, cy = y, cz = z, cw = w;
+         unsigned ucp_mask = ucp_enable;
+
+         if (use_cv) {
+            cx = _mm_loadu_ps(out[0]->data[cv]);
+            cy = _mm_loadu_ps(out[1]->data[cv]);
+            cz = _mm_loadu_ps(out[2]->data[cv]);
+            cw = _mm_loadu_ps(out[3]->data[cv]);
+            _MM_TRANSPOSE4_PS(cx, cy, cz, cw);
+         }
+
+         while (ucp_mask) {
+            unsigned plane_idx = ffs(ucp_mask)-1;
+            const float *plane;
+            __m128 dot;
+
+            ucp_mask &= ~(1 << plane_idx);
+            plane_idx += 6;
+            plane = draw->plane[plane_idx];
+
+            /* same evaluation order as dot4() */
+            dot = _mm_mul_ps(cx, _mm_set1_ps(plane[0]));
+            dot = _mm_add_ps(dot, _mm_mul_ps(cy, _mm_set1_ps(plane[1])));
+            dot = _mm_add_ps(dot, _mm_mul_ps(cz, _mm_set1_ps(plane[2])));
+            dot = _mm_add_ps(dot, _mm_mul_ps(cw, _mm_set1_ps(plane[3])));
+
+            mask = _mm_or_si128(mask, _mm_and_si128(
+               _mm_castps_si128(_mm_cmplt_ps(dot, zero)),
+               _mm_set1_epi32(1 << plane_idx)));
+         }
+      }
+
+      masks.m = mask;
+
+      /*
+       * Transform the vertex positions from clip coords to window coords,
+       * for the unclipped vertices.
+       */
+      {
+         __m128 keep;
+
+         if (flags & DO_VIEWPORT) {
+            __m128 rcp_w = _mm_div_ps(one, w);
+            __m128 unclipped = _mm_castsi128_ps(
+               _mm_cmpeq_epi32(mask, _mm_setzero_si128()));
+
+            x = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(x, rcp_w), scale0), trans0);
+            y = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(y, rcp_w), scale1), trans1);
+            z = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(z, rcp_w), scale2), trans2);
+            w = rcp_w;
+            keep = unclipped;
+         }
+         else {
+            keep = zero;
+         }
+
+#ifdef DEBUG
+         /* For debug builds, set the clipped vertex's window coordinate
+          * to NaN to help catch potential errors later.
+          */
+         {
+            const __m128 nan = _mm_castsi128_ps(_mm_set1_epi32(0x7fc00000));
+            x = _mm_or_ps(_mm_and_ps(keep, x), _mm_andnot_ps(keep, nan));
+            y = _mm_or_ps(_mm_and_ps(keep, y), _mm_andnot_ps(keep, nan));
+            z = _mm_or_ps(_mm_and_ps(keep, z), _mm_andnot_ps(keep, nan));
+            w = _mm_or_ps(_mm_and_ps(keep, w), _mm_andnot_ps(keep, nan));
+            keep = _mm_castsi128_ps(_mm_set1_epi32(~0));
+         }
+#endif
+
+         if (_mm_movemask_ps(keep)) {
+            const int keep_mask = _mm_movemask_ps(keep);
+            __m128 lanes[4];
+
+            _MM_TRANSPOSE4_PS(x, y, z, w);
+            lanes[0] = x;
+            lanes[1] = y;
+            lanes[2] = z;
+            lanes[3] = w;
+
+            for (i = 0; i < n; i++) {
+               if (keep_mask & (1 << i))
+                  _mm_storeu_ps(out[i]->data[pos], lanes[i]);
+            }
+         }
+      }
+
+      for (i = 0; i < n; i++) {
+         if (do_clip) {
+            out[i]->clipmask = masks.ui[i];
+            need_pipeline |= masks.ui[i];
+         }
+
+         if ((flags & DO_EDGEFLAG) && ef) {
+            const float *edgeflag = out[i]->data[ef];
+            out[i]->edgeflag = !(edgeflag[0] != 1.0f);
+            need_pipeline |= !out[i]->edgeflag;
+         }
+      }
+   }
+
+   return need_pipeline != 0;
+}
+
+#endif /* PIPE_ARCH_SSE */
+
+
+
 boolean draw_pt_post_vs_run( struct pt_post_vs *pvs,
 			     struct draw_vertex_info *info,
                              const struct draw_prim_info *prim_info )
@@ -135,11 +379,6 @@ void draw_pt_post_vs_prepare( struct pt_post_vs *pvs,
 {
    pvs->flags = 0;
 
-   /* This combination not currently tested/in use:
-    */
-   if (!clip_halfz)
-      guard_band = FALSE;
-
    if (clip_xy && !guard_band) {
       pvs->flags |= DO_CLIP_XY;
       ASSIGN_4V( pvs->draw->plane[0], -1,  0,  0, 1 );
@@ -148,11 +387,17 @@ void draw_pt_post_vs_prepare( struct pt_post_vs *pvs,
       ASSIGN_4V( pvs->draw->plane[3],  0,  1,  0, 1 );
    }
    else if (clip_xy && guard_band) {
+      const float gb_x = 1.0f / pvs->draw->driver.guard_band_size[0];
+      const float gb_y = 1.0f / pvs->draw->driver.guard_band_size[1];
+
+      /* The guard band test in the cliptest functions and the llvm code
+       * reads the plane[1] and plane[3] coefficients.
+       */
       pvs->flags |= DO_CLIP_XY_GUARD_BAND;
-      ASSIGN_4V( pvs->draw->plane[0], -0.5,  0,  0, 1 );
-      ASSIGN_4V( pvs->draw->plane[1],  0.5,  0,  0, 1 );
-      ASSIGN_4V( pvs->draw->plane[2],  0, -0.5,  0, 1 );
-      ASSIGN_4V( pvs->draw->plane[3],  0,  0.5,  0, 1 );
+      ASSIGN_4V( pvs->draw->plane[0], -gb_x,  0,  0, 1 );
+      ASSIGN_4V( pvs->draw->plane[1],  gb_x,  0,  0, 1 );
+      ASSIGN_4V( pvs->draw->plane[2],  0, -gb_y,  0, 1 );
+      ASSIGN_4V( pvs->draw->plane[3],  0,  gb_y,  0, 1 );
    }
 
    if (clip_z) {
@@ -193,6 +438,10 @@ void draw_pt_post_vs_prepare( struct pt_post_vs *pvs,
       pvs->run = do_cliptest_xy_gb_halfz_viewport;
       break;
 
+   case DO_CLIP_XY_GUARD_BAND | DO_CLIP_FULL_Z | DO_VIEWPORT:
+      pvs->run = do_cliptest_xy_gb_fullz_viewport;
+      break;
+
    case DO_CLIP_FULL_Z | DO_VIEWPORT:
       pvs->run = do_cliptest_fullz_viewport;
       break;
@@ -214,6 +463,13 @@ void draw_pt_post_vs_prepare( struct pt_post_vs *pvs,
       pvs->run = do_cliptest_generic;
       break;
    }
+
+#if defined(PIPE_ARCH_SSE)
+   if (util_cpu_caps.has_sse2 && pvs->flags != 0) {
+      pvs->run_scalar = pvs->run;
+      pvs->run = do_cliptest_sse;
+   }
+#endif
 }
 
 
@@ -225,6 +481,8 @@ struct pt_post_vs *draw_pt_post_vs_create( struct draw_context *draw )
 
    pvs->draw = draw;
 
+   util_cpu_detect();
+
    return pvs;
 }
 
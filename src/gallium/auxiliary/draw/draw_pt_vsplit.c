@@ -23,6 +23,7 @@
  * DEALINGS IN THE SOFTWARE.
  */
 
+#include "util/u_debug.h"
 #include "util/u_math.h"
 #include "util/u_memory.h"
 
@@ -30,12 +31,30 @@
 #include "draw/draw_private.h"
 #include "draw/draw_pt.h"
 
-#define SEGMENT_SIZE 1024
-#define MAP_SIZE     256
+/* Default and allowed range of the segment size, i.e. the maximum number
+ * of vertices fetched and shaded per middle-end run.  Can be overridden
+ * with DRAW_VSPLIT_SEGMENT_SIZE.
+ */
+#define SEGMENT_SIZE     1024
+#define MIN_SEGMENT_SIZE 64
+#define MAX_SEGMENT_SIZE 16384
+
+/* The post-transform vertex cache is set-associative: a fetch element
+ * hashes to one of CACHE_SETS sets and may live in any of its CACHE_WAYS
+ * ways.  Compared to a direct-mapped cache this avoids most of the
+ * conflict misses on meshes with poor index locality.
+ */
+#define CACHE_SET_BITS   8
+#define CACHE_SETS       (1 << CACHE_SET_BITS)
+#define CACHE_WAYS       4
 
 /* The largest possible index withing an index buffer */
 #define MAX_ELT_IDX 0xffffffff
 
+DEBUG_GET_ONCE_NUM_OPTION(vsplit_segment_size, "DRAW_VSPLIT_SEGMENT_SIZE",
+                          SEGMENT_SIZE)
+DEBUG_GET_ONCE_BOOL_OPTION(vsplit_stats, "DRAW_VSPLIT_STATS", FALSE)
+
 struct vsplit_frontend {
    struct draw_pt_front_end base;
    struct draw_context *draw;
@@ -46,29 +65,38 @@ struct vsplit_frontend {
 
    unsigned max_vertices;
    ushort segment_size;
+   ushort max_segment_size;
 
-   /* buffers for splitting */
-   unsigned fetch_elts[SEGMENT_SIZE];
-   ushort draw_elts[SEGMENT_SIZE];
-   ushort identity_draw_elts[SEGMENT_SIZE];
+   /* buffers for splitting, max_segment_size entries each */
+   unsigned *fetch_elts;
+   ushort *draw_elts;
+   ushort *identity_draw_elts;
 
    struct {
       /* map a fetch element to a draw element */
-      unsigned fetches[MAP_SIZE];
-      ushort draws[MAP_SIZE];
-      boolean has_max_fetch;
+      unsigned fetches[CACHE_SETS][CACHE_WAYS];
+      ushort draws[CACHE_SETS][CACHE_WAYS];
+      /* number of valid ways in each set */
+      ubyte fill[CACHE_SETS];
+      /* next way to evict once a set is full (round-robin) */
+      ubyte victim[CACHE_SETS];
 
       ushort num_fetch_elts;
       ushort num_draw_elts;
    } cache;
+
+   /* vertex reuse statistics, reported with DRAW_VSPLIT_STATS */
+   boolean stats;
+   uint64_t num_indices;
+   uint64_t num_shaded;
 };
 
 
 static void
 vsplit_clear_cache(struct vsplit_frontend *vsplit)
 {
-   memset(vsplit->cache.fetches, 0xff, sizeof(vsplit->cache.fetches));
-   vsplit->cache.has_max_fetch = FALSE;
+   memset(vsplit->cache.fill, 0, sizeof(vsplit->cache.fill));
+   memset(vsplit->cache.victim, 0, sizeof(vsplit->cache.victim));
    vsplit->cache.num_fetch_elts = 0;
    vsplit->cache.num_draw_elts = 0;
 }
@@ -76,34 +104,69 @@ vsplit_clear_cache(struct vsplit_frontend *vsplit)
 static void
 vsplit_flush_cache(struct vsplit_frontend *vsplit, unsigned flags)
 {
+   if (vsplit->stats) {
+      vsplit->num_indices += vsplit->cache.num_draw_elts;
+      vsplit->num_shaded += vsplit->cache.num_fetch_elts;
+   }
+
    vsplit->middle->run(vsplit->middle,
          vsplit->fetch_elts, vsplit->cache.num_fetch_elts,
          vsplit->draw_elts, vsplit->cache.num_draw_elts, flags);
 }
 
+/**
+ * Map a fetch element to a cache set.  Multiplicative hashing keeps
+ * sequential indices in distinct sets while also spreading out strided
+ * access patterns which would alias in a plain modulo.
+ */
+static INLINE unsigned
+vsplit_cache_set(unsigned fetch)
+{
+   return (fetch * 2654435761u) >> (32 - CACHE_SET_BITS);
+}
+
 /**
  * Add a fetch element and add it to the draw elements.
  */
 static INLINE void
 vsplit_add_cache(struct vsplit_frontend *vsplit, unsigned fetch, unsigned ofbias)
 {
-   unsigned hash;
+   const unsigned set = vsplit_cache_set(fetch);
+   const unsigned fill = vsplit->cache.fill[set];
+   unsigned way;
+
+   /* If the value is in the cache and isn't an overflow due to the
+    * element bias, reuse the already fetched vertex */
+   if (!ofbias) {
+      for (way = 0; way < fill; way++) {
+         if (vsplit->cache.fetches[set][way] == fetch) {
+            vsplit->draw_elts[vsplit->cache.num_draw_elts++] =
+               vsplit->cache.draws[set][way];
+            return;
+         }
+      }
+   }
 
-   hash = fetch % MAP_SIZE;
+   /* pick a free way, or evict one */
+   if (fill < CACHE_WAYS) {
+      way = fill;
+      vsplit->cache.fill[set] = fill + 1;
+   }
+   else {
+      way = vsplit->cache.victim[set];
+      vsplit->cache.victim[set] = (way + 1) % CACHE_WAYS;
+   }
 
-   /* If the value isn't in the cache of it's an overflow due to the
-    * element bias */
-   if (vsplit->cache.fetches[hash] != fetch || ofbias) {
-      /* update cache */
-      vsplit->cache.fetches[hash] = fetch;
-      vsplit->cache.draws[hash] = vsplit->cache.num_fetch_elts;
+   /* update cache */
+   vsplit->cache.fetches[set][way] = fetch;
+   vsplit->cache.draws[set][way] = vsplit->cache.num_fetch_elts;
 
-      /* add fetch */
-      assert(vsplit->cache.num_fetch_elts < vsplit->segment_size);
-      vsplit->fetch_elts[vsplit->cache.num_fetch_elts++] = fetch;
-   }
+   /* add fetch */
+   assert(vsplit->cache.num_fetch_elts < vsplit->segment_size);
+   vsplit->fetch_elts[vsplit->cache.num_fetch_elts++] = fetch;
 
-   vsplit->draw_elts[vsplit->cache.num_draw_elts++] = vsplit->cache.draws[hash];
+   vsplit->draw_elts[vsplit->cache.num_draw_elts++] =
+      vsplit->cache.draws[set][way];
 }
 
 /**
@@ -198,16 +261,7 @@ vsplit_add_cache_uint(struct vsplit_frontend *vsplit, const uint *elts,
                       unsigned start, unsigned fetch, int elt_bias)
 {
    struct draw_context *draw = vsplit->draw;
-   unsigned raw_elem_idx = start + fetch + elt_bias;
    VSPLIT_CREATE_IDX(elts, start, fetch, elt_bias);
-
-   /* special care for DRAW_MAX_FETCH_IDX */
-   if (raw_elem_idx == DRAW_MAX_FETCH_IDX && !vsplit->cache.has_max_fetch) {
-      unsigned hash = fetch % MAP_SIZE;
-      vsplit->cache.fetches[hash] = raw_elem_idx - 1; /* force update */
-      vsplit->cache.has_max_fetch = TRUE;
-   }
-
    vsplit_add_cache(vsplit, elt_idx, ofbias);
 }
 
@@ -262,7 +316,7 @@ static void vsplit_prepare(struct draw_pt_front_end *frontend,
    vsplit->middle = middle;
    middle->prepare(middle, vsplit->prim, opt, &vsplit->max_vertices);
 
-   vsplit->segment_size = MIN2(SEGMENT_SIZE, vsplit->max_vertices);
+   vsplit->segment_size = MIN2(vsplit->max_segment_size, vsplit->max_vertices);
 }
 
 
@@ -279,26 +333,54 @@ static void vsplit_flush(struct draw_pt_front_end *frontend, unsigned flags)
 
 static void vsplit_destroy(struct draw_pt_front_end *frontend)
 {
-   FREE(frontend);
+   struct vsplit_frontend *vsplit = (struct vsplit_frontend *) frontend;
+
+   if (vsplit->stats && vsplit->num_indices) {
+      debug_printf("draw: vsplit cache: %llu indices, %llu vertices shaded, "
+                   "reuse ratio %.3f\n",
+                   (unsigned long long) vsplit->num_indices,
+                   (unsigned long long) vsplit->num_shaded,
+                   (double) vsplit->num_indices / vsplit->num_shaded);
+   }
+
+   FREE(vsplit->fetch_elts);
+   FREE(vsplit->draw_elts);
+   FREE(vsplit->identity_draw_elts);
+   FREE(vsplit);
 }
 
 
 struct draw_pt_front_end *draw_pt_vsplit(struct draw_context *draw)
 {
    struct vsplit_frontend *vsplit = CALLOC_STRUCT(vsplit_frontend);
-   ushort i;
+   unsigned segment_size;
+   unsigned i;
 
    if (!vsplit)
       return NULL;
 
+   segment_size = CLAMP(debug_get_option_vsplit_segment_size(),
+                        MIN_SEGMENT_SIZE, MAX_SEGMENT_SIZE);
+   vsplit->max_segment_size = (ushort) segment_size;
+   vsplit->stats = debug_get_option_vsplit_stats();
+
+   vsplit->fetch_elts = MALLOC(segment_size * sizeof(unsigned));
+   vsplit->draw_elts = MALLOC(segment_size * sizeof(ushort));
+   vsplit->identity_draw_elts = MALLOC(segment_size * sizeof(ushort));
+   if (!vsplit->fetch_elts || !vsplit->draw_elts ||
+       !vsplit->identity_draw_elts) {
+      vsplit_destroy(&vsplit->base);
+      return NULL;
+   }
+
    vsplit->base.prepare = vsplit_prepare;
    vsplit->base.run     = NULL;
    vsplit->base.flush   = vsplit_flush;
    vsplit->base.destroy = vsplit_destroy;
    vsplit->draw = draw;
 
-   for (i = 0; i < SEGMENT_SIZE; i++)
-      vsplit->identity_draw_elts[i] = i;
+   for (i = 0; i < segment_size; i++)
+      vsplit->identity_draw_elts[i] = (ushort) i;
 
    return &vsplit->base;
 }
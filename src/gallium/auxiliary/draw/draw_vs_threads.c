@@ -0,0 +1,196 @@
+/**************************************************************************
+ * 
+ * Copyright 2014 VMware, Inc.
+ * All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ * 
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL VMWARE AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * 
+ **************************************************************************/
+
+/**
+ * Worker thread pool for splitting vertex shading across CPUs.
+ */
+
+#include "os/os_thread.h"
+#include "util/u_math.h"
+#include "util/u_memory.h"
+
+#include "draw/draw_vs_threads.h"
+
+
+struct draw_vs_worker {
+   struct draw_vs_threads *pool;
+   unsigned task;              /**< task index this worker runs, >= 1 */
+   pipe_semaphore work_ready;
+   pipe_semaphore work_done;
+};
+
+
+struct draw_vs_threads {
+   unsigned num_threads;
+
+   /* current job, set by draw_vs_threads_run() */
+   draw_vs_task_func func;
+   void *data;
+   unsigned fpstate;
+   boolean exit_flag;
+
+   struct draw_vs_worker workers[DRAW_VS_MAX_THREADS];
+   pipe_thread threads[DRAW_VS_MAX_THREADS];
+};
+
+
+static PIPE_THREAD_ROUTINE( draw_vs_thread_function, init_data )
+{
+   struct draw_vs_worker *worker = (struct draw_vs_worker *) init_data;
+   struct draw_vs_threads *pool = worker->pool;
+
+   while (1) {
+      pipe_semaphore_wait(&worker->work_ready);
+
+      if (pool->exit_flag)
+         break;
+
+      /* Shade with the same floating point state as the calling thread. */
+      util_fpstate_set(pool->fpstate);
+
+      pool->func(pool->data, worker->task);
+
+      pipe_semaphore_signal(&worker->work_done);
+   }
+
+   return 0;
+}
+
+
+/**
+ * Create a pool of up to num_threads worker threads.  Returns NULL if
+ * num_threads is zero or no thread could be started, in which case no
+ * threading should be done.
+ */
+struct draw_vs_threads *
+draw_vs_threads_create(unsigned num_threads)
+{
+   struct draw_vs_threads *pool;
+   unsigned i;
+
+   num_threads = MIN2(num_threads, DRAW_VS_MAX_THREADS);
+   if (num_threads == 0)
+      return NULL;
+
+   pool = CALLOC_STRUCT(draw_vs_threads);
+   if (!pool)
+      return NULL;
+
+   for (i = 0; i < num_threads; i++) {
+      struct draw_vs_worker *worker = &pool->workers[i];
+
+      worker->pool = pool;
+      worker->task = i + 1;
+      pipe_semaphore_init(&worker->work_ready, 0);
+      pipe_semaphore_init(&worker->work_done, 0);
+      pool->threads[i] = pipe_thread_create(draw_vs_thread_function, worker);
+      if (!pool->threads[i]) {
+         /* Make do with the threads started so far. */
+         pipe_semaphore_destroy(&worker->work_ready);
+         pipe_semaphore_destroy(&worker->work_done);
+         break;
+      }
+   }
+
+   pool->num_threads = i;
+   if (pool->num_threads == 0) {
+      /* Shade on the calling thread only. */
+      FREE(pool);
+      return NULL;
+   }
+
+   return pool;
+}
+
+
+void
+draw_vs_threads_destroy(struct draw_vs_threads *pool)
+{
+   unsigned i;
+
+   if (!pool)
+      return;
+
+   /* Wake every thread up so it notices the exit flag and terminates. */
+   pool->exit_flag = TRUE;
+   for (i = 0; i < pool->num_threads; i++) {
+      pipe_semaphore_signal(&pool->workers[i].work_ready);
+   }
+
+   for (i = 0; i < pool->num_threads; i++) {
+      pipe_thread_wait(pool->threads[i]);
+      pipe_semaphore_destroy(&pool->workers[i].work_ready);
+      pipe_semaphore_destroy(&pool->workers[i].work_done);
+   }
+
+   FREE(pool);
+}
+
+
+/**
+ * Maximum number of tasks which can be passed to draw_vs_threads_run(),
+ * i.e. the worker threads plus the calling thread.
+ */
+unsigned
+draw_vs_threads_max_tasks(const struct draw_vs_threads *pool)
+{
+   return pool ? pool->num_threads + 1 : 1;
+}
+
+
+/**
+ * Run func(data, task) for every task in [0, num_tasks) and wait for
+ * completion.  Task zero runs on the calling thread.
+ */
+void
+draw_vs_threads_run(struct draw_vs_threads *pool,
+                    draw_vs_task_func func,
+                    void *data,
+                    unsigned num_tasks)
+{
+   unsigned num_workers, i;
+
+   assert(num_tasks <= draw_vs_threads_max_tasks(pool));
+
+   if (num_tasks == 0)
+      return;
+
+   num_workers = num_tasks - 1;
+   if (num_workers) {
+      pool->func = func;
+      pool->data = data;
+      pool->fpstate = util_fpstate_get();
+
+      for (i = 0; i < num_workers; i++)
+         pipe_semaphore_signal(&pool->workers[i].work_ready);
+   }
+
+   func(data, 0);
+
+   for (i = 0; i < num_workers; i++)
+      pipe_semaphore_wait(&pool->workers[i].work_done);
+}
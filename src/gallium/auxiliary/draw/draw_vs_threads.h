@@ -0,0 +1,67 @@
+/**************************************************************************
+ * 
+ * Copyright 2014 VMware, Inc.
+ * All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ * 
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL VMWARE AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * 
+ **************************************************************************/
+
+/**
+ * A small pool of worker threads used to run the vertex shader of large
+ * draws concurrently.  Work is split by the caller into at most
+ * num_threads + 1 independent tasks; the calling thread always runs task
+ * zero itself and draw_vs_threads_run() returns once every task is done,
+ * so the results can be consumed in order afterwards.
+ */
+
+#ifndef DRAW_VS_THREADS_H
+#define DRAW_VS_THREADS_H
+
+#include "pipe/p_compiler.h"
+
+
+/** Upper bound for the number of worker threads in a pool */
+#define DRAW_VS_MAX_THREADS 16
+
+
+struct draw_vs_threads;
+
+typedef void (*draw_vs_task_func)(void *data, unsigned task);
+
+
+struct draw_vs_threads *
+draw_vs_threads_create(unsigned num_threads);
+
+void
+draw_vs_threads_destroy(struct draw_vs_threads *threads);
+
+unsigned
+draw_vs_threads_max_tasks(const struct draw_vs_threads *threads);
+
+void
+draw_vs_threads_run(struct draw_vs_threads *threads,
+                    draw_vs_task_func func,
+                    void *data,
+                    unsigned num_tasks);
+
+
+#endif /* DRAW_VS_THREADS_H */
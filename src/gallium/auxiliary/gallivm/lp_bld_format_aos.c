@@ -251,10 +251,13 @@ lp_build_unpack_arith_rgba_aos(struct gallivm_state *gallivm,
 /**
  * Pack a single pixel.
  *
+ * Normalized channels are clamped to [0, 1] and rounded to nearest, like
+ * the util_format pack functions do.
+ *
  * @param rgba 4 float vector with the unpacked components.
  *
- * XXX: This is mostly for reference and testing -- operating a single pixel at
- * a time is rarely if ever needed.
+ * XXX: Operating a single pixel at a time is rarely needed, this is mostly
+ * used by the row converters of lp_bld_format_translate.c.
  */
 LLVMValueRef
 lp_build_pack_rgba_aos(struct gallivm_state *gallivm,
@@ -319,8 +322,15 @@ lp_build_pack_rgba_aos(struct gallivm_state *gallivm,
       }
    }
 
-   if (normalized)
-      scaled = LLVMBuildFMul(builder, unswizzled, LLVMConstVector(scales, 4), "");
+   if (normalized) {
+      struct lp_build_context bld;
+
+      lp_build_context_init(&bld, gallivm, lp_float32_vec4_type());
+      scaled = lp_build_clamp_zero_one_nanzero(&bld, unswizzled);
+      scaled = LLVMBuildFMul(builder, scaled, LLVMConstVector(scales, 4), "");
+      scaled = LLVMBuildFAdd(builder, scaled,
+                             lp_build_const_vec(gallivm, bld.type, 0.5), "");
+   }
    else
       scaled = unswizzled;
 
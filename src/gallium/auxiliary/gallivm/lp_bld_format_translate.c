@@ -0,0 +1,335 @@
+/**************************************************************************
+ *
+ * Copyright 2014 VMware, Inc.
+ * All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL VMWARE AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ **************************************************************************/
+
+/**
+ * @file
+ * JIT compiled pixel row conversion between formats.
+ *
+ * Each (dst, src) format pair gets a function which unpacks every pixel
+ * with lp_build_fetch_rgba_aos() and repacks it with
+ * lp_build_pack_rgba_aos().  The functions are compiled the first time
+ * they're asked for, and kept in a cache until the cache is destroyed.
+ */
+
+
+#include "util/u_debug.h"
+#include "util/u_format.h"
+#include "util/u_math.h"
+#include "util/u_memory.h"
+#include "util/u_pointer.h"
+#include "util/u_string.h"
+
+#include "lp_bld_const.h"
+#include "lp_bld_flow.h"
+#include "lp_bld_format.h"
+#include "lp_bld_init.h"
+#include "lp_bld_type.h"
+#include "lp_bld_format_translate.h"
+
+
+#define LP_FORMAT_TRANSLATE_CACHE_SIZE 64
+
+
+struct lp_format_translate_entry
+{
+   enum pipe_format dst_format;
+   enum pipe_format src_format;
+   struct gallivm_state *gallivm;
+   lp_format_translate_func func;
+};
+
+
+struct lp_format_translate_cache
+{
+   struct lp_format_translate_entry entries[LP_FORMAT_TRANSLATE_CACHE_SIZE];
+   unsigned size;
+};
+
+
+/**
+ * Whether lp_build_fetch_rgba_aos() unpacks the format itself, with bit
+ * arithmetic or a vector load, instead of calling back into u_format.
+ */
+static boolean
+src_format_supported(const struct util_format_description *desc)
+{
+   unsigned chan;
+
+   if (desc->layout != UTIL_FORMAT_LAYOUT_PLAIN ||
+       desc->colorspace != UTIL_FORMAT_COLORSPACE_RGB ||
+       desc->block.width != 1 ||
+       desc->block.height != 1 ||
+       desc->block.bits % 8 != 0 ||
+       desc->is_mixed) {
+      return FALSE;
+   }
+
+   for (chan = 0; chan < 4; ++chan) {
+      const struct util_format_channel_description *channel =
+         &desc->channel[chan];
+
+      if (channel->type == UTIL_FORMAT_TYPE_VOID)
+         continue;
+
+      if (channel->pure_integer)
+         return FALSE;
+
+      if (!(channel->type == UTIL_FORMAT_TYPE_UNSIGNED &&
+            channel->normalized && channel->size <= 16) &&
+          !(channel->type == UTIL_FORMAT_TYPE_FLOAT &&
+            channel->size == 32)) {
+         return FALSE;
+      }
+   }
+
+   if (desc->is_bitmask &&
+       util_is_power_of_two(desc->block.bits) &&
+       desc->block.bits <= 32 &&
+       (desc->channel[0].type == UTIL_FORMAT_TYPE_UNSIGNED ||
+        desc->channel[1].type == UTIL_FORMAT_TYPE_UNSIGNED)) {
+      return TRUE;
+   }
+
+   return desc->is_array;
+}
+
+
+/**
+ * Whether lp_build_pack_rgba_aos() can pack the format.
+ */
+static boolean
+dst_format_supported(const struct util_format_description *desc)
+{
+   boolean has_channel = FALSE;
+   unsigned chan;
+
+   if (desc->layout != UTIL_FORMAT_LAYOUT_PLAIN ||
+       desc->colorspace != UTIL_FORMAT_COLORSPACE_RGB ||
+       desc->block.width != 1 ||
+       desc->block.height != 1 ||
+       desc->block.bits % 8 != 0 ||
+       desc->block.bits > 32) {
+      return FALSE;
+   }
+
+   for (chan = 0; chan < 4; ++chan) {
+      const struct util_format_channel_description *channel =
+         &desc->channel[chan];
+
+      if (channel->type == UTIL_FORMAT_TYPE_VOID)
+         continue;
+
+      if (channel->type != UTIL_FORMAT_TYPE_UNSIGNED ||
+          !channel->normalized ||
+          channel->size >= 32) {
+         return FALSE;
+      }
+
+      has_channel = TRUE;
+   }
+
+   return has_channel;
+}
+
+
+/**
+ * Whether lp_get_format_translate_func() can convert between the two
+ * formats.  This is limited to non-sRGB normalized formats which the JIT
+ * code converts entirely on its own, unsigned ones for the destination.
+ */
+boolean
+lp_format_translate_supported(enum pipe_format dst_format,
+                              enum pipe_format src_format)
+{
+   const struct util_format_description *dst_desc =
+      util_format_description(dst_format);
+   const struct util_format_description *src_desc =
+      util_format_description(src_format);
+
+   return dst_desc && src_desc &&
+          dst_format_supported(dst_desc) &&
+          src_format_supported(src_desc);
+}
+
+
+/**
+ * Build
+ *
+ *    void translate(uint8_t *dst, const uint8_t *src, unsigned width);
+ */
+static LLVMValueRef
+build_translate_func(struct gallivm_state *gallivm,
+                     const struct util_format_description *dst_desc,
+                     const struct util_format_description *src_desc)
+{
+   LLVMContextRef context = gallivm->context;
+   LLVMBuilderRef builder = gallivm->builder;
+   LLVMTypeRef i8_ptr_type =
+      LLVMPointerType(LLVMInt8TypeInContext(context), 0);
+   LLVMTypeRef arg_types[3];
+   LLVMValueRef func, dst_ptr, src_ptr, width;
+   LLVMValueRef dst_stride, src_stride, zero;
+   LLVMBasicBlockRef block;
+   struct lp_build_for_loop_state loop;
+   char name[64];
+
+   util_snprintf(name, sizeof name, "translate_%s_to_%s",
+                 src_desc->short_name, dst_desc->short_name);
+
+   arg_types[0] = i8_ptr_type;
+   arg_types[1] = i8_ptr_type;
+   arg_types[2] = LLVMInt32TypeInContext(context);
+
+   func = LLVMAddFunction(gallivm->module, name,
+                          LLVMFunctionType(LLVMVoidTypeInContext(context),
+                                           arg_types, Elements(arg_types),
+                                           0));
+   LLVMSetFunctionCallConv(func, LLVMCCallConv);
+
+   dst_ptr = LLVMGetParam(func, 0);
+   src_ptr = LLVMGetParam(func, 1);
+   width = LLVMGetParam(func, 2);
+
+   block = LLVMAppendBasicBlockInContext(context, func, "entry");
+   LLVMPositionBuilderAtEnd(builder, block);
+
+   dst_stride = lp_build_const_int32(gallivm, dst_desc->block.bits / 8);
+   src_stride = lp_build_const_int32(gallivm, src_desc->block.bits / 8);
+   zero = lp_build_const_int32(gallivm, 0);
+
+   lp_build_for_loop_begin(&loop, gallivm, zero, LLVMIntULT, width,
+                           lp_build_const_int32(gallivm, 1));
+   {
+      LLVMValueRef src_offset, dst_offset, rgba, packed, ptr, store;
+
+      src_offset = LLVMBuildMul(builder, loop.counter, src_stride, "");
+      dst_offset = LLVMBuildMul(builder, loop.counter, dst_stride, "");
+
+      rgba = lp_build_fetch_rgba_aos(gallivm, src_desc,
+                                     lp_float32_vec4_type(),
+                                     src_ptr, src_offset, zero, zero);
+
+      packed = lp_build_pack_rgba_aos(gallivm, dst_desc, rgba);
+
+      ptr = LLVMBuildGEP(builder, dst_ptr, &dst_offset, 1, "");
+      ptr = LLVMBuildBitCast(builder, ptr,
+                             LLVMPointerType(LLVMTypeOf(packed), 0), "");
+      store = LLVMBuildStore(builder, packed, ptr);
+      lp_set_store_alignment(store, 1);
+   }
+   lp_build_for_loop_end(&loop);
+
+   LLVMBuildRetVoid(builder);
+
+   gallivm_verify_function(gallivm, func);
+
+   return func;
+}
+
+
+struct lp_format_translate_cache *
+lp_format_translate_cache_create(void)
+{
+   return CALLOC_STRUCT(lp_format_translate_cache);
+}
+
+
+/**
+ * Free the cache and all the functions compiled into it.
+ */
+void
+lp_format_translate_cache_destroy(struct lp_format_translate_cache *cache)
+{
+   unsigned i;
+
+   if (!cache)
+      return;
+
+   for (i = 0; i < cache->size; ++i)
+      gallivm_destroy(cache->entries[i].gallivm);
+
+   FREE(cache);
+}
+
+
+/**
+ * Return a function converting rows of src_format pixels to dst_format,
+ * compiling it on first use, or NULL if the pair isn't supported or the
+ * cache is full.  The function is valid until the cache is destroyed.
+ */
+lp_format_translate_func
+lp_get_format_translate_func(struct lp_format_translate_cache *cache,
+                             enum pipe_format dst_format,
+                             enum pipe_format src_format)
+{
+   struct lp_format_translate_entry *entry;
+   struct gallivm_state *gallivm;
+   lp_format_translate_func func;
+   LLVMValueRef function;
+   unsigned i;
+
+   if (!lp_format_translate_supported(dst_format, src_format))
+      return NULL;
+
+   for (i = 0; i < cache->size; ++i) {
+      entry = &cache->entries[i];
+      if (entry->dst_format == dst_format &&
+          entry->src_format == src_format) {
+         return entry->func;
+      }
+   }
+
+   if (cache->size == LP_FORMAT_TRANSLATE_CACHE_SIZE)
+      return NULL;
+
+   lp_build_init();
+
+   gallivm = gallivm_create();
+   if (!gallivm)
+      return NULL;
+
+   function = build_translate_func(gallivm,
+                                   util_format_description(dst_format),
+                                   util_format_description(src_format));
+
+   gallivm_compile_module(gallivm);
+
+   func = (lp_format_translate_func)
+      pointer_to_func(gallivm_jit_function(gallivm, function));
+   if (!func) {
+      gallivm_destroy(gallivm);
+      return NULL;
+   }
+
+   entry = &cache->entries[cache->size++];
+   entry->dst_format = dst_format;
+   entry->src_format = src_format;
+   entry->gallivm = gallivm;
+   entry->func = func;
+
+   return func;
+}
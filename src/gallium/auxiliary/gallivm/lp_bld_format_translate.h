@@ -0,0 +1,78 @@
+/**************************************************************************
+ *
+ * Copyright 2014 VMware, Inc.
+ * All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL VMWARE AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ **************************************************************************/
+
+/**
+ * @file
+ * JIT compiled pixel row conversion between formats.
+ *
+ * This header doesn't depend on the LLVM headers, so that state trackers
+ * can use it without them.
+ */
+
+#ifndef LP_BLD_FORMAT_TRANSLATE_H
+#define LP_BLD_FORMAT_TRANSLATE_H
+
+
+#include "pipe/p_compiler.h"
+#include "pipe/p_format.h"
+
+
+/**
+ * Convert a row of width pixels from src to dst.  Neither needs to be
+ * aligned.
+ */
+typedef void
+(*lp_format_translate_func)(uint8_t *dst, const uint8_t *src,
+                            unsigned width);
+
+
+/**
+ * Compiled converters, owned by a single thread.
+ */
+struct lp_format_translate_cache;
+
+
+boolean
+lp_format_translate_supported(enum pipe_format dst_format,
+                              enum pipe_format src_format);
+
+
+struct lp_format_translate_cache *
+lp_format_translate_cache_create(void);
+
+
+void
+lp_format_translate_cache_destroy(struct lp_format_translate_cache *cache);
+
+
+lp_format_translate_func
+lp_get_format_translate_func(struct lp_format_translate_cache *cache,
+                             enum pipe_format dst_format,
+                             enum pipe_format src_format);
+
+
+#endif /* !LP_BLD_FORMAT_TRANSLATE_H */
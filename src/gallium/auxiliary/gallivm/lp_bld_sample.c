@@ -36,7 +36,9 @@
 #include "pipe/p_state.h"
 #include "util/u_format.h"
 #include "util/u_math.h"
+#include "util/u_memory.h"
 #include "util/u_cpu_detect.h"
+#include "util/u_pointer.h"
 #include "lp_bld_arit.h"
 #include "lp_bld_const.h"
 #include "lp_bld_debug.h"
@@ -2078,3 +2080,182 @@ lp_build_sample_offset(struct lp_build_context *bld,
 
    *out_offset = offset;
 }
+
+
+/**
+ * Compute the offset of a texel in a texture with the tiled layout.
+ *
+ * Texels are stored in 4x4 micro tiles, each one occupying 16 consecutive
+ * texels in row-major order, and the micro tiles of a row of tiles follow
+ * each other.  A row of micro tiles spans four rows of the linear layout,
+ * so y_stride keeps its usual meaning:
+ *
+ *   offset = (y & ~3) * y_stride +
+ *            ((x & ~3) * 4 + (y & 3) * 4 + (x & 3)) * bytes_per_texel
+ *
+ * Only formats with 1x1 blocks and a power of two size can be tiled.
+ */
+void
+lp_build_sample_offset_tiled(struct lp_build_context *bld,
+                             const struct util_format_description *format_desc,
+                             LLVMValueRef x,
+                             LLVMValueRef y,
+                             LLVMValueRef z,
+                             LLVMValueRef y_stride,
+                             LLVMValueRef z_stride,
+                             LLVMValueRef *out_offset,
+                             LLVMValueRef *out_i,
+                             LLVMValueRef *out_j)
+{
+   struct gallivm_state *gallivm = bld->gallivm;
+   unsigned texel_shift = util_logbase2(format_desc->block.bits / 8);
+   LLVMValueRef lo_mask = lp_build_const_int_vec(gallivm, bld->type, 3);
+   LLVMValueRef hi_mask = lp_build_const_int_vec(gallivm, bld->type, ~3);
+   LLVMValueRef x_lo, x_hi, offset;
+
+   assert(format_desc->block.width == 1);
+   assert(format_desc->block.height == 1);
+   assert(util_is_power_of_two(format_desc->block.bits / 8));
+
+   x_lo = lp_build_and(bld, x, lo_mask);
+   x_hi = lp_build_and(bld, x, hi_mask);
+   offset = lp_build_add(bld, lp_build_shl_imm(bld, x_hi, 2), x_lo);
+
+   if (y && y_stride) {
+      LLVMValueRef y_lo = lp_build_and(bld, y, lo_mask);
+      LLVMValueRef y_hi = lp_build_and(bld, y, hi_mask);
+      offset = lp_build_add(bld, offset, lp_build_shl_imm(bld, y_lo, 2));
+      offset = lp_build_shl_imm(bld, offset, texel_shift);
+      offset = lp_build_add(bld, offset, lp_build_mul(bld, y_hi, y_stride));
+   }
+   else {
+      offset = lp_build_shl_imm(bld, offset, texel_shift);
+   }
+
+   if (z && z_stride) {
+      offset = lp_build_add(bld, offset, lp_build_mul(bld, z, z_stride));
+   }
+
+   *out_offset = offset;
+   *out_i = bld->zero;
+   *out_j = bld->zero;
+}
+
+
+/**
+ * Record the texels about to be fetched from data_ptr + offset, offset
+ * being a vector of byte offsets, with lp_sampler_stats_record(), when the
+ * dynamic state asked for it.  This is a call to C per fetch, so it's only
+ * meant for profiling.
+ */
+void
+lp_build_sample_stats(struct lp_build_sample_context *bld,
+                      LLVMValueRef data_ptr,
+                      LLVMValueRef offset)
+{
+   struct gallivm_state *gallivm = bld->gallivm;
+   LLVMBuilderRef builder = gallivm->builder;
+   LLVMTypeRef i8_ptr_type;
+   LLVMTypeRef i32_type;
+   LLVMTypeRef offset_type;
+   LLVMTypeRef arg_types[5];
+   LLVMValueRef args[5];
+   LLVMValueRef offsets_ptr;
+   LLVMValueRef level;
+   LLVMValueRef function;
+   unsigned length = 1;
+
+   if (!bld->stats_ptr)
+      return;
+
+   i8_ptr_type = LLVMPointerType(LLVMInt8TypeInContext(gallivm->context), 0);
+   i32_type = LLVMInt32TypeInContext(gallivm->context);
+   offset_type = LLVMTypeOf(offset);
+
+   if (LLVMGetTypeKind(offset_type) == LLVMVectorTypeKind)
+      length = LLVMGetVectorSize(offset_type);
+
+   offsets_ptr = lp_build_alloca(gallivm, offset_type, "stats.offsets");
+   LLVMBuildStore(builder, offset, offsets_ptr);
+   offsets_ptr = LLVMBuildBitCast(builder, offsets_ptr,
+                                  LLVMPointerType(i32_type, 0), "");
+
+   /* With per quad or per pixel levels, attribute all to the first. */
+   level = bld->stats_level;
+   if (!level) {
+      level = lp_build_const_int32(gallivm, 0);
+   }
+   else if (LLVMGetTypeKind(LLVMTypeOf(level)) == LLVMVectorTypeKind) {
+      level = LLVMBuildExtractElement(builder, level,
+                                      lp_build_const_int32(gallivm, 0), "");
+   }
+
+   arg_types[0] = i8_ptr_type;
+   arg_types[1] = i8_ptr_type;
+   arg_types[2] = LLVMPointerType(i32_type, 0);
+   arg_types[3] = i32_type;
+   arg_types[4] = i32_type;
+
+   args[0] = LLVMBuildBitCast(builder, bld->stats_ptr, i8_ptr_type, "");
+   args[1] = LLVMBuildBitCast(builder, data_ptr, i8_ptr_type, "");
+   args[2] = offsets_ptr;
+   args[3] = lp_build_const_int32(gallivm, length);
+   args[4] = level;
+
+   function = lp_build_const_func_pointer(gallivm,
+                 func_to_pointer((func_pointer)lp_sampler_stats_record),
+                 LLVMVoidTypeInContext(gallivm->context),
+                 arg_types, Elements(arg_types),
+                 "lp_sampler_stats_record");
+
+   LLVMBuildCall(builder, function, args, Elements(args), "");
+}
+
+
+/**
+ * Account count texels at base + offsets[i], fetched from the given mip
+ * level, in stats.
+ *
+ * A texel (cache line) counts as redundant (not as a new cache line) if it
+ * is among the last LP_SAMPLER_STATS_WINDOW distinct texels (cache lines)
+ * fetched.  This approximates what stays in the L1 cache while sampling a
+ * 4x4 pixel block.
+ */
+void
+lp_sampler_stats_record(struct lp_sampler_stats *stats,
+                        const uint8_t *base,
+                        const int32_t *offsets,
+                        unsigned count,
+                        unsigned level)
+{
+   unsigned i, j;
+
+   stats->texels[MIN2(level, LP_SAMPLER_STATS_LEVELS - 1)] += count;
+
+   for (i = 0; i < count; ++i) {
+      const uint8_t *texel = base + offsets[i];
+      uintptr_t line = (uintptr_t)texel / LP_SAMPLER_STATS_LINE_SIZE;
+
+      for (j = 0; j < LP_SAMPLER_STATS_WINDOW; ++j) {
+         if (stats->recent_texels[j] == texel)
+            break;
+      }
+      if (j < LP_SAMPLER_STATS_WINDOW) {
+         stats->redundant++;
+      }
+      else {
+         stats->recent_texels[stats->next_texel] = texel;
+         stats->next_texel = (stats->next_texel + 1) % LP_SAMPLER_STATS_WINDOW;
+      }
+
+      for (j = 0; j < LP_SAMPLER_STATS_WINDOW; ++j) {
+         if (stats->recent_lines[j] == line)
+            break;
+      }
+      if (j == LP_SAMPLER_STATS_WINDOW) {
+         stats->cache_lines++;
+         stats->recent_lines[stats->next_line] = line;
+         stats->next_line = (stats->next_line + 1) % LP_SAMPLER_STATS_WINDOW;
+      }
+   }
+}
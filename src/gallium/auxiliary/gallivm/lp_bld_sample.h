@@ -89,6 +89,7 @@ struct lp_static_texture_state
    unsigned pot_height:1;
    unsigned pot_depth:1;
    unsigned level_zero_only:1;
+   unsigned tiled:1;         /**< texels stored in 4x4 micro tiles */
 };
 
 
@@ -115,6 +116,7 @@ struct lp_static_sampler_state
    unsigned apply_min_lod:1;  /**< min_lod > 0 ? */
    unsigned apply_max_lod:1;  /**< max_lod < last_level ? */
    unsigned seamless_cube_map:1;
+   unsigned texel_center_shortcut:1;  /**< skip filtering on texel centers */
 
    /* Hacks */
    unsigned force_nearest_s:1;
@@ -211,6 +213,44 @@ struct lp_sampler_dynamic_state
    LLVMValueRef
    (*border_color)(const struct lp_sampler_dynamic_state *state,
                    struct gallivm_state *gallivm, unsigned sampler_unit);
+
+   /**
+    * Optional.  Obtain pointer to the struct lp_sampler_stats texel fetches
+    * get recorded in (returns i8 pointer).  Fetches aren't recorded when
+    * this is NULL.
+    */
+   LLVMValueRef
+   (*stats_ptr)(const struct lp_sampler_dynamic_state *state,
+                struct gallivm_state *gallivm, unsigned texture_unit);
+};
+
+
+#define LP_SAMPLER_STATS_LEVELS 4
+
+/** Number of distinct texels and cache lines which count as recent */
+#define LP_SAMPLER_STATS_WINDOW 64
+
+#define LP_SAMPLER_STATS_LINE_SIZE 64
+
+
+/**
+ * Texel fetch statistics, see lp_sampler_stats_record().
+ */
+struct lp_sampler_stats
+{
+   /** Texels fetched from mip levels 0, 1, 2, and 3 or higher */
+   uint64_t texels[LP_SAMPLER_STATS_LEVELS];
+
+   /** Cache lines touched which weren't recently */
+   uint64_t cache_lines;
+
+   /** Texels fetched again while still recent */
+   uint64_t redundant;
+
+   const uint8_t *recent_texels[LP_SAMPLER_STATS_WINDOW];
+   uintptr_t recent_lines[LP_SAMPLER_STATS_WINDOW];
+   unsigned next_texel;
+   unsigned next_line;
 };
 
 
@@ -305,6 +345,12 @@ struct lp_build_sample_context
    LLVMValueRef int_size;
 
    LLVMValueRef border_color_clamped;
+
+   /** Where to record texel fetches, or NULL (see lp_build_sample_stats) */
+   LLVMValueRef stats_ptr;
+
+   /** Mip level of the texels being fetched, for stats_ptr */
+   LLVMValueRef stats_level;
 };
 
 
@@ -498,6 +544,19 @@ lp_build_sample_offset(struct lp_build_context *bld,
                        LLVMValueRef *out_j);
 
 
+void
+lp_build_sample_offset_tiled(struct lp_build_context *bld,
+                             const struct util_format_description *format_desc,
+                             LLVMValueRef x,
+                             LLVMValueRef y,
+                             LLVMValueRef z,
+                             LLVMValueRef y_stride,
+                             LLVMValueRef z_stride,
+                             LLVMValueRef *out_offset,
+                             LLVMValueRef *out_i,
+                             LLVMValueRef *out_j);
+
+
 void
 lp_build_sample_soa(struct gallivm_state *gallivm,
                     const struct lp_static_texture_state *static_texture_state,
@@ -551,4 +610,18 @@ lp_build_minify(struct lp_build_context *bld,
                 boolean lod_scalar);
 
 
+void
+lp_build_sample_stats(struct lp_build_sample_context *bld,
+                      LLVMValueRef data_ptr,
+                      LLVMValueRef offset);
+
+
+void
+lp_sampler_stats_record(struct lp_sampler_stats *stats,
+                        const uint8_t *base,
+                        const int32_t *offsets,
+                        unsigned count,
+                        unsigned level);
+
+
 #endif /* LP_BLD_SAMPLE_H */
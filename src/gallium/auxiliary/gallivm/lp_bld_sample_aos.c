@@ -486,6 +486,49 @@ lp_build_sample_wrap_linear_float(struct lp_build_sample_context *bld,
 }
 
 
+/**
+ * Fetch one texel per pixel as 8-bit unorm, in the order the texels are
+ * stored in for rgba8 formats (they get swizzled later), RGBA otherwise.
+ */
+static LLVMValueRef
+lp_build_sample_fetch_rgba8(struct lp_build_sample_context *bld,
+                            struct lp_build_context *u8n,
+                            LLVMValueRef data_ptr,
+                            LLVMValueRef offset,
+                            LLVMValueRef x_subcoord,
+                            LLVMValueRef y_subcoord)
+{
+   LLVMValueRef rgba8;
+
+   lp_build_sample_stats(bld, data_ptr, offset);
+
+   if (util_format_is_rgba8_variant(bld->format_desc)) {
+      /*
+       * Given the format is a rgba8, just read the pixels as is,
+       * without any swizzling. Swizzling will be done later.
+       */
+      rgba8 = lp_build_gather(bld->gallivm,
+                              bld->texel_type.length,
+                              bld->format_desc->block.bits,
+                              bld->texel_type.width,
+                              data_ptr, offset, TRUE);
+
+      rgba8 = LLVMBuildBitCast(bld->gallivm->builder, rgba8,
+                               u8n->vec_type, "");
+   }
+   else {
+      rgba8 = lp_build_fetch_rgba_aos(bld->gallivm,
+                                      bld->format_desc,
+                                      u8n->type,
+                                      data_ptr, offset,
+                                      x_subcoord,
+                                      y_subcoord);
+   }
+
+   return rgba8;
+}
+
+
 /**
  * Fetch texels for image with nearest sampling.
  * Return filtered color as two vectors of 16-bit fixed point values.
@@ -514,37 +557,12 @@ lp_build_sample_fetch_image_nearest(struct lp_build_sample_context *bld,
     *
     * The higher 8 bits of the resulting elements will be zero.
     */
-   LLVMBuilderRef builder = bld->gallivm->builder;
-   LLVMValueRef rgba8;
    struct lp_build_context u8n;
-   LLVMTypeRef u8n_vec_type;
 
    lp_build_context_init(&u8n, bld->gallivm, lp_type_unorm(8, bld->vector_width));
-   u8n_vec_type = lp_build_vec_type(bld->gallivm, u8n.type);
-
-   if (util_format_is_rgba8_variant(bld->format_desc)) {
-      /*
-       * Given the format is a rgba8, just read the pixels as is,
-       * without any swizzling. Swizzling will be done later.
-       */
-      rgba8 = lp_build_gather(bld->gallivm,
-                              bld->texel_type.length,
-                              bld->format_desc->block.bits,
-                              bld->texel_type.width,
-                              data_ptr, offset, TRUE);
 
-      rgba8 = LLVMBuildBitCast(builder, rgba8, u8n_vec_type, "");
-   }
-   else {
-      rgba8 = lp_build_fetch_rgba_aos(bld->gallivm,
-                                      bld->format_desc,
-                                      u8n.type,
-                                      data_ptr, offset,
-                                      x_subcoord,
-                                      y_subcoord);
-   }
-
-   *colors = rgba8;
+   *colors = lp_build_sample_fetch_rgba8(bld, &u8n, data_ptr, offset,
+                                         x_subcoord, y_subcoord);
 }
 
 
@@ -807,13 +825,41 @@ lp_build_sample_fetch_image_linear(struct lp_build_sample_context *bld,
    LLVMValueRef shuffles[LP_MAX_VECTOR_LENGTH];
    LLVMValueRef shuffle;
    LLVMValueRef neighbors[2][2][2]; /* [z][y][x] */
-   LLVMValueRef packed;
+   LLVMValueRef packed, packed_var = NULL;
+   LLVMValueRef weights = NULL;
+   struct lp_build_if_state if_ctx;
    unsigned i, j, k;
    unsigned numj, numk;
 
    lp_build_context_init(&u8n, bld->gallivm, lp_type_unorm(8, bld->vector_width));
    u8n_vec_type = lp_build_vec_type(bld->gallivm, u8n.type);
 
+   /*
+    * Magnifying by exactly 1:1 with the sample points on texel centers,
+    * as full screen post-processing passes do, gives all zero weights.
+    * If the sampler asks for it and that's the case for all pixels, only
+    * fetch one texel each.
+    */
+   if (bld->static_sampler_state->texel_center_shortcut) {
+      if (!bld->static_sampler_state->force_nearest_s)
+         weights = s_fpart;
+      if (dims >= 2 && !bld->static_sampler_state->force_nearest_t)
+         weights = weights ? LLVMBuildOr(builder, weights, t_fpart, "") : t_fpart;
+      if (dims >= 3)
+         weights = LLVMBuildOr(builder, weights, r_fpart, "");
+   }
+
+   if (weights) {
+      LLVMValueRef need_lerp;
+
+      need_lerp = lp_build_any_true_range(&bld->int_coord_bld,
+                                          bld->int_coord_bld.type.length,
+                                          weights);
+      packed_var = lp_build_alloca(bld->gallivm, u8n_vec_type, "packed_var");
+
+      lp_build_if(&if_ctx, bld->gallivm, need_lerp);
+   }
+
    /*
     * Transform 4 x i32 in
     *
@@ -882,31 +928,10 @@ lp_build_sample_fetch_image_linear(struct lp_build_sample_context *bld,
    for (k = 0; k < numk; k++) {
       for (j = 0; j < numj; j++) {
          for (i = 0; i < 2; i++) {
-            LLVMValueRef rgba8;
-
-            if (util_format_is_rgba8_variant(bld->format_desc)) {
-               /*
-                * Given the format is a rgba8, just read the pixels as is,
-                * without any swizzling. Swizzling will be done later.
-                */
-               rgba8 = lp_build_gather(bld->gallivm,
-                                       bld->texel_type.length,
-                                       bld->format_desc->block.bits,
-                                       bld->texel_type.width,
-                                       data_ptr, offset[k][j][i], TRUE);
-
-               rgba8 = LLVMBuildBitCast(builder, rgba8, u8n_vec_type, "");
-            }
-            else {
-               rgba8 = lp_build_fetch_rgba_aos(bld->gallivm,
-                                               bld->format_desc,
-                                               u8n.type,
-                                               data_ptr, offset[k][j][i],
-                                               x_subcoord[i],
-                                               y_subcoord[j]);
-            }
-
-            neighbors[k][j][i] = rgba8;
+            neighbors[k][j][i] =
+               lp_build_sample_fetch_rgba8(bld, &u8n, data_ptr,
+                                           offset[k][j][i],
+                                           x_subcoord[i], y_subcoord[j]);
          }
       }
    }
@@ -964,6 +989,21 @@ lp_build_sample_fetch_image_linear(struct lp_build_sample_context *bld,
       }
    }
 
+   if (weights) {
+      LLVMBuildStore(builder, packed, packed_var);
+
+      lp_build_else(&if_ctx);
+
+      packed = lp_build_sample_fetch_rgba8(bld, &u8n, data_ptr,
+                                           offset[0][0][0],
+                                           x_subcoord[0], y_subcoord[0]);
+      LLVMBuildStore(builder, packed, packed_var);
+
+      lp_build_endif(&if_ctx);
+
+      packed = LLVMBuildLoad(builder, packed_var, "");
+   }
+
    *colors = packed;
 }
 
@@ -1370,6 +1410,7 @@ lp_build_sample_mipmap(struct lp_build_sample_context *bld,
    LLVMValueRef colors1;
 
    /* sample the first mipmap level */
+   bld->stats_level = ilevel0;
    lp_build_mipmap_level_sizes(bld, ilevel0,
                                &size0,
                                &row_stride0_vec, &img_stride0_vec);
@@ -1462,6 +1503,7 @@ lp_build_sample_mipmap(struct lp_build_sample_context *bld,
          lp_build_context_init(&u8n_bld, bld->gallivm, lp_type_unorm(8, bld->vector_width));
 
          /* sample the second mipmap level */
+         bld->stats_level = ilevel1;
          lp_build_mipmap_level_sizes(bld, ilevel1,
                                      &size1,
                                      &row_stride1_vec, &img_stride1_vec);
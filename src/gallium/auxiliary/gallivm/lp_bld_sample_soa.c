@@ -136,10 +136,18 @@ lp_build_sample_texel_soa(struct lp_build_sample_context *bld,
    }
 
    /* convert x,y,z coords to linear offset from start of texture, in bytes */
-   lp_build_sample_offset(&bld->int_coord_bld,
-                          bld->format_desc,
-                          x, y, z, y_stride, z_stride,
-                          &offset, &i, &j);
+   if (bld->static_texture_state->tiled) {
+      lp_build_sample_offset_tiled(&bld->int_coord_bld,
+                                   bld->format_desc,
+                                   x, y, z, y_stride, z_stride,
+                                   &offset, &i, &j);
+   }
+   else {
+      lp_build_sample_offset(&bld->int_coord_bld,
+                             bld->format_desc,
+                             x, y, z, y_stride, z_stride,
+                             &offset, &i, &j);
+   }
    if (mipoffsets) {
       offset = lp_build_add(&bld->int_coord_bld, offset, mipoffsets);
    }
@@ -156,6 +164,8 @@ lp_build_sample_texel_soa(struct lp_build_sample_context *bld,
       offset = lp_build_andnot(&bld->int_coord_bld, offset, use_border);
    }
 
+   lp_build_sample_stats(bld, data_ptr, offset);
+
    lp_build_fetch_rgba_soa(bld->gallivm,
                            bld->format_desc,
                            bld->texel_type,
@@ -822,6 +832,30 @@ lp_build_masklerp2d(struct lp_build_context *bld,
    return lp_build_lerp(bld, weight1, val0, val1, 0);
 }
 
+/**
+ * Return a mask of the pixels whose filter weight is within the 8 bits of
+ * subtexel precision of the AoS path of 0 or 1, i.e. whose sample point is
+ * on a texel center along this axis.  use_second is set for the ones where
+ * that's the second texel.
+ */
+static LLVMValueRef
+lp_build_sample_on_texel_center(struct lp_build_sample_context *bld,
+                                LLVMValueRef fpart,
+                                LLVMValueRef *use_second)
+{
+   struct lp_build_context *coord_bld = &bld->coord_bld;
+   LLVMValueRef lo, hi;
+
+   lo = lp_build_cmp(coord_bld, PIPE_FUNC_LESS, fpart,
+                     lp_build_const_vec(bld->gallivm, coord_bld->type,
+                                        1.0 / 512.0));
+   hi = lp_build_cmp(coord_bld, PIPE_FUNC_GREATER, fpart,
+                     lp_build_const_vec(bld->gallivm, coord_bld->type,
+                                        1.0 - 1.0 / 512.0));
+   *use_second = hi;
+   return lp_build_or(&bld->int_coord_bld, lo, hi);
+}
+
 /*
  * this is a bit excessive code for something OpenGL just recommends
  * but does not require.
@@ -865,12 +899,23 @@ lp_build_sample_image_linear(struct lp_build_sample_context *bld,
    LLVMValueRef s_fpart, t_fpart = NULL, r_fpart = NULL;
    LLVMValueRef xs[4], ys[4], zs[4];
    LLVMValueRef neighbors[2][2][4];
+   LLVMValueRef texels[4], s_second = NULL, t_second = NULL;
+   struct lp_build_if_state center_if;
    int chan, texel_index;
-   boolean seamless_cube_filter, accurate_cube_corners;
+   boolean seamless_cube_filter, accurate_cube_corners, try_texel_center;
 
    seamless_cube_filter = bld->static_texture_state->target == PIPE_TEXTURE_CUBE &&
                           bld->static_sampler_state->seamless_cube_map;
    accurate_cube_corners = ACCURATE_CUBE_CORNERS && seamless_cube_filter;
+   /*
+    * Snapping to the nearest texel is only invisible when the result is
+    * going to be 8 bit unorm anyway, so leave other formats alone.  It
+    * still changes results slightly, so it has to be asked for.
+    */
+   try_texel_center = bld->static_sampler_state->texel_center_shortcut &&
+                      !seamless_cube_filter && !linear_mask && dims <= 2 &&
+                      bld->static_sampler_state->compare_mode == PIPE_TEX_COMPARE_NONE &&
+                      util_format_fits_8unorm(bld->format_desc);
 
    lp_build_extract_image_sizes(bld,
                                 &bld->int_size_bld,
@@ -1117,6 +1162,32 @@ lp_build_sample_image_linear(struct lp_build_sample_context *bld,
       }
    }
 
+   if (try_texel_center) {
+      /*
+       * Magnifying by exactly 1:1 with the sample points on texel centers,
+       * as full screen post-processing passes do, needs no filtering at
+       * all. If that's the case for all pixels only fetch one texel each.
+       */
+      LLVMValueRef on_center, off_center;
+
+      on_center = lp_build_sample_on_texel_center(bld, s_fpart, &s_second);
+      if (dims == 2) {
+         on_center = lp_build_and(ivec_bld, on_center,
+                                  lp_build_sample_on_texel_center(bld, t_fpart,
+                                                                  &t_second));
+      }
+      off_center = lp_build_not(ivec_bld, on_center);
+      off_center = lp_build_any_true_range(ivec_bld, ivec_bld->type.length,
+                                           off_center);
+
+      for (chan = 0; chan < 4; chan++) {
+         texels[chan] = lp_build_alloca(bld->gallivm, bld->texel_bld.vec_type,
+                                        "texel");
+      }
+
+      lp_build_if(&center_if, bld->gallivm, off_center);
+   }
+
    /*
     * Get texture colors.
     */
@@ -1378,6 +1449,36 @@ lp_build_sample_image_linear(struct lp_build_sample_context *bld,
          }
       }
    }
+
+   if (try_texel_center) {
+      LLVMValueRef x, y = NULL;
+
+      for (chan = 0; chan < 4; chan++) {
+         LLVMBuildStore(builder, colors_out[chan], texels[chan]);
+      }
+
+      lp_build_else(&center_if);
+
+      x = lp_build_select(ivec_bld, s_second, x01, x00);
+      if (dims == 2) {
+         y = lp_build_select(ivec_bld, t_second, y10, y00);
+      }
+      lp_build_sample_texel_soa(bld,
+                                width_vec, height_vec, depth_vec,
+                                x, y, z00,
+                                row_stride_vec, img_stride_vec,
+                                data_ptr, mipoffsets, colors_out);
+
+      for (chan = 0; chan < 4; chan++) {
+         LLVMBuildStore(builder, colors_out[chan], texels[chan]);
+      }
+
+      lp_build_endif(&center_if);
+
+      for (chan = 0; chan < 4; chan++) {
+         colors_out[chan] = LLVMBuildLoad(builder, texels[chan], "");
+      }
+   }
 }
 
 
@@ -1413,6 +1514,7 @@ lp_build_sample_mipmap(struct lp_build_sample_context *bld,
    unsigned chan;
 
    /* sample the first mipmap level */
+   bld->stats_level = ilevel0;
    lp_build_mipmap_level_sizes(bld, ilevel0,
                                &size0,
                                &row_stride0_vec, &img_stride0_vec);
@@ -1476,6 +1578,7 @@ lp_build_sample_mipmap(struct lp_build_sample_context *bld,
          lod_fpart = lp_build_max(&bld->lodf_bld, lod_fpart,
                                   bld->lodf_bld.zero);
          /* sample the second mipmap level */
+         bld->stats_level = ilevel1;
          lp_build_mipmap_level_sizes(bld, ilevel1,
                                      &size1,
                                      &row_stride1_vec, &img_stride1_vec);
@@ -1555,6 +1658,7 @@ lp_build_sample_mipmap_both(struct lp_build_sample_context *bld,
    unsigned chan;
 
    /* sample the first mipmap level */
+   bld->stats_level = ilevel0;
    lp_build_mipmap_level_sizes(bld, ilevel0,
                                &size0,
                                &row_stride0_vec, &img_stride0_vec);
@@ -1600,6 +1704,7 @@ lp_build_sample_mipmap_both(struct lp_build_sample_context *bld,
          lod_fpart = lp_build_max(&bld->lodf_bld, lod_fpart,
                                   bld->lodf_bld.zero);
          /* sample the second mipmap level */
+         bld->stats_level = ilevel1;
          lp_build_mipmap_level_sizes(bld, ilevel1,
                                      &size1,
                                      &row_stride1_vec, &img_stride1_vec);
@@ -2224,6 +2329,7 @@ lp_build_fetch_texel(struct lp_build_sample_context *bld,
          ilevel = lp_build_const_int32(bld->gallivm, 0);
       }
    }
+   bld->stats_level = ilevel;
    lp_build_mipmap_level_sizes(bld, ilevel,
                                &size,
                                &row_stride_vec, &img_stride_vec);
@@ -2274,10 +2380,18 @@ lp_build_fetch_texel(struct lp_build_sample_context *bld,
       }
    }
 
-   lp_build_sample_offset(int_coord_bld,
-                          bld->format_desc,
-                          x, y, z, row_stride_vec, img_stride_vec,
-                          &offset, &i, &j);
+   if (bld->static_texture_state->tiled) {
+      lp_build_sample_offset_tiled(int_coord_bld,
+                                   bld->format_desc,
+                                   x, y, z, row_stride_vec, img_stride_vec,
+                                   &offset, &i, &j);
+   }
+   else {
+      lp_build_sample_offset(int_coord_bld,
+                             bld->format_desc,
+                             x, y, z, row_stride_vec, img_stride_vec,
+                             &offset, &i, &j);
+   }
 
    if (bld->static_texture_state->target != PIPE_BUFFER) {
       offset = lp_build_add(int_coord_bld, offset,
@@ -2554,6 +2668,9 @@ lp_build_sample_soa(struct gallivm_state *gallivm,
    bld.base_ptr = dynamic_state->base_ptr(dynamic_state, gallivm, texture_index);
    bld.mip_offsets = dynamic_state->mip_offsets(dynamic_state, gallivm, texture_index);
    /* Note that mip_offsets is an array[level] of offsets to texture images */
+   if (dynamic_state->stats_ptr) {
+      bld.stats_ptr = dynamic_state->stats_ptr(dynamic_state, gallivm, texture_index);
+   }
 
    /* width, height, depth as single int vector */
    if (dims <= 1) {
@@ -2618,6 +2735,10 @@ lp_build_sample_soa(struct gallivm_state *gallivm,
          /* theoretically possible with AoS filtering but not implemented (complex!) */
          use_aos = 0;
       }
+      if (static_texture_state->tiled) {
+         /* the AoS path computes offsets assuming the linear layout */
+         use_aos = 0;
+      }
 
       if ((gallivm_debug & GALLIVM_DEBUG_PERF) &&
           !use_aos && util_format_fits_8unorm(bld.format_desc)) {
@@ -2689,6 +2810,7 @@ lp_build_sample_soa(struct gallivm_state *gallivm,
          bld4.base_ptr = bld.base_ptr;
          bld4.mip_offsets = bld.mip_offsets;
          bld4.int_size = bld.int_size;
+         bld4.stats_ptr = bld.stats_ptr;
 
          bld4.vector_width = lp_type_width(type4);
 
@@ -300,6 +300,9 @@ def emit_init():
     print '  if (!firsttime) return;'
     print '  firsttime = 0;'
     emit_all_inits()
+    print '#if defined(PIPE_ARCH_SSE)'
+    print '  u_index_init_sse2(translate);'
+    print '#endif'
     print '}'
 
 
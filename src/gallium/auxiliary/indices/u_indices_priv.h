@@ -26,6 +26,7 @@
 #define U_INDICES_PRIV_H
 
 #include "pipe/p_compiler.h"
+#include "pipe/p_defines.h"
 #include "u_indices.h"
 
 #define IN_UBYTE      0
@@ -40,4 +41,9 @@
 
 #define PRIM_COUNT   (PIPE_PRIM_POLYGON + 1)
 
+
+#if defined(PIPE_ARCH_SSE)
+void u_index_init_sse2( u_translate_func translate[IN_COUNT][OUT_COUNT][PV_COUNT][PV_COUNT][PRIM_COUNT] );
+#endif
+
 #endif
@@ -0,0 +1,362 @@
+/*
+ * Copyright 2014 VMware, Inc.
+ * All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * on the rights to use, copy, modify, merge, publish, distribute, sub
+ * license, and/or sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.  IN NO EVENT SHALL
+ * VMWARE AND/OR THEIR SUPPLIERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * @file
+ * SSE2 versions of the most frequently used index translators.
+ *
+ * The generated translators in u_indices_gen.c handle every combination of
+ * primitive, index size and provoking vertex convention one index at a time.
+ * The functions here cover the common cases where the provoking vertex
+ * convention is unchanged: widening of ubyte indices to ushort, and the
+ * decomposition of quads, quad strips and triangle strips into triangle
+ * lists.  Indices are handled as four 32-bit lanes, so the same shuffles
+ * serve all index sizes.
+ *
+ * The functions must produce exactly the same output as the generated ones,
+ * including writing points/lines/triangles at out + start.
+ */
+
+#include "pipe/p_config.h"
+
+#if defined(PIPE_ARCH_SSE)
+
+#include "pipe/p_compiler.h"
+#include "util/u_cpu_detect.h"
+#include "util/u_debug.h"
+#include "util/u_sse.h"
+#include "u_indices.h"
+#include "u_indices_priv.h"
+
+
+static INLINE __m128i
+load4(const void *in, unsigned i, unsigned in_size)
+{
+   const __m128i zero = _mm_setzero_si128();
+   __m128i v;
+
+   switch (in_size) {
+   case 1:
+      {
+         int bytes;
+         memcpy(&bytes, (const ubyte *)in + i, 4);
+         v = _mm_cvtsi32_si128(bytes);
+         v = _mm_unpacklo_epi8(v, zero);
+         return _mm_unpacklo_epi16(v, zero);
+      }
+   case 2:
+      v = _mm_loadl_epi64((const __m128i *)((const ushort *)in + i));
+      return _mm_unpacklo_epi16(v, zero);
+   default:
+      return _mm_loadu_si128((const __m128i *)((const uint *)in + i));
+   }
+}
+
+
+static INLINE void
+store4(void *out, unsigned j, __m128i v, unsigned out_size)
+{
+   if (out_size == 2) {
+      /* Values fit in 16 bits; sign-extend them so that the signed
+       * saturating pack leaves the bit pattern untouched.
+       */
+      v = _mm_srai_epi32(_mm_slli_epi32(v, 16), 16);
+      v = _mm_packs_epi32(v, v);
+      _mm_storel_epi64((__m128i *)((ushort *)out + j), v);
+   }
+   else {
+      _mm_storeu_si128((__m128i *)((uint *)out + j), v);
+   }
+}
+
+
+static INLINE uint
+load1(const void *in, unsigned i, unsigned in_size)
+{
+   switch (in_size) {
+   case 1:
+      return ((const ubyte *)in)[i];
+   case 2:
+      return ((const ushort *)in)[i];
+   default:
+      return ((const uint *)in)[i];
+   }
+}
+
+
+static INLINE void
+store1(void *out, unsigned j, uint v, unsigned out_size)
+{
+   if (out_size == 2)
+      ((ushort *)out)[j] = (ushort)v;
+   else
+      ((uint *)out)[j] = v;
+}
+
+
+static INLINE __m128i
+shuffle2(__m128i a, __m128i b, int imm)
+{
+   return _mm_castps_si128(_mm_shuffle_ps(_mm_castsi128_ps(a),
+                                          _mm_castsi128_ps(b), imm));
+}
+
+
+/**
+ * Quads to triangles, keeping the provoking vertex: each quad
+ * (v0, v1, v2, v3) becomes (v0, v1, v3), (v1, v2, v3).
+ */
+static INLINE void
+quads_sse2(const void *in, unsigned start, unsigned nr, void *out,
+           unsigned in_size, unsigned out_size)
+{
+   unsigned nr_quads = (nr + 5) / 6;
+   unsigned i = start, j = 0, q = 0;
+
+   for (; q + 2 <= nr_quads; q += 2, i += 8, j += 12) {
+      __m128i q0 = load4(in, i, in_size);
+      __m128i q1 = load4(in, i + 4, in_size);
+      store4(out, j + 0, _mm_shuffle_epi32(q0, _MM_SHUFFLE(1, 3, 1, 0)), out_size);
+      store4(out, j + 4, shuffle2(q0, q1, _MM_SHUFFLE(1, 0, 3, 2)), out_size);
+      store4(out, j + 8, _mm_shuffle_epi32(q1, _MM_SHUFFLE(3, 2, 1, 3)), out_size);
+   }
+
+   for (; q < nr_quads; q++, i += 4, j += 6) {
+      store1(out, j + 0, load1(in, i + 0, in_size), out_size);
+      store1(out, j + 1, load1(in, i + 1, in_size), out_size);
+      store1(out, j + 2, load1(in, i + 3, in_size), out_size);
+      store1(out, j + 3, load1(in, i + 1, in_size), out_size);
+      store1(out, j + 4, load1(in, i + 2, in_size), out_size);
+      store1(out, j + 5, load1(in, i + 3, in_size), out_size);
+   }
+}
+
+
+/**
+ * Quad strip to triangles, keeping the provoking vertex: the quad starting
+ * at vertex i becomes (i+2, i, i+3), (i, i+1, i+3).
+ */
+static INLINE void
+quadstrip_sse2(const void *in, unsigned start, unsigned nr, void *out,
+               unsigned in_size, unsigned out_size)
+{
+   unsigned nr_quads = (nr + 5) / 6;
+   unsigned i = start, j = 0, q = 0;
+
+   for (; q + 2 <= nr_quads; q += 2, i += 4, j += 12) {
+      __m128i v0 = load4(in, i, in_size);
+      __m128i v1 = load4(in, i + 2, in_size);
+      store4(out, j + 0, _mm_shuffle_epi32(v0, _MM_SHUFFLE(0, 3, 0, 2)), out_size);
+      store4(out, j + 4, shuffle2(v0, v1, _MM_SHUFFLE(0, 2, 3, 1)), out_size);
+      store4(out, j + 8, _mm_shuffle_epi32(v1, _MM_SHUFFLE(3, 1, 0, 3)), out_size);
+   }
+
+   for (; q < nr_quads; q++, i += 2, j += 6) {
+      store1(out, j + 0, load1(in, i + 2, in_size), out_size);
+      store1(out, j + 1, load1(in, i + 0, in_size), out_size);
+      store1(out, j + 2, load1(in, i + 3, in_size), out_size);
+      store1(out, j + 3, load1(in, i + 0, in_size), out_size);
+      store1(out, j + 4, load1(in, i + 1, in_size), out_size);
+      store1(out, j + 5, load1(in, i + 3, in_size), out_size);
+   }
+}
+
+
+/**
+ * Triangle strip to triangles, keeping the provoking vertex.  The winding
+ * of odd triangles is fixed up by swapping the two non-provoking vertices.
+ * The parity is that of the absolute vertex number, so an odd start is
+ * handled by emitting the first triangle on its own.
+ */
+static INLINE void
+tristrip_sse2(const void *in, unsigned start, unsigned nr, void *out,
+              unsigned in_size, unsigned out_size, unsigned pv)
+{
+   unsigned nr_tris = (nr + 2) / 3;
+   unsigned i = start, j = 0, t = 0;
+
+   for (; t < nr_tris; t++, i++, j += 3) {
+      if ((i & 1) == 0 && t + 4 <= nr_tris)
+         break;
+      if (pv == PV_FIRST) {
+         store1(out, j + 0, load1(in, i, in_size), out_size);
+         store1(out, j + 1, load1(in, i + 1 + (i & 1), in_size), out_size);
+         store1(out, j + 2, load1(in, i + 2 - (i & 1), in_size), out_size);
+      }
+      else {
+         store1(out, j + 0, load1(in, i + (i & 1), in_size), out_size);
+         store1(out, j + 1, load1(in, i + 1 - (i & 1), in_size), out_size);
+         store1(out, j + 2, load1(in, i + 2, in_size), out_size);
+      }
+   }
+
+   for (; t + 4 <= nr_tris; t += 4, i += 4, j += 12) {
+      __m128i v0 = load4(in, i, in_size);
+      __m128i v1 = load4(in, i + 2, in_size);
+      if (pv == PV_FIRST) {
+         store4(out, j + 0, _mm_shuffle_epi32(v0, _MM_SHUFFLE(1, 2, 1, 0)), out_size);
+         store4(out, j + 4, _mm_shuffle_epi32(v0, _MM_SHUFFLE(3, 2, 2, 3)), out_size);
+         store4(out, j + 8, _mm_shuffle_epi32(v1, _MM_SHUFFLE(2, 3, 1, 2)), out_size);
+      }
+      else {
+         store4(out, j + 0, _mm_shuffle_epi32(v0, _MM_SHUFFLE(2, 2, 1, 0)), out_size);
+         store4(out, j + 4, _mm_shuffle_epi32(v0, _MM_SHUFFLE(3, 2, 3, 1)), out_size);
+         store4(out, j + 8, _mm_shuffle_epi32(v1, _MM_SHUFFLE(3, 1, 2, 2)), out_size);
+      }
+   }
+
+   for (; t < nr_tris; t++, i++, j += 3) {
+      if (pv == PV_FIRST) {
+         store1(out, j + 0, load1(in, i, in_size), out_size);
+         store1(out, j + 1, load1(in, i + 1 + (i & 1), in_size), out_size);
+         store1(out, j + 2, load1(in, i + 2 - (i & 1), in_size), out_size);
+      }
+      else {
+         store1(out, j + 0, load1(in, i + (i & 1), in_size), out_size);
+         store1(out, j + 1, load1(in, i + 1 - (i & 1), in_size), out_size);
+         store1(out, j + 2, load1(in, i + 2, in_size), out_size);
+      }
+   }
+}
+
+
+/**
+ * Widen ubyte indices to ushort for points, lines and triangles.  Like the
+ * generated code, whole primitives are converted and the output is written
+ * at out + start.
+ */
+static INLINE void
+widen_ubyte_sse2(const void *_in, unsigned start, unsigned nr, void *_out,
+                 unsigned verts_per_prim)
+{
+   const ubyte *in = (const ubyte *)_in + start;
+   ushort *out = (ushort *)_out + start;
+   const __m128i zero = _mm_setzero_si128();
+   unsigned count = (nr + verts_per_prim - 1) / verts_per_prim * verts_per_prim;
+   unsigned i = 0;
+
+   for (; i + 16 <= count; i += 16) {
+      __m128i v = _mm_loadu_si128((const __m128i *)(in + i));
+      _mm_storeu_si128((__m128i *)(out + i), _mm_unpacklo_epi8(v, zero));
+      _mm_storeu_si128((__m128i *)(out + i + 8), _mm_unpackhi_epi8(v, zero));
+   }
+
+   for (; i < count; i++)
+      out[i] = in[i];
+}
+
+
+#define TRANSLATE_FUNC(name, body)                                    \
+static void name( const void *in, unsigned start, unsigned nr,        \
+                  void *out )                                         \
+{                                                                     \
+   body;                                                              \
+}
+
+TRANSLATE_FUNC(translate_points_ubyte2ushort_sse2,
+               widen_ubyte_sse2(in, start, nr, out, 1))
+TRANSLATE_FUNC(translate_lines_ubyte2ushort_sse2,
+               widen_ubyte_sse2(in, start, nr, out, 2))
+TRANSLATE_FUNC(translate_tris_ubyte2ushort_sse2,
+               widen_ubyte_sse2(in, start, nr, out, 3))
+
+TRANSLATE_FUNC(translate_quads_ubyte2ushort_sse2,
+               quads_sse2(in, start, nr, out, 1, 2))
+TRANSLATE_FUNC(translate_quads_ushort2ushort_sse2,
+               quads_sse2(in, start, nr, out, 2, 2))
+TRANSLATE_FUNC(translate_quads_uint2uint_sse2,
+               quads_sse2(in, start, nr, out, 4, 4))
+
+TRANSLATE_FUNC(translate_quadstrip_ubyte2ushort_sse2,
+               quadstrip_sse2(in, start, nr, out, 1, 2))
+TRANSLATE_FUNC(translate_quadstrip_ushort2ushort_sse2,
+               quadstrip_sse2(in, start, nr, out, 2, 2))
+TRANSLATE_FUNC(translate_quadstrip_uint2uint_sse2,
+               quadstrip_sse2(in, start, nr, out, 4, 4))
+
+TRANSLATE_FUNC(translate_tristrip_ubyte2ushort_first2first_sse2,
+               tristrip_sse2(in, start, nr, out, 1, 2, PV_FIRST))
+TRANSLATE_FUNC(translate_tristrip_ushort2ushort_first2first_sse2,
+               tristrip_sse2(in, start, nr, out, 2, 2, PV_FIRST))
+TRANSLATE_FUNC(translate_tristrip_uint2uint_first2first_sse2,
+               tristrip_sse2(in, start, nr, out, 4, 4, PV_FIRST))
+TRANSLATE_FUNC(translate_tristrip_ubyte2ushort_last2last_sse2,
+               tristrip_sse2(in, start, nr, out, 1, 2, PV_LAST))
+TRANSLATE_FUNC(translate_tristrip_ushort2ushort_last2last_sse2,
+               tristrip_sse2(in, start, nr, out, 2, 2, PV_LAST))
+TRANSLATE_FUNC(translate_tristrip_uint2uint_last2last_sse2,
+               tristrip_sse2(in, start, nr, out, 4, 4, PV_LAST))
+
+
+/**
+ * Replace entries of the generated translate table with the SSE2 versions
+ * above, when the CPU supports them.
+ */
+void
+u_index_init_sse2( u_translate_func translate[IN_COUNT][OUT_COUNT][PV_COUNT][PV_COUNT][PRIM_COUNT] )
+{
+   unsigned pv;
+
+   util_cpu_detect();
+   if (!util_cpu_caps.has_sse2)
+      return;
+
+   for (pv = 0; pv < PV_COUNT; pv++) {
+      translate[IN_UBYTE][OUT_USHORT][pv][pv][PIPE_PRIM_POINTS] =
+         translate_points_ubyte2ushort_sse2;
+      translate[IN_UBYTE][OUT_USHORT][pv][pv][PIPE_PRIM_LINES] =
+         translate_lines_ubyte2ushort_sse2;
+      translate[IN_UBYTE][OUT_USHORT][pv][pv][PIPE_PRIM_TRIANGLES] =
+         translate_tris_ubyte2ushort_sse2;
+
+      translate[IN_UBYTE][OUT_USHORT][pv][pv][PIPE_PRIM_QUADS] =
+         translate_quads_ubyte2ushort_sse2;
+      translate[IN_USHORT][OUT_USHORT][pv][pv][PIPE_PRIM_QUADS] =
+         translate_quads_ushort2ushort_sse2;
+      translate[IN_UINT][OUT_UINT][pv][pv][PIPE_PRIM_QUADS] =
+         translate_quads_uint2uint_sse2;
+
+      translate[IN_UBYTE][OUT_USHORT][pv][pv][PIPE_PRIM_QUAD_STRIP] =
+         translate_quadstrip_ubyte2ushort_sse2;
+      translate[IN_USHORT][OUT_USHORT][pv][pv][PIPE_PRIM_QUAD_STRIP] =
+         translate_quadstrip_ushort2ushort_sse2;
+      translate[IN_UINT][OUT_UINT][pv][pv][PIPE_PRIM_QUAD_STRIP] =
+         translate_quadstrip_uint2uint_sse2;
+   }
+
+   translate[IN_UBYTE][OUT_USHORT][PV_FIRST][PV_FIRST][PIPE_PRIM_TRIANGLE_STRIP] =
+      translate_tristrip_ubyte2ushort_first2first_sse2;
+   translate[IN_USHORT][OUT_USHORT][PV_FIRST][PV_FIRST][PIPE_PRIM_TRIANGLE_STRIP] =
+      translate_tristrip_ushort2ushort_first2first_sse2;
+   translate[IN_UINT][OUT_UINT][PV_FIRST][PV_FIRST][PIPE_PRIM_TRIANGLE_STRIP] =
+      translate_tristrip_uint2uint_first2first_sse2;
+   translate[IN_UBYTE][OUT_USHORT][PV_LAST][PV_LAST][PIPE_PRIM_TRIANGLE_STRIP] =
+      translate_tristrip_ubyte2ushort_last2last_sse2;
+   translate[IN_USHORT][OUT_USHORT][PV_LAST][PV_LAST][PIPE_PRIM_TRIANGLE_STRIP] =
+      translate_tristrip_ushort2ushort_last2last_sse2;
+   translate[IN_UINT][OUT_UINT][PV_LAST][PV_LAST][PIPE_PRIM_TRIANGLE_STRIP] =
+      translate_tristrip_uint2uint_last2last_sse2;
+}
+
+#endif /* PIPE_ARCH_SSE */
@@ -22,6 +22,19 @@ util_format_etc1_rgb8_pack_rgba_8unorm(uint8_t *dst_row, unsigned dst_stride, co
    assert(0);
 }
 
+void
+util_format_etc1_rgb8_fetch_rgba_8unorm(uint8_t *dst, const uint8_t *src, unsigned i, unsigned j)
+{
+   const unsigned bw = 4, bh = 4;
+   struct etc1_block block;
+
+   assert(i < bw && j < bh);
+
+   etc1_parse_block(&block, src);
+   etc1_fetch_texel(&block, i, j, dst);
+   dst[3] = 255;
+}
+
 void
 util_format_etc1_rgb8_unpack_rgba_float(float *dst_row, unsigned dst_stride, const uint8_t *src_row, unsigned src_stride, unsigned width, unsigned height)
 {
@@ -31,19 +44,22 @@ util_format_etc1_rgb8_unpack_rgba_float(float *dst_row, unsigned dst_stride, con
 
    for (y = 0; y < height; y += bh) {
       const uint8_t *src = src_row;
+      const unsigned h = MIN2(bh, height - y);
 
       for (x = 0; x < width; x+= bw) {
+         const unsigned w = MIN2(bw, width - x);
+         uint8_t tmp[4][4][4];
+
          etc1_parse_block(&block, src);
+         etc1_unpack_block(&block, &tmp[0][0][0], sizeof(tmp[0]), w, h);
 
-         for (j = 0; j < bh; j++) {
+         for (j = 0; j < h; j++) {
             float *dst = dst_row + (y + j) * dst_stride / sizeof(*dst_row) + x * comps;
-            uint8_t tmp[3];
 
-            for (i = 0; i < bw; i++) {
-               etc1_fetch_texel(&block, i, j, tmp);
-               dst[0] = ubyte_to_float(tmp[0]);
-               dst[1] = ubyte_to_float(tmp[1]);
-               dst[2] = ubyte_to_float(tmp[2]);
+            for (i = 0; i < w; i++) {
+               dst[0] = ubyte_to_float(tmp[j][i][0]);
+               dst[1] = ubyte_to_float(tmp[j][i][1]);
+               dst[2] = ubyte_to_float(tmp[j][i][2]);
                dst[3] = 1.0f;
                dst += comps;
             }
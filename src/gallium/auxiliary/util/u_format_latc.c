@@ -56,7 +56,8 @@ util_format_latc1_unorm_fetch_rgba_8unorm(uint8_t *dst, const uint8_t *src, unsi
 void
 util_format_latc1_unorm_unpack_rgba_8unorm(uint8_t *dst_row, unsigned dst_stride, const uint8_t *src_row, unsigned src_stride, unsigned width, unsigned height)
 {
-   util_format_rgtc1_unorm_unpack_rgba_8unorm(dst_row, dst_stride, src_row, src_stride, width, height);
+   util_format_unsigned_rgtc_unpack_rgba_8unorm(dst_row, dst_stride, src_row, src_stride,
+                                                width, height, 1, TRUE);
 }
 
 void
@@ -69,27 +70,8 @@ util_format_latc1_unorm_pack_rgba_8unorm(uint8_t *dst_row, unsigned dst_stride,
 void
 util_format_latc1_unorm_unpack_rgba_float(float *dst_row, unsigned dst_stride, const uint8_t *src_row, unsigned src_stride, unsigned width, unsigned height)
 {
-   unsigned x, y, i, j;
-   int block_size = 8;
-
-   for(y = 0; y < height; y += 4) {
-      const uint8_t *src = src_row;
-      for(x = 0; x < width; x += 4) {
-         for(j = 0; j < 4; ++j) {
-            for(i = 0; i < 4; ++i) {
-               float *dst = dst_row + (y + j)*dst_stride/sizeof(*dst_row) + (x + i)*4;
-               uint8_t tmp_r;
-               u_format_unsigned_fetch_texel_rgtc(0, src, i, j, &tmp_r, 1);
-               dst[0] =
-               dst[1] =
-               dst[2] = ubyte_to_float(tmp_r);
-               dst[3] = 1.0;
-            }
-         }
-         src += block_size;
-      }
-      src_row += src_stride;
-   }
+   util_format_unsigned_rgtc_unpack_rgba_float(dst_row, dst_stride, src_row, src_stride,
+                                               width, height, 1, TRUE);
 }
 
 void
@@ -185,7 +167,8 @@ util_format_latc2_unorm_fetch_rgba_8unorm(uint8_t *dst, const uint8_t *src, unsi
 void
 util_format_latc2_unorm_unpack_rgba_8unorm(uint8_t *dst_row, unsigned dst_stride, const uint8_t *src_row, unsigned src_stride, unsigned width, unsigned height)
 {
-   util_format_rgtc2_unorm_unpack_rgba_8unorm(dst_row, dst_stride, src_row, src_stride, width, height);
+   util_format_unsigned_rgtc_unpack_rgba_8unorm(dst_row, dst_stride, src_row, src_stride,
+                                                width, height, 2, TRUE);
 }
 
 void
@@ -203,28 +186,8 @@ util_format_latc2_unorm_pack_rgba_float(uint8_t *dst_row, unsigned dst_stride, c
 void
 util_format_latc2_unorm_unpack_rgba_float(float *dst_row, unsigned dst_stride, const uint8_t *src_row, unsigned src_stride, unsigned width, unsigned height)
 {
-   unsigned x, y, i, j;
-   int block_size = 16;
-
-   for(y = 0; y < height; y += 4) {
-      const uint8_t *src = src_row;
-      for(x = 0; x < width; x += 4) {
-         for(j = 0; j < 4; ++j) {
-            for(i = 0; i < 4; ++i) {
-               float *dst = dst_row + (y + j)*dst_stride/sizeof(*dst_row) + (x + i)*4;
-               uint8_t tmp_r, tmp_g;
-               u_format_unsigned_fetch_texel_rgtc(0, src, i, j, &tmp_r, 2);
-               u_format_unsigned_fetch_texel_rgtc(0, src + 8, i, j, &tmp_g, 2);
-               dst[0] =
-               dst[1] =
-               dst[2] = ubyte_to_float(tmp_r);
-               dst[3] = ubyte_to_float(tmp_g);
-            }
-         }
-         src += block_size;
-      }
-      src_row += src_stride;
-   }
+   util_format_unsigned_rgtc_unpack_rgba_float(dst_row, dst_stride, src_row, src_stride,
+                                               width, height, 2, TRUE);
 }
 
 void
@@ -23,6 +23,7 @@
  **************************************************************************/
 
 #include <stdio.h>
+#include <string.h>
 #include "u_math.h"
 #include "u_format.h"
 #include "u_format_rgtc.h"
@@ -39,40 +40,165 @@ static void u_format_signed_encode_rgtc_ubyte(int8_t *blkaddr, int8_t srccolors[
 static void u_format_signed_fetch_texel_rgtc(unsigned srcRowStride, const int8_t *pixdata,
 					       unsigned i, unsigned j, int8_t *value, unsigned comps);
 
+
+/**
+ * Compute the eight values an unsigned RGTC channel block with the given
+ * endpoints can encode, indexed by texel code.
+ */
+static INLINE void
+u_format_unsigned_rgtc_palette(unsigned alpha0, unsigned alpha1,
+                               uint8_t palette[8])
+{
+   unsigned code;
+
+   palette[0] = alpha0;
+   palette[1] = alpha1;
+   if (alpha0 > alpha1) {
+      for (code = 2; code < 8; ++code)
+         palette[code] = (alpha0 * (8 - code) + alpha1 * (code - 1)) / 7;
+   }
+   else {
+      for (code = 2; code < 6; ++code)
+         palette[code] = (alpha0 * (6 - code) + alpha1 * (code - 1)) / 5;
+      palette[6] = 0;
+      palette[7] = 255;
+   }
+}
+
+
+/**
+ * Decode all 16 texels of an unsigned RGTC channel block at once, in
+ * row-major order.  Matches u_format_unsigned_fetch_texel_rgtc() exactly.
+ */
 void
-util_format_rgtc1_unorm_fetch_rgba_8unorm(uint8_t *dst, const uint8_t *src, unsigned i, unsigned j)
+util_format_unsigned_decode_rgtc_block(const uint8_t *src, uint8_t dst[16])
 {
-   u_format_unsigned_fetch_texel_rgtc(0, src, i, j, dst, 1);
-   dst[1] = 0;
-   dst[2] = 0;
-   dst[3] = 255;
+   uint8_t palette[8];
+   uint64_t bits;
+   unsigned k;
+
+   u_format_unsigned_rgtc_palette(src[0], src[1], palette);
+
+   bits = (uint64_t)src[2] |
+          (uint64_t)src[3] << 8 |
+          (uint64_t)src[4] << 16 |
+          (uint64_t)src[5] << 24 |
+          (uint64_t)src[6] << 32 |
+          (uint64_t)src[7] << 40;
+
+   for (k = 0; k < 16; ++k) {
+      dst[k] = palette[bits & 7];
+      bits >>= 3;
+   }
 }
 
+
+/**
+ * Decode a 4x4 block of a one or two channel unsigned RGTC/LATC format to
+ * RGBA8.  Luminance formats replicate the first channel into RGB and put
+ * the second, if any, in alpha.
+ */
+static INLINE void
+u_format_unsigned_decode_rgtc_rgba(const uint8_t *src, unsigned chans,
+                                   boolean luminance, uint8_t dst[16][4])
+{
+   uint8_t c0[16], c1[16];
+   unsigned k;
+
+   util_format_unsigned_decode_rgtc_block(src, c0);
+   if (chans == 2)
+      util_format_unsigned_decode_rgtc_block(src + 8, c1);
+
+   for (k = 0; k < 16; ++k) {
+      if (luminance) {
+         dst[k][0] = c0[k];
+         dst[k][1] = c0[k];
+         dst[k][2] = c0[k];
+         dst[k][3] = chans == 2 ? c1[k] : 255;
+      }
+      else {
+         dst[k][0] = c0[k];
+         dst[k][1] = chans == 2 ? c1[k] : 0;
+         dst[k][2] = 0;
+         dst[k][3] = 255;
+      }
+   }
+}
+
+
 void
-util_format_rgtc1_unorm_unpack_rgba_8unorm(uint8_t *dst_row, unsigned dst_stride, const uint8_t *src_row, unsigned src_stride, unsigned width, unsigned height)
+util_format_unsigned_rgtc_unpack_rgba_8unorm(uint8_t *dst_row, unsigned dst_stride,
+                                             const uint8_t *src_row, unsigned src_stride,
+                                             unsigned width, unsigned height,
+                                             unsigned chans, boolean luminance)
 {
-   const unsigned bw = 4, bh = 4, comps = 4;
-   unsigned x, y, i, j;
-   unsigned block_size = 8;
+   const unsigned block_size = 8 * chans;
+   unsigned x, y, j;
 
-   for(y = 0; y < height; y += bh) {
+   for(y = 0; y < height; y += 4) {
       const uint8_t *src = src_row;
-      for(x = 0; x < width; x += bw) {
+      const unsigned bh = MIN2(height - y, 4);
+      for(x = 0; x < width; x += 4) {
+         const unsigned bw = MIN2(width - x, 4);
+         uint8_t tmp[16][4];
+         u_format_unsigned_decode_rgtc_rgba(src, chans, luminance, tmp);
+         for(j = 0; j < bh; ++j) {
+            memcpy(dst_row + (y + j)*dst_stride + x*4, tmp[j*4], bw*4);
+         }
+         src += block_size;
+      }
+      src_row += src_stride;
+   }
+}
+
+
+void
+util_format_unsigned_rgtc_unpack_rgba_float(float *dst_row, unsigned dst_stride,
+                                            const uint8_t *src_row, unsigned src_stride,
+                                            unsigned width, unsigned height,
+                                            unsigned chans, boolean luminance)
+{
+   const unsigned block_size = 8 * chans;
+   unsigned x, y, i, j, k;
+
+   for(y = 0; y < height; y += 4) {
+      const uint8_t *src = src_row;
+      const unsigned bh = MIN2(height - y, 4);
+      for(x = 0; x < width; x += 4) {
+         const unsigned bw = MIN2(width - x, 4);
+         uint8_t tmp[16][4];
+         u_format_unsigned_decode_rgtc_rgba(src, chans, luminance, tmp);
          for(j = 0; j < bh; ++j) {
+            float *dst = dst_row + (y + j)*dst_stride/sizeof(*dst_row) + x*4;
             for(i = 0; i < bw; ++i) {
-               uint8_t *dst = dst_row + (y + j)*dst_stride/sizeof(*dst_row) + (x + i)*comps;
-	       u_format_unsigned_fetch_texel_rgtc(0, src, i, j, dst, 1);
-	       dst[1] = 0;
-	       dst[2] = 0;
-	       dst[3] = 255;
-	    }
-	 }
-	 src += block_size;
+               for(k = 0; k < 4; ++k) {
+                  dst[i*4 + k] = ubyte_to_float(tmp[j*4 + i][k]);
+               }
+            }
+         }
+         src += block_size;
       }
       src_row += src_stride;
    }
 }
 
+
+void
+util_format_rgtc1_unorm_fetch_rgba_8unorm(uint8_t *dst, const uint8_t *src, unsigned i, unsigned j)
+{
+   u_format_unsigned_fetch_texel_rgtc(0, src, i, j, dst, 1);
+   dst[1] = 0;
+   dst[2] = 0;
+   dst[3] = 255;
+}
+
+void
+util_format_rgtc1_unorm_unpack_rgba_8unorm(uint8_t *dst_row, unsigned dst_stride, const uint8_t *src_row, unsigned src_stride, unsigned width, unsigned height)
+{
+   util_format_unsigned_rgtc_unpack_rgba_8unorm(dst_row, dst_stride, src_row, src_stride,
+                                                width, height, 1, FALSE);
+}
+
 void
 util_format_rgtc1_unorm_pack_rgba_8unorm(uint8_t *dst_row, unsigned dst_stride, const uint8_t *src_row, 
 					 unsigned src_stride, unsigned width, unsigned height)
@@ -99,26 +225,8 @@ util_format_rgtc1_unorm_pack_rgba_8unorm(uint8_t *dst_row, unsigned dst_stride,
 void
 util_format_rgtc1_unorm_unpack_rgba_float(float *dst_row, unsigned dst_stride, const uint8_t *src_row, unsigned src_stride, unsigned width, unsigned height)
 {
-   unsigned x, y, i, j;
-   int block_size = 8;
-   for(y = 0; y < height; y += 4) {
-      const uint8_t *src = src_row;
-      for(x = 0; x < width; x += 4) {
-         for(j = 0; j < 4; ++j) {
-            for(i = 0; i < 4; ++i) {
-               float *dst = dst_row + (y + j)*dst_stride/sizeof(*dst_row) + (x + i)*4;
-               uint8_t tmp_r;
-               u_format_unsigned_fetch_texel_rgtc(0, src, i, j, &tmp_r, 1);
-               dst[0] = ubyte_to_float(tmp_r);
-               dst[1] = 0.0;
-               dst[2] = 0.0;
-               dst[3] = 1.0;
-            }
-         }
-         src += block_size;
-      }
-      src_row += src_stride;
-   }
+   util_format_unsigned_rgtc_unpack_rgba_float(dst_row, dst_stride, src_row, src_stride,
+                                               width, height, 1, FALSE);
 }
 
 void
@@ -243,26 +351,8 @@ util_format_rgtc2_unorm_fetch_rgba_8unorm(uint8_t *dst, const uint8_t *src, unsi
 void
 util_format_rgtc2_unorm_unpack_rgba_8unorm(uint8_t *dst_row, unsigned dst_stride, const uint8_t *src_row, unsigned src_stride, unsigned width, unsigned height)
 {
-   const unsigned bw = 4, bh = 4, comps = 4;
-   unsigned x, y, i, j;
-   unsigned block_size = 16;
-
-   for(y = 0; y < height; y += bh) {
-      const uint8_t *src = src_row;
-      for(x = 0; x < width; x += bw) {
-         for(j = 0; j < bh; ++j) {
-            for(i = 0; i < bw; ++i) {
-               uint8_t *dst = dst_row + (y + j)*dst_stride/sizeof(*dst_row) + (x + i)*comps;
-	       u_format_unsigned_fetch_texel_rgtc(0, src, i, j, dst, 2);
-	       u_format_unsigned_fetch_texel_rgtc(0, src + 8, i, j, dst + 1, 2);
-	       dst[2] = 0;
-	       dst[3] = 255;
-	    }
-	 }
-	 src += block_size;
-      }
-      src_row += src_stride;
-   }
+   util_format_unsigned_rgtc_unpack_rgba_8unorm(dst_row, dst_stride, src_row, src_stride,
+                                                width, height, 2, FALSE);
 }
 
 void
@@ -324,27 +414,8 @@ util_format_rgtc2_unorm_pack_rgba_float(uint8_t *dst_row, unsigned dst_stride, c
 void
 util_format_rgtc2_unorm_unpack_rgba_float(float *dst_row, unsigned dst_stride, const uint8_t *src_row, unsigned src_stride, unsigned width, unsigned height)
 {
-   unsigned x, y, i, j;
-   int block_size = 16;
-   for(y = 0; y < height; y += 4) {
-      const uint8_t *src = src_row;
-      for(x = 0; x < width; x += 4) {
-         for(j = 0; j < 4; ++j) {
-            for(i = 0; i < 4; ++i) {
-               float *dst = dst_row + (y + j)*dst_stride/sizeof(*dst_row) + (x + i)*4;
-               uint8_t tmp_r, tmp_g;
-               u_format_unsigned_fetch_texel_rgtc(0, src, i, j, &tmp_r, 2);
-               u_format_unsigned_fetch_texel_rgtc(0, src + 8, i, j, &tmp_g, 2);
-               dst[0] = ubyte_to_float(tmp_r);
-               dst[1] = ubyte_to_float(tmp_g);
-               dst[2] = 0.0;
-               dst[3] = 1.0;
-            }
-         }
-         src += block_size;
-      }
-      src_row += src_stride;
-   }
+   util_format_unsigned_rgtc_unpack_rgba_float(dst_row, dst_stride, src_row, src_stride,
+                                               width, height, 2, FALSE);
 }
 
 void
@@ -111,4 +111,18 @@ void
 util_format_rgtc2_snorm_fetch_rgba_float(float *dst, const uint8_t *src, unsigned i, unsigned j);
 
 
+/*
+ * Whole block decoders shared by the unsigned RGTC and LATC formats.
+ */
+
+void
+util_format_unsigned_decode_rgtc_block(const uint8_t *src, uint8_t dst[16]);
+
+void
+util_format_unsigned_rgtc_unpack_rgba_8unorm(uint8_t *dst_row, unsigned dst_stride, const uint8_t *src_row, unsigned src_stride, unsigned width, unsigned height, unsigned chans, boolean luminance);
+
+void
+util_format_unsigned_rgtc_unpack_rgba_float(float *dst_row, unsigned dst_stride, const uint8_t *src_row, unsigned src_stride, unsigned width, unsigned height, unsigned chans, boolean luminance);
+
+
 #endif
@@ -23,6 +23,8 @@
  *
  **************************************************************************/
 
+#include <string.h>
+
 #include "u_dl.h"
 #include "u_math.h"
 #include "u_format.h"
@@ -39,68 +41,38 @@
 #endif
 
 
-static void
-util_format_dxt1_rgb_fetch_stub(int src_stride,
-                                const uint8_t *src,
-                                int col, int row,
-                                uint8_t *dst)
-{
-   assert(0);
-}
-
-
-static void
-util_format_dxt1_rgba_fetch_stub(int src_stride,
-                                 const uint8_t *src,
-                                 int col, int row,
-                                 uint8_t *dst )
-{
-   assert(0);
-}
+#include "../../../mesa/main/texcompress_s3tc_tmp.h"
 
 
 static void
-util_format_dxt3_rgba_fetch_stub(int src_stride,
-                                 const uint8_t *src,
-                                 int col, int row,
-                                 uint8_t *dst )
+util_format_dxtn_pack_builtin(int src_comps,
+                              int width, int height,
+                              const uint8_t *src,
+                              enum util_format_dxtn dst_format,
+                              uint8_t *dst,
+                              int dst_stride)
 {
-   assert(0);
-}
-
-
-static void
-util_format_dxt5_rgba_fetch_stub(int src_stride,
-                                 const uint8_t *src,
-                                 int col, int row,
-                                 uint8_t *dst )
-{
-   assert(0);
-}
-
-
-static void
-util_format_dxtn_pack_stub(int src_comps,
-                           int width, int height,
-                           const uint8_t *src,
-                           enum util_format_dxtn dst_format,
-                           uint8_t *dst,
-                           int dst_stride)
-{
-   assert(0);
+   /* The format enums are consecutive and in dxtn_compress()'s order. */
+   dxtn_compress(src_comps, width, height, src,
+                 dst_format - UTIL_FORMAT_DXT1_RGB, dst, dst_stride);
 }
 
 
 boolean util_format_s3tc_enabled = FALSE;
 
-util_format_dxtn_fetch_t util_format_dxt1_rgb_fetch = util_format_dxt1_rgb_fetch_stub;
-util_format_dxtn_fetch_t util_format_dxt1_rgba_fetch = util_format_dxt1_rgba_fetch_stub;
-util_format_dxtn_fetch_t util_format_dxt3_rgba_fetch = util_format_dxt3_rgba_fetch_stub;
-util_format_dxtn_fetch_t util_format_dxt5_rgba_fetch = util_format_dxt5_rgba_fetch_stub;
+util_format_dxtn_fetch_t util_format_dxt1_rgb_fetch = dxt1_rgb_fetch_texel;
+util_format_dxtn_fetch_t util_format_dxt1_rgba_fetch = dxt1_rgba_fetch_texel;
+util_format_dxtn_fetch_t util_format_dxt3_rgba_fetch = dxt3_rgba_fetch_texel;
+util_format_dxtn_fetch_t util_format_dxt5_rgba_fetch = dxt5_rgba_fetch_texel;
 
-util_format_dxtn_pack_t util_format_dxtn_pack = util_format_dxtn_pack_stub;
+util_format_dxtn_pack_t util_format_dxtn_pack = util_format_dxtn_pack_builtin;
 
 
+/**
+ * S3TC is only enabled when libtxc_dxtn is installed.  The fetch and pack
+ * functions default to the built-in decoder and compressor, the former
+ * matching the library bit for bit, and are replaced by the library's.
+ */
 void
 util_format_s3tc_init(void)
 {
@@ -137,11 +109,11 @@ util_format_s3tc_init(void)
    tx_compress_dxtn =
          util_dl_get_proc_address(library, "tx_compress_dxtn");
 
-   if (!util_format_dxt1_rgb_fetch ||
-       !util_format_dxt1_rgba_fetch ||
-       !util_format_dxt3_rgba_fetch ||
-       !util_format_dxt5_rgba_fetch ||
-       !util_format_dxtn_pack) {
+   if (!fetch_2d_texel_rgb_dxt1 ||
+       !fetch_2d_texel_rgba_dxt1 ||
+       !fetch_2d_texel_rgba_dxt3 ||
+       !fetch_2d_texel_rgba_dxt5 ||
+       !tx_compress_dxtn) {
       debug_printf("couldn't reference all symbols in " DXTN_LIBNAME
                    ", software DXTn compression/decompression "
                    "unavailable\n");
@@ -235,28 +207,37 @@ util_format_dxt5_rgba_fetch_rgba_float(float *dst, const uint8_t *src, unsigned
  * Block decompression.
  */
 
+typedef void
+(*util_format_dxtn_decode_block_t)(const uint8_t *src, uint8_t dst[16][4]);
+
 static INLINE void
 util_format_dxtn_rgb_unpack_rgba_8unorm(uint8_t *dst_row, unsigned dst_stride,
                                         const uint8_t *src_row, unsigned src_stride,
                                         unsigned width, unsigned height,
-                                        util_format_dxtn_fetch_t fetch,
+                                        util_format_dxtn_decode_block_t decode,
                                         unsigned block_size, boolean srgb)
 {
-   const unsigned bw = 4, bh = 4, comps = 4;
    unsigned x, y, i, j;
-   for(y = 0; y < height; y += bh) {
+   for(y = 0; y < height; y += 4) {
       const uint8_t *src = src_row;
-      for(x = 0; x < width; x += bw) {
+      const unsigned bh = MIN2(height - y, 4);
+      for(x = 0; x < width; x += 4) {
+         const unsigned bw = MIN2(width - x, 4);
+         uint8_t tmp[16][4];
+         decode(src, tmp);
          for(j = 0; j < bh; ++j) {
-            for(i = 0; i < bw; ++i) {
-               uint8_t *dst = dst_row + (y + j)*dst_stride/sizeof(*dst_row) + (x + i)*comps;
-               fetch(0, src, i, j, dst);
-               if (srgb) {
-                  dst[0] = util_format_srgb_to_linear_8unorm(dst[0]);
-                  dst[1] = util_format_srgb_to_linear_8unorm(dst[1]);
-                  dst[2] = util_format_srgb_to_linear_8unorm(dst[2]);
+            uint8_t *dst = dst_row + (y + j)*dst_stride/sizeof(*dst_row) + x*4;
+            if (srgb) {
+               for(i = 0; i < bw; ++i) {
+                  dst[i*4 + 0] = util_format_srgb_to_linear_8unorm(tmp[j*4 + i][0]);
+                  dst[i*4 + 1] = util_format_srgb_to_linear_8unorm(tmp[j*4 + i][1]);
+                  dst[i*4 + 2] = util_format_srgb_to_linear_8unorm(tmp[j*4 + i][2]);
+                  dst[i*4 + 3] = tmp[j*4 + i][3];
                }
             }
+            else {
+               memcpy(dst, tmp[j*4], bw*4);
+            }
          }
          src += block_size;
       }
@@ -272,7 +253,7 @@ util_format_dxt1_rgb_unpack_rgba_8unorm(uint8_t *dst_row, unsigned dst_stride,
    util_format_dxtn_rgb_unpack_rgba_8unorm(dst_row, dst_stride,
                                            src_row, src_stride,
                                            width, height,
-                                           util_format_dxt1_rgb_fetch,
+                                           dxt1_rgb_decode_block,
                                            8, FALSE);
 }
 
@@ -284,7 +265,7 @@ util_format_dxt1_rgba_unpack_rgba_8unorm(uint8_t *dst_row, unsigned dst_stride,
    util_format_dxtn_rgb_unpack_rgba_8unorm(dst_row, dst_stride,
                                            src_row, src_stride,
                                            width, height,
-                                           util_format_dxt1_rgba_fetch,
+                                           dxt1_rgba_decode_block,
                                            8, FALSE);
 }
 
@@ -296,7 +277,7 @@ util_format_dxt3_rgba_unpack_rgba_8unorm(uint8_t *dst_row, unsigned dst_stride,
    util_format_dxtn_rgb_unpack_rgba_8unorm(dst_row, dst_stride,
                                            src_row, src_stride,
                                            width, height,
-                                           util_format_dxt3_rgba_fetch,
+                                           dxt3_rgba_decode_block,
                                            16, FALSE);
 }
 
@@ -308,7 +289,7 @@ util_format_dxt5_rgba_unpack_rgba_8unorm(uint8_t *dst_row, unsigned dst_stride,
    util_format_dxtn_rgb_unpack_rgba_8unorm(dst_row, dst_stride,
                                            src_row, src_stride,
                                            width, height,
-                                           util_format_dxt5_rgba_fetch,
+                                           dxt5_rgba_decode_block,
                                            16, FALSE);
 }
 
@@ -316,29 +297,32 @@ static INLINE void
 util_format_dxtn_rgb_unpack_rgba_float(float *dst_row, unsigned dst_stride,
                                        const uint8_t *src_row, unsigned src_stride,
                                        unsigned width, unsigned height,
-                                       util_format_dxtn_fetch_t fetch,
+                                       util_format_dxtn_decode_block_t decode,
                                        unsigned block_size, boolean srgb)
 {
    unsigned x, y, i, j;
    for(y = 0; y < height; y += 4) {
       const uint8_t *src = src_row;
+      const unsigned bh = MIN2(height - y, 4);
       for(x = 0; x < width; x += 4) {
-         for(j = 0; j < 4; ++j) {
-            for(i = 0; i < 4; ++i) {
+         const unsigned bw = MIN2(width - x, 4);
+         uint8_t tmp[16][4];
+         decode(src, tmp);
+         for(j = 0; j < bh; ++j) {
+            for(i = 0; i < bw; ++i) {
                float *dst = dst_row + (y + j)*dst_stride/sizeof(*dst_row) + (x + i)*4;
-               uint8_t tmp[4];
-               fetch(0, src, i, j, tmp);
+               const uint8_t *texel = tmp[j*4 + i];
                if (srgb) {
-                  dst[0] = util_format_srgb_8unorm_to_linear_float(tmp[0]);
-                  dst[1] = util_format_srgb_8unorm_to_linear_float(tmp[1]);
-                  dst[2] = util_format_srgb_8unorm_to_linear_float(tmp[2]);
+                  dst[0] = util_format_srgb_8unorm_to_linear_float(texel[0]);
+                  dst[1] = util_format_srgb_8unorm_to_linear_float(texel[1]);
+                  dst[2] = util_format_srgb_8unorm_to_linear_float(texel[2]);
                }
                else {
-                  dst[0] = ubyte_to_float(tmp[0]);
-                  dst[1] = ubyte_to_float(tmp[1]);
-                  dst[2] = ubyte_to_float(tmp[2]);
+                  dst[0] = ubyte_to_float(texel[0]);
+                  dst[1] = ubyte_to_float(texel[1]);
+                  dst[2] = ubyte_to_float(texel[2]);
                }
-               dst[3] = ubyte_to_float(tmp[3]);
+               dst[3] = ubyte_to_float(texel[3]);
             }
          }
          src += block_size;
@@ -355,7 +339,7 @@ util_format_dxt1_rgb_unpack_rgba_float(float *dst_row, unsigned dst_stride,
    util_format_dxtn_rgb_unpack_rgba_float(dst_row, dst_stride,
                                           src_row, src_stride,
                                           width, height,
-                                          util_format_dxt1_rgb_fetch,
+                                          dxt1_rgb_decode_block,
                                           8, FALSE);
 }
 
@@ -367,7 +351,7 @@ util_format_dxt1_rgba_unpack_rgba_float(float *dst_row, unsigned dst_stride,
    util_format_dxtn_rgb_unpack_rgba_float(dst_row, dst_stride,
                                           src_row, src_stride,
                                           width, height,
-                                          util_format_dxt1_rgba_fetch,
+                                          dxt1_rgba_decode_block,
                                           8, FALSE);
 }
 
@@ -379,7 +363,7 @@ util_format_dxt3_rgba_unpack_rgba_float(float *dst_row, unsigned dst_stride,
    util_format_dxtn_rgb_unpack_rgba_float(dst_row, dst_stride,
                                           src_row, src_stride,
                                           width, height,
-                                          util_format_dxt3_rgba_fetch,
+                                          dxt3_rgba_decode_block,
                                           16, FALSE);
 }
 
@@ -391,7 +375,7 @@ util_format_dxt5_rgba_unpack_rgba_float(float *dst_row, unsigned dst_stride,
    util_format_dxtn_rgb_unpack_rgba_float(dst_row, dst_stride,
                                           src_row, src_stride,
                                           width, height,
-                                          util_format_dxt5_rgba_fetch,
+                                          dxt5_rgba_decode_block,
                                           16, FALSE);
 }
 
@@ -653,7 +637,7 @@ util_format_dxt1_srgb_unpack_rgba_8unorm(uint8_t *dst_row, unsigned dst_stride,
    util_format_dxtn_rgb_unpack_rgba_8unorm(dst_row, dst_stride,
                                            src_row, src_stride,
                                            width, height,
-                                           util_format_dxt1_rgb_fetch,
+                                           dxt1_rgb_decode_block,
                                            8, TRUE);
 }
 
@@ -663,7 +647,7 @@ util_format_dxt1_srgba_unpack_rgba_8unorm(uint8_t *dst_row, unsigned dst_stride,
    util_format_dxtn_rgb_unpack_rgba_8unorm(dst_row, dst_stride,
                                            src_row, src_stride,
                                            width, height,
-                                           util_format_dxt1_rgba_fetch,
+                                           dxt1_rgba_decode_block,
                                            8, TRUE);
 }
 
@@ -673,7 +657,7 @@ util_format_dxt3_srgba_unpack_rgba_8unorm(uint8_t *dst_row, unsigned dst_stride,
    util_format_dxtn_rgb_unpack_rgba_8unorm(dst_row, dst_stride,
                                            src_row, src_stride,
                                            width, height,
-                                           util_format_dxt3_rgba_fetch,
+                                           dxt3_rgba_decode_block,
                                            16, TRUE);
 }
 
@@ -683,7 +667,7 @@ util_format_dxt5_srgba_unpack_rgba_8unorm(uint8_t *dst_row, unsigned dst_stride,
    util_format_dxtn_rgb_unpack_rgba_8unorm(dst_row, dst_stride,
                                            src_row, src_stride,
                                            width, height,
-                                           util_format_dxt5_rgba_fetch,
+                                           dxt5_rgba_decode_block,
                                            16, TRUE);
 }
 
@@ -693,7 +677,7 @@ util_format_dxt1_srgb_unpack_rgba_float(float *dst_row, unsigned dst_stride, con
    util_format_dxtn_rgb_unpack_rgba_float(dst_row, dst_stride,
                                           src_row, src_stride,
                                           width, height,
-                                          util_format_dxt1_rgb_fetch,
+                                          dxt1_rgb_decode_block,
                                           8, TRUE);
 }
 
@@ -703,7 +687,7 @@ util_format_dxt1_srgba_unpack_rgba_float(float *dst_row, unsigned dst_stride, co
    util_format_dxtn_rgb_unpack_rgba_float(dst_row, dst_stride,
                                           src_row, src_stride,
                                           width, height,
-                                          util_format_dxt1_rgba_fetch,
+                                          dxt1_rgba_decode_block,
                                           8, TRUE);
 }
 
@@ -713,7 +697,7 @@ util_format_dxt3_srgba_unpack_rgba_float(float *dst_row, unsigned dst_stride, co
    util_format_dxtn_rgb_unpack_rgba_float(dst_row, dst_stride,
                                           src_row, src_stride,
                                           width, height,
-                                          util_format_dxt3_rgba_fetch,
+                                          dxt3_rgba_decode_block,
                                           16, TRUE);
 }
 
@@ -723,7 +707,7 @@ util_format_dxt5_srgba_unpack_rgba_float(float *dst_row, unsigned dst_stride, co
    util_format_dxtn_rgb_unpack_rgba_float(dst_row, dst_stride,
                                           src_row, src_stride,
                                           width, height,
-                                          util_format_dxt5_rgba_fetch,
+                                          dxt5_rgba_decode_block,
                                           16, TRUE);
 }
 
@@ -135,7 +135,7 @@ def write_format_table(formats):
         if format.colorspace != ZS and format.channels[0].pure == False:
             print "   &util_format_%s_unpack_rgba_8unorm," % format.short_name() 
             print "   &util_format_%s_pack_rgba_8unorm," % format.short_name() 
-            if format.layout == 's3tc' or format.layout == 'rgtc':
+            if format.layout in ('s3tc', 'rgtc', 'etc'):
                 print "   &util_format_%s_fetch_rgba_8unorm," % format.short_name()
             else:
                 print "   NULL, /* fetch_rgba_8unorm */" 
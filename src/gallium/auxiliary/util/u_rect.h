@@ -52,6 +52,18 @@ u_rect_test_intersection(const struct u_rect *a,
              b->y1 < a->y0));
 }
 
+/* Is rectangle b entirely inside rectangle a?
+ */
+static INLINE boolean
+u_rect_contains(const struct u_rect *a,
+                const struct u_rect *b)
+{
+   return (b->x0 >= a->x0 &&
+           b->x1 <= a->x1 &&
+           b->y0 >= a->y0 &&
+           b->y1 <= a->y1);
+}
+
 /* Find the intersection of two rectangles known to intersect.
  */
 static INLINE void
@@ -200,6 +200,11 @@ llvmpipe_create_context( struct pipe_screen *screen, void *priv )
    draw_wide_point_threshold(llvmpipe->draw, 10000.0);
    draw_wide_line_threshold(llvmpipe->draw, 10000.0);
 
+   /* Triangles and lines which stay within the guard band don't need to
+    * be clipped by draw; setup scissors them to the viewport instead.
+    */
+   llvmpipe_update_guard_band(llvmpipe);
+
    lp_reset_counters();
 
    return &llvmpipe->pipe;
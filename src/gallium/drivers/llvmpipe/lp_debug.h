@@ -59,6 +59,9 @@ st_print_current(void);
 #define PERF_NO_BLEND       0x20  	/* disable blending */
 #define PERF_NO_DEPTH       0x40  	/* disable depth buffering entirely */
 #define PERF_NO_ALPHATEST   0x80  	/* disable alpha testing */
+#define PERF_NO_GUARD_BAND  0x100 	/* clip all primitives to the viewport */
+#define PERF_TEX_STATS      0x200 	/* count texel fetches, for the HUD */
+#define PERF_TEXEL_CENTER   0x400 	/* fetch one texel on texel centers */
 
 
 extern int LP_PERF;
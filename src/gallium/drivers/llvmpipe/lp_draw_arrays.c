@@ -47,10 +47,12 @@
  * Draw vertex arrays, with optional indexing, optional instancing.
  * All the other drawing functions are implemented in terms of this function.
  * Basically, map the vertex buffers (and drawing surfaces), then hand off
- * the drawing to the 'draw' module.
+ * the drawing of all the num_draws primitives to the 'draw' module at once.
  */
 static void
-llvmpipe_draw_vbo(struct pipe_context *pipe, const struct pipe_draw_info *info)
+llvmpipe_multi_draw_vbo(struct pipe_context *pipe,
+                        const struct pipe_draw_info *info,
+                        unsigned num_draws)
 {
    struct llvmpipe_context *lp = llvmpipe_context(pipe);
    struct draw_context *draw = lp->draw;
@@ -123,7 +125,7 @@ llvmpipe_draw_vbo(struct pipe_context *pipe, const struct pipe_draw_info *info)
                                     lp->active_statistics_queries > 0);
 
    /* draw! */
-   draw_vbo(draw, info);
+   draw_multi_vbo(draw, info, num_draws);
 
    /*
     * unmap vertex/index buffers
@@ -156,8 +158,16 @@ llvmpipe_draw_vbo(struct pipe_context *pipe, const struct pipe_draw_info *info)
 }
 
 
+static void
+llvmpipe_draw_vbo(struct pipe_context *pipe, const struct pipe_draw_info *info)
+{
+   llvmpipe_multi_draw_vbo(pipe, info, 1);
+}
+
+
 void
 llvmpipe_init_draw_funcs(struct llvmpipe_context *llvmpipe)
 {
    llvmpipe->pipe.draw_vbo = llvmpipe_draw_vbo;
+   llvmpipe->pipe.multi_draw_vbo = llvmpipe_multi_draw_vbo;
 }
@@ -45,6 +45,7 @@
 
 struct lp_fragment_shader_variant;
 struct llvmpipe_screen;
+struct lp_sampler_stats;
 
 
 struct lp_jit_texture
@@ -197,12 +198,16 @@ struct lp_jit_thread_data
    struct {
       uint32_t viewport_index;
    } raster_state;
+
+   /** Where the samplers record texel fetches, see PERF_TEX_STATS */
+   struct lp_sampler_stats *sampler_stats;
 };
 
 
 enum {
    LP_JIT_THREAD_DATA_COUNTER = 0,
    LP_JIT_THREAD_DATA_RASTER_STATE_VIEWPORT_INDEX,
+   LP_JIT_THREAD_DATA_SAMPLER_STATS,
    LP_JIT_THREAD_DATA_COUNT
 };
 
@@ -214,6 +219,10 @@ enum {
    lp_build_struct_get(_gallivm, _ptr, \
                        LP_JIT_THREAD_DATA_RASTER_STATE_VIEWPORT_INDEX, \
                        "raster_state.viewport_index")
+
+#define lp_jit_thread_data_sampler_stats(_gallivm, _ptr) \
+   lp_build_struct_get(_gallivm, _ptr, LP_JIT_THREAD_DATA_SAMPLER_STATS, \
+                       "sampler_stats")
  
 /**
  * typedef for fragment shader function
@@ -31,6 +31,7 @@
  */
 
 #include "draw/draw_context.h"
+#include "gallivm/lp_bld_sample.h"
 #include "pipe/p_defines.h"
 #include "util/u_memory.h"
 #include "os/os_time.h"
@@ -54,7 +55,7 @@ llvmpipe_create_query(struct pipe_context *pipe,
 {
    struct llvmpipe_query *pq;
 
-   assert(type < PIPE_QUERY_TYPES);
+   assert(type < PIPE_QUERY_TYPES || lp_query_is_texel_stats(type));
 
    pq = CALLOC_STRUCT( llvmpipe_query );
 
@@ -175,6 +176,12 @@ llvmpipe_get_query_result(struct pipe_context *pipe,
    }
       break;
    default:
+      if (lp_query_is_texel_stats(pq->type)) {
+         for (i = 0; i < num_threads; i++) {
+            *result += pq->end[i];
+         }
+         break;
+      }
       assert(0);
       break;
    }
@@ -183,6 +190,38 @@ llvmpipe_get_query_result(struct pipe_context *pipe,
 }
 
 
+/**
+ * The counter of a rasterizer thread's texel fetch statistics a query
+ * reports.
+ */
+uint64_t
+lp_query_texel_stats(const struct lp_sampler_stats *stats, unsigned type)
+{
+   uint64_t texels = 0;
+   unsigned i;
+
+   switch (type) {
+   case LP_QUERY_TEXELS:
+      for (i = 0; i < LP_SAMPLER_STATS_LEVELS; i++) {
+         texels += stats->texels[i];
+      }
+      return texels;
+   case LP_QUERY_TEXELS_LEVEL0:
+   case LP_QUERY_TEXELS_LEVEL1:
+   case LP_QUERY_TEXELS_LEVEL2:
+   case LP_QUERY_TEXELS_LEVEL3:
+      return stats->texels[type - LP_QUERY_TEXELS_LEVEL0];
+   case LP_QUERY_TEXEL_CACHE_LINES:
+      return stats->cache_lines;
+   case LP_QUERY_TEXELS_REDUNDANT:
+      return stats->redundant;
+   default:
+      assert(0);
+      return 0;
+   }
+}
+
+
 static void
 llvmpipe_begin_query(struct pipe_context *pipe, struct pipe_query *q)
 {
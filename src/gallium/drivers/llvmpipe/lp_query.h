@@ -35,10 +35,34 @@
 
 #include <limits.h>
 #include "os/os_thread.h"
+#include "pipe/p_defines.h"
 #include "lp_limits.h"
 
 
 struct llvmpipe_context;
+struct lp_sampler_stats;
+
+
+/**
+ * Driver queries counting texel fetches, see PERF_TEX_STATS.
+ */
+enum lp_query_type {
+   LP_QUERY_TEXELS = PIPE_QUERY_DRIVER_SPECIFIC,
+   LP_QUERY_TEXELS_LEVEL0,
+   LP_QUERY_TEXELS_LEVEL1,
+   LP_QUERY_TEXELS_LEVEL2,
+   LP_QUERY_TEXELS_LEVEL3,
+   LP_QUERY_TEXEL_CACHE_LINES,
+   LP_QUERY_TEXELS_REDUNDANT,
+   LP_QUERY_TYPE_END
+};
+
+
+static INLINE boolean
+lp_query_is_texel_stats(unsigned type)
+{
+   return type >= LP_QUERY_TEXELS && type < LP_QUERY_TYPE_END;
+}
 
 
 struct llvmpipe_query {
@@ -55,6 +79,9 @@ struct llvmpipe_query {
 
 extern void llvmpipe_init_query_funcs(struct llvmpipe_context * );
 
+extern uint64_t
+lp_query_texel_stats(const struct lp_sampler_stats *stats, unsigned type);
+
 extern boolean llvmpipe_check_render_cond(struct llvmpipe_context *);
 
 #endif /* LP_QUERY_H */
@@ -536,6 +536,11 @@ lp_rast_begin_query(struct lp_rasterizer_task *task,
       pq->start[task->thread_index] = task->ps_invocations;
       break;
    default:
+      if (lp_query_is_texel_stats(pq->type)) {
+         pq->start[task->thread_index] =
+            lp_query_texel_stats(&task->sampler_stats, pq->type);
+         break;
+      }
       assert(0);
       break;
    }
@@ -569,6 +574,13 @@ lp_rast_end_query(struct lp_rasterizer_task *task,
       pq->start[task->thread_index] = 0;
       break;
    default:
+      if (lp_query_is_texel_stats(pq->type)) {
+         pq->end[task->thread_index] +=
+            lp_query_texel_stats(&task->sampler_stats, pq->type) -
+            pq->start[task->thread_index];
+         pq->start[task->thread_index] = 0;
+         break;
+      }
       assert(0);
       break;
    }
@@ -906,6 +918,7 @@ lp_rast_create( unsigned num_threads )
       struct lp_rasterizer_task *task = &rast->tasks[i];
       task->rast = rast;
       task->thread_index = i;
+      task->thread_data.sampler_stats = &task->sampler_stats;
    }
 
    rast->num_threads = num_threads;
@@ -915,7 +928,9 @@ lp_rast_create( unsigned num_threads )
    create_rast_threads(rast);
 
    /* for synchronizing rasterization threads */
-   pipe_barrier_init( &rast->barrier, rast->num_threads );
+   if (rast->num_threads > 0) {
+      pipe_barrier_init( &rast->barrier, rast->num_threads );
+   }
 
    memset(lp_dummy_tile, 0, sizeof lp_dummy_tile);
 
@@ -955,7 +970,9 @@ void lp_rast_destroy( struct lp_rasterizer *rast )
    }
 
    /* for synchronizing rasterization threads */
-   pipe_barrier_destroy( &rast->barrier );
+   if (rast->num_threads > 0) {
+      pipe_barrier_destroy( &rast->barrier );
+   }
 
    lp_scene_queue_destroy(rast->full_scenes);
 
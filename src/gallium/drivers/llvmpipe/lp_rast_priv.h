@@ -31,6 +31,7 @@
 #include "os/os_thread.h"
 #include "util/u_format.h"
 #include "gallivm/lp_bld_debug.h"
+#include "gallivm/lp_bld_sample.h"
 #include "lp_memory.h"
 #include "lp_rast.h"
 #include "lp_scene.h"
@@ -102,6 +103,9 @@ struct lp_rasterizer_task
    uint64_t ps_invocations;
    uint8_t ps_inv_multiplier;
 
+   /** Texel fetches, only counted with PERF_TEX_STATS */
+   struct lp_sampler_stats sampler_stats;
+
    pipe_semaphore work_ready;
    pipe_semaphore work_done;
 };
@@ -45,6 +45,7 @@
 #include "lp_context.h"
 #include "lp_debug.h"
 #include "lp_public.h"
+#include "lp_query.h"
 #include "lp_limits.h"
 #include "lp_rast.h"
 
@@ -80,6 +81,9 @@ static const struct debug_named_value lp_perf_flags[] = {
    { "no_blend",       PERF_NO_BLEND, NULL },
    { "no_depth",       PERF_NO_DEPTH, NULL },
    { "no_alphatest",   PERF_NO_ALPHATEST, NULL },
+   { "no_guard_band",  PERF_NO_GUARD_BAND, NULL },
+   { "tex_stats",      PERF_TEX_STATS, NULL },
+   { "texel_center",   PERF_TEXEL_CENTER, NULL },
    DEBUG_NAMED_VALUE_END
 };
 
@@ -238,6 +242,9 @@ llvmpipe_get_param(struct pipe_screen *screen, enum pipe_cap param)
       return PIPE_ENDIAN_NATIVE;
    case PIPE_CAP_TGSI_VS_LAYER:
       return 0;
+   case PIPE_CAP_BUFFER_MAP_PERSISTENT_COHERENT:
+   case PIPE_CAP_MULTI_DRAW:
+      return 1;
    }
    /* should only get here on unhandled cases */
    debug_printf("Unexpected PIPE_CAP %d query\n", param);
@@ -494,6 +501,37 @@ llvmpipe_get_timestamp(struct pipe_screen *_screen)
    return os_time_get_nano();
 }
 
+
+/**
+ * The texel fetch counters are only there with LP_PERF=tex_stats, since
+ * they make sampling a lot slower.
+ */
+static int
+llvmpipe_get_driver_query_info(struct pipe_screen *screen,
+                               unsigned index,
+                               struct pipe_driver_query_info *info)
+{
+   static const struct pipe_driver_query_info queries[] = {
+      {"lp-texels", LP_QUERY_TEXELS, 0, FALSE},
+      {"lp-texels-level0", LP_QUERY_TEXELS_LEVEL0, 0, FALSE},
+      {"lp-texels-level1", LP_QUERY_TEXELS_LEVEL1, 0, FALSE},
+      {"lp-texels-level2", LP_QUERY_TEXELS_LEVEL2, 0, FALSE},
+      {"lp-texels-level3+", LP_QUERY_TEXELS_LEVEL3, 0, FALSE},
+      {"lp-texel-cache-lines", LP_QUERY_TEXEL_CACHE_LINES, 0, FALSE},
+      {"lp-texels-redundant", LP_QUERY_TEXELS_REDUNDANT, 0, FALSE}
+   };
+   unsigned num_queries = (LP_PERF & PERF_TEX_STATS) ? Elements(queries) : 0;
+
+   if (!info)
+      return num_queries;
+
+   if (index >= num_queries)
+      return 0;
+
+   *info = queries[index];
+   return 1;
+}
+
 /**
  * Create a new pipe_screen object
  * Note: we're not presently subclassing pipe_screen (no llvmpipe_screen).
@@ -539,6 +577,7 @@ llvmpipe_create_screen(struct sw_winsys *winsys)
    screen->base.fence_finish = llvmpipe_fence_finish;
 
    screen->base.get_timestamp = llvmpipe_get_timestamp;
+   screen->base.get_driver_query_info = llvmpipe_get_driver_query_info;
 
    llvmpipe_init_screen_resource_funcs(&screen->base);
 
@@ -551,6 +590,8 @@ llvmpipe_create_screen(struct sw_winsys *winsys)
    screen->num_threads = debug_get_num_option("LP_NUM_THREADS", screen->num_threads);
    screen->num_threads = MIN2(screen->num_threads, LP_MAX_THREADS);
 
+   screen->tiled_textures = debug_get_bool_option("LP_TILED_TEXTURES", FALSE);
+
    screen->rast = lp_rast_create(screen->num_threads);
    if (!screen->rast) {
       lp_jit_screen_cleanup(screen);
@@ -645,6 +645,23 @@ lp_setup_set_vertex_info( struct lp_setup_context *setup,
 }
 
 
+/**
+ * Enable or disable guard band clipping.  With a guard band the draw
+ * module passes primitives which extend past the viewport through
+ * unclipped, so setup must restrict rasterization of triangles and lines
+ * to the viewport, and cull points whose center is outside of it.
+ */
+void
+lp_setup_set_guard_band(struct lp_setup_context *setup,
+                        boolean guard_band)
+{
+   if (setup->guard_band != guard_band) {
+      setup->guard_band = guard_band;
+      setup->dirty |= LP_SETUP_NEW_SCISSOR;
+   }
+}
+
+
 /**
  * Called during state validation when LP_NEW_VIEWPORT is set.
  */
@@ -667,6 +684,26 @@ lp_setup_set_viewports(struct lp_setup_context *setup,
    for (i = 0; i < num_viewports; i++) {
       float min_depth;
       float max_depth;
+      float half_width = fabsf(viewports[i].scale[0]);
+      float half_height = fabsf(viewports[i].scale[1]);
+      struct u_rect rect;
+
+      /* Pixels whose centers lie within the viewport, inclusive. */
+      rect.x0 = (int) ceilf(viewports[i].translate[0] - half_width - 0.5f);
+      rect.x1 = (int) ceilf(viewports[i].translate[0] + half_width - 0.5f) - 1;
+      rect.y0 = (int) ceilf(viewports[i].translate[1] - half_height - 0.5f);
+      rect.y1 = (int) ceilf(viewports[i].translate[1] + half_height - 0.5f) - 1;
+
+      setup->viewport_bounds[i][0] = viewports[i].translate[0] - half_width;
+      setup->viewport_bounds[i][1] = viewports[i].translate[1] - half_height;
+      setup->viewport_bounds[i][2] = viewports[i].translate[0] + half_width;
+      setup->viewport_bounds[i][3] = viewports[i].translate[1] + half_height;
+
+      if (memcmp(&setup->viewport_rects[i], &rect, sizeof rect) != 0) {
+         setup->viewport_rects[i] = rect;
+         if (setup->guard_band)
+            setup->dirty |= LP_SETUP_NEW_SCISSOR;
+      }
 
       if (lp->rasterizer->clip_halfz == 0) {
          float half_depth = viewports[i].scale[2];
@@ -1082,6 +1119,11 @@ try_update_scene_state( struct lp_setup_context *setup )
             u_rect_possible_intersection(&setup->scissors[i],
                                          &setup->draw_regions[i]);
          }
+         setup->tri_regions[i] = setup->draw_regions[i];
+         if (setup->guard_band) {
+            u_rect_possible_intersection(&setup->viewport_rects[i],
+                                         &setup->tri_regions[i]);
+         }
       }
    }
 
@@ -1279,7 +1321,8 @@ lp_setup_begin_query(struct lp_setup_context *setup,
 
    if (!(pq->type == PIPE_QUERY_OCCLUSION_COUNTER ||
          pq->type == PIPE_QUERY_OCCLUSION_PREDICATE ||
-         pq->type == PIPE_QUERY_PIPELINE_STATISTICS))
+         pq->type == PIPE_QUERY_PIPELINE_STATISTICS ||
+         lp_query_is_texel_stats(pq->type)))
       return;
 
    /* init the query to its beginning state */
@@ -1330,7 +1373,8 @@ lp_setup_end_query(struct lp_setup_context *setup, struct llvmpipe_query *pq)
       if (pq->type == PIPE_QUERY_OCCLUSION_COUNTER ||
           pq->type == PIPE_QUERY_OCCLUSION_PREDICATE ||
           pq->type == PIPE_QUERY_PIPELINE_STATISTICS ||
-          pq->type == PIPE_QUERY_TIMESTAMP) {
+          pq->type == PIPE_QUERY_TIMESTAMP ||
+          lp_query_is_texel_stats(pq->type)) {
          if (pq->type == PIPE_QUERY_TIMESTAMP &&
                !(setup->scene->tiles_x | setup->scene->tiles_y)) {
             /*
@@ -1365,7 +1409,8 @@ fail:
     */
    if (pq->type == PIPE_QUERY_OCCLUSION_COUNTER ||
       pq->type == PIPE_QUERY_OCCLUSION_PREDICATE ||
-      pq->type == PIPE_QUERY_PIPELINE_STATISTICS) {
+      pq->type == PIPE_QUERY_PIPELINE_STATISTICS ||
+      lp_query_is_texel_stats(pq->type)) {
       unsigned i;
 
       /* remove from active binned query list */
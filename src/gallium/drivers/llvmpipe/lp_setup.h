@@ -120,6 +120,10 @@ void
 lp_setup_set_scissors( struct lp_setup_context *setup,
                        const struct pipe_scissor_state *scissors );
 
+void
+lp_setup_set_guard_band(struct lp_setup_context *setup,
+                        boolean guard_band);
+
 void
 lp_setup_set_viewports(struct lp_setup_context *setup,
                        unsigned num_viewports,
@@ -111,7 +111,12 @@ struct lp_setup_context
    struct pipe_framebuffer_state fb;
    struct u_rect framebuffer;
    struct u_rect scissors[PIPE_MAX_VIEWPORTS];
+   struct u_rect viewport_rects[PIPE_MAX_VIEWPORTS]; /* pixels covered by each viewport */
+   float viewport_bounds[PIPE_MAX_VIEWPORTS][4];     /* x0, y0, x1, y1 of each viewport */
    struct u_rect draw_regions[PIPE_MAX_VIEWPORTS];   /* intersection of fb & scissor */
+   struct u_rect tri_regions[PIPE_MAX_VIEWPORTS];    /* draw regions for tris & lines,
+                                                        and viewport with guard band */
+   boolean guard_band;  /**< primitives may extend past the viewport */
    struct lp_jit_viewport viewports[PIPE_MAX_VIEWPORTS];
 
    struct {
@@ -201,6 +206,23 @@ lp_setup_bin_triangle( struct lp_setup_context *setup,
                        struct lp_rast_triangle *tri,
                        const struct u_rect *bbox,
                        int nr_planes,
+                       boolean use_32bits,
                        unsigned scissor_index );
 
+
+/**
+ * Can a primitive be rasterized with 32-bit arithmetic?  This must be
+ * decided from the bounding box of its vertices before it's clamped to
+ * the framebuffer: with guard band clipping the vertices may lie far
+ * outside of it.
+ */
+static INLINE boolean
+lp_setup_fits_32bits(const struct u_rect *bbox)
+{
+   int max_sz = ((bbox->x1 - (bbox->x0 & ~3)) |
+                 (bbox->y1 - (bbox->y0 & ~3)));
+
+   return max_sz <= MAX_FIXED_LENGTH32;
+}
+
 #endif
@@ -294,6 +294,7 @@ try_setup_line( struct lp_setup_context *setup,
    int y[4];
    int i;
    int nr_planes = 4;
+   boolean use_32bits;
    unsigned viewport_index = 0;
    unsigned layer = 0;
    
@@ -320,16 +321,12 @@ try_setup_line( struct lp_setup_context *setup,
    if (0)
       print_line(setup, v1, v2);
 
-   if (setup->scissor_test) {
-      nr_planes = 8;
+   if (setup->scissor_test || setup->guard_band) {
       if (setup->viewport_index_slot > 0) {
          unsigned *udata = (unsigned*)v1[setup->viewport_index_slot];
          viewport_index = lp_clamp_viewport_idx(*udata);
       }
    }
-   else {
-      nr_planes = 4;
-   }
 
    if (setup->layer_slot > 0) {
       layer = *(unsigned*)v1[setup->layer_slot];
@@ -573,12 +570,23 @@ try_setup_line( struct lp_setup_context *setup,
       return TRUE;
    }
 
-   if (!u_rect_test_intersection(&setup->draw_regions[viewport_index], &bbox)) {
+   if (!u_rect_test_intersection(&setup->tri_regions[viewport_index], &bbox)) {
       if (0) debug_printf("offscreen\n");
       LP_COUNT(nr_culled_tris);
       return TRUE;
    }
 
+   /* Lines in the guard band which weren't clipped by draw need to be
+    * scissored to the viewport.
+    */
+   if (setup->scissor_test ||
+       (setup->guard_band &&
+        !u_rect_contains(&setup->tri_regions[viewport_index], &bbox))) {
+      nr_planes = 8;
+   }
+
+   use_32bits = lp_setup_fits_32bits(&bbox);
+
    /* Can safely discard negative regions:
     */
    bbox.x0 = MAX2(bbox.x0, 0);
@@ -698,7 +706,7 @@ try_setup_line( struct lp_setup_context *setup,
     */
    if (nr_planes == 8) {
       const struct u_rect *scissor =
-         &setup->scissors[viewport_index];
+         &setup->tri_regions[viewport_index];
 
       plane[4].dcdx = -1;
       plane[4].dcdy = 0;
@@ -721,7 +729,8 @@ try_setup_line( struct lp_setup_context *setup,
       plane[7].eo = 0;
    }
 
-   return lp_setup_bin_triangle(setup, line, &bbox, nr_planes, viewport_index);
+   return lp_setup_bin_triangle(setup, line, &bbox, nr_planes, use_32bits,
+                                viewport_index);
 }
 
 
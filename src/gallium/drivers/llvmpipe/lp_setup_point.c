@@ -359,6 +359,20 @@ try_setup_point( struct lp_setup_context *setup,
       layer = MIN2(layer, scene->fb_max_layer);
    }
 
+   /* With guard band clipping draw doesn't clip points to the viewport:
+    * points whose center is outside of it must be culled, but wide points
+    * may still extend past it.
+    */
+   if (setup->guard_band) {
+      const float *bounds = setup->viewport_bounds[viewport_index];
+
+      if (!(v0[0][0] >= bounds[0] && v0[0][0] <= bounds[2] &&
+            v0[0][1] >= bounds[1] && v0[0][1] <= bounds[3])) {
+         LP_COUNT(nr_culled_tris);
+         return TRUE;
+      }
+   }
+
    if (0)
       print_point(setup, v0, size);
 
@@ -513,7 +527,8 @@ try_setup_point( struct lp_setup_context *setup,
       plane[3].eo = 0;
    }
 
-   return lp_setup_bin_triangle(setup, point, &bbox, nr_planes, viewport_index);
+   return lp_setup_bin_triangle(setup, point, &bbox, nr_planes,
+                                lp_setup_fits_32bits(&bbox), viewport_index);
 }
 
 
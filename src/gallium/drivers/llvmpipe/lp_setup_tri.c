@@ -274,6 +274,7 @@ do_triangle_ccw(struct lp_setup_context *setup,
    struct u_rect bbox;
    unsigned tri_bytes;
    int nr_planes = 3;
+   boolean use_32bits;
    unsigned viewport_index = 0;
    unsigned layer = 0;
 
@@ -283,16 +284,12 @@ do_triangle_ccw(struct lp_setup_context *setup,
    if (0)
       lp_setup_print_triangle(setup, v0, v1, v2);
 
-   if (setup->scissor_test) {
-      nr_planes = 7;
+   if (setup->scissor_test || setup->guard_band) {
       if (setup->viewport_index_slot > 0) {
          unsigned *udata = (unsigned*)v0[setup->viewport_index_slot];
          viewport_index = lp_clamp_viewport_idx(*udata);
       }
    }
-   else {
-      nr_planes = 3;
-   }
    if (setup->layer_slot > 0) {
       layer = *(unsigned*)v1[setup->layer_slot];
       layer = MIN2(layer, scene->fb_max_layer);
@@ -323,12 +320,23 @@ do_triangle_ccw(struct lp_setup_context *setup,
       return TRUE;
    }
 
-   if (!u_rect_test_intersection(&setup->draw_regions[viewport_index], &bbox)) {
+   if (!u_rect_test_intersection(&setup->tri_regions[viewport_index], &bbox)) {
       if (0) debug_printf("offscreen\n");
       LP_COUNT(nr_culled_tris);
       return TRUE;
    }
 
+   /* Triangles in the guard band which weren't clipped by draw need to be
+    * scissored to the viewport.
+    */
+   if (setup->scissor_test ||
+       (setup->guard_band &&
+        !u_rect_contains(&setup->tri_regions[viewport_index], &bbox))) {
+      nr_planes = 7;
+   }
+
+   use_32bits = lp_setup_fits_32bits(&bbox);
+
    /* Can safely discard negative regions, but need to keep hold of
     * information about when the triangle extends past screen
     * boundaries.  See trimmed_box in lp_setup_bin_triangle().
@@ -381,8 +389,7 @@ do_triangle_ccw(struct lp_setup_context *setup,
 #if defined(PIPE_ARCH_SSE)
    if (setup->fb.width <= MAX_FIXED_LENGTH32 &&
        setup->fb.height <= MAX_FIXED_LENGTH32 &&
-       (bbox.x1 - bbox.x0) <= MAX_FIXED_LENGTH32 &&
-       (bbox.y1 - bbox.y0) <= MAX_FIXED_LENGTH32) {
+       use_32bits) {
       __m128i vertx, verty;
       __m128i shufx, shufy;
       __m128i dcdx, dcdy, c;
@@ -532,7 +539,8 @@ do_triangle_ccw(struct lp_setup_context *setup,
    /* 
     * When rasterizing scissored tris, use the intersection of the
     * triangle bounding box and the scissor rect to generate the
-    * scissor planes.
+    * scissor planes.  The draw region is the scissor rect, restricted
+    * to the viewport when guard band clipping is enabled.
     *
     * This permits us to cut off the triangle "tails" that are present
     * in the intermediate recursive levels caused when two of the
@@ -548,7 +556,7 @@ do_triangle_ccw(struct lp_setup_context *setup,
     * these planes elsewhere.
     */
    if (nr_planes == 7) {
-      const struct u_rect *scissor = &setup->scissors[viewport_index];
+      const struct u_rect *scissor = &setup->tri_regions[viewport_index];
 
       plane[3].dcdx = -1;
       plane[3].dcdy = 0;
@@ -571,7 +579,8 @@ do_triangle_ccw(struct lp_setup_context *setup,
       plane[6].eo = 0;
    }
 
-   return lp_setup_bin_triangle(setup, tri, &bbox, nr_planes, viewport_index);
+   return lp_setup_bin_triangle(setup, tri, &bbox, nr_planes, use_32bits,
+                                viewport_index);
 }
 
 /*
@@ -606,6 +615,7 @@ lp_setup_bin_triangle( struct lp_setup_context *setup,
                        struct lp_rast_triangle *tri,
                        const struct u_rect *bbox,
                        int nr_planes,
+                       boolean use_32bits,
                        unsigned viewport_index )
 {
    struct lp_scene *scene = setup->scene;
@@ -622,7 +632,6 @@ lp_setup_bin_triangle( struct lp_setup_context *setup,
    int max_sz = ((bbox->x1 - (bbox->x0 & ~3)) |
                  (bbox->y1 - (bbox->y0 & ~3)));
    int sz = floor_pot(max_sz);
-   boolean use_32bits = max_sz <= MAX_FIXED_LENGTH32;
 
    /* Now apply scissor, etc to the bounding box.  Could do this
     * earlier, but it confuses the logic for tri-16 and would force
@@ -728,8 +737,8 @@ lp_setup_bin_triangle( struct lp_setup_context *setup,
                  IMUL64(plane[i].dcdy, iy0) * TILE_SIZE -
                  IMUL64(plane[i].dcdx, ix0) * TILE_SIZE);
 
-         ei[i] = (plane[i].dcdy - 
-                  plane[i].dcdx - 
+         ei[i] = ((int64_t)plane[i].dcdy -
+                  plane[i].dcdx -
                   plane[i].eo) << TILE_ORDER;
 
          eo[i] = plane[i].eo << TILE_ORDER;
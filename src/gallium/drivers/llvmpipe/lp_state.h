@@ -118,6 +118,9 @@ llvmpipe_init_draw_funcs(struct llvmpipe_context *llvmpipe);
 void
 llvmpipe_init_clip_funcs(struct llvmpipe_context *llvmpipe);
 
+void
+llvmpipe_update_guard_band(struct llvmpipe_context *llvmpipe);
+
 void
 llvmpipe_init_fs_funcs(struct llvmpipe_context *llvmpipe);
 
@@ -27,11 +27,26 @@
 
 /* Authors:  Keith Whitwell <keithw@vmware.com>
  */
+#include "util/u_math.h"
 #include "lp_context.h"
+#include "lp_debug.h"
+#include "lp_setup.h"
 #include "lp_state.h"
 #include "draw/draw_context.h"
 
 
+/**
+ * Largest window coordinate primitives in the guard band may reach.
+ *
+ * Setup converts vertices to 24.8 fixed point and keeps the edge
+ * increments in 32 bits after shifting them up by another FIXED_ORDER bits
+ * (see lp_setup_tri.c and lp_setup_line.c), so no edge may be 2^15 pixels
+ * long or more.  Keeping every vertex within +/-16000 leaves some room for
+ * the pixel center offset and for the ends of lines.
+ */
+#define LP_GUARD_BAND_MAX_COORD 16000.0f
+
+
 static void
 llvmpipe_set_clip_state(struct pipe_context *pipe,
                         const struct pipe_clip_state *clip)
@@ -43,6 +58,57 @@ llvmpipe_set_clip_state(struct pipe_context *pipe,
 }
 
 
+/**
+ * Enable the draw module's guard band clipping when possible, and size
+ * the guard band so that it fits the fixed point range for every viewport.
+ */
+void
+llvmpipe_update_guard_band(struct llvmpipe_context *llvmpipe)
+{
+   const struct pipe_rasterizer_state *rast = llvmpipe->rasterizer;
+   float size_x = LP_GUARD_BAND_MAX_COORD;
+   float size_y = LP_GUARD_BAND_MAX_COORD;
+   boolean guard_band;
+   unsigned i;
+
+   /* Wide and smooth lines are clipped to the viewport before they are
+    * widened, and draw turns smooth points into triangles, so all of them
+    * may cover pixels past the viewport, which setup would scissor away.
+    * Have draw clip everything to the viewport for those.
+    */
+   guard_band = !(LP_PERF & PERF_NO_GUARD_BAND) &&
+                !(rast && (rast->line_width > 1.0f ||
+                           rast->line_smooth ||
+                           rast->point_smooth));
+
+   if (guard_band != llvmpipe->guard_band) {
+      draw_set_driver_clipping(llvmpipe->draw, FALSE, FALSE, guard_band, FALSE);
+      lp_setup_set_guard_band(llvmpipe->setup, guard_band);
+      llvmpipe->guard_band = guard_band;
+   }
+
+   if (!guard_band)
+      return;
+
+   for (i = 0; i < PIPE_MAX_VIEWPORTS; i++) {
+      const struct pipe_viewport_state *vp = &llvmpipe->viewports[i];
+      float scale_x = fabsf(vp->scale[0]);
+      float scale_y = fabsf(vp->scale[1]);
+
+      if (scale_x > 0.0f)
+         size_x = MIN2(size_x, (LP_GUARD_BAND_MAX_COORD -
+                                fabsf(vp->translate[0])) / scale_x);
+      if (scale_y > 0.0f)
+         size_y = MIN2(size_y, (LP_GUARD_BAND_MAX_COORD -
+                                fabsf(vp->translate[1])) / scale_y);
+   }
+
+   draw_set_guard_band_size(llvmpipe->draw,
+                            MAX2(size_x, 1.0f),
+                            MAX2(size_y, 1.0f));
+}
+
+
 static void
 llvmpipe_set_viewport_states(struct pipe_context *pipe,
                              unsigned start_slot,
@@ -57,6 +123,7 @@ llvmpipe_set_viewport_states(struct pipe_context *pipe,
 
    memcpy(llvmpipe->viewports + start_slot, viewports,
           sizeof(struct pipe_viewport_state) * num_viewports);
+   llvmpipe_update_guard_band(llvmpipe);
    llvmpipe->dirty |= LP_NEW_VIEWPORT;
 }
 
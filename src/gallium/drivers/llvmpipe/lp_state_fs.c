@@ -101,6 +101,7 @@
 #include "lp_flush.h"
 #include "lp_state_fs.h"
 #include "lp_rast.h"
+#include "lp_texture.h"
 
 
 /** Fragment shader number (for debugging) */
@@ -2285,7 +2286,8 @@ generate_fragment(struct llvmpipe_context *lp,
    LLVMPositionBuilderAtEnd(builder, block);
 
    /* code generated texture sampling */
-   sampler = lp_llvm_sampler_soa_create(key->state, context_ptr);
+   sampler = lp_llvm_sampler_soa_create(key->state, context_ptr,
+                                        thread_data_ptr);
 
    num_fs = 16 / fs_type.length; /* number of loops per 4x4 stamp */
    /* for 1d resources only run "upper half" of stamp */
@@ -2876,6 +2878,20 @@ force_dst_alpha_one(unsigned factor, boolean clamped_zero)
  * TODO: there is actually no reason to tie this to context state -- the
  * generated code could be cached globally in the screen.
  */
+/**
+ * Like lp_sampler_static_texture_state(), plus the llvmpipe texture layout.
+ */
+static void
+make_texture_state(struct lp_static_texture_state *state,
+                   const struct pipe_sampler_view *view)
+{
+   lp_sampler_static_texture_state(state, view);
+
+   if (view && view->texture)
+      state->tiled = llvmpipe_resource_const(view->texture)->tiled;
+}
+
+
 static void
 make_variant_key(struct llvmpipe_context *lp,
                  struct lp_fragment_shader *shader,
@@ -3026,6 +3042,8 @@ make_variant_key(struct llvmpipe_context *lp,
       if(shader->info.base.file_mask[TGSI_FILE_SAMPLER] & (1 << i)) {
          lp_sampler_static_sampler_state(&key->state[i].sampler_state,
                                          lp->samplers[PIPE_SHADER_FRAGMENT][i]);
+         if (LP_PERF & PERF_TEXEL_CENTER)
+            key->state[i].sampler_state.texel_center_shortcut = 1;
       }
    }
 
@@ -3038,8 +3056,8 @@ make_variant_key(struct llvmpipe_context *lp,
       key->nr_sampler_views = shader->info.base.file_max[TGSI_FILE_SAMPLER_VIEW] + 1;
       for(i = 0; i < key->nr_sampler_views; ++i) {
          if(shader->info.base.file_mask[TGSI_FILE_SAMPLER_VIEW] & (1 << i)) {
-            lp_sampler_static_texture_state(&key->state[i].texture_state,
-                                            lp->sampler_views[PIPE_SHADER_FRAGMENT][i]);
+            make_texture_state(&key->state[i].texture_state,
+                               lp->sampler_views[PIPE_SHADER_FRAGMENT][i]);
          }
       }
    }
@@ -3047,8 +3065,8 @@ make_variant_key(struct llvmpipe_context *lp,
       key->nr_sampler_views = key->nr_samplers;
       for(i = 0; i < key->nr_sampler_views; ++i) {
          if(shader->info.base.file_mask[TGSI_FILE_SAMPLER] & (1 << i)) {
-            lp_sampler_static_texture_state(&key->state[i].texture_state,
-                                            lp->sampler_views[PIPE_SHADER_FRAGMENT][i]);
+            make_texture_state(&key->state[i].texture_state,
+                               lp->sampler_views[PIPE_SHADER_FRAGMENT][i]);
          }
       }
    }
@@ -132,6 +132,8 @@ llvmpipe_bind_rasterizer_state(struct pipe_context *pipe, void *handle)
       draw_set_rasterizer_state(llvmpipe->draw, NULL, handle);      
    }
 
+   llvmpipe_update_guard_band(llvmpipe);
+
    llvmpipe->dirty |= LP_NEW_RASTERIZER;
 }
 
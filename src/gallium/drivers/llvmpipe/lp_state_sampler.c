@@ -38,6 +38,7 @@
 #include "lp_screen.h"
 #include "lp_state.h"
 #include "lp_debug.h"
+#include "lp_texture.h"
 #include "state_tracker/sw_winsys.h"
 
 
@@ -144,6 +145,10 @@ llvmpipe_set_sampler_views(struct pipe_context *pipe,
                                 &llvmpipe->sampler_views[shader][start + i]);
       pipe_sampler_view_reference(&llvmpipe->sampler_views[shader][start + i],
                                   views[i]);
+
+      /* The draw module's samplers only know the linear layout */
+      if (shader != PIPE_SHADER_FRAGMENT && views[i] && views[i]->texture)
+         llvmpipe_resource_untile(pipe, llvmpipe_resource(views[i]->texture));
    }
 
    /* find highest non-null sampler_views[] entry */
@@ -159,7 +159,20 @@ lp_resource_copy(struct pipe_context *pipe,
          = llvmpipe_get_texture_image_address(dst_tex, dstz,
                                               dst_level);
 
-      if (dst_linear_ptr && src_linear_ptr) {
+      if (dst_linear_ptr && src_linear_ptr &&
+          (src_tex->tiled || dst_tex->tiled)) {
+         /* tiled textures are 2D, so there is a single slice to copy */
+         assert(depth == 1);
+         llvmpipe_copy_texture_rect(dst_linear_ptr,
+                                    llvmpipe_resource_stride(&dst_tex->base, dst_level),
+                                    dst_tex->tiled, dstx, dsty,
+                                    src_linear_ptr,
+                                    llvmpipe_resource_stride(&src_tex->base, src_level),
+                                    src_tex->tiled, src_box->x, src_box->y,
+                                    width, height,
+                                    util_format_get_blocksize(format));
+      }
+      else if (dst_linear_ptr && src_linear_ptr) {
          util_copy_box(dst_linear_ptr, format,
                        llvmpipe_resource_stride(&dst_tex->base, dst_level),
                        dst_tex->img_stride[dst_level],
@@ -249,6 +262,9 @@ llvmpipe_create_surface(struct pipe_context *pipe,
    if (!(pt->bind & (PIPE_BIND_DEPTH_STENCIL | PIPE_BIND_RENDER_TARGET)))
       debug_printf("Illegal surface creation without bind flag\n");
 
+   /* The rasterizer only writes the linear layout */
+   llvmpipe_resource_untile(pipe, llvmpipe_resource(pt));
+
    ps = CALLOC_STRUCT(pipe_surface);
    if (ps) {
       pipe_reference_init(&ps->reference, 1);
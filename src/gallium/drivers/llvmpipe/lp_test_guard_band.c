@@ -0,0 +1,415 @@
+/**************************************************************************
+ *
+ * Copyright 2014 VMware, Inc.
+ * All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL VMWARE AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ **************************************************************************/
+
+
+/**
+ * @file
+ * Renders primitives whose vertices lie far outside the viewport, so that
+ * they go through the guard band instead of being clipped, and checks that
+ * the rasterized pixels match the exact coverage.
+ */
+
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <math.h>
+
+#include "pipe/p_context.h"
+#include "pipe/p_defines.h"
+#include "pipe/p_screen.h"
+#include "pipe/p_shader_tokens.h"
+#include "pipe/p_state.h"
+#include "state_tracker/sw_winsys.h"
+#include "cso_cache/cso_context.h"
+#include "util/u_draw_quad.h"
+#include "util/u_inlines.h"
+#include "util/u_memory.h"
+#include "util/u_simple_shaders.h"
+
+#include "lp_public.h"
+#include "lp_test.h"
+
+
+#define WIDTH 256
+#define HEIGHT 256
+
+
+struct guard_band_test_case
+{
+   const char *name;
+   unsigned prim;
+   unsigned num_verts;
+   float pos[3][2];
+};
+
+
+/*
+ * All of these cross the viewport, and have vertices well past the
+ * largest window coordinate the guard band allows.
+ */
+static const struct guard_band_test_case test_cases[] = {
+   { "diagonal triangle", PIPE_PRIM_TRIANGLES, 3,
+     { { -200.0f, -200.0f }, { 200.0f, -200.0f }, { -200.0f, 200.0f } } },
+   { "sliver triangle", PIPE_PRIM_TRIANGLES, 3,
+     { { -300.0f, -0.5f }, { 300.0f, -0.5f }, { 300.0f, 0.5f } } },
+   { "tall triangle", PIPE_PRIM_TRIANGLES, 3,
+     { { -0.3f, -1000.0f }, { 0.6f, 1000.0f }, { -0.7f, 1000.0f } } },
+   { "horizontal line", PIPE_PRIM_LINES, 2,
+     { { -300.0f, 0.1f }, { 300.0f, 0.1f } } },
+   { "vertical line", PIPE_PRIM_LINES, 2,
+     { { -0.3f, -1000.0f }, { -0.3f, 1000.0f } } },
+   { "sloped line", PIPE_PRIM_LINES, 2,
+     { { -250.0f, -200.0f }, { 250.0f, 200.0f } } },
+};
+
+
+struct guard_band_context
+{
+   struct pipe_screen *screen;
+   struct pipe_context *pipe;
+   struct cso_context *cso;
+   struct pipe_resource *target;
+   struct pipe_framebuffer_state framebuffer;
+   struct pipe_vertex_element velem[2];
+   void *vs;
+   void *fs;
+};
+
+
+/*
+ * Nothing here is ever displayed, so the winsys does not need to provide
+ * display targets.
+ */
+static boolean
+test_is_displaytarget_format_supported(struct sw_winsys *ws,
+                                       unsigned tex_usage,
+                                       enum pipe_format format)
+{
+   return FALSE;
+}
+
+
+static struct sw_winsys test_winsys = {
+   NULL,
+   test_is_displaytarget_format_supported
+};
+
+
+static boolean
+init_context(struct guard_band_context *ctx)
+{
+   const uint semantic_names[] = { TGSI_SEMANTIC_POSITION,
+                                   TGSI_SEMANTIC_COLOR };
+   const uint semantic_indexes[] = { 0, 0 };
+   struct pipe_resource templ;
+   struct pipe_surface surf_templ;
+   struct pipe_blend_state blend;
+   struct pipe_depth_stencil_alpha_state dsa;
+   struct pipe_rasterizer_state rast;
+   struct pipe_viewport_state viewport;
+
+   memset(ctx, 0, sizeof *ctx);
+
+   ctx->screen = llvmpipe_create_screen(&test_winsys);
+   if (!ctx->screen)
+      return FALSE;
+
+   ctx->pipe = ctx->screen->context_create(ctx->screen, NULL);
+   if (!ctx->pipe)
+      return FALSE;
+
+   ctx->cso = cso_create_context(ctx->pipe);
+
+   memset(&templ, 0, sizeof templ);
+   templ.target = PIPE_TEXTURE_2D;
+   templ.format = PIPE_FORMAT_B8G8R8A8_UNORM;
+   templ.width0 = WIDTH;
+   templ.height0 = HEIGHT;
+   templ.depth0 = 1;
+   templ.array_size = 1;
+   templ.bind = PIPE_BIND_RENDER_TARGET;
+   ctx->target = ctx->screen->resource_create(ctx->screen, &templ);
+   if (!ctx->target)
+      return FALSE;
+
+   memset(&surf_templ, 0, sizeof surf_templ);
+   surf_templ.format = templ.format;
+   ctx->framebuffer.width = WIDTH;
+   ctx->framebuffer.height = HEIGHT;
+   ctx->framebuffer.nr_cbufs = 1;
+   ctx->framebuffer.cbufs[0] = ctx->pipe->create_surface(ctx->pipe,
+                                                         ctx->target,
+                                                         &surf_templ);
+
+   memset(&blend, 0, sizeof blend);
+   blend.rt[0].colormask = PIPE_MASK_RGBA;
+
+   memset(&dsa, 0, sizeof dsa);
+
+   memset(&rast, 0, sizeof rast);
+   rast.cull_face = PIPE_FACE_NONE;
+   rast.half_pixel_center = 1;
+   rast.bottom_edge_rule = 1;
+   rast.depth_clip = 1;
+   rast.line_width = 1.0f;
+
+   memset(&viewport, 0, sizeof viewport);
+   viewport.scale[0] = WIDTH / 2.0f;
+   viewport.scale[1] = HEIGHT / 2.0f;
+   viewport.scale[2] = 0.5f;
+   viewport.scale[3] = 1.0f;
+   viewport.translate[0] = WIDTH / 2.0f;
+   viewport.translate[1] = HEIGHT / 2.0f;
+   viewport.translate[2] = 0.5f;
+
+   memset(ctx->velem, 0, sizeof ctx->velem);
+   ctx->velem[0].src_offset = 0;
+   ctx->velem[0].src_format = PIPE_FORMAT_R32G32B32A32_FLOAT;
+   ctx->velem[1].src_offset = 4 * sizeof(float);
+   ctx->velem[1].src_format = PIPE_FORMAT_R32G32B32A32_FLOAT;
+
+   ctx->vs = util_make_vertex_passthrough_shader(ctx->pipe, 2,
+                                                 semantic_names,
+                                                 semantic_indexes);
+   ctx->fs = util_make_fragment_passthrough_shader(ctx->pipe,
+                                                   TGSI_SEMANTIC_COLOR,
+                                                   TGSI_INTERPOLATE_CONSTANT,
+                                                   TRUE);
+
+   cso_set_framebuffer(ctx->cso, &ctx->framebuffer);
+   cso_set_blend(ctx->cso, &blend);
+   cso_set_depth_stencil_alpha(ctx->cso, &dsa);
+   cso_set_rasterizer(ctx->cso, &rast);
+   cso_set_viewport(ctx->cso, &viewport);
+   cso_set_vertex_shader_handle(ctx->cso, ctx->vs);
+   cso_set_fragment_shader_handle(ctx->cso, ctx->fs);
+   cso_set_vertex_elements(ctx->cso, 2, ctx->velem);
+
+   return TRUE;
+}
+
+
+static void
+destroy_context(struct guard_band_context *ctx)
+{
+   if (ctx->cso) {
+      cso_release_all(ctx->cso);
+      cso_destroy_context(ctx->cso);
+   }
+
+   if (ctx->vs)
+      ctx->pipe->delete_vs_state(ctx->pipe, ctx->vs);
+   if (ctx->fs)
+      ctx->pipe->delete_fs_state(ctx->pipe, ctx->fs);
+
+   pipe_surface_reference(&ctx->framebuffer.cbufs[0], NULL);
+   pipe_resource_reference(&ctx->target, NULL);
+
+   if (ctx->pipe)
+      ctx->pipe->destroy(ctx->pipe);
+   if (ctx->screen)
+      ctx->screen->destroy(ctx->screen);
+}
+
+
+/**
+ * Signed distance, in pixels, of the window position (x, y) from the line
+ * through a and b.  Positive on the left of a->b.
+ */
+static double
+edge_distance(const double a[2], const double b[2], double x, double y)
+{
+   double dx = b[0] - a[0];
+   double dy = b[1] - a[1];
+
+   return (dx * (y - a[1]) - dy * (x - a[0])) / sqrt(dx * dx + dy * dy);
+}
+
+
+/**
+ * Whether the pixel centered at (x, y) must be covered (1), must not be
+ * covered (0), or is too close to an edge to tell (-1).
+ */
+static int
+expected_coverage(const double win[3][2], const struct guard_band_test_case *test,
+                  double x, double y)
+{
+   if (test->prim == PIPE_PRIM_TRIANGLES) {
+      double sign = edge_distance(win[0], win[1], win[2][0], win[2][1]) > 0.0 ?
+                    1.0 : -1.0;
+      double min_dist = 1e30;
+      unsigned i;
+
+      for (i = 0; i < 3; i++) {
+         double d = sign * edge_distance(win[i], win[(i + 1) % 3], x, y);
+         min_dist = MIN2(min_dist, d);
+      }
+
+      if (min_dist > 1.0)
+         return 1;
+      if (min_dist < -1.0)
+         return 0;
+      return -1;
+   }
+   else {
+      double d = fabs(edge_distance(win[0], win[1], x, y));
+
+      if (d < 0.25)
+         return 1;
+      if (d > 0.75)
+         return 0;
+      return -1;
+   }
+}
+
+
+static boolean
+test_guard_band(struct guard_band_context *ctx, unsigned verbose, FILE *fp,
+                const struct guard_band_test_case *test)
+{
+   const union pipe_color_union black = { { 0.0f, 0.0f, 0.0f, 0.0f } };
+   float vertices[3][2][4];
+   double win[3][2];
+   struct pipe_resource *vbuf;
+   struct pipe_transfer *transfer;
+   const ubyte *map;
+   unsigned wrong = 0, covered = 0;
+   unsigned i, x, y;
+   boolean success;
+
+   for (i = 0; i < test->num_verts; i++) {
+      vertices[i][0][0] = test->pos[i][0];
+      vertices[i][0][1] = test->pos[i][1];
+      vertices[i][0][2] = 0.0f;
+      vertices[i][0][3] = 1.0f;
+      vertices[i][1][0] = 1.0f;
+      vertices[i][1][1] = 1.0f;
+      vertices[i][1][2] = 1.0f;
+      vertices[i][1][3] = 1.0f;
+
+      win[i][0] = test->pos[i][0] * (WIDTH / 2.0) + WIDTH / 2.0;
+      win[i][1] = test->pos[i][1] * (HEIGHT / 2.0) + HEIGHT / 2.0;
+   }
+
+   vbuf = pipe_buffer_create(ctx->screen, PIPE_BIND_VERTEX_BUFFER,
+                             PIPE_USAGE_STATIC, sizeof vertices);
+   pipe_buffer_write(ctx->pipe, vbuf, 0, sizeof vertices, vertices);
+
+   ctx->pipe->clear(ctx->pipe, PIPE_CLEAR_COLOR, &black, 0.0, 0);
+   util_draw_vertex_buffer(ctx->pipe, ctx->cso, vbuf, 0, 0,
+                           test->prim, test->num_verts, 2);
+   ctx->pipe->flush(ctx->pipe, NULL, 0);
+
+   map = pipe_transfer_map(ctx->pipe, ctx->target, 0, 0, PIPE_TRANSFER_READ,
+                           0, 0, WIDTH, HEIGHT, &transfer);
+
+   for (y = 0; y < HEIGHT; y++) {
+      const uint32_t *row = (const uint32_t *)(map + y * transfer->stride);
+
+      for (x = 0; x < WIDTH; x++) {
+         int expected = expected_coverage(win, test, x + 0.5, y + 0.5);
+         int result = row[x] != 0;
+
+         covered += result;
+
+         if (expected >= 0 && expected != result) {
+            if (verbose && wrong < 8)
+               printf("  %s: pixel %u,%u is %s\n", test->name, x, y,
+                      result ? "covered" : "not covered");
+            wrong++;
+         }
+      }
+   }
+
+   pipe_transfer_unmap(ctx->pipe, transfer);
+   pipe_resource_reference(&vbuf, NULL);
+
+   /* An empty image would trivially match the lines' expectations away
+    * from the line, so make sure something got drawn at all.
+    */
+   success = wrong == 0 && covered != 0;
+
+   if (!success || verbose)
+      printf("%s: %s (%u wrong pixels, %u covered)\n", test->name,
+             success ? "PASS" : "FAIL", wrong, covered);
+
+   if (fp)
+      fprintf(fp, "%s\t\"%s\"\n", success ? "pass" : "fail", test->name);
+
+   return success;
+}
+
+
+void
+write_tsv_header(FILE *fp)
+{
+   fprintf(fp,
+           "result\t"
+           "primitive\n");
+
+   fflush(fp);
+}
+
+
+boolean
+test_all(unsigned verbose, FILE *fp)
+{
+   struct guard_band_context ctx;
+   boolean success = TRUE;
+   unsigned i;
+
+   if (!init_context(&ctx)) {
+      printf("failed to create an llvmpipe context\n");
+      destroy_context(&ctx);
+      return FALSE;
+   }
+
+   for (i = 0; i < Elements(test_cases); i++) {
+      if (!test_guard_band(&ctx, verbose, fp, &test_cases[i]))
+         success = FALSE;
+   }
+
+   destroy_context(&ctx);
+
+   return success;
+}
+
+
+boolean
+test_some(unsigned verbose, FILE *fp,
+          unsigned long n)
+{
+   return test_all(verbose, fp);
+}
+
+
+boolean
+test_single(unsigned verbose, FILE *fp)
+{
+   printf("no test_single()");
+   return TRUE;
+}
@@ -0,0 +1,666 @@
+/**************************************************************************
+ *
+ * Copyright 2014 VMware, Inc.
+ * All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL VMWARE AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ **************************************************************************/
+
+
+
+/**
+ * @file
+ * Unit tests for bilinear texture sampling with lp_build_sample_soa(),
+ * checked against a C reference and the texel fetch statistics, with cycle
+ * counts for texel centered and off-center coordinates.  Textures are
+ * sampled both in the linear and in the llvmpipe tiled layout.
+ */
+
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+#include "util/u_memory.h"
+#include "util/u_format.h"
+#include "util/u_pointer.h"
+
+#include "gallivm/lp_bld_const.h"
+#include "gallivm/lp_bld_init.h"
+#include "gallivm/lp_bld_sample.h"
+#include "gallivm/lp_bld_type.h"
+
+#include "lp_texture.h"
+#include "lp_test.h"
+
+
+#define TEX_SIZE 64
+
+
+/** Dynamic state returning constants describing a single level texture */
+struct sample_test_state
+{
+   struct lp_sampler_dynamic_state base;
+
+   const void *data;
+   int row_stride[PIPE_MAX_TEXTURE_LEVELS];
+   int img_stride[PIPE_MAX_TEXTURE_LEVELS];
+   int mip_offsets[PIPE_MAX_TEXTURE_LEVELS];
+   float border_color[4];
+
+   struct lp_sampler_stats stats;
+};
+
+
+typedef void
+(*sample_func)(const float *s, const float *t, float *rgba);
+
+
+static const enum pipe_format
+test_formats[] = {
+   PIPE_FORMAT_R8G8B8A8_UNORM,
+   PIPE_FORMAT_R32G32B32A32_FLOAT,
+};
+
+
+void
+write_tsv_header(FILE *fp)
+{
+   fprintf(fp,
+           "result\t"
+           "cycles_per_pixel\t"
+           "format\t"
+           "layout\t"
+           "coords\n");
+
+   fflush(fp);
+}
+
+
+static void
+write_tsv_row(FILE *fp,
+              enum pipe_format format,
+              boolean tiled,
+              const char *coords,
+              double cycles,
+              boolean success)
+{
+   fprintf(fp, "%s\t", success ? "pass" : "fail");
+
+   fprintf(fp, "%.1f\t", cycles / 4);
+
+   fprintf(fp, "%s\t%s\t%s\n", util_format_name(format),
+           tiled ? "tiled" : "linear", coords);
+
+   fflush(fp);
+}
+
+
+static LLVMValueRef
+test_int(struct gallivm_state *gallivm, int value)
+{
+   return lp_build_const_int32(gallivm, value);
+}
+
+
+static LLVMValueRef
+test_array(struct gallivm_state *gallivm, const int *array)
+{
+   LLVMTypeRef array_type =
+      LLVMArrayType(LLVMInt32TypeInContext(gallivm->context),
+                    PIPE_MAX_TEXTURE_LEVELS);
+
+   return LLVMBuildBitCast(gallivm->builder,
+                           lp_build_const_int_pointer(gallivm, array),
+                           LLVMPointerType(array_type, 0), "");
+}
+
+
+static LLVMValueRef
+test_width(const struct lp_sampler_dynamic_state *state,
+           struct gallivm_state *gallivm, unsigned unit)
+{
+   return test_int(gallivm, TEX_SIZE);
+}
+
+
+static LLVMValueRef
+test_depth(const struct lp_sampler_dynamic_state *state,
+           struct gallivm_state *gallivm, unsigned unit)
+{
+   return test_int(gallivm, 1);
+}
+
+
+static LLVMValueRef
+test_level(const struct lp_sampler_dynamic_state *state,
+           struct gallivm_state *gallivm, unsigned unit)
+{
+   return test_int(gallivm, 0);
+}
+
+
+static LLVMValueRef
+test_row_stride(const struct lp_sampler_dynamic_state *state,
+                struct gallivm_state *gallivm, unsigned unit)
+{
+   return test_array(gallivm,
+                     ((const struct sample_test_state *)state)->row_stride);
+}
+
+
+static LLVMValueRef
+test_img_stride(const struct lp_sampler_dynamic_state *state,
+                struct gallivm_state *gallivm, unsigned unit)
+{
+   return test_array(gallivm,
+                     ((const struct sample_test_state *)state)->img_stride);
+}
+
+
+static LLVMValueRef
+test_mip_offsets(const struct lp_sampler_dynamic_state *state,
+                 struct gallivm_state *gallivm, unsigned unit)
+{
+   return test_array(gallivm,
+                     ((const struct sample_test_state *)state)->mip_offsets);
+}
+
+
+static LLVMValueRef
+test_base_ptr(const struct lp_sampler_dynamic_state *state,
+              struct gallivm_state *gallivm, unsigned unit)
+{
+   LLVMTypeRef i8_ptr_type =
+      LLVMPointerType(LLVMInt8TypeInContext(gallivm->context), 0);
+
+   return LLVMBuildBitCast(gallivm->builder,
+                           lp_build_const_int_pointer(gallivm,
+                              ((const struct sample_test_state *)state)->data),
+                           i8_ptr_type, "");
+}
+
+
+static LLVMValueRef
+test_lod(const struct lp_sampler_dynamic_state *state,
+         struct gallivm_state *gallivm, unsigned unit)
+{
+   return lp_build_const_float(gallivm, 0.0f);
+}
+
+
+static LLVMValueRef
+test_border_color(const struct lp_sampler_dynamic_state *state,
+                  struct gallivm_state *gallivm, unsigned unit)
+{
+   LLVMTypeRef float_ptr_type =
+      LLVMPointerType(LLVMFloatTypeInContext(gallivm->context), 0);
+
+   return LLVMBuildBitCast(gallivm->builder,
+                           lp_build_const_int_pointer(gallivm,
+                              ((const struct sample_test_state *)state)->border_color),
+                           float_ptr_type, "");
+}
+
+
+static LLVMValueRef
+test_stats_ptr(const struct lp_sampler_dynamic_state *state,
+               struct gallivm_state *gallivm, unsigned unit)
+{
+   LLVMTypeRef i8_ptr_type =
+      LLVMPointerType(LLVMInt8TypeInContext(gallivm->context), 0);
+
+   return LLVMBuildBitCast(gallivm->builder,
+                           lp_build_const_int_pointer(gallivm,
+                              &((const struct sample_test_state *)state)->stats),
+                           i8_ptr_type, "");
+}
+
+
+static void
+init_test_state(struct sample_test_state *state,
+                const struct util_format_description *desc,
+                const void *data)
+{
+   memset(state, 0, sizeof *state);
+
+   state->base.width = test_width;
+   state->base.height = test_width;
+   state->base.depth = test_depth;
+   state->base.first_level = test_level;
+   state->base.last_level = test_level;
+   state->base.row_stride = test_row_stride;
+   state->base.img_stride = test_img_stride;
+   state->base.base_ptr = test_base_ptr;
+   state->base.mip_offsets = test_mip_offsets;
+   state->base.min_lod = test_lod;
+   state->base.max_lod = test_lod;
+   state->base.lod_bias = test_lod;
+   state->base.border_color = test_border_color;
+
+   state->data = data;
+   state->row_stride[0] = TEX_SIZE * desc->block.bits / 8;
+   state->img_stride[0] = TEX_SIZE * state->row_stride[0];
+}
+
+
+/**
+ * Build
+ *
+ *    void sample(const float *s, const float *t, float *rgba);
+ *
+ * sampling four pixels, with rgba in SoA layout, and recording the texel
+ * fetches in state->stats if with_stats is set.
+ */
+static LLVMValueRef
+add_sample_test(struct gallivm_state *gallivm,
+                enum pipe_format format,
+                boolean tiled,
+                struct sample_test_state *state,
+                boolean with_stats)
+{
+   LLVMContextRef context = gallivm->context;
+   LLVMBuilderRef builder = gallivm->builder;
+   struct lp_type type = lp_float32_vec4_type();
+   LLVMTypeRef vec_type = lp_build_vec_type(gallivm, type);
+   LLVMTypeRef float_ptr_type = LLVMPointerType(LLVMFloatTypeInContext(context), 0);
+   LLVMTypeRef vec_ptr_type = LLVMPointerType(vec_type, 0);
+   LLVMTypeRef args[3];
+   struct lp_static_texture_state texture_state;
+   struct lp_static_sampler_state sampler_state;
+   LLVMValueRef func, s_ptr, t_ptr, rgba_ptr;
+   LLVMValueRef coords[5], offsets[3], texel[4];
+   LLVMBasicBlockRef block;
+   unsigned chan;
+
+   memset(&texture_state, 0, sizeof texture_state);
+   texture_state.format = format;
+   texture_state.swizzle_r = PIPE_SWIZZLE_RED;
+   texture_state.swizzle_g = PIPE_SWIZZLE_GREEN;
+   texture_state.swizzle_b = PIPE_SWIZZLE_BLUE;
+   texture_state.swizzle_a = PIPE_SWIZZLE_ALPHA;
+   texture_state.target = PIPE_TEXTURE_2D;
+   texture_state.pot_width = 1;
+   texture_state.pot_height = 1;
+   texture_state.pot_depth = 1;
+   texture_state.level_zero_only = 1;
+   texture_state.tiled = tiled;
+
+   memset(&sampler_state, 0, sizeof sampler_state);
+   sampler_state.wrap_s = PIPE_TEX_WRAP_CLAMP_TO_EDGE;
+   sampler_state.wrap_t = PIPE_TEX_WRAP_CLAMP_TO_EDGE;
+   sampler_state.wrap_r = PIPE_TEX_WRAP_CLAMP_TO_EDGE;
+   sampler_state.min_img_filter = PIPE_TEX_FILTER_LINEAR;
+   sampler_state.mag_img_filter = PIPE_TEX_FILTER_LINEAR;
+   sampler_state.min_mip_filter = PIPE_TEX_MIPFILTER_NONE;
+   sampler_state.normalized_coords = 1;
+   sampler_state.min_max_lod_equal = 1;
+   sampler_state.texel_center_shortcut = 1;
+
+   args[0] = float_ptr_type;
+   args[1] = float_ptr_type;
+   args[2] = float_ptr_type;
+   state->base.stats_ptr = with_stats ? test_stats_ptr : NULL;
+
+   func = LLVMAddFunction(gallivm->module,
+                          with_stats ? "sample_stats" : "sample",
+                          LLVMFunctionType(LLVMVoidTypeInContext(context),
+                                           args, 3, 0));
+   LLVMSetFunctionCallConv(func, LLVMCCallConv);
+   s_ptr = LLVMGetParam(func, 0);
+   t_ptr = LLVMGetParam(func, 1);
+   rgba_ptr = LLVMGetParam(func, 2);
+
+   block = LLVMAppendBasicBlockInContext(context, func, "entry");
+   LLVMPositionBuilderAtEnd(builder, block);
+
+   s_ptr = LLVMBuildBitCast(builder, s_ptr, vec_ptr_type, "");
+   t_ptr = LLVMBuildBitCast(builder, t_ptr, vec_ptr_type, "");
+   rgba_ptr = LLVMBuildBitCast(builder, rgba_ptr, vec_ptr_type, "");
+
+   coords[0] = LLVMBuildLoad(builder, s_ptr, "s");
+   lp_set_load_alignment(coords[0], 4);
+   coords[1] = LLVMBuildLoad(builder, t_ptr, "t");
+   lp_set_load_alignment(coords[1], 4);
+   coords[2] = coords[3] = coords[4] = lp_build_const_vec(gallivm, type, 0.0);
+   offsets[0] = offsets[1] = offsets[2] = NULL;
+
+   lp_build_sample_soa(gallivm, &texture_state, &sampler_state, &state->base,
+                       type, FALSE, 0, 0, coords, offsets, NULL, NULL, NULL,
+                       LP_SAMPLER_LOD_SCALAR, texel);
+
+   for (chan = 0; chan < 4; ++chan) {
+      LLVMValueRef index = lp_build_const_int32(gallivm, chan);
+      LLVMValueRef ptr = LLVMBuildGEP(builder, rgba_ptr, &index, 1, "");
+      LLVMValueRef store = LLVMBuildStore(builder, texel[chan], ptr);
+      lp_set_store_alignment(store, 4);
+   }
+
+   LLVMBuildRetVoid(builder);
+
+   gallivm_verify_function(gallivm, func);
+
+   return func;
+}
+
+
+static void
+fetch_texel(const struct util_format_description *desc, const uint8_t *data,
+            int x, int y, float *rgba)
+{
+   unsigned stride = TEX_SIZE * desc->block.bits / 8;
+
+   x = CLAMP(x, 0, TEX_SIZE - 1);
+   y = CLAMP(y, 0, TEX_SIZE - 1);
+
+   desc->unpack_rgba_float(rgba, 0,
+                           data + y * stride + x * desc->block.bits / 8, 0,
+                           1, 1);
+}
+
+
+/**
+ * Bilinear filtering with clamp to edge wrapping.
+ */
+static void
+sample_ref(const struct util_format_description *desc, const uint8_t *data,
+           float s, float t, float *rgba)
+{
+   float u = s * TEX_SIZE - 0.5f;
+   float v = t * TEX_SIZE - 0.5f;
+   int x0 = (int)floorf(u);
+   int y0 = (int)floorf(v);
+   float wx = u - x0;
+   float wy = v - y0;
+   float t00[4], t01[4], t10[4], t11[4];
+   unsigned chan;
+
+   fetch_texel(desc, data, x0, y0, t00);
+   fetch_texel(desc, data, x0 + 1, y0, t01);
+   fetch_texel(desc, data, x0, y0 + 1, t10);
+   fetch_texel(desc, data, x0 + 1, y0 + 1, t11);
+
+   for (chan = 0; chan < 4; ++chan) {
+      float top = t00[chan] + wx * (t01[chan] - t00[chan]);
+      float bottom = t10[chan] + wx * (t11[chan] - t10[chan]);
+      rgba[chan] = top + wy * (bottom - top);
+   }
+}
+
+
+/**
+ * Fill s and t with four coordinates.  When centered they land on texel
+ * centers, within 1/1024 of a texel if jitter is set, otherwise anywhere
+ * in the texture.
+ */
+static void
+random_coords(boolean centered, boolean jitter, float *s, float *t)
+{
+   unsigned i;
+
+   for (i = 0; i < 4; ++i) {
+      if (centered) {
+         float du = 0.0f, dv = 0.0f;
+         if (jitter) {
+            du = (random_float() - 0.5f) / 512.0f;
+            dv = (random_float() - 0.5f) / 512.0f;
+         }
+         s[i] = ((rand() % TEX_SIZE) + 0.5f + du) / TEX_SIZE;
+         t[i] = ((rand() % TEX_SIZE) + 0.5f + dv) / TEX_SIZE;
+      }
+      else {
+         s[i] = random_float();
+         t[i] = random_float();
+      }
+   }
+}
+
+
+static boolean
+test_coords(unsigned verbose, FILE *fp,
+            enum pipe_format format,
+            boolean tiled,
+            sample_func sample,
+            sample_func sample_stats,
+            struct sample_test_state *state,
+            const uint8_t *data,
+            boolean centered)
+{
+   const struct util_format_description *desc = util_format_description(format);
+   /*
+    * The AoS path, used for 8 bit formats unless tiled, truncates the
+    * weights to 8 bits and the lerps to 8 bit results.
+    */
+   const float tolerance = desc->channel[0].size == 8 ? 4.0f / 255.0f : 1e-4f;
+   /*
+    * Only 8 bit unorm formats skip the filtering on texel centers.  The
+    * AoS path, used for those unless tiled, truncates the coords to 8 bits
+    * of subtexel precision, so only exact texel centers give zero weights
+    * there, while the SoA path tolerates being a bit off.
+    */
+   const boolean unfiltered = centered && util_format_fits_8unorm(desc);
+   const boolean jitter = unfiltered && tiled;
+   const unsigned n = LP_TEST_NUM_SAMPLES;
+   int64_t cycles[LP_TEST_NUM_SAMPLES];
+   double cycles_avg = 0.0;
+   boolean success = TRUE;
+   unsigned i, j, chan;
+
+   for (i = 0; i < n && success; ++i) {
+      PIPE_ALIGN_VAR(16) float s[4];
+      PIPE_ALIGN_VAR(16) float t[4];
+      PIPE_ALIGN_VAR(16) float rgba[4][4];
+      PIPE_ALIGN_VAR(16) float rgba_stats[4][4];
+      int64_t start_counter, end_counter;
+
+      random_coords(centered, jitter, s, t);
+
+      start_counter = rdtsc();
+      sample(s, t, &rgba[0][0]);
+      end_counter = rdtsc();
+
+      cycles[i] = end_counter - start_counter;
+
+      memset(&state->stats, 0, sizeof state->stats);
+      sample_stats(s, t, &rgba_stats[0][0]);
+
+      /* One texel per pixel when not filtering, four otherwise. */
+      if (state->stats.texels[0] != (unfiltered ? 4 : 16) ||
+          memcmp(rgba, rgba_stats, sizeof rgba) != 0) {
+         printf("FAILED: %s, %s, %s coords, %u texels fetched\n",
+                desc->short_name, tiled ? "tiled" : "linear",
+                centered ? "centered" : "off-center",
+                (unsigned)state->stats.texels[0]);
+         success = FALSE;
+      }
+
+      for (j = 0; j < 4; ++j) {
+         float ref[4];
+
+         if (centered) {
+            /* Must be the texel itself, no blending with the neighbours. */
+            fetch_texel(desc, data,
+                        (int)(s[j] * TEX_SIZE), (int)(t[j] * TEX_SIZE), ref);
+         }
+         else {
+            sample_ref(desc, data, s[j], t[j], ref);
+         }
+
+         for (chan = 0; chan < 4; ++chan) {
+            float delta = fabsf(rgba[chan][j] - ref[chan]);
+            if (delta > (centered ? 1e-5f : tolerance)) {
+               success = FALSE;
+            }
+         }
+
+         if (!success || verbose >= 2) {
+            printf("%s: %s, %s, %s coords (%f, %f)\n",
+                   success ? "PASS" : "FAILED",
+                   desc->short_name, tiled ? "tiled" : "linear",
+                   centered ? "centered" : "off-center",
+                   s[j], t[j]);
+            printf("  %f %f %f %f obtained\n",
+                   rgba[0][j], rgba[1][j], rgba[2][j], rgba[3][j]);
+            printf("  %f %f %f %f expected\n",
+                   ref[0], ref[1], ref[2], ref[3]);
+         }
+
+         if (!success)
+            break;
+      }
+   }
+
+   if (success) {
+      double sum = 0.0;
+
+      /* Skip the first sample, which warms up the caches. */
+      for (i = 1; i < n; ++i)
+         sum += cycles[i];
+      cycles_avg = sum / (n - 1);
+   }
+
+   if (fp)
+      write_tsv_row(fp, format, tiled, centered ? "centered" : "off-center",
+                    cycles_avg, success);
+
+   return success;
+}
+
+
+/**
+ * Sample a random texture.  The reference always reads the linear data; in
+ * the tiled case the sampler is given a tiled copy of it.
+ */
+static boolean
+test_one(unsigned verbose, FILE *fp, enum pipe_format format, boolean tiled)
+{
+   const struct util_format_description *desc = util_format_description(format);
+   const unsigned bpp = desc->block.bits / 8;
+   unsigned size = TEX_SIZE * TEX_SIZE * bpp;
+   struct sample_test_state state;
+   struct gallivm_state *gallivm;
+   LLVMValueRef func, func_stats;
+   sample_func sample, sample_stats;
+   uint8_t *data, *tiled_data = NULL;
+   boolean success = TRUE;
+   unsigned i;
+
+   if (verbose >= 1)
+      printf("Testing %s, %s ...\n", desc->short_name,
+             tiled ? "tiled" : "linear");
+
+   data = align_malloc(size, 16);
+   if (!data)
+      return FALSE;
+
+   if (desc->channel[0].type == UTIL_FORMAT_TYPE_FLOAT) {
+      float *values = (float *)data;
+      for (i = 0; i < size / 4; ++i)
+         values[i] = random_float();
+   }
+   else {
+      for (i = 0; i < size; ++i)
+         data[i] = rand();
+   }
+
+   if (tiled) {
+      tiled_data = align_malloc(size, 16);
+      if (!tiled_data) {
+         align_free(data);
+         return FALSE;
+      }
+
+      llvmpipe_copy_texture_rect(tiled_data, TEX_SIZE * bpp, TRUE, 0, 0,
+                                 data, TEX_SIZE * bpp, FALSE, 0, 0,
+                                 TEX_SIZE, TEX_SIZE, bpp);
+   }
+
+   init_test_state(&state, desc, tiled ? tiled_data : data);
+
+   gallivm = gallivm_create();
+
+   func = add_sample_test(gallivm, format, tiled, &state, FALSE);
+   func_stats = add_sample_test(gallivm, format, tiled, &state, TRUE);
+
+   gallivm_compile_module(gallivm);
+
+   sample = (sample_func) pointer_to_func(gallivm_jit_function(gallivm, func));
+   sample_stats = (sample_func)
+      pointer_to_func(gallivm_jit_function(gallivm, func_stats));
+
+   if (!test_coords(verbose, fp, format, tiled, sample, sample_stats, &state,
+                    data, TRUE))
+      success = FALSE;
+   if (!test_coords(verbose, fp, format, tiled, sample, sample_stats, &state,
+                    data, FALSE))
+      success = FALSE;
+
+   gallivm_destroy(gallivm);
+
+   align_free(tiled_data);
+   align_free(data);
+
+   return success;
+}
+
+
+boolean
+test_all(unsigned verbose, FILE *fp)
+{
+   boolean success = TRUE;
+   unsigned i;
+
+   for (i = 0; i < Elements(test_formats); ++i) {
+      if (!test_one(verbose, fp, test_formats[i], FALSE))
+         success = FALSE;
+      if (!test_one(verbose, fp, test_formats[i], TRUE))
+         success = FALSE;
+   }
+
+   return success;
+}
+
+
+boolean
+test_some(unsigned verbose, FILE *fp,
+          unsigned long n)
+{
+   boolean success = TRUE;
+   unsigned long i;
+
+   for (i = 0; i < n; ++i) {
+      if (!test_one(verbose, fp, test_formats[rand() % Elements(test_formats)],
+                    rand() & 1))
+         success = FALSE;
+   }
+
+   return success;
+}
+
+
+boolean
+test_single(unsigned verbose, FILE *fp)
+{
+   printf("no test_single()");
+   return TRUE;
+}
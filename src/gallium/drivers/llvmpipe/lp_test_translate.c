@@ -0,0 +1,309 @@
+/**************************************************************************
+ *
+ * Copyright 2014 VMware, Inc.
+ * All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL VMWARE AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ **************************************************************************/
+
+
+/**
+ * @file
+ * Unit tests for the JIT row converters of lp_bld_format_translate.c,
+ * checked against util_format_translate().
+ */
+
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+#include "util/u_memory.h"
+#include "util/u_format.h"
+
+#include "gallivm/lp_bld_format_translate.h"
+
+#include "lp_test.h"
+
+
+/* Not a multiple of any vector width. */
+#define TEST_WIDTH 37
+
+
+struct translate_test_case
+{
+   enum pipe_format dst_format;
+   enum pipe_format src_format;
+};
+
+
+static const struct translate_test_case
+test_cases[] = {
+   {PIPE_FORMAT_B8G8R8A8_UNORM, PIPE_FORMAT_R8G8B8A8_UNORM},
+   {PIPE_FORMAT_B8G8R8A8_UNORM, PIPE_FORMAT_R8G8B8_UNORM},
+   {PIPE_FORMAT_B8G8R8A8_UNORM, PIPE_FORMAT_B5G6R5_UNORM},
+   {PIPE_FORMAT_B8G8R8A8_UNORM, PIPE_FORMAT_R16G16B16A16_UNORM},
+   {PIPE_FORMAT_B8G8R8A8_UNORM, PIPE_FORMAT_R32G32B32A32_FLOAT},
+   {PIPE_FORMAT_B8G8R8A8_UNORM, PIPE_FORMAT_R32_FLOAT},
+   {PIPE_FORMAT_B8G8R8A8_UNORM, PIPE_FORMAT_A8_UNORM},
+   {PIPE_FORMAT_B8G8R8A8_UNORM, PIPE_FORMAT_L8_UNORM},
+   {PIPE_FORMAT_B8G8R8X8_UNORM, PIPE_FORMAT_R32G32B32_FLOAT},
+   {PIPE_FORMAT_R8G8B8A8_UNORM, PIPE_FORMAT_B8G8R8A8_UNORM},
+   {PIPE_FORMAT_R8G8B8A8_UNORM, PIPE_FORMAT_B4G4R4A4_UNORM},
+   {PIPE_FORMAT_R8G8B8A8_UNORM, PIPE_FORMAT_R32G32B32A32_FLOAT},
+   {PIPE_FORMAT_R8G8B8_UNORM, PIPE_FORMAT_R32G32B32_FLOAT},
+   {PIPE_FORMAT_B5G6R5_UNORM, PIPE_FORMAT_R8G8B8A8_UNORM},
+   {PIPE_FORMAT_B5G6R5_UNORM, PIPE_FORMAT_R32G32B32_FLOAT},
+   {PIPE_FORMAT_B5G5R5A1_UNORM, PIPE_FORMAT_R8G8B8A8_UNORM},
+   {PIPE_FORMAT_B4G4R4A4_UNORM, PIPE_FORMAT_R8G8B8A8_UNORM},
+   {PIPE_FORMAT_R10G10B10A2_UNORM, PIPE_FORMAT_R16G16B16A16_UNORM},
+   {PIPE_FORMAT_B10G10R10A2_UNORM, PIPE_FORMAT_R32G32B32A32_FLOAT},
+   {PIPE_FORMAT_R16G16_UNORM, PIPE_FORMAT_R32G32_FLOAT},
+   {PIPE_FORMAT_R16_UNORM, PIPE_FORMAT_R32_FLOAT},
+   {PIPE_FORMAT_A8_UNORM, PIPE_FORMAT_B8G8R8A8_UNORM},
+   {PIPE_FORMAT_L8A8_UNORM, PIPE_FORMAT_R8G8B8A8_UNORM},
+   {PIPE_FORMAT_I8_UNORM, PIPE_FORMAT_R32G32B32A32_FLOAT},
+};
+
+
+/* Pairs which must be left to util_format. */
+static const struct translate_test_case
+unsupported_cases[] = {
+   {PIPE_FORMAT_B8G8R8A8_SRGB, PIPE_FORMAT_R8G8B8A8_UNORM},
+   {PIPE_FORMAT_B8G8R8A8_UNORM, PIPE_FORMAT_DXT1_RGBA},
+   {PIPE_FORMAT_B8G8R8A8_UNORM, PIPE_FORMAT_R8G8B8A8_UINT},
+   {PIPE_FORMAT_B8G8R8A8_UNORM, PIPE_FORMAT_R8G8B8A8_SNORM},
+   {PIPE_FORMAT_B8G8R8A8_UNORM, PIPE_FORMAT_Z24_UNORM_S8_UINT},
+   {PIPE_FORMAT_R8G8B8A8_SNORM, PIPE_FORMAT_R8G8B8A8_UNORM},
+   {PIPE_FORMAT_R16G16B16A16_UNORM, PIPE_FORMAT_R8G8B8A8_UNORM},
+   {PIPE_FORMAT_R32_FLOAT, PIPE_FORMAT_R8G8B8A8_UNORM},
+};
+
+
+void
+write_tsv_header(FILE *fp)
+{
+   fprintf(fp,
+           "result\t"
+           "dst_format\t"
+           "src_format\n");
+
+   fflush(fp);
+}
+
+
+static void
+write_tsv_row(FILE *fp,
+              const struct translate_test_case *test,
+              boolean success)
+{
+   fprintf(fp, "%s\t", success ? "pass" : "fail");
+
+   fprintf(fp, "%s\t%s\n",
+           util_format_name(test->dst_format),
+           util_format_name(test->src_format));
+
+   fflush(fp);
+}
+
+
+static void
+random_row(const struct util_format_description *desc, uint8_t *row)
+{
+   unsigned size = TEST_WIDTH * desc->block.bits / 8;
+   unsigned i;
+
+   if (desc->channel[0].type == UTIL_FORMAT_TYPE_FLOAT) {
+      float *values = (float *)row;
+
+      /* Also check clamping, but not NaNs. */
+      for (i = 0; i < size / 4; ++i)
+         values[i] = random_float() * 1.5f - 0.25f;
+   }
+   else {
+      for (i = 0; i < size; ++i)
+         row[i] = rand();
+   }
+}
+
+
+static boolean
+test_one(unsigned verbose, FILE *fp,
+         struct lp_format_translate_cache *cache,
+         const struct translate_test_case *test)
+{
+   const struct util_format_description *dst_desc =
+      util_format_description(test->dst_format);
+   const struct util_format_description *src_desc =
+      util_format_description(test->src_format);
+   uint8_t src[TEST_WIDTH * 16];
+   uint8_t dst[TEST_WIDTH * 4 + 4];
+   uint8_t ref[TEST_WIDTH * 4];
+   float dst_rgba[TEST_WIDTH][4];
+   float ref_rgba[TEST_WIDTH][4];
+   unsigned dst_size = TEST_WIDTH * dst_desc->block.bits / 8;
+   lp_format_translate_func translate;
+   float tolerance = 0.0f;
+   boolean success = TRUE;
+   unsigned i, j;
+
+   if (verbose >= 1)
+      printf("Testing %s -> %s ...\n",
+             src_desc->short_name, dst_desc->short_name);
+
+   if (!lp_format_translate_supported(test->dst_format, test->src_format)) {
+      printf("FAILED: %s -> %s not supported\n",
+             src_desc->short_name, dst_desc->short_name);
+      success = FALSE;
+      goto out;
+   }
+
+   translate = lp_get_format_translate_func(cache, test->dst_format,
+                                            test->src_format);
+   if (!translate) {
+      printf("FAILED: %s -> %s not compiled\n",
+             src_desc->short_name, dst_desc->short_name);
+      success = FALSE;
+      goto out;
+   }
+
+   /* Allow one unit of rounding difference in the smallest channel. */
+   for (j = 0; j < 4; ++j) {
+      if (dst_desc->channel[j].type != UTIL_FORMAT_TYPE_VOID) {
+         float unit = 1.0f / ((1 << dst_desc->channel[j].size) - 1);
+         tolerance = MAX2(tolerance, unit);
+      }
+   }
+   tolerance *= 1.01f;
+
+   random_row(src_desc, src);
+   memset(dst, 0xcd, sizeof dst);
+
+   translate(dst, src, TEST_WIDTH);
+
+   util_format_translate(test->dst_format, ref, 0, 0, 0,
+                         test->src_format, src, 0, 0, 0,
+                         TEST_WIDTH, 1);
+
+   for (i = dst_size; i < sizeof dst; ++i) {
+      if (dst[i] != 0xcd) {
+         printf("FAILED: %s -> %s wrote past the end of the row\n",
+                src_desc->short_name, dst_desc->short_name);
+         success = FALSE;
+         goto out;
+      }
+   }
+
+   dst_desc->unpack_rgba_float(&dst_rgba[0][0], 0, dst, 0, TEST_WIDTH, 1);
+   dst_desc->unpack_rgba_float(&ref_rgba[0][0], 0, ref, 0, TEST_WIDTH, 1);
+
+   for (i = 0; i < TEST_WIDTH; ++i) {
+      for (j = 0; j < 4; ++j) {
+         if (fabsf(dst_rgba[i][j] - ref_rgba[i][j]) > tolerance) {
+            printf("FAILED: %s -> %s, pixel %u\n",
+                   src_desc->short_name, dst_desc->short_name, i);
+            printf("  %f %f %f %f obtained\n",
+                   dst_rgba[i][0], dst_rgba[i][1],
+                   dst_rgba[i][2], dst_rgba[i][3]);
+            printf("  %f %f %f %f expected\n",
+                   ref_rgba[i][0], ref_rgba[i][1],
+                   ref_rgba[i][2], ref_rgba[i][3]);
+            success = FALSE;
+            goto out;
+         }
+      }
+   }
+
+out:
+   if (fp)
+      write_tsv_row(fp, test, success);
+
+   return success;
+}
+
+
+boolean
+test_all(unsigned verbose, FILE *fp)
+{
+   struct lp_format_translate_cache *cache;
+   boolean success = TRUE;
+   unsigned i;
+
+   cache = lp_format_translate_cache_create();
+   if (!cache)
+      return FALSE;
+
+   for (i = 0; i < Elements(test_cases); ++i) {
+      if (!test_one(verbose, fp, cache, &test_cases[i]))
+         success = FALSE;
+   }
+
+   for (i = 0; i < Elements(unsupported_cases); ++i) {
+      const struct translate_test_case *test = &unsupported_cases[i];
+
+      if (lp_format_translate_supported(test->dst_format, test->src_format) ||
+          lp_get_format_translate_func(cache, test->dst_format,
+                                       test->src_format)) {
+         printf("FAILED: %s -> %s should not be supported\n",
+                util_format_name(test->src_format),
+                util_format_name(test->dst_format));
+         success = FALSE;
+      }
+   }
+
+   lp_format_translate_cache_destroy(cache);
+
+   return success;
+}
+
+
+boolean
+test_some(unsigned verbose, FILE *fp,
+          unsigned long n)
+{
+   struct lp_format_translate_cache *cache;
+   boolean success = TRUE;
+   unsigned long i;
+
+   cache = lp_format_translate_cache_create();
+   if (!cache)
+      return FALSE;
+
+   for (i = 0; i < n; ++i) {
+      if (!test_one(verbose, fp, cache,
+                    &test_cases[rand() % Elements(test_cases)]))
+         success = FALSE;
+   }
+
+   lp_format_translate_cache_destroy(cache);
+
+   return success;
+}
+
+
+boolean
+test_single(unsigned verbose, FILE *fp)
+{
+   printf("no test_single()");
+   return TRUE;
+}
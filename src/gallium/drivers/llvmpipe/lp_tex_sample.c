@@ -67,6 +67,8 @@ struct llvmpipe_sampler_dynamic_state
    const struct lp_sampler_static_state *static_state;
 
    LLVMValueRef context_ptr;
+
+   LLVMValueRef thread_data_ptr;
 };
 
 
@@ -221,6 +223,21 @@ LP_LLVM_SAMPLER_MEMBER(lod_bias,   LP_JIT_SAMPLER_LOD_BIAS, TRUE)
 LP_LLVM_SAMPLER_MEMBER(border_color, LP_JIT_SAMPLER_BORDER_COLOR, FALSE)
 
 
+/**
+ * Fetch the lp_jit_thread_data::sampler_stats pointer.
+ */
+static LLVMValueRef
+lp_llvm_sampler_stats_ptr(const struct lp_sampler_dynamic_state *base,
+                          struct gallivm_state *gallivm,
+                          unsigned texture_unit)
+{
+   struct llvmpipe_sampler_dynamic_state *state =
+      (struct llvmpipe_sampler_dynamic_state *)base;
+
+   return lp_jit_thread_data_sampler_stats(gallivm, state->thread_data_ptr);
+}
+
+
 static void
 lp_llvm_sampler_soa_destroy(struct lp_build_sampler_soa *sampler)
 {
@@ -305,7 +322,8 @@ lp_llvm_sampler_soa_emit_size_query(const struct lp_build_sampler_soa *base,
 
 struct lp_build_sampler_soa *
 lp_llvm_sampler_soa_create(const struct lp_sampler_static_state *static_state,
-                           LLVMValueRef context_ptr)
+                           LLVMValueRef context_ptr,
+                           LLVMValueRef thread_data_ptr)
 {
    struct lp_llvm_sampler_soa *sampler;
 
@@ -330,8 +348,13 @@ lp_llvm_sampler_soa_create(const struct lp_sampler_static_state *static_state,
    sampler->dynamic_state.base.lod_bias = lp_llvm_sampler_lod_bias;
    sampler->dynamic_state.base.border_color = lp_llvm_sampler_border_color;
 
+   if ((LP_PERF & PERF_TEX_STATS) && thread_data_ptr) {
+      sampler->dynamic_state.base.stats_ptr = lp_llvm_sampler_stats_ptr;
+   }
+
    sampler->dynamic_state.static_state = static_state;
    sampler->dynamic_state.context_ptr = context_ptr;
+   sampler->dynamic_state.thread_data_ptr = thread_data_ptr;
 
    return &sampler->base;
 }
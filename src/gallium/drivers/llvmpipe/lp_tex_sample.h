@@ -39,10 +39,13 @@ struct lp_sampler_static_state;
  * Pure-LLVM texture sampling code generator.
  *
  * @param context_ptr LLVM value with the pointer to the struct lp_jit_context.
+ * @param thread_data_ptr LLVM value with the pointer to the struct
+ *                        lp_jit_thread_data, for PERF_TEX_STATS.
  */
 struct lp_build_sampler_soa *
 lp_llvm_sampler_soa_create(const struct lp_sampler_static_state *key,
-                           LLVMValueRef context_ptr);
+                           LLVMValueRef context_ptr,
+                           LLVMValueRef thread_data_ptr);
 
 
 #endif /* LP_TEX_SAMPLE_H */
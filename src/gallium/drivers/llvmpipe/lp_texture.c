@@ -166,6 +166,43 @@ fail:
 }
 
 
+/**
+ * Can the texture use the tiled layout?  Only color textures which are
+ * sampled from or rendered to qualify; rendering (and any other direct
+ * access to the linear data) converts them back with
+ * llvmpipe_resource_untile().
+ */
+static boolean
+llvmpipe_texture_can_tile(const struct llvmpipe_screen *screen,
+                          const struct pipe_resource *res)
+{
+   const struct util_format_description *desc;
+   unsigned bpp;
+
+   if (!screen->tiled_textures)
+      return FALSE;
+
+   if (res->target != PIPE_TEXTURE_2D &&
+       res->target != PIPE_TEXTURE_RECT)
+      return FALSE;
+
+   if (!(res->bind & PIPE_BIND_SAMPLER_VIEW) ||
+       (res->bind & ~(PIPE_BIND_SAMPLER_VIEW | PIPE_BIND_RENDER_TARGET)))
+      return FALSE;
+
+   if (res->usage == PIPE_USAGE_STAGING || res->nr_samples > 1)
+      return FALSE;
+
+   desc = util_format_description(res->format);
+   if (desc->block.width != 1 || desc->block.height != 1 ||
+       desc->block.bits % 8 != 0)
+      return FALSE;
+
+   bpp = desc->block.bits / 8;
+   return util_is_power_of_two(bpp) && bpp <= 16;
+}
+
+
 /**
  * Check the size of the texture specified by 'res'.
  * \return TRUE if OK, FALSE if too large.
@@ -245,6 +282,7 @@ llvmpipe_resource_create(struct pipe_screen *_screen,
       }
       else {
          /* texture map */
+         lpr->tiled = llvmpipe_texture_can_tile(screen, &lpr->base);
          if (!llvmpipe_texture_layout(screen, lpr))
             goto fail;
       }
@@ -499,6 +537,10 @@ llvmpipe_transfer_map( struct pipe_context *pipe,
    assert(resource);
    assert(level <= resource->last_level);
 
+   /* Tiled textures are only mapped through a linear staging copy */
+   if (lpr->tiled && (usage & PIPE_TRANSFER_MAP_DIRECTLY))
+      return NULL;
+
    /*
     * Transfers, like other pipe operations, must happen in order, so flush the
     * context if necessary.
@@ -585,6 +627,33 @@ llvmpipe_transfer_map( struct pipe_context *pipe,
       screen->timestamp++;
    }
 
+   if (lpr->tiled) {
+      const unsigned bpp = util_format_get_blocksize(format);
+
+      assert(box->depth == 1);
+
+      pt->stride = box->width * bpp;
+      pt->layer_stride = pt->stride * box->height;
+
+      lpt->staging = MALLOC(pt->layer_stride);
+      if (!lpt->staging || !map) {
+         FREE(lpt->staging);
+         pipe_resource_reference(&pt->resource, NULL);
+         FREE(lpt);
+         return NULL;
+      }
+
+      if (!(usage & (PIPE_TRANSFER_DISCARD_RANGE |
+                     PIPE_TRANSFER_DISCARD_WHOLE_RESOURCE))) {
+         llvmpipe_copy_texture_rect(lpt->staging, pt->stride, FALSE, 0, 0,
+                                    map, lpr->row_stride[level], TRUE,
+                                    box->x, box->y,
+                                    box->width, box->height, bpp);
+      }
+
+      return lpt->staging;
+   }
+
    map +=
       box->y / util_format_get_blockheight(format) * pt->stride +
       box->x / util_format_get_blockwidth(format) * util_format_get_blocksize(format);
@@ -597,8 +666,28 @@ static void
 llvmpipe_transfer_unmap(struct pipe_context *pipe,
                         struct pipe_transfer *transfer)
 {
+   struct llvmpipe_transfer *lpt = llvmpipe_transfer(transfer);
+
    assert(transfer->resource);
 
+   if (lpt->staging) {
+      struct llvmpipe_resource *lpr = llvmpipe_resource(transfer->resource);
+
+      if (transfer->usage & PIPE_TRANSFER_WRITE) {
+         ubyte *image = llvmpipe_get_texture_image_address(lpr,
+                                                           transfer->box.z,
+                                                           transfer->level);
+         llvmpipe_copy_texture_rect(image, lpr->row_stride[transfer->level],
+                                    lpr->tiled,
+                                    transfer->box.x, transfer->box.y,
+                                    lpt->staging, transfer->stride, FALSE,
+                                    0, 0,
+                                    transfer->box.width, transfer->box.height,
+                                    util_format_get_blocksize(lpr->base.format));
+      }
+      FREE(lpt->staging);
+   }
+
    llvmpipe_resource_unmap(transfer->resource,
                            transfer->level,
                            transfer->box.z);
@@ -886,6 +975,108 @@ llvmpipe_get_texture_tile_linear(struct llvmpipe_resource *lpr,
 }
 
 
+/**
+ * Copy a rectangle of texels between two images, either of which may use
+ * the tiled layout.  Texels of a micro tile row are contiguous, so the
+ * copy is done in runs of up to four texels for tiled images.
+ */
+void
+llvmpipe_copy_texture_rect(ubyte *dst, unsigned dst_stride,
+                           boolean dst_tiled,
+                           unsigned dst_x, unsigned dst_y,
+                           const ubyte *src, unsigned src_stride,
+                           boolean src_tiled,
+                           unsigned src_x, unsigned src_y,
+                           unsigned width, unsigned height,
+                           unsigned bpp)
+{
+   unsigned x, y;
+
+   for (y = 0; y < height; y++) {
+      if (!dst_tiled && !src_tiled) {
+         memcpy(dst + llvmpipe_texel_offset(dst_x, dst_y + y, dst_stride,
+                                            bpp, FALSE),
+                src + llvmpipe_texel_offset(src_x, src_y + y, src_stride,
+                                            bpp, FALSE),
+                width * bpp);
+         continue;
+      }
+
+      for (x = 0; x < width; ) {
+         unsigned run = width - x;
+
+         if (dst_tiled)
+            run = MIN2(run, 4 - ((dst_x + x) & 3));
+         if (src_tiled)
+            run = MIN2(run, 4 - ((src_x + x) & 3));
+
+         memcpy(dst + llvmpipe_texel_offset(dst_x + x, dst_y + y, dst_stride,
+                                            bpp, dst_tiled),
+                src + llvmpipe_texel_offset(src_x + x, src_y + y, src_stride,
+                                            bpp, src_tiled),
+                run * bpp);
+         x += run;
+      }
+   }
+}
+
+
+/**
+ * Convert a tiled texture to the linear layout, in place.  This is done
+ * the first time the texture is used in a way which needs linear access,
+ * e.g. as a render target or from the vertex shader, and the texture
+ * then stays linear.
+ */
+void
+llvmpipe_resource_untile(struct pipe_context *pipe,
+                         struct llvmpipe_resource *lpr)
+{
+   const unsigned bpp = util_format_get_blocksize(lpr->base.format);
+   unsigned level;
+   ubyte *tmp;
+
+   if (!lpr->tiled)
+      return;
+
+   if (lpr->linear_img.data) {
+      llvmpipe_flush_resource(pipe, &lpr->base, 0,
+                              FALSE, /* read_only */
+                              TRUE, /* cpu_access */
+                              FALSE, /* do_not_block */
+                              __FUNCTION__);
+
+      /* one row of micro tiles at a time */
+      tmp = MALLOC(4 * lpr->row_stride[0]);
+      if (!tmp)
+         return;
+
+      for (level = 0; level <= lpr->base.last_level; level++) {
+         const unsigned stride = lpr->row_stride[level];
+         const unsigned width = align(u_minify(lpr->base.width0, level), 4);
+         const unsigned height = align(u_minify(lpr->base.height0, level), 4);
+         ubyte *image = llvmpipe_get_texture_image_address(lpr, 0, level);
+         unsigned y;
+
+         for (y = 0; y < height; y += 4) {
+            memcpy(tmp, image + y * stride, 4 * stride);
+            llvmpipe_copy_texture_rect(image, stride, FALSE, 0, y,
+                                       tmp, stride, TRUE, 0, 0,
+                                       width, 4, bpp);
+         }
+      }
+
+      FREE(tmp);
+   }
+
+   lpr->tiled = FALSE;
+
+   /* Fragment shader variants sampling the texture must be rebuilt, in
+    * every context which may have it bound.
+    */
+   llvmpipe_screen(pipe->screen)->timestamp++;
+}
+
+
 /**
  * Return size of resource in bytes
  */
@@ -92,6 +92,13 @@ struct llvmpipe_resource
     */
    void *data;
 
+   /**
+    * Texels are stored in 4x4 micro tiles rather than row by row.
+    * Only used for 2D textures which are just sampled from, see
+    * llvmpipe_texel_offset().
+    */
+   boolean tiled;
+
    boolean userBuffer;  /** Is this a user-space buffer? */
    unsigned timestamp;
 
@@ -109,6 +116,9 @@ struct llvmpipe_transfer
    struct pipe_transfer base;
 
    unsigned long offset;
+
+   /** Linear copy of the mapped box, for tiled textures */
+   ubyte *staging;
 };
 
 
@@ -200,6 +210,38 @@ llvmpipe_resource_stride(struct pipe_resource *resource,
 }
 
 
+/**
+ * Byte offset of texel (x, y) within an image with the given row stride.
+ * The tiled layout must match lp_build_sample_offset_tiled().
+ */
+static INLINE unsigned
+llvmpipe_texel_offset(unsigned x, unsigned y,
+                      unsigned stride, unsigned bpp,
+                      boolean tiled)
+{
+   if (!tiled)
+      return y * stride + x * bpp;
+
+   return (y & ~3) * stride +
+          ((x & ~3) * 4 + (y & 3) * 4 + (x & 3)) * bpp;
+}
+
+
+void
+llvmpipe_copy_texture_rect(ubyte *dst, unsigned dst_stride,
+                           boolean dst_tiled,
+                           unsigned dst_x, unsigned dst_y,
+                           const ubyte *src, unsigned src_stride,
+                           boolean src_tiled,
+                           unsigned src_x, unsigned src_y,
+                           unsigned width, unsigned height,
+                           unsigned bpp);
+
+void
+llvmpipe_resource_untile(struct pipe_context *pipe,
+                         struct llvmpipe_resource *lpr);
+
+
 void *
 llvmpipe_resource_map(struct pipe_resource *resource,
                       unsigned level,
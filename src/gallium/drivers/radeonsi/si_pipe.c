@@ -277,6 +277,8 @@ static int si_get_param(struct pipe_screen* pscreen, enum pipe_cap param)
 		return MIN2(sscreen->b.info.vram_size, 0xFFFFFFFF);
 
 	/* Unsupported features. */
+	case PIPE_CAP_BUFFER_MAP_PERSISTENT_COHERENT:
+	case PIPE_CAP_MULTI_DRAW:
 	case PIPE_CAP_TGSI_FS_COORD_ORIGIN_LOWER_LEFT:
 	case PIPE_CAP_TGSI_FS_COORD_PIXEL_CENTER_INTEGER:
 	case PIPE_CAP_TGSI_CAN_COMPACT_CONSTANTS:
@@ -54,19 +54,18 @@
  * For non-instanced drawing, instanceCount should be 1.
  * When the min/max element indexes aren't known, minIndex should be 0
  * and maxIndex should be ~0.
+ *
+ * All the num_draws primitives must have the same reduced primitive type.
  */
-void
-softpipe_draw_vbo(struct pipe_context *pipe,
-                  const struct pipe_draw_info *info)
+static void
+draw_vbo_run(struct softpipe_context *sp,
+             const struct pipe_draw_info *info,
+             unsigned num_draws)
 {
-   struct softpipe_context *sp = softpipe_context(pipe);
    struct draw_context *draw = sp->draw;
    const void *mapped_indices = NULL;
    unsigned i;
 
-   if (!softpipe_check_render_cond(sp))
-      return;
-
    sp->reduced_api_prim = u_reduced_prim(info->mode);
 
    if (sp->dirty) {
@@ -128,7 +127,7 @@ softpipe_draw_vbo(struct pipe_context *pipe,
                                     sp->active_statistics_queries > 0);
 
    /* draw! */
-   draw_vbo(draw, info);
+   draw_multi_vbo(draw, info, num_draws);
 
    /* unmap vertex/index buffers - will cause draw module to flush */
    for (i = 0; i < sp->num_vertex_buffers; i++) {
@@ -150,3 +149,41 @@ softpipe_draw_vbo(struct pipe_context *pipe,
    /* Note: leave drawing surfaces mapped */
    sp->dirty_render_cache = TRUE;
 }
+
+
+void
+softpipe_draw_vbo(struct pipe_context *pipe,
+                  const struct pipe_draw_info *info)
+{
+   struct softpipe_context *sp = softpipe_context(pipe);
+
+   if (!softpipe_check_render_cond(sp))
+      return;
+
+   draw_vbo_run(sp, info, 1);
+}
+
+
+/**
+ * Draw num_draws primitives, handing them to the draw module in as few
+ * runs as the changes of the reduced primitive type allow.
+ */
+void
+softpipe_multi_draw_vbo(struct pipe_context *pipe,
+                        const struct pipe_draw_info *info,
+                        unsigned num_draws)
+{
+   struct softpipe_context *sp = softpipe_context(pipe);
+   unsigned first = 0, i;
+
+   if (!softpipe_check_render_cond(sp))
+      return;
+
+   for (i = 1; i <= num_draws; i++) {
+      if (i == num_draws ||
+          u_reduced_prim(info[i].mode) != u_reduced_prim(info[first].mode)) {
+         draw_vbo_run(sp, &info[first], i - first);
+         first = i;
+      }
+   }
+}
@@ -167,6 +167,11 @@ void
 softpipe_draw_vbo(struct pipe_context *pipe,
                   const struct pipe_draw_info *info);
 
+void
+softpipe_multi_draw_vbo(struct pipe_context *pipe,
+                        const struct pipe_draw_info *info,
+                        unsigned num_draws);
+
 void
 softpipe_map_texture_surfaces(struct softpipe_context *sp);
 
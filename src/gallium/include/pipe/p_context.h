@@ -91,6 +91,14 @@ struct pipe_context {
    /*@{*/
    void (*draw_vbo)( struct pipe_context *pipe,
                      const struct pipe_draw_info *info );
+
+   /**
+    * Draw several primitives in a row with the same state, as draw_vbo
+    * would one at a time.  Optional, see PIPE_CAP_MULTI_DRAW.
+    */
+   void (*multi_draw_vbo)( struct pipe_context *pipe,
+                           const struct pipe_draw_info *info,
+                           unsigned num_draws );
    /*@}*/
 
    /**
@@ -0,0 +1,287 @@
+/**************************************************************************
+ *
+ * Copyright 2014 VMware, Inc.
+ * All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL VMWARE AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ **************************************************************************/
+
+/*
+ * Check that the SIMD clip test / viewport transform path of the draw
+ * module produces the same vertices as the templated scalar code.
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "pipe/p_context.h"
+#include "pipe/p_screen.h"
+#include "pipe/p_state.h"
+#include "tgsi/tgsi_text.h"
+#include "util/u_cpu_detect.h"
+#include "util/u_math.h"
+#include "util/u_memory.h"
+#include "draw/draw_context.h"
+#include "draw/draw_private.h"
+#include "draw/draw_pt.h"
+
+
+#define MAX_VERTS 37
+#define NUM_ATTRIBS 3
+
+
+static const char *vs_text =
+   "VERT\n"
+   "DCL IN[0]\n"
+   "DCL IN[1]\n"
+   "DCL IN[2]\n"
+   "DCL OUT[0], POSITION\n"
+   "DCL OUT[1], CLIPVERTEX\n"
+   "DCL OUT[2], EDGEFLAG\n"
+   "MOV OUT[0], IN[0]\n"
+   "MOV OUT[1], IN[1]\n"
+   "MOV OUT[2], IN[2]\n"
+   "END\n";
+
+
+static int
+dummy_get_param(struct pipe_screen *screen, enum pipe_cap param)
+{
+   return 0;
+}
+
+
+static float
+rand_coord(void)
+{
+   return (float) (rand() % 4001 - 2000) / 1000.0f;
+}
+
+
+static boolean
+float_equal(float a, float b)
+{
+   if (util_is_inf_or_nan(a) && a != a)
+      return b != b;
+   return memcmp(&a, &b, sizeof a) == 0;
+}
+
+
+static boolean
+vertex_equal(const struct vertex_header *a, const struct vertex_header *b)
+{
+   unsigned i, j;
+
+   if (a->clipmask != b->clipmask ||
+       a->edgeflag != b->edgeflag ||
+       a->have_clipdist != b->have_clipdist ||
+       a->vertex_id != b->vertex_id)
+      return FALSE;
+
+   for (i = 0; i < 4; i++) {
+      if (!float_equal(a->clip[i], b->clip[i]) ||
+          !float_equal(a->pre_clip_pos[i], b->pre_clip_pos[i]))
+         return FALSE;
+   }
+
+   for (j = 0; j < NUM_ATTRIBS; j++) {
+      for (i = 0; i < 4; i++) {
+         if (!float_equal(a->data[j][i], b->data[j][i]))
+            return FALSE;
+      }
+   }
+
+   return TRUE;
+}
+
+
+static void
+run_cliptest(struct pt_post_vs *pvs, boolean simd,
+             const unsigned *prepare_flags,
+             struct draw_vertex_info *vinfo,
+             const struct draw_prim_info *pinfo,
+             boolean *need_pipeline)
+{
+   util_cpu_caps.has_sse2 = simd;
+
+   draw_pt_post_vs_prepare(pvs,
+                           prepare_flags[0], prepare_flags[1],
+                           prepare_flags[2], prepare_flags[3],
+                           prepare_flags[4], prepare_flags[5],
+                           prepare_flags[6]);
+
+   *need_pipeline = draw_pt_post_vs_run(pvs, vinfo, pinfo);
+}
+
+
+int main(int argc, char **argv)
+{
+   struct pipe_screen screen;
+   struct pipe_context pipe;
+   struct draw_context *draw;
+   struct pipe_rasterizer_state rast;
+   struct pipe_viewport_state vp;
+   struct pipe_clip_state clip;
+   struct pipe_shader_state vs_state;
+   struct tgsi_token tokens[256];
+   void *vs;
+   struct pt_post_vs *pvs;
+   const unsigned vertex_size = sizeof(struct vertex_header) +
+                                NUM_ATTRIBS * 4 * sizeof(float);
+   char *verts_scalar, *verts_simd;
+   boolean has_sse2;
+   unsigned passed = 0, failed = 0;
+   unsigned config, count, i, j;
+
+   util_cpu_detect();
+   has_sse2 = util_cpu_caps.has_sse2;
+   if (!has_sse2) {
+      printf("SIMD clip test not available on this CPU\n");
+      return 0;
+   }
+
+   memset(&screen, 0, sizeof screen);
+   memset(&pipe, 0, sizeof pipe);
+   screen.get_param = dummy_get_param;
+   pipe.screen = &screen;
+
+   draw = draw_create_no_llvm(&pipe);
+   if (!draw) {
+      fprintf(stderr, "failed to create draw context\n");
+      return 1;
+   }
+
+   if (!tgsi_text_translate(vs_text, tokens, Elements(tokens))) {
+      fprintf(stderr, "failed to translate vertex shader\n");
+      return 1;
+   }
+   memset(&vs_state, 0, sizeof vs_state);
+   vs_state.tokens = tokens;
+   vs = draw_create_vertex_shader(draw, &vs_state);
+   draw_bind_vertex_shader(draw, vs);
+
+   memset(&rast, 0, sizeof rast);
+   rast.depth_clip = 1;
+   rast.clip_plane_enable = 0x5;
+   draw_set_rasterizer_state(draw, &rast, &rast);
+
+   memset(&vp, 0, sizeof vp);
+   vp.scale[0] = 320.0f;
+   vp.scale[1] = -240.0f;
+   vp.scale[2] = 0.5f;
+   vp.scale[3] = 1.0f;
+   vp.translate[0] = 320.0f;
+   vp.translate[1] = 240.0f;
+   vp.translate[2] = 0.5f;
+   draw_set_viewport_states(draw, 0, 1, &vp);
+
+   memset(&clip, 0, sizeof clip);
+   clip.ucp[0][0] = 1.0f;
+   clip.ucp[0][3] = 0.25f;
+   clip.ucp[2][1] = -0.5f;
+   clip.ucp[2][2] = 0.75f;
+   clip.ucp[2][3] = 1.0f;
+   draw_set_clip_state(draw, &clip);
+
+   pvs = draw_pt_post_vs_create(draw);
+
+   verts_scalar = MALLOC(MAX_VERTS * vertex_size);
+   verts_simd = MALLOC(MAX_VERTS * vertex_size);
+
+   /* clip_xy, clip_z, clip_user, guard_band, bypass_viewport, clip_halfz,
+    * need_edgeflags
+    */
+   for (config = 0; config < 128; config++) {
+      unsigned prepare_flags[7];
+
+      for (i = 0; i < 7; i++)
+         prepare_flags[i] = (config >> i) & 1;
+
+      for (count = 1; count <= MAX_VERTS; count++) {
+         struct draw_vertex_info vinfo;
+         struct draw_prim_info pinfo;
+         boolean need_scalar, need_simd;
+         boolean ok = TRUE;
+
+         for (j = 0; j < count; j++) {
+            struct vertex_header *v =
+               (struct vertex_header *) (verts_scalar + j * vertex_size);
+
+            memset(v, 0, vertex_size);
+            for (i = 0; i < 4; i++) {
+               v->data[0][i] = rand_coord();
+               v->data[1][i] = rand_coord();
+            }
+            /* mostly positive w, with some vertices behind the eye */
+            v->data[0][3] = fabsf(v->data[0][3]) + (rand() % 8 ? 0.25f : -1.0f);
+            v->data[2][0] = rand() % 2 ? 1.0f : 0.0f;
+         }
+         memcpy(verts_simd, verts_scalar, count * vertex_size);
+
+         memset(&pinfo, 0, sizeof pinfo);
+         pinfo.prim = PIPE_PRIM_TRIANGLES;
+         pinfo.linear = TRUE;
+         pinfo.count = count;
+
+         vinfo.vertex_size = vertex_size;
+         vinfo.stride = vertex_size;
+         vinfo.count = count;
+
+         vinfo.verts = (struct vertex_header *) verts_scalar;
+         run_cliptest(pvs, FALSE, prepare_flags, &vinfo, &pinfo, &need_scalar);
+
+         vinfo.verts = (struct vertex_header *) verts_simd;
+         run_cliptest(pvs, TRUE, prepare_flags, &vinfo, &pinfo, &need_simd);
+
+         if (need_scalar != need_simd)
+            ok = FALSE;
+
+         for (j = 0; j < count; j++) {
+            if (!vertex_equal((struct vertex_header *) (verts_scalar + j * vertex_size),
+                              (struct vertex_header *) (verts_simd + j * vertex_size))) {
+               ok = FALSE;
+               printf("config 0x%02x, %u vertices: vertex %u differs\n",
+                      config, count, j);
+               break;
+            }
+         }
+
+         if (ok)
+            passed++;
+         else
+            failed++;
+      }
+   }
+
+   util_cpu_caps.has_sse2 = has_sse2;
+
+   FREE(verts_scalar);
+   FREE(verts_simd);
+   draw_pt_post_vs_destroy(pvs);
+   draw_delete_vertex_shader(draw, vs);
+   draw_destroy(draw);
+
+   printf("%u tests passed, %u failed\n", passed, failed);
+
+   return failed ? 1 : 0;
+}
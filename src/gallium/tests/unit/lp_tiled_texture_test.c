@@ -0,0 +1,85 @@
+/*
+ * Copyright 2014 VMware, Inc.
+ * All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * on the rights to use, copy, modify, merge, publish, distribute, sub
+ * license, and/or sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.  IN NO EVENT SHALL
+ * VMWARE AND/OR THEIR SUPPLIERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * Checks that the llvmpipe tiled texture layout maps every texel to a
+ * distinct location inside the image.  Sampling from tiled textures is
+ * covered by lp_test_sample.
+ */
+
+#include <stdio.h>
+
+#include "util/u_math.h"
+#include "util/u_memory.h"
+#include "llvmpipe/lp_texture.h"
+
+
+static boolean
+test_layout(unsigned width, unsigned height, unsigned bpp)
+{
+   const unsigned stride = align(width, 4) * bpp;
+   const unsigned rows = align(height, 4);
+   const unsigned texels = stride / bpp * rows;
+   ubyte *used = CALLOC(texels, 1);
+   boolean ok = TRUE;
+   unsigned x, y;
+
+   if (!used)
+      return FALSE;
+
+   for (y = 0; y < rows && ok; y++) {
+      for (x = 0; x < stride / bpp; x++) {
+         unsigned offset = llvmpipe_texel_offset(x, y, stride, bpp, TRUE);
+         if (offset % bpp != 0 || offset / bpp >= texels ||
+             used[offset / bpp]) {
+            printf("FAILED: %ux%u, %u bytes per texel: bad offset %u "
+                   "for texel %u,%u\n", width, height, bpp, offset, x, y);
+            ok = FALSE;
+            break;
+         }
+         used[offset / bpp] = 1;
+      }
+   }
+
+   FREE(used);
+   return ok;
+}
+
+
+int
+main(int argc, char **argv)
+{
+   static const unsigned sizes[][2] = {
+      { 1, 1 }, { 3, 5 }, { 16, 16 }, { 17, 33 }, { 256, 1 }, { 129, 64 }
+   };
+   unsigned i, bpp;
+   boolean ok = TRUE;
+
+   for (i = 0; i < Elements(sizes); i++)
+      for (bpp = 1; bpp <= 16; bpp *= 2)
+         ok = test_layout(sizes[i][0], sizes[i][1], bpp) && ok;
+
+   printf("%s\n", ok ? "Success!" : "Failure!");
+   return ok ? 0 : 1;
+}
@@ -0,0 +1,382 @@
+/*
+ * Copyright 2014 VMware, Inc.
+ * All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * on the rights to use, copy, modify, merge, publish, distribute, sub
+ * license, and/or sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.  IN NO EVENT SHALL
+ * VMWARE AND/OR THEIR SUPPLIERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * Checks that the whole block decoders of the S3TC, RGTC, LATC and ETC1
+ * formats agree with their single texel fetches on random data, and that the
+ * S3TC compressor stays close to smooth images.
+ *
+ * Pass -b to report instead how many blocks per second are decoded and
+ * compressed.
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "os/os_time.h"
+#include "util/u_format.h"
+#include "util/u_format_s3tc.h"
+#include "util/u_math.h"
+#include "util/u_memory.h"
+
+
+/* Not a multiple of the block size, to exercise partial blocks. */
+#define TEST_WIDTH   37
+#define TEST_HEIGHT  23
+#define GUARD        0xcd
+
+/* Largest difference allowed between a smooth image and its compression. */
+#define PACK_TOLERANCE  8
+
+#define BENCH_SIZE   1024
+#define BENCH_NANOS  (50 * 1000 * 1000)
+
+
+static const enum pipe_format formats[] = {
+   PIPE_FORMAT_DXT1_RGB,
+   PIPE_FORMAT_DXT1_RGBA,
+   PIPE_FORMAT_DXT3_RGBA,
+   PIPE_FORMAT_DXT5_RGBA,
+   PIPE_FORMAT_DXT1_SRGB,
+   PIPE_FORMAT_DXT5_SRGBA,
+   PIPE_FORMAT_RGTC1_UNORM,
+   PIPE_FORMAT_RGTC2_UNORM,
+   PIPE_FORMAT_LATC1_UNORM,
+   PIPE_FORMAT_LATC2_UNORM,
+   PIPE_FORMAT_ETC1_RGB8
+};
+
+
+static void
+fill_random(uint8_t *data, unsigned size)
+{
+   unsigned i;
+   for (i = 0; i < size; i++)
+      data[i] = rand() & 0xff;
+}
+
+
+static unsigned
+packed_stride(const struct util_format_description *desc, unsigned width)
+{
+   return (width + 3) / 4 * desc->block.bits / 8;
+}
+
+
+static const uint8_t *
+block_address(const struct util_format_description *desc,
+              const uint8_t *src, unsigned src_stride,
+              unsigned x, unsigned y)
+{
+   return src + (y / 4) * src_stride + (x / 4) * desc->block.bits / 8;
+}
+
+
+/**
+ * Decode a random image and compare every texel against the fetch functions.
+ */
+static boolean
+test_unpack(const struct util_format_description *desc)
+{
+   const unsigned src_stride = packed_stride(desc, TEST_WIDTH);
+   const unsigned src_size = src_stride * ((TEST_HEIGHT + 3) / 4);
+   /* Leave some room past every row to catch overruns. */
+   const unsigned dst_stride = TEST_WIDTH * 4 + 12;
+   const unsigned fdst_stride = dst_stride * sizeof(float);
+   uint8_t *src = MALLOC(src_size);
+   uint8_t *dst = MALLOC(dst_stride * (TEST_HEIGHT + 1));
+   float *fdst = MALLOC(fdst_stride * TEST_HEIGHT);
+   boolean success = TRUE;
+   unsigned x, y, c;
+
+   fill_random(src, src_size);
+   memset(dst, GUARD, dst_stride * (TEST_HEIGHT + 1));
+
+   desc->unpack_rgba_8unorm(dst, dst_stride, src, src_stride,
+                            TEST_WIDTH, TEST_HEIGHT);
+   desc->unpack_rgba_float(fdst, fdst_stride, src, src_stride,
+                           TEST_WIDTH, TEST_HEIGHT);
+
+   for (y = 0; y < TEST_HEIGHT && success; ++y) {
+      const uint8_t *row = dst + y * dst_stride;
+      const float *frow = fdst + y * dst_stride;
+
+      for (x = 0; x < TEST_WIDTH; ++x) {
+         const uint8_t *blk = block_address(desc, src, src_stride, x, y);
+         uint8_t expected[4];
+         float fexpected[4];
+
+         desc->fetch_rgba_8unorm(expected, blk, x % 4, y % 4);
+         desc->fetch_rgba_float(fexpected, blk, x % 4, y % 4);
+
+         for (c = 0; c < 4; ++c) {
+            if (row[x * 4 + c] != expected[c] ||
+                frow[x * 4 + c] != fexpected[c]) {
+               printf("FAILED: %s unpack, texel %u,%u channel %u: "
+                      "got %u/%f, expected %u/%f\n",
+                      desc->short_name, x, y, c,
+                      row[x * 4 + c], frow[x * 4 + c],
+                      expected[c], fexpected[c]);
+               success = FALSE;
+               break;
+            }
+         }
+         if (!success)
+            break;
+      }
+
+      for (x = TEST_WIDTH * 4; x < dst_stride && success; ++x) {
+         if (row[x] != GUARD) {
+            printf("FAILED: %s unpack wrote past the end of row %u\n",
+                   desc->short_name, y);
+            success = FALSE;
+         }
+      }
+   }
+
+   for (x = 0; x < dst_stride && success; ++x) {
+      if (dst[TEST_HEIGHT * dst_stride + x] != GUARD) {
+         printf("FAILED: %s unpack wrote past the last row\n",
+                desc->short_name);
+         success = FALSE;
+      }
+   }
+
+   FREE(src);
+   FREE(dst);
+   FREE(fdst);
+
+   return success;
+}
+
+
+/**
+ * Compress a smooth image, decompress it again and check that no channel
+ * moved far.
+ */
+static boolean
+test_pack(const struct util_format_description *desc)
+{
+   const unsigned width = 4 * ((TEST_WIDTH + 3) / 4);
+   const unsigned height = 4 * ((TEST_HEIGHT + 3) / 4);
+   const unsigned stride = width * 4;
+   const unsigned packed_size = packed_stride(desc, width) * height / 4;
+   uint8_t *src = MALLOC(stride * height);
+   uint8_t *dst = MALLOC(stride * height);
+   uint8_t *packed = MALLOC(packed_size);
+   unsigned x, y, c, max_error = 0;
+
+   /*
+    * A ramp along one direction, which is what the block formats can
+    * represent well.  Green runs against red to check that the compressor
+    * picks the right diagonal.
+    */
+   for (y = 0; y < height; ++y) {
+      for (x = 0; x < width; ++x) {
+         uint8_t *texel = src + y * stride + x * 4;
+         const unsigned v = (x * 5 + y * 3) * 255 / (width * 5 + height * 3);
+         texel[0] = v;
+         texel[1] = 255 - v;
+         texel[2] = 64 + v / 2;
+         /* DXT1 RGBA only has one bit of alpha. */
+         if (desc->format == PIPE_FORMAT_DXT1_RGBA)
+            texel[3] = ((x / 3 + y / 5) & 1) ? 255 : 0;
+         else
+            texel[3] = 255 - v;
+      }
+   }
+
+   desc->pack_rgba_8unorm(packed, packed_stride(desc, width), src, stride,
+                          width, height);
+   desc->unpack_rgba_8unorm(dst, stride, packed, packed_stride(desc, width),
+                            width, height);
+
+   for (y = 0; y < height; ++y) {
+      for (x = 0; x < width; ++x) {
+         const uint8_t *expected = src + y * stride + x * 4;
+         const uint8_t *texel = dst + y * stride + x * 4;
+
+         /* Transparent DXT1 texels have no color. */
+         if (desc->format == PIPE_FORMAT_DXT1_RGBA && expected[3] == 0) {
+            if (texel[3] != 0)
+               max_error = 255;
+            continue;
+         }
+
+         for (c = 0; c < 4; ++c) {
+            unsigned error = abs(texel[c] - expected[c]);
+            if (c == 3 && desc->format == PIPE_FORMAT_DXT1_RGB)
+               continue;
+            max_error = MAX2(max_error, error);
+         }
+      }
+   }
+
+   FREE(src);
+   FREE(dst);
+   FREE(packed);
+
+   if (max_error > PACK_TOLERANCE) {
+      printf("FAILED: %s pack, largest channel error %u\n",
+             desc->short_name, max_error);
+      return FALSE;
+   }
+
+   return TRUE;
+}
+
+
+static unsigned
+test_all(void)
+{
+   unsigned passed = 0, failed = 0;
+   unsigned i;
+
+   for (i = 0; i < Elements(formats); ++i) {
+      const struct util_format_description *desc =
+         util_format_description(formats[i]);
+
+      if (test_unpack(desc))
+         passed++;
+      else
+         failed++;
+
+      if (desc->layout == UTIL_FORMAT_LAYOUT_S3TC &&
+          desc->colorspace != UTIL_FORMAT_COLORSPACE_SRGB) {
+         if (test_pack(desc))
+            passed++;
+         else
+            failed++;
+      }
+   }
+
+   printf("%u tests passed, %u failed\n", passed, failed);
+
+   return failed;
+}
+
+
+/**
+ * Decode the way the block decoders did before, one texel fetch at a time,
+ * for comparison.
+ */
+static void
+unpack_by_texel(const struct util_format_description *desc,
+                uint8_t *dst, unsigned dst_stride,
+                const uint8_t *src, unsigned src_stride,
+                unsigned width, unsigned height)
+{
+   unsigned x, y;
+
+   for (y = 0; y < height; ++y) {
+      for (x = 0; x < width; ++x) {
+         desc->fetch_rgba_8unorm(dst + y * dst_stride + x * 4,
+                                 block_address(desc, src, src_stride, x, y),
+                                 x % 4, y % 4);
+      }
+   }
+}
+
+
+static double
+bench_rate(const struct util_format_description *desc, unsigned mode,
+           uint8_t *packed, uint8_t *unpacked)
+{
+   const unsigned src_stride = packed_stride(desc, BENCH_SIZE);
+   const unsigned blocks = (BENCH_SIZE / 4) * (BENCH_SIZE / 4);
+   unsigned iterations = 0;
+   int64_t start_time, elapsed;
+
+   start_time = os_time_get_nano();
+   do {
+      switch (mode) {
+      case 0:
+         desc->unpack_rgba_8unorm(unpacked, BENCH_SIZE * 4, packed, src_stride,
+                                  BENCH_SIZE, BENCH_SIZE);
+         break;
+      case 1:
+         unpack_by_texel(desc, unpacked, BENCH_SIZE * 4, packed, src_stride,
+                         BENCH_SIZE, BENCH_SIZE);
+         break;
+      default:
+         desc->pack_rgba_8unorm(packed, src_stride, unpacked, BENCH_SIZE * 4,
+                                BENCH_SIZE, BENCH_SIZE);
+         break;
+      }
+      iterations++;
+      elapsed = os_time_get_nano() - start_time;
+   } while (elapsed < BENCH_NANOS);
+
+   return (double)blocks * iterations * 1000.0 / elapsed;
+}
+
+
+static void
+bench_all(void)
+{
+   uint8_t *packed = MALLOC(BENCH_SIZE * BENCH_SIZE);
+   uint8_t *unpacked = MALLOC(BENCH_SIZE * BENCH_SIZE * 4);
+   unsigned i;
+
+   if (!packed || !unpacked) {
+      FREE(packed);
+      FREE(unpacked);
+      return;
+   }
+
+   for (i = 0; i < Elements(formats); ++i) {
+      const struct util_format_description *desc =
+         util_format_description(formats[i]);
+
+      fill_random(packed, BENCH_SIZE * BENCH_SIZE);
+
+      printf("%-24s unpack %8.1f Mblocks/s, by texel %8.1f Mblocks/s",
+             desc->short_name,
+             bench_rate(desc, 0, packed, unpacked),
+             bench_rate(desc, 1, packed, unpacked));
+
+      if (desc->layout == UTIL_FORMAT_LAYOUT_S3TC)
+         printf(", pack %8.1f Mblocks/s", bench_rate(desc, 2, packed, unpacked));
+
+      printf("\n");
+   }
+
+   FREE(packed);
+   FREE(unpacked);
+}
+
+
+int
+main(int argc, char **argv)
+{
+   util_format_s3tc_init();
+
+   if (argc > 1 && strcmp(argv[1], "-b") == 0) {
+      bench_all();
+      return 0;
+   }
+
+   return test_all() ? 1 : 0;
+}
@@ -0,0 +1,336 @@
+/*
+ * Copyright 2014 VMware, Inc.
+ * All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * on the rights to use, copy, modify, merge, publish, distribute, sub
+ * license, and/or sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.  IN NO EVENT SHALL
+ * VMWARE AND/OR THEIR SUPPLIERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * Checks the index translators against a straightforward reference
+ * implementation.
+ *
+ * Pass -b to report instead how many indices per second each of the
+ * commonly used translators converts.
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "pipe/p_defines.h"
+#include "os/os_time.h"
+#include "util/u_memory.h"
+#include "util/u_prim.h"
+#include "indices/u_indices.h"
+
+
+#define MAX_VERTS  1024
+#define SLACK      16
+
+#define BENCH_VERTS  (64 * 1024)
+#define BENCH_NANOS  (50 * 1000 * 1000)
+
+#define HW_MASK ((1 << PIPE_PRIM_POINTS) | \
+                 (1 << PIPE_PRIM_LINES) | \
+                 (1 << PIPE_PRIM_TRIANGLES))
+
+
+static const unsigned prims[] = {
+   PIPE_PRIM_POINTS,
+   PIPE_PRIM_LINES,
+   PIPE_PRIM_TRIANGLES,
+   PIPE_PRIM_TRIANGLE_STRIP,
+   PIPE_PRIM_QUADS,
+   PIPE_PRIM_QUAD_STRIP
+};
+
+static const char *prim_names[] = {
+   "points",
+   "lines",
+   "line_loop",
+   "line_strip",
+   "triangles",
+   "triangle_strip",
+   "triangle_fan",
+   "quads",
+   "quad_strip",
+   "polygon"
+};
+
+
+static unsigned
+get_index(const void *in, unsigned size, unsigned i)
+{
+   switch (size) {
+   case 1:
+      return ((const ubyte *)in)[i];
+   case 2:
+      return ((const ushort *)in)[i];
+   default:
+      return ((const uint *)in)[i];
+   }
+}
+
+
+static void
+put_index(void *out, unsigned size, unsigned j, unsigned value)
+{
+   if (size == 2)
+      ((ushort *)out)[j] = (ushort)value;
+   else
+      ((uint *)out)[j] = value;
+}
+
+
+/**
+ * Reference translation for the case where the provoking vertex convention
+ * does not change, mirroring the loops in u_indices_gen.py.
+ */
+static void
+reference_translate(unsigned prim, unsigned pv,
+                    const void *in, unsigned in_size,
+                    unsigned start, unsigned nr,
+                    void *out, unsigned out_size)
+{
+   unsigned i, j;
+
+   switch (prim) {
+   case PIPE_PRIM_POINTS:
+   case PIPE_PRIM_LINES:
+   case PIPE_PRIM_TRIANGLES:
+      {
+         unsigned step = u_vertices_per_prim(prim);
+         for (i = start; i < nr + start; i += step)
+            for (j = 0; j < step; j++)
+               put_index(out, out_size, i + j,
+                         get_index(in, in_size, i + j));
+      }
+      break;
+   case PIPE_PRIM_TRIANGLE_STRIP:
+      for (i = start, j = 0; j < nr; j += 3, i++) {
+         if (pv == PV_FIRST) {
+            put_index(out, out_size, j + 0, get_index(in, in_size, i));
+            put_index(out, out_size, j + 1, get_index(in, in_size, i + 1 + (i & 1)));
+            put_index(out, out_size, j + 2, get_index(in, in_size, i + 2 - (i & 1)));
+         }
+         else {
+            put_index(out, out_size, j + 0, get_index(in, in_size, i + (i & 1)));
+            put_index(out, out_size, j + 1, get_index(in, in_size, i + 1 - (i & 1)));
+            put_index(out, out_size, j + 2, get_index(in, in_size, i + 2));
+         }
+      }
+      break;
+   case PIPE_PRIM_QUADS:
+      for (i = start, j = 0; j < nr; j += 6, i += 4) {
+         put_index(out, out_size, j + 0, get_index(in, in_size, i + 0));
+         put_index(out, out_size, j + 1, get_index(in, in_size, i + 1));
+         put_index(out, out_size, j + 2, get_index(in, in_size, i + 3));
+         put_index(out, out_size, j + 3, get_index(in, in_size, i + 1));
+         put_index(out, out_size, j + 4, get_index(in, in_size, i + 2));
+         put_index(out, out_size, j + 5, get_index(in, in_size, i + 3));
+      }
+      break;
+   case PIPE_PRIM_QUAD_STRIP:
+      for (i = start, j = 0; j < nr; j += 6, i += 2) {
+         put_index(out, out_size, j + 0, get_index(in, in_size, i + 2));
+         put_index(out, out_size, j + 1, get_index(in, in_size, i + 0));
+         put_index(out, out_size, j + 2, get_index(in, in_size, i + 3));
+         put_index(out, out_size, j + 3, get_index(in, in_size, i + 0));
+         put_index(out, out_size, j + 4, get_index(in, in_size, i + 1));
+         put_index(out, out_size, j + 5, get_index(in, in_size, i + 3));
+      }
+      break;
+   default:
+      assert(0);
+   }
+}
+
+
+static void
+fill_indices(void *in, unsigned size, unsigned count)
+{
+   unsigned i;
+
+   for (i = 0; i < count; i++) {
+      uint value = ((uint)rand() << 16) ^ (uint)rand();
+
+      switch (size) {
+      case 1:
+         ((ubyte *)in)[i] = (ubyte)value;
+         break;
+      case 2:
+         ((ushort *)in)[i] = (ushort)value;
+         break;
+      default:
+         ((uint *)in)[i] = value;
+         break;
+      }
+   }
+}
+
+
+static boolean
+test_one(unsigned prim, unsigned in_size, unsigned pv,
+         unsigned start, unsigned nr, const void *in)
+{
+   static uint out[MAX_VERTS * 3 + 2 * SLACK];
+   static uint expected[MAX_VERTS * 3 + 2 * SLACK];
+   u_translate_func translate;
+   unsigned out_prim, out_size, out_nr;
+
+   u_index_translator(HW_MASK, prim, in_size, nr, pv, pv,
+                      &out_prim, &out_size, &out_nr, &translate);
+
+   memset(out, 0xcd, sizeof out);
+   memset(expected, 0xcd, sizeof expected);
+
+   translate(in, start, out_nr, out);
+   reference_translate(prim, pv, in, in_size, start, out_nr,
+                       expected, out_size);
+
+   if (memcmp(out, expected, sizeof out) != 0) {
+      printf("FAILED: %s, %u byte indices, %s provoking vertex, "
+             "start %u, count %u\n",
+             prim_names[prim], in_size,
+             pv == PV_FIRST ? "first" : "last", start, nr);
+      return FALSE;
+   }
+
+   return TRUE;
+}
+
+
+static unsigned
+test_all(void)
+{
+   static uint in[MAX_VERTS + 2 * SLACK];
+   static const unsigned sizes[] = { 1, 2, 4 };
+   unsigned p, s, pv, start, count, nr;
+   unsigned passed = 0, failed = 0;
+
+   for (s = 0; s < Elements(sizes); s++) {
+      fill_indices(in, sizes[s], MAX_VERTS + 2 * SLACK);
+
+      for (p = 0; p < Elements(prims); p++) {
+         unsigned prim = prims[p];
+
+         /* Lists that are already supported only go through the
+          * translators when the index size changes.
+          */
+         if ((HW_MASK & (1 << prim)) && sizes[s] != 1)
+            continue;
+
+         for (pv = 0; pv < PV_COUNT; pv++) {
+            for (start = 0; start < 8; start++) {
+               for (count = 4; count < 64; count++) {
+                  nr = count;
+                  if (!u_trim_pipe_prim(prim, &nr) || nr != count)
+                     continue;
+                  if (test_one(prim, sizes[s], pv, start, nr, in))
+                     passed++;
+                  else
+                     failed++;
+               }
+               nr = MAX_VERTS - start;
+               if (u_trim_pipe_prim(prim, &nr)) {
+                  if (test_one(prim, sizes[s], pv, start, nr, in))
+                     passed++;
+                  else
+                     failed++;
+               }
+            }
+         }
+      }
+   }
+
+   printf("%u tests passed, %u failed\n", passed, failed);
+
+   return failed;
+}
+
+
+static void
+bench_one(unsigned prim, unsigned in_size, const void *in, void *out)
+{
+   u_translate_func translate;
+   unsigned out_prim, out_size, out_nr;
+   unsigned nr = BENCH_VERTS;
+   int64_t start_time, elapsed;
+   unsigned iterations;
+   double rate;
+
+   u_trim_pipe_prim(prim, &nr);
+   u_index_translator(HW_MASK, prim, in_size, nr, PV_LAST, PV_LAST,
+                      &out_prim, &out_size, &out_nr, &translate);
+
+   iterations = 0;
+   start_time = os_time_get_nano();
+   do {
+      translate(in, 0, out_nr, out);
+      iterations++;
+      elapsed = os_time_get_nano() - start_time;
+   } while (elapsed < BENCH_NANOS);
+   rate = (double)nr * iterations * 1000.0 / elapsed;
+
+   printf("%-16s %u -> %u bytes: %8.1f Mindices/s\n",
+          prim_names[prim], in_size, out_size, rate);
+}
+
+
+static void
+bench_all(void)
+{
+   void *in = MALLOC(BENCH_VERTS * 4);
+   void *out = MALLOC(BENCH_VERTS * 3 * 4);
+   unsigned p;
+
+   if (!in || !out) {
+      FREE(in);
+      FREE(out);
+      return;
+   }
+
+   for (p = 0; p < Elements(prims); p++) {
+      fill_indices(in, 1, BENCH_VERTS);
+      bench_one(prims[p], 1, in, out);
+
+      if (!(HW_MASK & (1 << prims[p]))) {
+         fill_indices(in, 2, BENCH_VERTS);
+         bench_one(prims[p], 2, in, out);
+         fill_indices(in, 4, BENCH_VERTS);
+         bench_one(prims[p], 4, in, out);
+      }
+   }
+
+   FREE(in);
+   FREE(out);
+}
+
+
+int
+main(int argc, char **argv)
+{
+   if (argc > 1 && strcmp(argv[1], "-b") == 0) {
+      bench_all();
+      return 0;
+   }
+
+   return test_all() ? 1 : 0;
+}
@@ -124,6 +124,23 @@ struct gl_uniform_storage {
    unsigned num_driver_storage;
    struct gl_uniform_driver_storage *driver_storage;
 
+   /**
+    * Precomputed for the fast path of \c _mesa_uniform, which applies when
+    * the values only need to be copied to the storage.
+    *
+    * \sa _mesa_uniform_update_fast_path
+    */
+   struct {
+      /**
+       * The \c GL_FLOAT_VEC2 etc. type of glUniform calls which can take the
+       * fast path, or zero if the uniform always needs the slow path.
+       */
+      unsigned type;
+
+      /** Size in bytes of an array element in \c ::storage. */
+      unsigned element_size;
+   } fast_path;
+
    /**
     * Storage used by Mesa for the uniform
     *
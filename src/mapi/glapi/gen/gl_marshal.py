@@ -0,0 +1,569 @@
+#!/usr/bin/env python
+
+# Copyright (C) 2014 VMware, Inc.
+#
+# Permission is hereby granted, free of charge, to any person obtaining a
+# copy of this software and associated documentation files (the "Software"),
+# to deal in the Software without restriction, including without limitation
+# the rights to use, copy, modify, merge, publish, distribute, sublicense,
+# and/or sell copies of the Software, and to permit persons to whom the
+# Software is furnished to do so, subject to the following conditions:
+#
+# The above copyright notice and this permission notice (including the next
+# paragraph) shall be included in all copies or substantial portions of the
+# Software.
+#
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+# THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+# FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+# IN THE SOFTWARE.
+
+# This script generates the file marshal_generated.c, which contains a
+# marshalling function for every GL entry point, the functions executing
+# the marshalled commands on the GL thread, and
+# _mesa_create_marshal_table().  See main/marshal.h.
+#
+# Every function is marshalled in one of these ways:
+#
+# - async: the parameters, including the arrays they point to when the XML
+#   tells how big those are, are copied into the command and the call
+#   returns immediately.
+#
+# - sync: the parameters are stored by value, pointers included, and the
+#   calling thread waits for the GL thread to execute the command.  This is
+#   the default for anything returning data or taking pointers of unknown
+#   size.
+#
+# - draw: like sync, but only waits when the draw may read client memory,
+#   i.e. when client vertex arrays or client indices may be in use.
+#
+# - pointer: vertex array pointer setters.  The pointer is only stored by
+#   the GL, so it's passed by value and the call is asynchronous.
+
+import license
+import gl_XML
+import sys, getopt
+
+
+# Draw calls, mapped to their index parameter, if any.
+draw_functions = {
+    'ArrayElement': None,
+    'DrawArrays': None,
+    'DrawArraysInstancedARB': None,
+    'DrawArraysInstancedBaseInstance': None,
+    'DrawTransformFeedback': None,
+    'DrawTransformFeedbackInstanced': None,
+    'DrawTransformFeedbackStream': None,
+    'DrawTransformFeedbackStreamInstanced': None,
+    'DrawElements': 'indices',
+    'DrawElementsBaseVertex': 'indices',
+    'DrawElementsInstancedARB': 'indices',
+    'DrawElementsInstancedBaseInstance': 'indices',
+    'DrawElementsInstancedBaseVertex': 'indices',
+    'DrawElementsInstancedBaseVertexBaseInstance': 'indices',
+    'DrawRangeElements': 'indices',
+    'DrawRangeElementsBaseVertex': 'indices',
+    }
+
+# Functions setting client vertex array pointers, mapped to the
+# VERT_ATTRIB_* they set, if known.
+pointer_functions = {
+    'ColorPointer': 'VERT_ATTRIB_COLOR0',
+    'ColorPointerEXT': 'VERT_ATTRIB_COLOR0',
+    'EdgeFlagPointer': 'VERT_ATTRIB_EDGEFLAG',
+    'EdgeFlagPointerEXT': 'VERT_ATTRIB_EDGEFLAG',
+    'FogCoordPointer': 'VERT_ATTRIB_FOG',
+    'IndexPointer': 'VERT_ATTRIB_COLOR_INDEX',
+    'IndexPointerEXT': 'VERT_ATTRIB_COLOR_INDEX',
+    'InterleavedArrays': None,
+    'NormalPointer': 'VERT_ATTRIB_NORMAL',
+    'NormalPointerEXT': 'VERT_ATTRIB_NORMAL',
+    'PointSizePointerOES': 'VERT_ATTRIB_POINT_SIZE',
+    'SecondaryColorPointer': 'VERT_ATTRIB_COLOR1',
+    'TexCoordPointer':
+        'VERT_ATTRIB_TEX(ctx->GLThread->client_active_texture)',
+    'TexCoordPointerEXT':
+        'VERT_ATTRIB_TEX(ctx->GLThread->client_active_texture)',
+    # out of range indices give VERT_ATTRIB_MAX, which is ignored
+    'VertexAttribIPointer':
+        'VERT_ATTRIB_GENERIC(MIN2(index, VERT_ATTRIB_GENERIC_MAX))',
+    'VertexAttribPointer':
+        'VERT_ATTRIB_GENERIC(MIN2(index, VERT_ATTRIB_GENERIC_MAX))',
+    'VertexAttribPointerNV': None,
+    'VertexPointer': 'VERT_ATTRIB_POS',
+    'VertexPointerEXT': 'VERT_ATTRIB_POS',
+    }
+
+# Functions which would be async judging by their parameters, but must not
+# return before the GL thread has run them.
+sync_functions = set([
+    'Finish',
+    # the arrays of counts and firsts are only read when drawing, which
+    # the GL thread may be doing after the caller has freed them
+    'MultiDrawArrays',
+    # read the indirect buffer, or client memory
+    'DrawArraysIndirect',
+    'DrawElementsIndirect',
+    'MultiDrawArraysIndirect',
+    'MultiDrawElementsIndirect',
+    ])
+
+# Code run on the calling thread after the command has been queued, for
+# the functions changing state the marshalling code looks at.
+hooks = {
+    'BindBuffer': '_mesa_glthread_BindBuffer(ctx, target, buffer);',
+    'BindVertexArray': '_mesa_glthread_BindVertexArray(ctx, array);',
+    'BindVertexArrayAPPLE': '_mesa_glthread_BindVertexArray(ctx, array);',
+    'DeleteBuffers': '_mesa_glthread_DeleteBuffers(ctx, n, buffer);',
+    'DeleteVertexArrays': '_mesa_glthread_DeleteVertexArrays(ctx, n, arrays);',
+    'ClientActiveTexture': '_mesa_glthread_ClientActiveTexture(ctx, texture);',
+    'Enable': '_mesa_glthread_ClientState(ctx, cap, GL_TRUE);',
+    'Disable': '_mesa_glthread_ClientState(ctx, cap, GL_FALSE);',
+    'EnableClientState': '_mesa_glthread_ClientState(ctx, array, GL_TRUE);',
+    'DisableClientState': '_mesa_glthread_ClientState(ctx, array, GL_FALSE);',
+    'EnableVertexAttribArray':
+        '_mesa_glthread_VertexAttribArray(ctx, index, GL_TRUE);',
+    'DisableVertexAttribArray':
+        '_mesa_glthread_VertexAttribArray(ctx, index, GL_FALSE);',
+    # these change which arrays are enabled, or where they come from, in
+    # ways not worth following
+    'InterleavedArrays': '_mesa_glthread_resync_arrays(ctx);',
+    'BindVertexBuffer': '_mesa_glthread_resync_arrays(ctx);',
+    'VertexAttribBinding': '_mesa_glthread_resync_arrays(ctx);',
+    'PopClientAttrib': '_mesa_glthread_resync_arrays(ctx);',
+    # callbacks must be called on the application's thread
+    'DebugMessageCallback':
+        '_mesa_glthread_DebugMessageCallback(ctx, callback != NULL);',
+    'DebugMessageCallbackARB':
+        '_mesa_glthread_DebugMessageCallback(ctx, callback != NULL);',
+    'Flush': '_mesa_glthread_flush_batch(ctx);',
+    }
+
+
+header = """
+#include <string.h>
+
+#include "main/api_exec.h"
+#include "main/context.h"
+#include "main/dispatch.h"
+#include "main/macros.h"
+#include "main/marshal.h"
+#include "main/mtypes.h"
+"""
+
+
+def marshal_flavor(func):
+    if func.name in draw_functions:
+        return 'draw'
+    if func.name in pointer_functions:
+        return 'pointer'
+    if func.name in sync_functions or func.return_type != 'void':
+        return 'sync'
+
+    for p in func.parameterIterator():
+        if p.is_padding or not p.is_pointer():
+            continue
+        if p.is_output or p.is_image() or p.count_parameter_list:
+            return 'sync'
+        # pointers to pointers: only the outer array would be copied
+        if p.type_string().count('*') > 1:
+            return 'sync'
+        if not p.count and not p.counter:
+            return 'sync'
+
+    return 'async'
+
+
+def copied_params(func):
+    """Parameters copied into async commands, minus the padding."""
+    return [p for p in func.parameterIterator() if not p.is_padding]
+
+
+def is_fixed_array(p):
+    return p.is_pointer() and p.count
+
+
+def is_variable_array(p):
+    return p.is_pointer() and p.counter
+
+
+def base_type(p):
+    t = p.get_base_type_string()
+    if t == 'GLvoid':
+        return 'GLubyte'
+    return t
+
+
+def variable_size(p, prefix='', cast='(GLint64) '):
+    """C expression for the size in bytes of a counted array, as GLint64.
+    prefix is prepended to the counter, e.g. 'cmd->'."""
+    size = max(p.size(), 1)
+    if size == 1:
+        return '%s%s%s' % (cast, prefix, p.counter)
+    return '%s%s%s * %d' % (cast, prefix, p.counter, size)
+
+
+class PrintCode(gl_XML.gl_print_base):
+
+    def __init__(self):
+        gl_XML.gl_print_base.__init__(self)
+
+        self.name = 'gl_marshal.py'
+        self.license = license.bsd_license_template % (
+            'Copyright (C) 2014 VMware, Inc.', 'VMware, Inc.')
+
+    def printRealHeader(self):
+        print header
+
+    def printRealFooter(self):
+        pass
+
+    def check_names(self, api):
+        names = set([f.name for f in api.functionIterateByOffset()])
+        for name in (draw_functions.keys() + pointer_functions.keys() +
+                     list(sync_functions) + hooks.keys()):
+            if name not in names:
+                raise Exception('Unknown function {0}'.format(name))
+
+    def print_cmd_ids(self, api):
+        print 'enum marshal_dispatch_cmd_id'
+        print '{'
+        for func in api.functionIterateByOffset():
+            print '   DISPATCH_CMD_{0},'.format(func.name)
+            if marshal_flavor(func) == 'async' and self.has_arrays(func):
+                print '   DISPATCH_CMD_{0}_sync,'.format(func.name)
+        print '   NUM_DISPATCH_CMD'
+        print '};'
+        print ''
+
+    def has_arrays(self, func):
+        for p in copied_params(func):
+            if p.is_pointer():
+                return True
+        return False
+
+    def print_call(self, func, args, result):
+        call = 'CALL_{0}(ctx->CurrentDispatch, ({1}))'.format(
+            func.name, ', '.join(args))
+        if result:
+            print '   *cmd->result = {0};'.format(call)
+        else:
+            print '   {0};'.format(call)
+
+    def print_byref_cmd(self, func, suffix):
+        """Command storing every parameter by value."""
+        name = func.name + suffix
+        params = copied_params(func)
+        has_result = func.return_type != 'void'
+
+        print 'struct marshal_cmd_{0}'.format(name)
+        print '{'
+        print '   struct marshal_cmd_base cmd_base;'
+        for p in params:
+            print '   {0} {1};'.format(p.type_string(), p.name)
+        if has_result:
+            print '   {0} *result;'.format(func.return_type)
+        print '};'
+        print ''
+        print 'static void'
+        prefix = '_mesa_unmarshal_{0}('.format(name)
+        print '{0}struct gl_context *ctx,'.format(prefix)
+        print '{0}const struct marshal_cmd_{1} *cmd)'.format(
+            ' ' * len(prefix), name)
+        print '{'
+        self.print_call(func, ['cmd->' + p.name for p in params], has_result)
+        print '}'
+        print ''
+
+    def print_byref_enqueue(self, func, suffix):
+        name = func.name + suffix
+        print '   cmd = _mesa_glthread_allocate_command(ctx, ' \
+              'DISPATCH_CMD_{0},'.format(name)
+        print '                                         sizeof(*cmd));'
+        for p in copied_params(func):
+            print '   cmd->{0} = {0};'.format(p.name)
+
+    def print_copy_cmd(self, func):
+        """Command carrying copies of the arrays passed to the function."""
+        params = copied_params(func)
+        variable = [p for p in params if is_variable_array(p)]
+
+        print 'struct marshal_cmd_{0}'.format(func.name)
+        print '{'
+        print '   struct marshal_cmd_base cmd_base;'
+        for p in params:
+            if is_fixed_array(p):
+                print '   {0} {1}[{2}];'.format(base_type(p), p.name,
+                                                p.get_element_count())
+            elif not is_variable_array(p):
+                print '   {0} {1};'.format(p.type_string(), p.name)
+        for p in variable:
+            print '   /* followed by {0} bytes of {1} */'.format(
+                variable_size(p, cast=''), p.name)
+        print '};'
+        print ''
+        print 'static void'
+        prefix = '_mesa_unmarshal_{0}('.format(func.name)
+        print '{0}struct gl_context *ctx,'.format(prefix)
+        print '{0}const struct marshal_cmd_{1} *cmd)'.format(
+            ' ' * len(prefix), func.name)
+        print '{'
+        if variable:
+            print '   const GLubyte *variable_data ='
+            print '      (const GLubyte *) cmd + ' \
+                  'ALIGN(sizeof(*cmd), MARSHAL_CMD_ALIGN);'
+            for p in variable:
+                print '   {0} {1};'.format(p.type_string(), p.name)
+            print ''
+            for i, p in enumerate(variable):
+                print '   {0} = ({1}) variable_data;'.format(
+                    p.name, p.type_string())
+                if i + 1 < len(variable):
+                    size = variable_size(p, 'cmd->')
+                    print '   variable_data += ' \
+                          'ALIGN({0}, MARSHAL_CMD_ALIGN);'.format(size)
+        args = []
+        for p in params:
+            if is_variable_array(p):
+                args.append(p.name)
+            else:
+                args.append('cmd->' + p.name)
+        self.print_call(func, args, False)
+        print '}'
+        print ''
+
+    def print_marshal_prologue(self, func):
+        print 'static {0} GLAPIENTRY'.format(func.return_type)
+        print '_mesa_marshal_{0}({1})'.format(func.name,
+                                              func.get_parameter_string())
+        print '{'
+        print '   GET_CURRENT_CONTEXT(ctx);'
+
+    def print_hook(self, func, indent='   '):
+        if func.name in hooks:
+            print '{0}{1}'.format(indent, hooks[func.name])
+
+    def print_sync_marshal(self, func):
+        has_result = func.return_type != 'void'
+
+        self.print_marshal_prologue(func)
+        print '   struct marshal_cmd_{0} *cmd;'.format(func.name)
+        if has_result:
+            print '   {0} result;'.format(func.return_type)
+        print ''
+        self.print_byref_enqueue(func, '')
+        if has_result:
+            print '   cmd->result = &result;'
+        print '   _mesa_glthread_finish(ctx);'
+        self.print_hook(func)
+        if has_result:
+            print '   return result;'
+        print '}'
+        print ''
+
+    def print_draw_marshal(self, func):
+        indices = draw_functions.get(func.name)
+
+        self.print_marshal_prologue(func)
+        print '   struct marshal_cmd_{0} *cmd;'.format(func.name)
+        print ''
+        self.print_byref_enqueue(func, '')
+        if indices:
+            print '   if (_mesa_glthread_draw_needs_sync(ctx, GL_TRUE))'
+        else:
+            print '   if (_mesa_glthread_draw_needs_sync(ctx, GL_FALSE))'
+        print '      _mesa_glthread_finish(ctx);'
+        print '}'
+        print ''
+
+    def print_pointer_marshal(self, func):
+        self.print_marshal_prologue(func)
+        print '   struct marshal_cmd_{0} *cmd;'.format(func.name)
+        print ''
+        self.print_byref_enqueue(func, '')
+        attrib = pointer_functions[func.name]
+        if attrib:
+            print '   _mesa_glthread_array_pointer(ctx, {0});'.format(attrib)
+        self.print_hook(func)
+        print '}'
+        print ''
+
+    def print_async_marshal(self, func):
+        params = copied_params(func)
+        fixed = [p for p in params if is_fixed_array(p)]
+        variable = [p for p in params if is_variable_array(p)]
+
+        self.print_marshal_prologue(func)
+        print '   struct marshal_cmd_{0} *cmd;'.format(func.name)
+        if variable:
+            print '   GLubyte *variable_data;'
+        for p in variable:
+            print '   const GLint64 {0}_size = {1};'.format(p.name,
+                                                        variable_size(p))
+        size_terms = ['ALIGN(sizeof(*cmd), MARSHAL_CMD_ALIGN)']
+        for p in variable:
+            size_terms.append('ALIGN({0}_size, MARSHAL_CMD_ALIGN)'.format(
+                p.name))
+        if variable:
+            print '   const GLint64 cmd_size ='
+            print '      {0};'.format(' +\n      '.join(size_terms))
+        print ''
+
+        # Let the GL thread report the errors, or crash, with the original
+        # pointers.
+        checks = []
+        for p in fixed:
+            checks.append('!{0}'.format(p.name))
+        for p in variable:
+            checks.append('{0}_size < 0'.format(p.name))
+            checks.append('({0}_size > 0 && !{0})'.format(p.name))
+        if variable:
+            checks.append('cmd_size > MARSHAL_MAX_CMD_SIZE')
+        if checks:
+            print '   if ({0}) {{'.format(' ||\n       '.join(checks))
+            print '      struct marshal_cmd_{0}_sync *sync_cmd;'.format(
+                func.name)
+            print '      sync_cmd = _mesa_glthread_allocate_command(ctx, ' \
+                  'DISPATCH_CMD_{0}_sync,'.format(func.name)
+            print '                                                 ' \
+                  'sizeof(*sync_cmd));'
+            for p in params:
+                print '      sync_cmd->{0} = {0};'.format(p.name)
+            print '      _mesa_glthread_finish(ctx);'
+            self.print_hook(func, '      ')
+            print '      return;'
+            print '   }'
+            print ''
+
+        if variable:
+            print '   cmd = _mesa_glthread_allocate_command(ctx, ' \
+                  'DISPATCH_CMD_{0},'.format(func.name)
+            print '                                         ' \
+                  '(size_t) cmd_size);'
+        else:
+            print '   cmd = _mesa_glthread_allocate_command(ctx, ' \
+                  'DISPATCH_CMD_{0},'.format(func.name)
+            print '                                         sizeof(*cmd));'
+        for p in params:
+            if is_fixed_array(p):
+                print '   memcpy(cmd->{0}, {0}, sizeof(cmd->{0}));'.format(
+                    p.name)
+            elif not is_variable_array(p):
+                print '   cmd->{0} = {0};'.format(p.name)
+        if variable:
+            print '   variable_data ='
+            print '      (GLubyte *) cmd + ' \
+                  'ALIGN(sizeof(*cmd), MARSHAL_CMD_ALIGN);'
+            for i, p in enumerate(variable):
+                print '   memcpy(variable_data, {0}, (size_t) {0}_size);' \
+                    .format(p.name)
+                if i + 1 < len(variable):
+                    print '   variable_data += ' \
+                          'ALIGN({0}_size, MARSHAL_CMD_ALIGN);'.format(p.name)
+        self.print_hook(func)
+        print '}'
+        print ''
+
+    def print_function(self, func):
+        flavor = marshal_flavor(func)
+
+        print '/* {0}: {1} */'.format(func.name, flavor)
+        if flavor == 'async' and self.has_arrays(func):
+            self.print_copy_cmd(func)
+            self.print_byref_cmd(func, '_sync')
+        else:
+            self.print_byref_cmd(func, '')
+
+        if flavor == 'sync':
+            self.print_sync_marshal(func)
+        elif flavor == 'draw':
+            self.print_draw_marshal(func)
+        elif flavor == 'pointer':
+            self.print_pointer_marshal(func)
+        else:
+            self.print_async_marshal(func)
+
+    def print_unmarshal_dispatch(self, api):
+        print '/**'
+        print ' * Execute the command at cmd, returning its size.'
+        print ' */'
+        print 'size_t'
+        print '_mesa_unmarshal_dispatch_cmd(struct gl_context *ctx, ' \
+              'const void *cmd)'
+        print '{'
+        print '   const struct marshal_cmd_base *cmd_base ='
+        print '      (const struct marshal_cmd_base *) cmd;'
+        print ''
+        print '   switch (cmd_base->cmd_id) {'
+        for func in api.functionIterateByOffset():
+            names = [func.name]
+            if marshal_flavor(func) == 'async' and self.has_arrays(func):
+                names.append(func.name + '_sync')
+            for name in names:
+                print '   case DISPATCH_CMD_{0}:'.format(name)
+                print '      _mesa_unmarshal_{0}(ctx, (const struct ' \
+                      'marshal_cmd_{0} *) cmd);'.format(name)
+                print '      break;'
+        print '   default:'
+        print '      assert(!"Unknown marshalled command");'
+        print '      break;'
+        print '   }'
+        print ''
+        print '   return cmd_base->cmd_size;'
+        print '}'
+        print ''
+
+    def print_create_marshal_table(self, api):
+        print '/**'
+        print ' * Create the dispatch table installed on the calling thread ' \
+              'while'
+        print ' * the context runs its GL calls on the GL thread.'
+        print ' */'
+        print 'struct _glapi_table *'
+        print '_mesa_create_marshal_table(void)'
+        print '{'
+        print '   struct _glapi_table *table;'
+        print ''
+        print '   table = _mesa_alloc_dispatch_table();'
+        print '   if (table == NULL)'
+        print '      return NULL;'
+        print ''
+        for func in api.functionIterateByOffset():
+            print '   SET_{0}(table, _mesa_marshal_{0});'.format(func.name)
+        print ''
+        print '   return table;'
+        print '}'
+
+    def printBody(self, api):
+        self.check_names(api)
+        self.print_cmd_ids(api)
+        for func in api.functionIterateByOffset():
+            self.print_function(func)
+        self.print_unmarshal_dispatch(api)
+        self.print_create_marshal_table(api)
+
+
+def show_usage():
+    print "Usage: %s [-f input_file_name]" % sys.argv[0]
+    sys.exit(1)
+
+
+if __name__ == '__main__':
+    file_name = "gl_and_es_API.xml"
+
+    try:
+        (args, trail) = getopt.getopt(sys.argv[1:], "m:f:")
+    except Exception,e:
+        show_usage()
+
+    for (arg,val) in args:
+        if arg == "-f":
+            file_name = val
+
+    printer = PrintCode()
+
+    api = gl_XML.parse_GL_API(file_name)
+    printer.Print(api)
@@ -292,6 +292,7 @@ intelInitExtensions(struct gl_context *ctx)
          ctx->Extensions.ARB_transform_feedback3 = true;
          ctx->Extensions.ARB_transform_feedback_instanced = true;
          ctx->Extensions.ARB_draw_indirect = true;
+         ctx->Extensions.ARB_multi_draw_indirect = true;
       }
 
       /* Only enable this in core profile because other parts of Mesa behave
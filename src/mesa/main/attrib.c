@@ -1720,6 +1720,8 @@ _mesa_PopClientAttrib(void)
 	      (struct gl_array_attrib *) node->data;
             restore_array_attrib(ctx, &ctx->Array, attr);
             free_array_attrib_data(ctx, attr);
+            /* All the arrays may have changed, tell the driver */
+            ctx->Array.ArrayObj->NewArrays |= VERT_BIT_ALL;
 	    ctx->NewState |= _NEW_ARRAY;
             break;
 	 }
@@ -46,6 +46,7 @@
 #include "texstore.h"
 #include "transformfeedback.h"
 #include "dispatch.h"
+#include "vbo/vbo.h"
 
 
 /* Debug flags */
@@ -207,7 +208,7 @@ static bool
 bufferobj_range_mapped(const struct gl_buffer_object *obj,
                        GLintptr offset, GLsizeiptr size)
 {
-   if (_mesa_bufferobj_mapped(obj)) {
+   if (_mesa_check_disallowed_mapping(obj)) {
       const GLintptr end = offset + size;
       const GLintptr mapEnd = obj->Offset + obj->Length;
 
@@ -276,7 +277,7 @@ buffer_object_subdata_range_good(struct gl_context * ctx, GLenum target,
       }
    }
    else {
-      if (_mesa_bufferobj_mapped(bufObj)) {
+      if (_mesa_check_disallowed_mapping(bufObj)) {
          _mesa_error(ctx, GL_INVALID_OPERATION, "%s", caller);
          return NULL;
       }
@@ -455,6 +456,8 @@ _mesa_reference_buffer_object_(struct gl_context *ctx,
 	 ASSERT(ctx->Array.ArrayObj->Vertex.BufferObj != bufObj);
 #endif
 
+         vbo_delete_minmax_cache(oldObj);
+
 	 ASSERT(ctx->Driver.DeleteBuffer);
          ctx->Driver.DeleteBuffer(ctx, oldObj);
       }
@@ -956,6 +959,17 @@ bind_buffer_object(struct gl_context *ctx, GLenum target, GLuint buffer)
    /* bind new buffer */
    _mesa_reference_buffer_object(ctx, bindTarget, newBufObj);
 
+   switch (target) {
+   case GL_PIXEL_PACK_BUFFER:
+   case GL_TRANSFORM_FEEDBACK_BUFFER:
+   case GL_TEXTURE_BUFFER:
+   case GL_ATOMIC_COUNTER_BUFFER:
+      /* The buffer may be written by the GPU, behind our back */
+      if (newBufObj != ctx->Shared->NullBufferObj)
+         vbo_disable_minmax_cache(newBufObj);
+      break;
+   }
+
    /* Pass BindBuffer call to device driver */
    if (ctx->Driver.BindBuffer)
       ctx->Driver.BindBuffer( ctx, target, newBufObj );
@@ -1238,6 +1252,92 @@ _mesa_IsBuffer(GLuint id)
 }
 
 
+void GLAPIENTRY
+_mesa_BufferStorage(GLenum target, GLsizeiptr size, const GLvoid *data,
+                    GLbitfield flags)
+{
+   GET_CURRENT_CONTEXT(ctx);
+   struct gl_buffer_object *bufObj;
+
+   if (MESA_VERBOSE & VERBOSE_API)
+      _mesa_debug(ctx, "glBufferStorage(%s, %ld, %p, 0x%x)\n",
+                  _mesa_lookup_enum_by_nr(target),
+                  (long int) size, data, flags);
+
+   if (!ctx->Extensions.ARB_buffer_storage) {
+      _mesa_error(ctx, GL_INVALID_OPERATION,
+                  "glBufferStorage(extension not supported)");
+      return;
+   }
+
+   if (size <= 0) {
+      _mesa_error(ctx, GL_INVALID_VALUE, "glBufferStorage(size <= 0)");
+      return;
+   }
+
+   if (flags & ~(GL_MAP_READ_BIT |
+                 GL_MAP_WRITE_BIT |
+                 GL_MAP_PERSISTENT_BIT |
+                 GL_MAP_COHERENT_BIT |
+                 GL_DYNAMIC_STORAGE_BIT |
+                 GL_CLIENT_STORAGE_BIT)) {
+      _mesa_error(ctx, GL_INVALID_VALUE, "glBufferStorage(flags)");
+      return;
+   }
+
+   /* The GL_ARB_buffer_storage spec says:
+    *
+    *     "If <flags> contains MAP_PERSISTENT_BIT, it must also contain at
+    *     least one of MAP_READ_BIT or MAP_WRITE_BIT.
+    *
+    *      It is an error to specify MAP_COHERENT_BIT without also
+    *      specifying MAP_PERSISTENT_BIT."
+    */
+   if ((flags & GL_MAP_PERSISTENT_BIT) &&
+       !(flags & (GL_MAP_READ_BIT | GL_MAP_WRITE_BIT))) {
+      _mesa_error(ctx, GL_INVALID_VALUE, "glBufferStorage(flags!=READ/WRITE)");
+      return;
+   }
+
+   if ((flags & GL_MAP_COHERENT_BIT) && !(flags & GL_MAP_PERSISTENT_BIT)) {
+      _mesa_error(ctx, GL_INVALID_VALUE, "glBufferStorage(flags!=PERSISTENT)");
+      return;
+   }
+
+   bufObj = get_buffer(ctx, "glBufferStorage", target, GL_INVALID_OPERATION);
+   if (!bufObj)
+      return;
+
+   if (bufObj->Immutable) {
+      _mesa_error(ctx, GL_INVALID_OPERATION, "glBufferStorage(immutable)");
+      return;
+   }
+
+   if (_mesa_bufferobj_mapped(bufObj)) {
+      /* Unmap the existing buffer.  We'll replace it now.  Not an error. */
+      ctx->Driver.UnmapBuffer(ctx, bufObj);
+      bufObj->AccessFlags = 0;
+      ASSERT(bufObj->Pointer == NULL);
+   }
+
+   FLUSH_VERTICES(ctx, _NEW_BUFFER_OBJECT);
+
+   bufObj->Written = GL_TRUE;
+   bufObj->Immutable = GL_TRUE;
+   bufObj->StorageFlags = flags;
+   vbo_delete_minmax_cache(bufObj);
+
+   /* Drivers look at bufObj->StorageFlags to decide where the storage
+    * goes and how it can be mapped.
+    */
+   ASSERT(ctx->Driver.BufferData);
+   if (!ctx->Driver.BufferData(ctx, target, size, data, GL_DYNAMIC_DRAW,
+                               bufObj)) {
+      _mesa_error(ctx, GL_OUT_OF_MEMORY, "glBufferStorage()");
+   }
+}
+
+
 void GLAPIENTRY
 _mesa_BufferData(GLenum target, GLsizeiptrARB size,
                     const GLvoid * data, GLenum usage)
@@ -1290,6 +1390,11 @@ _mesa_BufferData(GLenum target, GLsizeiptrARB size,
    if (!bufObj)
       return;
 
+   if (bufObj->Immutable) {
+      _mesa_error(ctx, GL_INVALID_OPERATION, "glBufferData(immutable)");
+      return;
+   }
+
    if (_mesa_bufferobj_mapped(bufObj)) {
       /* Unmap the existing buffer.  We'll replace it now.  Not an error. */
       ctx->Driver.UnmapBuffer(ctx, bufObj);
@@ -1300,6 +1405,9 @@ _mesa_BufferData(GLenum target, GLsizeiptrARB size,
    FLUSH_VERTICES(ctx, _NEW_BUFFER_OBJECT);
 
    bufObj->Written = GL_TRUE;
+   bufObj->StorageFlags = GL_MAP_READ_BIT | GL_MAP_WRITE_BIT |
+                          GL_DYNAMIC_STORAGE_BIT;
+   vbo_delete_minmax_cache(bufObj);
 
 #ifdef VBO_DEBUG
    printf("glBufferDataARB(%u, sz %ld, from %p, usage 0x%x)\n",
@@ -1332,10 +1440,17 @@ _mesa_BufferSubData(GLenum target, GLintptrARB offset,
       return;
    }
 
+   if (bufObj->Immutable &&
+       !(bufObj->StorageFlags & GL_DYNAMIC_STORAGE_BIT)) {
+      _mesa_error(ctx, GL_INVALID_OPERATION, "glBufferSubData");
+      return;
+   }
+
    if (size == 0)
       return;
 
    bufObj->Written = GL_TRUE;
+   vbo_delete_minmax_cache(bufObj);
 
    ASSERT(ctx->Driver.BufferSubData);
    ctx->Driver.BufferSubData( ctx, offset, size, data, bufObj );
@@ -1377,7 +1492,7 @@ _mesa_ClearBufferData(GLenum target, GLenum internalformat, GLenum format,
       return;
    }
 
-   if (_mesa_bufferobj_mapped(bufObj)) {
+   if (_mesa_check_disallowed_mapping(bufObj)) {
       _mesa_error(ctx, GL_INVALID_OPERATION,
                   "glClearBufferData(buffer currently mapped)");
       return;
@@ -1398,6 +1513,8 @@ _mesa_ClearBufferData(GLenum target, GLenum internalformat, GLenum format,
       return;
    }
 
+   vbo_delete_minmax_cache(bufObj);
+
    if (data == NULL) {
       /* clear to zeros, per the spec */
       ctx->Driver.ClearBufferSubData(ctx, 0, bufObj->Size,
@@ -1449,6 +1566,8 @@ _mesa_ClearBufferSubData(GLenum target, GLenum internalformat,
       return;
    }
 
+   vbo_delete_minmax_cache(bufObj);
+
    if (data == NULL) {
       /* clear to zeros, per the spec */
       ctx->Driver.ClearBufferSubData(ctx, offset, size,
@@ -1516,6 +1635,22 @@ _mesa_MapBuffer(GLenum target, GLenum access)
       return NULL;
    }
 
+   if (bufObj->Immutable) {
+      if ((accessFlags & GL_MAP_READ_BIT) &&
+          !(bufObj->StorageFlags & GL_MAP_READ_BIT)) {
+         _mesa_error(ctx, GL_INVALID_OPERATION,
+                     "glMapBuffer(buffer does not allow read access)");
+         return NULL;
+      }
+
+      if ((accessFlags & GL_MAP_WRITE_BIT) &&
+          !(bufObj->StorageFlags & GL_MAP_WRITE_BIT)) {
+         _mesa_error(ctx, GL_INVALID_OPERATION,
+                     "glMapBuffer(buffer does not allow write access)");
+         return NULL;
+      }
+   }
+
    ASSERT(ctx->Driver.MapBufferRange);
    map = ctx->Driver.MapBufferRange(ctx, 0, bufObj->Size, accessFlags, bufObj);
    if (!map) {
@@ -1533,8 +1668,10 @@ _mesa_MapBuffer(GLenum target, GLenum access)
       bufObj->AccessFlags = accessFlags;
    }
 
-   if (access == GL_WRITE_ONLY_ARB || access == GL_READ_WRITE_ARB)
+   if (access == GL_WRITE_ONLY_ARB || access == GL_READ_WRITE_ARB) {
       bufObj->Written = GL_TRUE;
+      vbo_delete_minmax_cache(bufObj);
+   }
 
 #ifdef VBO_DEBUG
    printf("glMapBufferARB(%u, sz %ld, access 0x%x)\n",
@@ -1664,6 +1801,16 @@ _mesa_GetBufferParameteriv(GLenum target, GLenum pname, GLint *params)
          goto invalid_pname;
       *params = (GLint) bufObj->Length;
       return;
+   case GL_BUFFER_IMMUTABLE_STORAGE:
+      if (!ctx->Extensions.ARB_buffer_storage)
+         goto invalid_pname;
+      *params = bufObj->Immutable;
+      return;
+   case GL_BUFFER_STORAGE_FLAGS:
+      if (!ctx->Extensions.ARB_buffer_storage)
+         goto invalid_pname;
+      *params = bufObj->StorageFlags;
+      return;
    default:
       ; /* fall-through */
    }
@@ -1718,6 +1865,16 @@ _mesa_GetBufferParameteri64v(GLenum target, GLenum pname, GLint64 *params)
          goto invalid_pname;
       *params = bufObj->Length;
       return;
+   case GL_BUFFER_IMMUTABLE_STORAGE:
+      if (!ctx->Extensions.ARB_buffer_storage)
+         goto invalid_pname;
+      *params = bufObj->Immutable;
+      return;
+   case GL_BUFFER_STORAGE_FLAGS:
+      if (!ctx->Extensions.ARB_buffer_storage)
+         goto invalid_pname;
+      *params = bufObj->StorageFlags;
+      return;
    default:
       ; /* fall-through */
    }
@@ -1766,13 +1923,13 @@ _mesa_CopyBufferSubData(GLenum readTarget, GLenum writeTarget,
    if (!dst)
       return;
 
-   if (_mesa_bufferobj_mapped(src)) {
+   if (_mesa_check_disallowed_mapping(src)) {
       _mesa_error(ctx, GL_INVALID_OPERATION,
                   "glCopyBufferSubData(readBuffer is mapped)");
       return;
    }
 
-   if (_mesa_bufferobj_mapped(dst)) {
+   if (_mesa_check_disallowed_mapping(dst)) {
       _mesa_error(ctx, GL_INVALID_OPERATION,
                   "glCopyBufferSubData(writeBuffer is mapped)");
       return;
@@ -1825,6 +1982,8 @@ _mesa_CopyBufferSubData(GLenum readTarget, GLenum writeTarget,
       }
    }
 
+   vbo_delete_minmax_cache(dst);
+
    ctx->Driver.CopyBufferSubData(ctx, src, dst, readOffset, writeOffset, size);
 }
 
@@ -1839,6 +1998,7 @@ _mesa_MapBufferRange(GLenum target, GLintptr offset, GLsizeiptr length,
    GET_CURRENT_CONTEXT(ctx);
    struct gl_buffer_object *bufObj;
    void *map;
+   GLbitfield allowed_access, storage_flags;
 
    ASSERT_OUTSIDE_BEGIN_END_WITH_RETVAL(ctx, NULL);
 
@@ -1873,12 +2033,19 @@ _mesa_MapBufferRange(GLenum target, GLintptr offset, GLsizeiptr length,
       return NULL;
    }
 
-   if (access & ~(GL_MAP_READ_BIT |
-                  GL_MAP_WRITE_BIT |
-                  GL_MAP_INVALIDATE_RANGE_BIT |
-                  GL_MAP_INVALIDATE_BUFFER_BIT |
-                  GL_MAP_FLUSH_EXPLICIT_BIT |
-                  GL_MAP_UNSYNCHRONIZED_BIT)) {
+   allowed_access = GL_MAP_READ_BIT |
+                    GL_MAP_WRITE_BIT |
+                    GL_MAP_INVALIDATE_RANGE_BIT |
+                    GL_MAP_INVALIDATE_BUFFER_BIT |
+                    GL_MAP_FLUSH_EXPLICIT_BIT |
+                    GL_MAP_UNSYNCHRONIZED_BIT;
+
+   if (ctx->Extensions.ARB_buffer_storage) {
+      allowed_access |= GL_MAP_PERSISTENT_BIT |
+                        GL_MAP_COHERENT_BIT;
+   }
+
+   if (access & ~allowed_access) {
       /* generate an error if any undefind bit is set */
       _mesa_error(ctx, GL_INVALID_VALUE, "glMapBufferRange(access)");
       return NULL;
@@ -1928,6 +2095,41 @@ _mesa_MapBufferRange(GLenum target, GLintptr offset, GLsizeiptr length,
       return NULL;
    }
 
+   /* The GL_ARB_buffer_storage spec says:
+    *
+    *     "An INVALID_OPERATION error is generated by MapBufferRange if any
+    *     of the following are true:
+    *
+    *     * <access> has MAP_READ_BIT, MAP_WRITE_BIT, MAP_PERSISTENT_BIT or
+    *       MAP_COHERENT_BIT set, and the corresponding bit is not set in
+    *       the value of BUFFER_STORAGE_FLAGS for the buffer;
+    *
+    *     * <access> has MAP_COHERENT_BIT set without MAP_PERSISTENT_BIT."
+    *
+    * Storage not allocated by glBufferStorage() can be mapped for reading
+    * and writing, but not persistently.  Don't look at StorageFlags for it,
+    * which is only set by glBufferData().
+    */
+   if (bufObj->Immutable)
+      storage_flags = bufObj->StorageFlags;
+   else
+      storage_flags = GL_MAP_READ_BIT | GL_MAP_WRITE_BIT;
+
+   if ((access & (GL_MAP_READ_BIT | GL_MAP_WRITE_BIT |
+                  GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT)) &
+       ~storage_flags) {
+      _mesa_error(ctx, GL_INVALID_OPERATION,
+                  "glMapBufferRange(access not allowed by the storage "
+                  "flags)");
+      return NULL;
+   }
+
+   if ((access & GL_MAP_COHERENT_BIT) && !(access & GL_MAP_PERSISTENT_BIT)) {
+      _mesa_error(ctx, GL_INVALID_OPERATION,
+                  "glMapBufferRange(COHERENT without PERSISTENT)");
+      return NULL;
+   }
+
    /* Mapping zero bytes should return a non-null pointer. */
    if (!length) {
       static long dummy = 0;
@@ -1952,6 +2154,14 @@ _mesa_MapBufferRange(GLenum target, GLintptr offset, GLsizeiptr length,
       ASSERT(bufObj->Length == length);
       ASSERT(bufObj->Offset == offset);
       ASSERT(bufObj->AccessFlags == access);
+
+      if (access & GL_MAP_WRITE_BIT) {
+         /* The buffer may now change at any time without any GL call */
+         if (access & GL_MAP_PERSISTENT_BIT)
+            vbo_disable_minmax_cache(bufObj);
+         else
+            vbo_delete_minmax_cache(bufObj);
+      }
    }
 
    return map;
@@ -2550,6 +2760,12 @@ _mesa_BindBufferRange(GLenum target, GLuint index,
       }
    }
 
+   /* The buffer may be written by the GPU, behind our back */
+   if ((target == GL_TRANSFORM_FEEDBACK_BUFFER ||
+        target == GL_ATOMIC_COUNTER_BUFFER) &&
+       bufObj != ctx->Shared->NullBufferObj)
+      vbo_disable_minmax_cache(bufObj);
+
    switch (target) {
    case GL_TRANSFORM_FEEDBACK_BUFFER:
       _mesa_bind_buffer_range_transform_feedback(ctx, index, bufObj,
@@ -2615,6 +2831,12 @@ _mesa_BindBufferBase(GLenum target, GLuint index, GLuint buffer)
     * rendering work in cases where it would have had undefined results.
     */
 
+   /* The buffer may be written by the GPU, behind our back */
+   if ((target == GL_TRANSFORM_FEEDBACK_BUFFER ||
+        target == GL_ATOMIC_COUNTER_BUFFER) &&
+       bufObj != ctx->Shared->NullBufferObj)
+      vbo_disable_minmax_cache(bufObj);
+
    switch (target) {
    case GL_TRANSFORM_FEEDBACK_BUFFER:
       _mesa_bind_buffer_base_transform_feedback(ctx, index, bufObj);
@@ -2699,7 +2921,7 @@ _mesa_InvalidateBufferData(GLuint buffer)
     *     mapped by MapBuffer, or if the invalidate range intersects the range
     *     currently mapped by MapBufferRange."
     */
-   if (_mesa_bufferobj_mapped(bufObj)) {
+   if (_mesa_check_disallowed_mapping(bufObj)) {
       _mesa_error(ctx, GL_INVALID_OPERATION,
                   "glInvalidateBufferData(intersection with mapped "
                   "range)");
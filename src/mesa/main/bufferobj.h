@@ -44,6 +44,19 @@ _mesa_bufferobj_mapped(const struct gl_buffer_object *obj)
    return obj->Pointer != NULL;
 }
 
+/**
+ * Is the given buffer object mapped in a way that prevents the GL from
+ * using it?  Only persistent mappings (GL_ARB_buffer_storage) may stay in
+ * place while the buffer is used, and drivers must allow mapping such a
+ * buffer once more internally.
+ */
+static inline GLboolean
+_mesa_check_disallowed_mapping(const struct gl_buffer_object *obj)
+{
+   return _mesa_bufferobj_mapped(obj) &&
+          !(obj->AccessFlags & GL_MAP_PERSISTENT_BIT);
+}
+
 /**
  * Is the given buffer object a user-created buffer object?
  * Mesa uses default buffer objects in several places.  Default buffers
@@ -117,6 +130,10 @@ _mesa_GenBuffers(GLsizei n, GLuint * buffer);
 GLboolean GLAPIENTRY
 _mesa_IsBuffer(GLuint buffer);
 
+void GLAPIENTRY
+_mesa_BufferStorage(GLenum target, GLsizeiptr size, const GLvoid *data,
+                    GLbitfield flags);
+
 void GLAPIENTRY
 _mesa_BufferData(GLenum target, GLsizeiptrARB size,
                  const GLvoid * data, GLenum usage);
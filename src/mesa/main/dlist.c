@@ -994,6 +994,7 @@ dlist_alloc(struct gl_context *ctx, OpCode opcode, GLuint bytes)
 
    n = ctx->ListState.CurrentBlock + ctx->ListState.CurrentPos;
    ctx->ListState.CurrentPos += numNodes;
+   ctx->ListState.LastInstSize = numNodes;
 
    n[0].opcode = opcode;
 
@@ -4980,13 +4981,39 @@ save_SetFragmentShaderConstantATI(GLuint dst, const GLfloat *value)
    }
 }
 
+/**
+ * Return the last instruction of the display list being compiled if it
+ * sets the same attribute, with the same opcode, as the one about to be
+ * compiled.  Nothing can have used the value it sets, so the new value
+ * can simply replace it: this collapses the redundant glColor/glNormal/
+ * glVertexAttrib calls which state-sorting scene graphs tend to emit.
+ * Attribute 0 provokes a vertex, so it's never collapsed.
+ */
+static Node *
+last_attr_instruction(struct gl_context *ctx, OpCode opcode, GLuint attr)
+{
+   Node *n;
+
+   if (attr == 0 || ctx->ListState.LastInstSize == 0)
+      return NULL;
+
+   n = ctx->ListState.CurrentBlock + ctx->ListState.CurrentPos -
+       ctx->ListState.LastInstSize;
+   if (n[0].opcode != opcode || n[1].e != attr)
+      return NULL;
+
+   return n;
+}
+
 static void GLAPIENTRY
 save_Attr1fNV(GLenum attr, GLfloat x)
 {
    GET_CURRENT_CONTEXT(ctx);
    Node *n;
    SAVE_FLUSH_VERTICES(ctx);
-   n = alloc_instruction(ctx, OPCODE_ATTR_1F_NV, 2);
+   n = last_attr_instruction(ctx, OPCODE_ATTR_1F_NV, attr);
+   if (!n)
+      n = alloc_instruction(ctx, OPCODE_ATTR_1F_NV, 2);
    if (n) {
       n[1].e = attr;
       n[2].f = x;
@@ -5007,7 +5034,9 @@ save_Attr2fNV(GLenum attr, GLfloat x, GLfloat y)
    GET_CURRENT_CONTEXT(ctx);
    Node *n;
    SAVE_FLUSH_VERTICES(ctx);
-   n = alloc_instruction(ctx, OPCODE_ATTR_2F_NV, 3);
+   n = last_attr_instruction(ctx, OPCODE_ATTR_2F_NV, attr);
+   if (!n)
+      n = alloc_instruction(ctx, OPCODE_ATTR_2F_NV, 3);
    if (n) {
       n[1].e = attr;
       n[2].f = x;
@@ -5029,7 +5058,9 @@ save_Attr3fNV(GLenum attr, GLfloat x, GLfloat y, GLfloat z)
    GET_CURRENT_CONTEXT(ctx);
    Node *n;
    SAVE_FLUSH_VERTICES(ctx);
-   n = alloc_instruction(ctx, OPCODE_ATTR_3F_NV, 4);
+   n = last_attr_instruction(ctx, OPCODE_ATTR_3F_NV, attr);
+   if (!n)
+      n = alloc_instruction(ctx, OPCODE_ATTR_3F_NV, 4);
    if (n) {
       n[1].e = attr;
       n[2].f = x;
@@ -5052,7 +5083,9 @@ save_Attr4fNV(GLenum attr, GLfloat x, GLfloat y, GLfloat z, GLfloat w)
    GET_CURRENT_CONTEXT(ctx);
    Node *n;
    SAVE_FLUSH_VERTICES(ctx);
-   n = alloc_instruction(ctx, OPCODE_ATTR_4F_NV, 5);
+   n = last_attr_instruction(ctx, OPCODE_ATTR_4F_NV, attr);
+   if (!n)
+      n = alloc_instruction(ctx, OPCODE_ATTR_4F_NV, 5);
    if (n) {
       n[1].e = attr;
       n[2].f = x;
@@ -5077,7 +5110,9 @@ save_Attr1fARB(GLenum attr, GLfloat x)
    GET_CURRENT_CONTEXT(ctx);
    Node *n;
    SAVE_FLUSH_VERTICES(ctx);
-   n = alloc_instruction(ctx, OPCODE_ATTR_1F_ARB, 2);
+   n = last_attr_instruction(ctx, OPCODE_ATTR_1F_ARB, attr);
+   if (!n)
+      n = alloc_instruction(ctx, OPCODE_ATTR_1F_ARB, 2);
    if (n) {
       n[1].e = attr;
       n[2].f = x;
@@ -5098,7 +5133,9 @@ save_Attr2fARB(GLenum attr, GLfloat x, GLfloat y)
    GET_CURRENT_CONTEXT(ctx);
    Node *n;
    SAVE_FLUSH_VERTICES(ctx);
-   n = alloc_instruction(ctx, OPCODE_ATTR_2F_ARB, 3);
+   n = last_attr_instruction(ctx, OPCODE_ATTR_2F_ARB, attr);
+   if (!n)
+      n = alloc_instruction(ctx, OPCODE_ATTR_2F_ARB, 3);
    if (n) {
       n[1].e = attr;
       n[2].f = x;
@@ -5120,7 +5157,9 @@ save_Attr3fARB(GLenum attr, GLfloat x, GLfloat y, GLfloat z)
    GET_CURRENT_CONTEXT(ctx);
    Node *n;
    SAVE_FLUSH_VERTICES(ctx);
-   n = alloc_instruction(ctx, OPCODE_ATTR_3F_ARB, 4);
+   n = last_attr_instruction(ctx, OPCODE_ATTR_3F_ARB, attr);
+   if (!n)
+      n = alloc_instruction(ctx, OPCODE_ATTR_3F_ARB, 4);
    if (n) {
       n[1].e = attr;
       n[2].f = x;
@@ -5143,7 +5182,9 @@ save_Attr4fARB(GLenum attr, GLfloat x, GLfloat y, GLfloat z, GLfloat w)
    GET_CURRENT_CONTEXT(ctx);
    Node *n;
    SAVE_FLUSH_VERTICES(ctx);
-   n = alloc_instruction(ctx, OPCODE_ATTR_4F_ARB, 5);
+   n = last_attr_instruction(ctx, OPCODE_ATTR_4F_ARB, attr);
+   if (!n)
+      n = alloc_instruction(ctx, OPCODE_ATTR_4F_ARB, 5);
    if (n) {
       n[1].e = attr;
       n[2].f = x;
@@ -8235,6 +8276,7 @@ _mesa_NewList(GLuint name, GLenum mode)
    ctx->ListState.CurrentList = make_list(name, BLOCK_SIZE);
    ctx->ListState.CurrentBlock = ctx->ListState.CurrentList->Head;
    ctx->ListState.CurrentPos = 0;
+   ctx->ListState.LastInstSize = 0;
 
    ctx->Driver.NewList(ctx, name, mode);
 
@@ -8291,6 +8333,7 @@ _mesa_EndList(void)
    ctx->ListState.CurrentList = NULL;
    ctx->ListState.CurrentBlock = NULL;
    ctx->ListState.CurrentPos = 0;
+   ctx->ListState.LastInstSize = 0;
    ctx->ExecuteFlag = GL_TRUE;
    ctx->CompileFlag = GL_FALSE;
 
@@ -9236,6 +9279,7 @@ _mesa_init_display_list(struct gl_context *ctx)
    ctx->CompileFlag = GL_FALSE;
    ctx->ListState.CurrentBlock = NULL;
    ctx->ListState.CurrentPos = 0;
+   ctx->ListState.LastInstSize = 0;
 
    /* Display List group */
    ctx->List.ListBase = 0;
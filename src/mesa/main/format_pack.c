@@ -38,6 +38,7 @@
 
 #include "colormac.h"
 #include "format_pack.h"
+#include "format_sse2.h"
 #include "macros.h"
 #include "../../gallium/auxiliary/util/u_format_rgb9e5.h"
 #include "../../gallium/auxiliary/util/u_format_r11g11b10f.h"
@@ -2263,6 +2264,18 @@ get_pack_ubyte_rgba_row_function(mesa_format format)
       table[MESA_FORMAT_B5G6R5_UNORM] = pack_row_ubyte_RGB565;
       table[MESA_FORMAT_R5G6B5_UNORM] = pack_row_ubyte_RGB565_REV;
 
+#if defined(__SSE2__)
+      {
+         GLuint f;
+         for (f = 0; f < MESA_FORMAT_COUNT; f++) {
+            pack_ubyte_rgba_row_func packrow =
+               _mesa_get_pack_ubyte_rgba_row_sse2(f);
+            if (packrow)
+               table[f] = packrow;
+         }
+      }
+#endif
+
       initialized = GL_TRUE;
    }
 
@@ -0,0 +1,389 @@
+/*
+ * Mesa 3-D graphics library
+ *
+ * Copyright (c) 2014 VMware, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * \file format_sse2.c
+ * SSE2 row pack/unpack functions.
+ *
+ * All the 8888 formats are handled as one 32-bit word per pixel which is
+ * swizzled into (or out of) the GLubyte[4] RGBA order with shifts and
+ * masks, four pixels at a time.  The results are bit-identical to the
+ * scalar functions in format_pack.c and format_unpack.c.
+ */
+
+#include "format_sse2.h"
+
+#if defined(__SSE2__)
+
+#include <string.h>
+#include <emmintrin.h>
+
+#include "colormac.h"
+#include "macros.h"
+
+
+#define EXPAND_5_8(X)  ( ((X) << 3) | ((X) >> 2) )
+
+#define EXPAND_6_8(X)  ( ((X) << 2) | ((X) >> 4) )
+
+
+/*
+ * Swizzles.  Each takes four pixels in one 32-bit lane each and returns
+ * them reordered.  The comments give the byte order in memory, with the
+ * GLubyte[4] RGBA order being R, G, B, A.
+ */
+
+static inline __m128i
+alpha_mask(void)
+{
+   return _mm_set1_epi32(0xff000000);
+}
+
+/** A, B, G, R <-> R, G, B, A */
+static inline __m128i
+swizzle_bswap(__m128i x)
+{
+   x = _mm_or_si128(_mm_slli_epi16(x, 8), _mm_srli_epi16(x, 8));
+   x = _mm_shufflelo_epi16(x, _MM_SHUFFLE(2, 3, 0, 1));
+   return _mm_shufflehi_epi16(x, _MM_SHUFFLE(2, 3, 0, 1));
+}
+
+/** X, B, G, R -> R, G, B, 0xff */
+static inline __m128i
+swizzle_bswap_x(__m128i x)
+{
+   return _mm_or_si128(swizzle_bswap(x), alpha_mask());
+}
+
+/** R, G, B, X -> R, G, B, 0xff */
+static inline __m128i
+swizzle_x(__m128i x)
+{
+   return _mm_or_si128(x, alpha_mask());
+}
+
+/** B, G, R, A <-> R, G, B, A */
+static inline __m128i
+swizzle_swap_rb(__m128i x)
+{
+   const __m128i ga = _mm_set1_epi32(0xff00ff00);
+   __m128i rb = _mm_andnot_si128(ga, x);
+
+   rb = _mm_shufflelo_epi16(rb, _MM_SHUFFLE(2, 3, 0, 1));
+   rb = _mm_shufflehi_epi16(rb, _MM_SHUFFLE(2, 3, 0, 1));
+   return _mm_or_si128(_mm_and_si128(x, ga), rb);
+}
+
+/** B, G, R, X -> R, G, B, 0xff */
+static inline __m128i
+swizzle_swap_rb_x(__m128i x)
+{
+   return _mm_or_si128(swizzle_swap_rb(x), alpha_mask());
+}
+
+/** R, G, B, A -> B, G, R, 0 */
+static inline __m128i
+swizzle_swap_rb_clear_x(__m128i x)
+{
+   return _mm_andnot_si128(alpha_mask(), swizzle_swap_rb(x));
+}
+
+/** A, R, G, B -> R, G, B, A */
+static inline __m128i
+swizzle_ror8(__m128i x)
+{
+   return _mm_or_si128(_mm_srli_epi32(x, 8), _mm_slli_epi32(x, 24));
+}
+
+/** X, R, G, B -> R, G, B, 0xff */
+static inline __m128i
+swizzle_ror8_x(__m128i x)
+{
+   return _mm_or_si128(_mm_srli_epi32(x, 8), alpha_mask());
+}
+
+/** R, G, B, A -> A, R, G, B */
+static inline __m128i
+swizzle_rol8(__m128i x)
+{
+   return _mm_or_si128(_mm_slli_epi32(x, 8), _mm_srli_epi32(x, 24));
+}
+
+/** R, G, B, A -> 0, R, G, B */
+static inline __m128i
+swizzle_rol8_clear_x(__m128i x)
+{
+   return _mm_slli_epi32(x, 8);
+}
+
+
+/**
+ * Define a function which applies a swizzle to a row of 32-bit pixels.
+ */
+#define SWIZZLE_ROW(SWIZZLE)                                              \
+static void                                                               \
+SWIZZLE##_row(const GLuint *s, GLuint *d, GLuint n)                       \
+{                                                                         \
+   GLuint i;                                                              \
+                                                                          \
+   for (i = 0; i + 8 <= n; i += 8) {                                      \
+      __m128i x0 = _mm_loadu_si128((const __m128i *) (s + i));            \
+      __m128i x1 = _mm_loadu_si128((const __m128i *) (s + i + 4));        \
+      _mm_storeu_si128((__m128i *) (d + i), SWIZZLE(x0));                 \
+      _mm_storeu_si128((__m128i *) (d + i + 4), SWIZZLE(x1));             \
+   }                                                                      \
+   for (; i < n; i++) {                                                   \
+      d[i] = _mm_cvtsi128_si32(SWIZZLE(_mm_cvtsi32_si128(s[i])));         \
+   }                                                                      \
+}
+
+SWIZZLE_ROW(swizzle_bswap)
+SWIZZLE_ROW(swizzle_bswap_x)
+SWIZZLE_ROW(swizzle_x)
+SWIZZLE_ROW(swizzle_swap_rb)
+SWIZZLE_ROW(swizzle_swap_rb_x)
+SWIZZLE_ROW(swizzle_swap_rb_clear_x)
+SWIZZLE_ROW(swizzle_ror8)
+SWIZZLE_ROW(swizzle_ror8_x)
+SWIZZLE_ROW(swizzle_rol8)
+SWIZZLE_ROW(swizzle_rol8_clear_x)
+
+
+/**********************************************************************/
+/*  Unpack, returning GLubyte colors                                  */
+/**********************************************************************/
+
+static void
+unpack_ubyte_RGBA8888_sse2(const void *src, GLubyte dst[][4], GLuint n)
+{
+   swizzle_bswap_row(src, (GLuint *) dst, n);
+}
+
+static void
+unpack_ubyte_RGBA8888_REV_sse2(const void *src, GLubyte dst[][4], GLuint n)
+{
+   memcpy(dst, src, n * 4);
+}
+
+static void
+unpack_ubyte_ARGB8888_sse2(const void *src, GLubyte dst[][4], GLuint n)
+{
+   swizzle_swap_rb_row(src, (GLuint *) dst, n);
+}
+
+static void
+unpack_ubyte_ARGB8888_REV_sse2(const void *src, GLubyte dst[][4], GLuint n)
+{
+   swizzle_ror8_row(src, (GLuint *) dst, n);
+}
+
+static void
+unpack_ubyte_RGBX8888_sse2(const void *src, GLubyte dst[][4], GLuint n)
+{
+   swizzle_bswap_x_row(src, (GLuint *) dst, n);
+}
+
+static void
+unpack_ubyte_RGBX8888_REV_sse2(const void *src, GLubyte dst[][4], GLuint n)
+{
+   swizzle_x_row(src, (GLuint *) dst, n);
+}
+
+static void
+unpack_ubyte_XRGB8888_sse2(const void *src, GLubyte dst[][4], GLuint n)
+{
+   swizzle_swap_rb_x_row(src, (GLuint *) dst, n);
+}
+
+static void
+unpack_ubyte_XRGB8888_REV_sse2(const void *src, GLubyte dst[][4], GLuint n)
+{
+   swizzle_ror8_x_row(src, (GLuint *) dst, n);
+}
+
+static void
+unpack_ubyte_RGB565_sse2(const void *src, GLubyte dst[][4], GLuint n)
+{
+   const GLushort *s = ((const GLushort *) src);
+   const __m128i mask5 = _mm_set1_epi16(0x1f);
+   const __m128i mask6 = _mm_set1_epi16(0x3f);
+   const __m128i alpha = _mm_set1_epi16(0xff00);
+   GLuint i;
+
+   for (i = 0; i + 8 <= n; i += 8) {
+      __m128i v = _mm_loadu_si128((const __m128i *) (s + i));
+      __m128i r = _mm_srli_epi16(v, 11);
+      __m128i g = _mm_and_si128(_mm_srli_epi16(v, 5), mask6);
+      __m128i b = _mm_and_si128(v, mask5);
+      __m128i rg, ba;
+
+      r = _mm_or_si128(_mm_slli_epi16(r, 3), _mm_srli_epi16(r, 2));
+      g = _mm_or_si128(_mm_slli_epi16(g, 2), _mm_srli_epi16(g, 4));
+      b = _mm_or_si128(_mm_slli_epi16(b, 3), _mm_srli_epi16(b, 2));
+
+      rg = _mm_or_si128(r, _mm_slli_epi16(g, 8));
+      ba = _mm_or_si128(b, alpha);
+
+      _mm_storeu_si128((__m128i *) dst[i], _mm_unpacklo_epi16(rg, ba));
+      _mm_storeu_si128((__m128i *) dst[i + 4], _mm_unpackhi_epi16(rg, ba));
+   }
+
+   for (; i < n; i++) {
+      dst[i][RCOMP] = EXPAND_5_8((s[i] >> 11) & 0x1f);
+      dst[i][GCOMP] = EXPAND_6_8((s[i] >> 5 ) & 0x3f);
+      dst[i][BCOMP] = EXPAND_5_8( s[i]        & 0x1f);
+      dst[i][ACOMP] = 0xff;
+   }
+}
+
+
+sse2_unpack_ubyte_rgba_row_func
+_mesa_get_unpack_ubyte_rgba_row_sse2(mesa_format format)
+{
+   switch (format) {
+   case MESA_FORMAT_A8B8G8R8_UNORM:
+      return unpack_ubyte_RGBA8888_sse2;
+   case MESA_FORMAT_R8G8B8A8_UNORM:
+      return unpack_ubyte_RGBA8888_REV_sse2;
+   case MESA_FORMAT_B8G8R8A8_UNORM:
+      return unpack_ubyte_ARGB8888_sse2;
+   case MESA_FORMAT_A8R8G8B8_UNORM:
+      return unpack_ubyte_ARGB8888_REV_sse2;
+   case MESA_FORMAT_X8B8G8R8_UNORM:
+      return unpack_ubyte_RGBX8888_sse2;
+   case MESA_FORMAT_R8G8B8X8_UNORM:
+      return unpack_ubyte_RGBX8888_REV_sse2;
+   case MESA_FORMAT_B8G8R8X8_UNORM:
+      return unpack_ubyte_XRGB8888_sse2;
+   case MESA_FORMAT_X8R8G8B8_UNORM:
+      return unpack_ubyte_XRGB8888_REV_sse2;
+   case MESA_FORMAT_B5G6R5_UNORM:
+      return unpack_ubyte_RGB565_sse2;
+   default:
+      return NULL;
+   }
+}
+
+
+/**********************************************************************/
+/*  Pack GLubyte colors                                               */
+/**********************************************************************/
+
+static void
+pack_row_ubyte_RGBA8888_sse2(GLuint n, const GLubyte src[][4], void *dst)
+{
+   swizzle_bswap_row((const GLuint *) src, dst, n);
+}
+
+static void
+pack_row_ubyte_RGBA8888_REV_sse2(GLuint n, const GLubyte src[][4], void *dst)
+{
+   memcpy(dst, src, n * 4);
+}
+
+static void
+pack_row_ubyte_ARGB8888_sse2(GLuint n, const GLubyte src[][4], void *dst)
+{
+   swizzle_swap_rb_row((const GLuint *) src, dst, n);
+}
+
+static void
+pack_row_ubyte_ARGB8888_REV_sse2(GLuint n, const GLubyte src[][4], void *dst)
+{
+   swizzle_rol8_row((const GLuint *) src, dst, n);
+}
+
+static void
+pack_row_ubyte_XRGB8888_sse2(GLuint n, const GLubyte src[][4], void *dst)
+{
+   swizzle_swap_rb_clear_x_row((const GLuint *) src, dst, n);
+}
+
+static void
+pack_row_ubyte_XRGB8888_REV_sse2(GLuint n, const GLubyte src[][4], void *dst)
+{
+   swizzle_rol8_clear_x_row((const GLuint *) src, dst, n);
+}
+
+/**
+ * Pack four RGBA pixels to 565 and narrow the 32-bit lanes to 16 bits.
+ * The lanes are sign extended first so the saturating pack leaves them
+ * untouched.
+ */
+static inline __m128i
+pack_565_4(__m128i x)
+{
+   __m128i r = _mm_slli_epi32(_mm_and_si128(x, _mm_set1_epi32(0xf8)), 8);
+   __m128i g = _mm_and_si128(_mm_srli_epi32(x, 5), _mm_set1_epi32(0x7e0));
+   __m128i b = _mm_and_si128(_mm_srli_epi32(x, 19), _mm_set1_epi32(0x1f));
+   __m128i v = _mm_or_si128(_mm_or_si128(r, g), b);
+
+   return _mm_srai_epi32(_mm_slli_epi32(v, 16), 16);
+}
+
+static void
+pack_row_ubyte_RGB565_sse2(GLuint n, const GLubyte src[][4], void *dst)
+{
+   GLushort *d = ((GLushort *) dst);
+   GLuint i;
+
+   for (i = 0; i + 8 <= n; i += 8) {
+      __m128i x0 = _mm_loadu_si128((const __m128i *) src[i]);
+      __m128i x1 = _mm_loadu_si128((const __m128i *) src[i + 4]);
+      _mm_storeu_si128((__m128i *) (d + i),
+                       _mm_packs_epi32(pack_565_4(x0), pack_565_4(x1)));
+   }
+
+   for (; i < n; i++) {
+      d[i] = PACK_COLOR_565(src[i][RCOMP], src[i][GCOMP], src[i][BCOMP]);
+   }
+}
+
+
+sse2_pack_ubyte_rgba_row_func
+_mesa_get_pack_ubyte_rgba_row_sse2(mesa_format format)
+{
+   switch (format) {
+   case MESA_FORMAT_A8B8G8R8_UNORM:
+   case MESA_FORMAT_X8B8G8R8_UNORM:
+      return pack_row_ubyte_RGBA8888_sse2;
+   case MESA_FORMAT_R8G8B8A8_UNORM:
+   case MESA_FORMAT_R8G8B8X8_UNORM:
+      return pack_row_ubyte_RGBA8888_REV_sse2;
+   case MESA_FORMAT_B8G8R8A8_UNORM:
+      return pack_row_ubyte_ARGB8888_sse2;
+   case MESA_FORMAT_A8R8G8B8_UNORM:
+      return pack_row_ubyte_ARGB8888_REV_sse2;
+   case MESA_FORMAT_B8G8R8X8_UNORM:
+      return pack_row_ubyte_XRGB8888_sse2;
+   case MESA_FORMAT_X8R8G8B8_UNORM:
+      return pack_row_ubyte_XRGB8888_REV_sse2;
+   case MESA_FORMAT_B5G6R5_UNORM:
+      return pack_row_ubyte_RGB565_sse2;
+   default:
+      return NULL;
+   }
+}
+
+#endif /* __SSE2__ */
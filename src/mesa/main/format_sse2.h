@@ -0,0 +1,53 @@
+/*
+ * Mesa 3-D graphics library
+ *
+ * Copyright (c) 2014 VMware, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * SSE2 versions of the row pack/unpack functions for the most common
+ * 8-bit and 16-bit color formats.  format_pack.c and format_unpack.c
+ * use these in place of the scalar loops when the compiler targets SSE2.
+ */
+
+#ifndef FORMAT_SSE2_H
+#define FORMAT_SSE2_H
+
+#include "formats.h"
+
+#if defined(__SSE2__)
+
+typedef void (*sse2_unpack_ubyte_rgba_row_func)(const void *src,
+                                                GLubyte dst[][4], GLuint n);
+
+typedef void (*sse2_pack_ubyte_rgba_row_func)(GLuint n,
+                                              const GLubyte src[][4],
+                                              void *dst);
+
+extern sse2_unpack_ubyte_rgba_row_func
+_mesa_get_unpack_ubyte_rgba_row_sse2(mesa_format format);
+
+extern sse2_pack_ubyte_rgba_row_func
+_mesa_get_pack_ubyte_rgba_row_sse2(mesa_format format);
+
+#endif /* __SSE2__ */
+
+#endif /* FORMAT_SSE2_H */
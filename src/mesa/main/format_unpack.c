@@ -25,6 +25,7 @@
 
 #include "colormac.h"
 #include "format_unpack.h"
+#include "format_sse2.h"
 #include "macros.h"
 #include "../../gallium/auxiliary/util/u_format_rgb9e5.h"
 #include "../../gallium/auxiliary/util/u_format_r11g11b10f.h"
@@ -2928,6 +2929,15 @@ void
 _mesa_unpack_ubyte_rgba_row(mesa_format format, GLuint n,
                             const void *src, GLubyte dst[][4])
 {
+#if defined(__SSE2__)
+   sse2_unpack_ubyte_rgba_row_func unpack =
+      _mesa_get_unpack_ubyte_rgba_row_sse2(format);
+   if (unpack) {
+      unpack(src, dst, n);
+      return;
+   }
+#endif
+
    switch (format) {
    case MESA_FORMAT_A8B8G8R8_UNORM:
       unpack_ubyte_RGBA8888(src, dst, n);
@@ -3,7 +3,8 @@
  * Generic hash table. 
  *
  * Used for display lists, texture objects, vertex/fragment programs,
- * buffer objects, etc.  The hash functions are thread-safe.
+ * buffer objects, etc.  The hash functions are thread-safe, and lookups
+ * of small keys don't lock.
  * 
  * \note key=0 is illegal.
  *
@@ -53,11 +54,52 @@
  */
 #define DELETED_KEY_VALUE 1
 
+/**
+ * Keys below this are also stored in a plain array, which _mesa_HashLookup()
+ * reads without locking.  GL object names are mostly small integers handed
+ * out by glGen*(), so in practice this covers nearly all the lookups.
+ */
+#define DENSE_MAX_KEYS (64 * 1024)
+
+/** Initial size of the dense array */
+#define DENSE_MIN_KEYS 64
+
+/**
+ * Make the stores done so far visible to other threads before the following
+ * ones.  Lock-free readers rely on it to never see a dense array before its
+ * contents.  The loads of the readers depend on the pointer they first load,
+ * so they need no barrier themselves.
+ */
+#if defined(__GNUC__)
+#define write_barrier() __sync_synchronize()
+#elif defined(_MSC_VER)
+#include <intrin.h>
+#define write_barrier() _ReadWriteBarrier()
+#else
+#define write_barrier()
+#endif
+
+/**
+ * Array of the values of the keys 0 to size - 1, NULL for the ones not in
+ * the table.
+ *
+ * When it grows, the old array can still be in use by readers, so it is only
+ * freed along with the table.  Since the size doubles each time, the retired
+ * arrays never take more memory than the current one.
+ */
+struct dense_array {
+   GLuint size;
+   struct dense_array *retired;          /**< previous, smaller array */
+   void * volatile data[1];              /**< size entries, really */
+};
+
 /**
  * The hash table data structure.  
  */
 struct _mesa_HashTable {
    struct hash_table *ht;
+   /** Keys below DENSE_MAX_KEYS, replaced by writers while locked */
+   struct dense_array * volatile dense;
    GLuint MaxKey;                        /**< highest key inserted so far */
    _glthread_Mutex Mutex;                /**< mutual exclusion lock */
    _glthread_Mutex WalkMutex;            /**< for _mesa_HashWalk() */
@@ -104,6 +146,51 @@ uint_key(GLuint id)
 }
 /** @} */
 
+/**
+ * Store the value of a key in the dense array, growing it if needed.
+ * Called with the table locked.
+ */
+static void
+dense_store(struct _mesa_HashTable *table, GLuint key, void *data)
+{
+   struct dense_array *dense = table->dense;
+
+   if (key >= DENSE_MAX_KEYS)
+      return;
+
+   if (!dense || key >= dense->size) {
+      struct dense_array *grown;
+      GLuint size = dense ? dense->size * 2 : DENSE_MIN_KEYS;
+
+      if (!data)
+         return;
+
+      while (key >= size)
+         size *= 2;
+
+      grown = calloc(1, sizeof(*grown) + (size - 1) * sizeof(grown->data[0]));
+      if (!grown) {
+         /* Keys outside the dense array are looked up in the hash table. */
+         return;
+      }
+
+      grown->size = size;
+      if (dense) {
+         memcpy((void *) grown->data, (void *) dense->data,
+                dense->size * sizeof(dense->data[0]));
+         grown->retired = dense;
+      }
+      grown->data[key] = data;
+
+      /* Fill the array before anybody can see it */
+      write_barrier();
+      table->dense = grown;
+      return;
+   }
+
+   dense->data[key] = data;
+}
+
 /**
  * Create a new hash table.
  * 
@@ -144,6 +231,12 @@ _mesa_DeleteHashTable(struct _mesa_HashTable *table)
 
    _mesa_hash_table_destroy(table->ht, NULL);
 
+   while (table->dense) {
+      struct dense_array *dense = table->dense;
+      table->dense = dense->retired;
+      free(dense);
+   }
+
    _glthread_DESTROY_MUTEX(table->Mutex);
    _glthread_DESTROY_MUTEX(table->WalkMutex);
    free(table);
@@ -181,12 +274,24 @@ _mesa_HashLookup_unlocked(struct _mesa_HashTable *table, GLuint key)
  * \param key the key.
  * 
  * \return pointer to user's data or NULL if key not in table
+ *
+ * Small keys are looked up in the dense array without locking, so binding
+ * objects doesn't serialize the contexts sharing them.  As with the locked
+ * lookup, the caller must make sure the object isn't deleted meanwhile.
  */
 void *
 _mesa_HashLookup(struct _mesa_HashTable *table, GLuint key)
 {
+   const struct dense_array *dense;
    void *res;
    assert(table);
+
+   dense = table->dense;
+   if (likely(dense && key < dense->size)) {
+      assert(key);
+      return dense->data[key];
+   }
+
    _glthread_LOCK_MUTEX(table->Mutex);
    res = _mesa_HashLookup_unlocked(table, key);
    _glthread_UNLOCK_MUTEX(table->Mutex);
@@ -227,6 +332,8 @@ _mesa_HashInsert(struct _mesa_HashTable *table, GLuint key, void *data)
       }
    }
 
+   dense_store(table, key, data);
+
    _glthread_UNLOCK_MUTEX(table->Mutex);
 }
 
@@ -263,6 +370,7 @@ _mesa_HashRemove(struct _mesa_HashTable *table, GLuint key)
       entry = _mesa_hash_table_search(table->ht, uint_hash(key), uint_key(key));
       _mesa_hash_table_remove(table->ht, entry);
    }
+   dense_store(table, key, NULL);
    _glthread_UNLOCK_MUTEX(table->Mutex);
 }
 
@@ -296,6 +404,10 @@ _mesa_HashDeleteAll(struct _mesa_HashTable *table,
       callback(DELETED_KEY_VALUE, table->deleted_key_data, userData);
       table->deleted_key_data = NULL;
    }
+   if (table->dense) {
+      memset((void *) table->dense->data, 0,
+             table->dense->size * sizeof(table->dense->data[0]));
+   }
    table->InDeleteAll = GL_FALSE;
    _glthread_UNLOCK_MUTEX(table->Mutex);
 }
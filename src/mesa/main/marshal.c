@@ -0,0 +1,563 @@
+/*
+ * Mesa 3-D graphics library
+ *
+ * Copyright (c) 2014 VMware, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * \file marshal.c
+ * The GL thread, and the binding state followed by the marshalling code.
+ */
+
+
+#include "glapi/glapi.h"
+#include "bufferobj.h"
+#include "context.h"
+#include "hash.h"
+#include "imports.h"
+#include "marshal.h"
+
+
+/**
+ * Execute all the commands of a batch.
+ */
+static void
+execute_batch(struct gl_context *ctx, struct glthread_batch *batch)
+{
+   const GLubyte *buffer = (const GLubyte *) batch->buffer;
+   GLuint pos = 0;
+
+   while (pos < batch->used)
+      pos += _mesa_unmarshal_dispatch_cmd(ctx, buffer + pos);
+
+   assert(pos == batch->used);
+   batch->used = 0;
+}
+
+
+static int
+glthread_worker(void *data)
+{
+   struct gl_context *ctx = (struct gl_context *) data;
+   struct glthread_state *glthread = ctx->GLThread;
+
+   /* The GL functions find the context through the thread's current
+    * context, so make it current here too.
+    */
+   _glapi_check_multithread();
+   _glapi_set_context(ctx);
+   _glapi_set_dispatch(ctx->CurrentDispatch);
+
+   mtx_lock(&glthread->mutex);
+
+   for (;;) {
+      struct glthread_batch *batch;
+
+      while (!glthread->queue && !glthread->shutdown)
+         cnd_wait(&glthread->new_work, &glthread->mutex);
+
+      if (!glthread->queue)
+         break;
+
+      batch = glthread->queue;
+      glthread->queue = batch->next;
+      if (!glthread->queue)
+         glthread->queue_tail = &glthread->queue;
+      glthread->num_queued--;
+      glthread->busy = GL_TRUE;
+      mtx_unlock(&glthread->mutex);
+
+      execute_batch(ctx, batch);
+
+      mtx_lock(&glthread->mutex);
+      batch->next = glthread->free_batches;
+      glthread->free_batches = batch;
+      glthread->busy = GL_FALSE;
+      cnd_broadcast(&glthread->work_done);
+   }
+
+   mtx_unlock(&glthread->mutex);
+
+   _glapi_set_context(NULL);
+   _glapi_set_dispatch(NULL);
+
+   return 0;
+}
+
+
+/**
+ * Copy the vertex array state of obj the marshalling code follows.
+ */
+static void
+read_vao(const struct gl_array_object *obj, struct glthread_vao *vao)
+{
+   GLuint i;
+
+   vao->name = obj->Name;
+   vao->element_buffer = obj->ElementArrayBufferObj->Name;
+   vao->enabled = 0;
+   vao->user_pointers = 0;
+
+   for (i = 0; i < VERT_ATTRIB_MAX; i++) {
+      const struct gl_vertex_attrib_array *array = &obj->VertexAttrib[i];
+      GLuint buffer = obj->VertexBinding[array->VertexBinding].BufferObj->Name;
+
+      vao->array_buffers[i] = buffer;
+      if (array->Enabled)
+         vao->enabled |= VERT_BIT(i);
+      if (!buffer)
+         vao->user_pointers |= VERT_BIT(i);
+   }
+}
+
+
+/**
+ * Read back the bindings and the bound vertex array object.  The GL thread
+ * must be idle.
+ */
+static void
+read_array_state(struct gl_context *ctx, struct glthread_state *glthread)
+{
+   const struct gl_array_object *obj = ctx->Array.ArrayObj;
+   struct glthread_vao *vao;
+
+   glthread->array_buffer = ctx->Array.ArrayBufferObj->Name;
+   glthread->client_active_texture = ctx->Array.ActiveTexture;
+
+   if (obj->Name) {
+      vao = _mesa_HashLookup(glthread->vaos, obj->Name);
+      if (!vao) {
+         vao = malloc(sizeof(*vao));
+         if (vao)
+            _mesa_HashInsert(glthread->vaos, obj->Name, vao);
+      }
+   }
+   else {
+      vao = &glthread->default_vao;
+   }
+
+   if (vao) {
+      read_vao(obj, vao);
+   }
+   else {
+      /* Out of memory: keep the default one, with all arrays enabled and
+       * in client memory, so draws always wait.
+       */
+      vao = &glthread->default_vao;
+      vao->element_buffer = 0;
+      vao->enabled = VERT_BIT_ALL;
+      vao->user_pointers = VERT_BIT_ALL;
+   }
+
+   glthread->vao = vao;
+   _mesa_glthread_update_client_arrays(glthread);
+}
+
+
+static void
+free_vao(GLuint key, void *data, void *userData)
+{
+   free(data);
+}
+
+
+/**
+ * Start running the GL calls of ctx on a GL thread.  The caller must
+ * install ctx->MarshalExec as its dispatch table, which
+ * _mesa_make_current() does.  On failure, ctx->GLThread is left NULL.
+ */
+void
+_mesa_glthread_init(struct gl_context *ctx)
+{
+   struct glthread_state *glthread;
+
+   assert(!ctx->GLThread);
+
+   glthread = calloc(1, sizeof(*glthread));
+   if (!glthread)
+      return;
+
+   glthread->batch = calloc(1, sizeof(*glthread->batch));
+   glthread->vaos = _mesa_NewHashTable();
+   ctx->MarshalExec = _mesa_create_marshal_table();
+   if (!glthread->batch || !glthread->vaos || !ctx->MarshalExec)
+      goto fail;
+
+   glthread->queue_tail = &glthread->queue;
+
+   /* The context may already have state, if made current before. */
+   read_vao(ctx->Array.DefaultArrayObj, &glthread->default_vao);
+   glthread->vao = &glthread->default_vao;
+   read_array_state(ctx, glthread);
+
+   mtx_init(&glthread->mutex, mtx_plain);
+   cnd_init(&glthread->new_work);
+   cnd_init(&glthread->work_done);
+
+   ctx->GLThread = glthread;
+
+   if (thrd_create(&glthread->thread, glthread_worker, ctx) != thrd_success) {
+      ctx->GLThread = NULL;
+      cnd_destroy(&glthread->work_done);
+      cnd_destroy(&glthread->new_work);
+      mtx_destroy(&glthread->mutex);
+      goto fail;
+   }
+
+   return;
+
+fail:
+   free(ctx->MarshalExec);
+   ctx->MarshalExec = NULL;
+   if (glthread->vaos) {
+      _mesa_HashDeleteAll(glthread->vaos, free_vao, NULL);
+      _mesa_DeleteHashTable(glthread->vaos);
+   }
+   free(glthread->batch);
+   free(glthread);
+}
+
+
+/**
+ * Wait for the GL thread to execute everything, then stop it.  ctx goes
+ * back to running its GL calls on the calling thread.
+ */
+void
+_mesa_glthread_destroy(struct gl_context *ctx)
+{
+   struct glthread_state *glthread = ctx->GLThread;
+   struct glthread_batch *batch;
+
+   if (!glthread)
+      return;
+
+   _mesa_glthread_finish(ctx);
+
+   mtx_lock(&glthread->mutex);
+   glthread->shutdown = GL_TRUE;
+   cnd_signal(&glthread->new_work);
+   mtx_unlock(&glthread->mutex);
+
+   thrd_join(glthread->thread, NULL);
+
+   ctx->GLThread = NULL;
+
+   cnd_destroy(&glthread->work_done);
+   cnd_destroy(&glthread->new_work);
+   mtx_destroy(&glthread->mutex);
+
+   while (glthread->free_batches) {
+      batch = glthread->free_batches;
+      glthread->free_batches = batch->next;
+      free(batch);
+   }
+   free(glthread->batch);
+
+   _mesa_HashDeleteAll(glthread->vaos, free_vao, NULL);
+   _mesa_DeleteHashTable(glthread->vaos);
+
+   free(glthread);
+
+   if (_glapi_get_context() == ctx)
+      _glapi_set_dispatch(ctx->CurrentDispatch);
+
+   free(ctx->MarshalExec);
+   ctx->MarshalExec = NULL;
+}
+
+
+/**
+ * Hand the current batch to the GL thread, waiting if too many are queued
+ * already.
+ */
+void
+_mesa_glthread_flush_batch(struct gl_context *ctx)
+{
+   struct glthread_state *glthread = ctx->GLThread;
+   struct glthread_batch *batch = glthread->batch;
+
+   if (!batch->used)
+      return;
+
+   mtx_lock(&glthread->mutex);
+
+   while (glthread->num_queued >= MARSHAL_MAX_QUEUED)
+      cnd_wait(&glthread->work_done, &glthread->mutex);
+
+   batch->next = NULL;
+   *glthread->queue_tail = batch;
+   glthread->queue_tail = &batch->next;
+   glthread->num_queued++;
+   cnd_signal(&glthread->new_work);
+
+   batch = glthread->free_batches;
+   if (batch)
+      glthread->free_batches = batch->next;
+
+   mtx_unlock(&glthread->mutex);
+
+   if (!batch) {
+      batch = malloc(sizeof(*batch));
+      if (!batch) {
+         /* Reuse the next batch the GL thread is done with */
+         mtx_lock(&glthread->mutex);
+         while (!glthread->free_batches)
+            cnd_wait(&glthread->work_done, &glthread->mutex);
+         batch = glthread->free_batches;
+         glthread->free_batches = batch->next;
+         mtx_unlock(&glthread->mutex);
+      }
+   }
+
+   batch->used = 0;
+   glthread->batch = batch;
+}
+
+
+/**
+ * Wait for the GL thread to execute every command recorded so far.
+ * Does nothing when called from the GL thread itself, e.g. by the driver.
+ */
+void
+_mesa_glthread_finish(struct gl_context *ctx)
+{
+   struct glthread_state *glthread = ctx->GLThread;
+
+   if (!glthread || thrd_equal(thrd_current(), glthread->thread))
+      return;
+
+   _mesa_glthread_flush_batch(ctx);
+
+   mtx_lock(&glthread->mutex);
+   while (glthread->queue || glthread->busy)
+      cnd_wait(&glthread->work_done, &glthread->mutex);
+   mtx_unlock(&glthread->mutex);
+}
+
+
+/**
+ * Catch up with the GL thread and read back the vertex array state, when
+ * it can't be worked out on the calling thread.
+ */
+void
+_mesa_glthread_resync_arrays(struct gl_context *ctx)
+{
+   _mesa_glthread_finish(ctx);
+   read_array_state(ctx, ctx->GLThread);
+}
+
+
+void
+_mesa_glthread_BindBuffer(struct gl_context *ctx, GLenum target,
+                          GLuint buffer)
+{
+   struct glthread_state *glthread = ctx->GLThread;
+
+   switch (target) {
+   case GL_ARRAY_BUFFER:
+      glthread->array_buffer = buffer;
+      break;
+   case GL_ELEMENT_ARRAY_BUFFER:
+      glthread->vao->element_buffer = buffer;
+      break;
+   }
+}
+
+
+void
+_mesa_glthread_BindVertexArray(struct gl_context *ctx, GLuint array)
+{
+   struct glthread_state *glthread = ctx->GLThread;
+   struct glthread_vao *vao;
+
+   if (array == 0) {
+      glthread->vao = &glthread->default_vao;
+      _mesa_glthread_update_client_arrays(glthread);
+      return;
+   }
+
+   vao = _mesa_HashLookup(glthread->vaos, array);
+   if (vao) {
+      glthread->vao = vao;
+      _mesa_glthread_update_client_arrays(glthread);
+   }
+   else {
+      /* First time bound, or an error */
+      _mesa_glthread_resync_arrays(ctx);
+   }
+}
+
+
+/**
+ * Deleting a buffer unbinds it from the bound vertex array object, which
+ * leaves the arrays that used it pointing to client memory.
+ */
+void
+_mesa_glthread_DeleteBuffers(struct gl_context *ctx, GLsizei n,
+                             const GLuint *buffers)
+{
+   struct glthread_state *glthread = ctx->GLThread;
+   struct glthread_vao *vao = glthread->vao;
+   GLsizei i;
+   GLuint j;
+
+   if (!buffers)
+      return;
+
+   for (i = 0; i < n; i++) {
+      if (!buffers[i])
+         continue;
+      if (buffers[i] == glthread->array_buffer)
+         glthread->array_buffer = 0;
+      if (buffers[i] == vao->element_buffer)
+         vao->element_buffer = 0;
+      for (j = 0; j < VERT_ATTRIB_MAX; j++) {
+         if (vao->array_buffers[j] == buffers[i]) {
+            vao->array_buffers[j] = 0;
+            vao->user_pointers |= VERT_BIT(j);
+         }
+      }
+   }
+
+   _mesa_glthread_update_client_arrays(glthread);
+}
+
+
+void
+_mesa_glthread_DeleteVertexArrays(struct gl_context *ctx, GLsizei n,
+                                  const GLuint *arrays)
+{
+   struct glthread_state *glthread = ctx->GLThread;
+   GLsizei i;
+
+   if (!arrays)
+      return;
+
+   for (i = 0; i < n; i++) {
+      struct glthread_vao *vao;
+
+      if (!arrays[i])
+         continue;
+      vao = _mesa_HashLookup(glthread->vaos, arrays[i]);
+      if (!vao)
+         continue;
+      if (vao == glthread->vao)
+         _mesa_glthread_BindVertexArray(ctx, 0);
+      _mesa_HashRemove(glthread->vaos, arrays[i]);
+      free(vao);
+   }
+}
+
+
+static void
+set_array_enabled(struct glthread_state *glthread, GLuint attrib,
+                  GLboolean enable)
+{
+   if (enable)
+      glthread->vao->enabled |= VERT_BIT(attrib);
+   else
+      glthread->vao->enabled &= ~VERT_BIT(attrib);
+
+   _mesa_glthread_update_client_arrays(glthread);
+}
+
+
+/**
+ * glEnable/DisableClientState(), and glEnable/Disable(), which accept the
+ * same arrays.
+ */
+void
+_mesa_glthread_ClientState(struct gl_context *ctx, GLenum cap,
+                           GLboolean enable)
+{
+   struct glthread_state *glthread = ctx->GLThread;
+
+   switch (cap) {
+   case GL_VERTEX_ARRAY:
+      set_array_enabled(glthread, VERT_ATTRIB_POS, enable);
+      break;
+   case GL_NORMAL_ARRAY:
+      set_array_enabled(glthread, VERT_ATTRIB_NORMAL, enable);
+      break;
+   case GL_COLOR_ARRAY:
+      set_array_enabled(glthread, VERT_ATTRIB_COLOR0, enable);
+      break;
+   case GL_INDEX_ARRAY:
+      set_array_enabled(glthread, VERT_ATTRIB_COLOR_INDEX, enable);
+      break;
+   case GL_TEXTURE_COORD_ARRAY:
+      set_array_enabled(glthread,
+                        VERT_ATTRIB_TEX(glthread->client_active_texture),
+                        enable);
+      break;
+   case GL_EDGE_FLAG_ARRAY:
+      set_array_enabled(glthread, VERT_ATTRIB_EDGEFLAG, enable);
+      break;
+   case GL_FOG_COORDINATE_ARRAY_EXT:
+      set_array_enabled(glthread, VERT_ATTRIB_FOG, enable);
+      break;
+   case GL_SECONDARY_COLOR_ARRAY_EXT:
+      set_array_enabled(glthread, VERT_ATTRIB_COLOR1, enable);
+      break;
+   case GL_POINT_SIZE_ARRAY_OES:
+      set_array_enabled(glthread, VERT_ATTRIB_POINT_SIZE, enable);
+      break;
+   }
+}
+
+
+void
+_mesa_glthread_VertexAttribArray(struct gl_context *ctx, GLuint index,
+                                 GLboolean enable)
+{
+   if (index < VERT_ATTRIB_GENERIC_MAX)
+      set_array_enabled(ctx->GLThread, VERT_ATTRIB_GENERIC(index), enable);
+}
+
+
+void
+_mesa_glthread_ClientActiveTexture(struct gl_context *ctx, GLenum texture)
+{
+   GLuint unit = texture - GL_TEXTURE0;
+
+   if (unit < VERT_ATTRIB_TEX_MAX)
+      ctx->GLThread->client_active_texture = unit;
+}
+
+
+/**
+ * Debug message callbacks are called by the thread generating the message,
+ * which the application expects to be its own.  Once one is installed,
+ * make the GL calls directly.
+ */
+void
+_mesa_glthread_DebugMessageCallback(struct gl_context *ctx,
+                                    GLboolean callback)
+{
+   struct glthread_state *glthread = ctx->GLThread;
+
+   if (!callback || glthread->sync)
+      return;
+
+   /* Called after the GL thread executed the command */
+   glthread->sync = GL_TRUE;
+   _glapi_set_dispatch(ctx->CurrentDispatch);
+}
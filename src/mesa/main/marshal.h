@@ -0,0 +1,276 @@
+/*
+ * Mesa 3-D graphics library
+ *
+ * Copyright (c) 2014 VMware, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * \file marshal.h
+ * Threaded GL dispatch.
+ *
+ * When enabled, the application's thread gets a dispatch table of
+ * marshalling functions (see gl_marshal.py) which record every GL call into
+ * a batch of commands.  Full batches are handed to a GL thread owned by the
+ * context, which executes them in order through ctx->CurrentDispatch, so
+ * all the state validation and driver work moves off the application's
+ * thread.  Calls returning data wait for the GL thread to catch up.
+ */
+
+#ifndef MARSHAL_H
+#define MARSHAL_H
+
+
+#include "c11/threads.h"
+#include "glheader.h"
+#include "macros.h"
+#include "mtypes.h"
+
+
+struct _glapi_table;
+struct _mesa_HashTable;
+
+
+/** Size of the command batches */
+#define MARSHAL_BATCH_SIZE (8 * 1024)
+
+/** Bigger commands are executed synchronously, by reference */
+#define MARSHAL_MAX_CMD_SIZE (MARSHAL_BATCH_SIZE / 2)
+
+/** Alignment of commands, and of the arrays following them */
+#define MARSHAL_CMD_ALIGN 8
+
+/** Number of batches queued before the application thread waits */
+#define MARSHAL_MAX_QUEUED 8
+
+
+struct marshal_cmd_base
+{
+   /** DISPATCH_CMD_* from marshal_generated.c */
+   GLushort cmd_id;
+   /** Size in bytes, including this header */
+   GLushort cmd_size;
+};
+
+
+struct glthread_batch
+{
+   struct glthread_batch *next;
+   /** Bytes of buffer used */
+   GLuint used;
+   GLuint64 buffer[MARSHAL_BATCH_SIZE / sizeof(GLuint64)];
+};
+
+
+/**
+ * Vertex array state of a vertex array object, as followed on the
+ * application thread.
+ */
+struct glthread_vao
+{
+   GLuint name;
+   GLuint element_buffer;
+   /** VERT_BIT_* of the enabled arrays */
+   GLbitfield64 enabled;
+   /** VERT_BIT_* of the arrays set while no array buffer was bound */
+   GLbitfield64 user_pointers;
+   /** Array buffer bound when each array was set */
+   GLuint array_buffers[VERT_ATTRIB_MAX];
+};
+
+
+struct glthread_state
+{
+   thrd_t thread;
+
+   /** Protects the queue and the free list */
+   mtx_t mutex;
+   /** Signalled when a batch is queued, or the thread must exit */
+   cnd_t new_work;
+   /** Signalled each time the GL thread finishes a batch */
+   cnd_t work_done;
+
+   /** Batches waiting for the GL thread, oldest first */
+   struct glthread_batch *queue;
+   struct glthread_batch **queue_tail;
+   GLuint num_queued;
+   /** Executed batches, for reuse */
+   struct glthread_batch *free_batches;
+   /** Whether the GL thread is executing a batch */
+   GLboolean busy;
+   GLboolean shutdown;
+
+   /**
+    * Set once a debug message callback is installed.  The application
+    * expects it to be called on its own thread, so from then on the GL
+    * calls are made directly, and the GL thread stays idle.
+    */
+   GLboolean sync;
+
+   /** Batch being recorded by the application thread */
+   struct glthread_batch *batch;
+
+   /**
+    * \name State followed on the application thread
+    *
+    * Draws can only run asynchronously when they don't read client memory,
+    * so the marshalling code keeps track of the enabled arrays and of the
+    * buffer bindings.
+    */
+   /*@{*/
+   GLuint array_buffer;
+   /** GL_CLIENT_ACTIVE_TEXTURE, as a unit number */
+   GLuint client_active_texture;
+   /** Bound vertex array object, default_vao or one of vaos */
+   struct glthread_vao *vao;
+   struct glthread_vao default_vao;
+   /** The other vertex array objects, by name */
+   struct _mesa_HashTable *vaos;
+   /** Whether any enabled array of the bound VAO is in client memory */
+   GLboolean client_arrays;
+   /*@}*/
+};
+
+
+extern void
+_mesa_glthread_init(struct gl_context *ctx);
+
+extern void
+_mesa_glthread_destroy(struct gl_context *ctx);
+
+extern void
+_mesa_glthread_flush_batch(struct gl_context *ctx);
+
+extern void
+_mesa_glthread_finish(struct gl_context *ctx);
+
+extern void
+_mesa_glthread_resync_arrays(struct gl_context *ctx);
+
+extern void
+_mesa_glthread_BindBuffer(struct gl_context *ctx, GLenum target,
+                          GLuint buffer);
+
+extern void
+_mesa_glthread_BindVertexArray(struct gl_context *ctx, GLuint array);
+
+extern void
+_mesa_glthread_DeleteBuffers(struct gl_context *ctx, GLsizei n,
+                             const GLuint *buffers);
+
+extern void
+_mesa_glthread_DeleteVertexArrays(struct gl_context *ctx, GLsizei n,
+                                  const GLuint *arrays);
+
+extern void
+_mesa_glthread_ClientState(struct gl_context *ctx, GLenum cap,
+                           GLboolean enable);
+
+extern void
+_mesa_glthread_VertexAttribArray(struct gl_context *ctx, GLuint index,
+                                 GLboolean enable);
+
+extern void
+_mesa_glthread_ClientActiveTexture(struct gl_context *ctx, GLenum texture);
+
+extern void
+_mesa_glthread_DebugMessageCallback(struct gl_context *ctx,
+                                    GLboolean callback);
+
+/* marshal_generated.c */
+extern struct _glapi_table *
+_mesa_create_marshal_table(void);
+
+extern size_t
+_mesa_unmarshal_dispatch_cmd(struct gl_context *ctx, const void *cmd);
+
+
+/**
+ * Reserve size bytes for a command in the current batch.
+ */
+static inline void *
+_mesa_glthread_allocate_command(struct gl_context *ctx, GLushort cmd_id,
+                                size_t size)
+{
+   struct glthread_state *glthread = ctx->GLThread;
+   struct marshal_cmd_base *cmd;
+
+   size = ALIGN(size, MARSHAL_CMD_ALIGN);
+   assert(size <= MARSHAL_BATCH_SIZE);
+
+   if (glthread->batch->used + size > MARSHAL_BATCH_SIZE)
+      _mesa_glthread_flush_batch(ctx);
+
+   cmd = (struct marshal_cmd_base *)
+      ((GLubyte *) glthread->batch->buffer + glthread->batch->used);
+   glthread->batch->used += size;
+   cmd->cmd_id = cmd_id;
+   cmd->cmd_size = size;
+   return cmd;
+}
+
+
+/**
+ * Whether a draw may read client memory, so must not return before the GL
+ * thread is done with it.
+ */
+static inline GLboolean
+_mesa_glthread_draw_needs_sync(const struct gl_context *ctx, GLboolean indexed)
+{
+   const struct glthread_state *glthread = ctx->GLThread;
+
+   return glthread->client_arrays ||
+          (indexed && !glthread->vao->element_buffer);
+}
+
+
+static inline void
+_mesa_glthread_update_client_arrays(struct glthread_state *glthread)
+{
+   const struct glthread_vao *vao = glthread->vao;
+
+   glthread->client_arrays = (vao->enabled & vao->user_pointers) != 0;
+}
+
+
+/**
+ * Note that the pointer of the vertex array attrib (VERT_ATTRIB_*) was set.
+ * Out of range attribs are errors, the GL ignores them.
+ */
+static inline void
+_mesa_glthread_array_pointer(struct gl_context *ctx, GLuint attrib)
+{
+   struct glthread_state *glthread = ctx->GLThread;
+   struct glthread_vao *vao = glthread->vao;
+
+   if (attrib >= VERT_ATTRIB_MAX)
+      return;
+
+   vao->array_buffers[attrib] = glthread->array_buffer;
+   if (glthread->array_buffer)
+      vao->user_pointers &= ~VERT_BIT(attrib);
+   else
+      vao->user_pointers |= VERT_BIT(attrib);
+
+   _mesa_glthread_update_client_arrays(glthread);
+}
+
+
+#endif /* MARSHAL_H */
@@ -39,6 +39,11 @@
 #include "macros.h"
 #include "../../gallium/auxiliary/util/u_format_rgb9e5.h"
 #include "../../gallium/auxiliary/util/u_format_r11g11b10f.h"
+#include "c11/threads.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 
 
 
@@ -137,6 +142,91 @@ bytes_per_pixel(GLenum datatype, GLuint comps)
 /*@}*/
 
 
+#if defined(__SSE2__)
+
+/**
+ * SSE2 version of the GL_UNSIGNED_BYTE 2x2 box filter for 1 and 4
+ * component images whose width is being halved.  The results match the
+ * scalar code in do_row() exactly.
+ */
+static void
+do_row_ubyte_sse2(GLuint comps, const GLubyte *rowA, const GLubyte *rowB,
+                  GLint dstWidth, GLubyte *dst)
+{
+   const __m128i zero = _mm_setzero_si128();
+   GLint i = 0;
+   GLuint c;
+
+   if (comps == 4) {
+      /* four dest pixels from eight source pixels per row */
+      for (; i + 4 <= dstWidth; i += 4) {
+         const GLubyte *a = rowA + i * 8, *b = rowB + i * 8;
+         __m128 a0 = _mm_castsi128_ps(_mm_loadu_si128((const __m128i *) a));
+         __m128 a1 = _mm_castsi128_ps(_mm_loadu_si128((const __m128i *) (a + 16)));
+         __m128 b0 = _mm_castsi128_ps(_mm_loadu_si128((const __m128i *) b));
+         __m128 b1 = _mm_castsi128_ps(_mm_loadu_si128((const __m128i *) (b + 16)));
+         __m128i ae = _mm_castps_si128(_mm_shuffle_ps(a0, a1, _MM_SHUFFLE(2, 0, 2, 0)));
+         __m128i ao = _mm_castps_si128(_mm_shuffle_ps(a0, a1, _MM_SHUFFLE(3, 1, 3, 1)));
+         __m128i be = _mm_castps_si128(_mm_shuffle_ps(b0, b1, _MM_SHUFFLE(2, 0, 2, 0)));
+         __m128i bo = _mm_castps_si128(_mm_shuffle_ps(b0, b1, _MM_SHUFFLE(3, 1, 3, 1)));
+         __m128i lo, hi;
+
+         lo = _mm_add_epi16(_mm_add_epi16(_mm_unpacklo_epi8(ae, zero),
+                                          _mm_unpacklo_epi8(ao, zero)),
+                            _mm_add_epi16(_mm_unpacklo_epi8(be, zero),
+                                          _mm_unpacklo_epi8(bo, zero)));
+         hi = _mm_add_epi16(_mm_add_epi16(_mm_unpackhi_epi8(ae, zero),
+                                          _mm_unpackhi_epi8(ao, zero)),
+                            _mm_add_epi16(_mm_unpackhi_epi8(be, zero),
+                                          _mm_unpackhi_epi8(bo, zero)));
+         lo = _mm_srli_epi16(lo, 2);
+         hi = _mm_srli_epi16(hi, 2);
+
+         _mm_storeu_si128((__m128i *) (dst + i * 4), _mm_packus_epi16(lo, hi));
+      }
+   }
+   else {
+      /* sixteen dest pixels from thirty-two source pixels per row */
+      const __m128i mask = _mm_set1_epi16(0xff);
+
+      assert(comps == 1);
+
+      for (; i + 16 <= dstWidth; i += 16) {
+         const GLubyte *a = rowA + i * 2, *b = rowB + i * 2;
+         __m128i a0 = _mm_loadu_si128((const __m128i *) a);
+         __m128i a1 = _mm_loadu_si128((const __m128i *) (a + 16));
+         __m128i b0 = _mm_loadu_si128((const __m128i *) b);
+         __m128i b1 = _mm_loadu_si128((const __m128i *) (b + 16));
+         __m128i lo, hi;
+
+         lo = _mm_add_epi16(_mm_add_epi16(_mm_and_si128(a0, mask),
+                                          _mm_srli_epi16(a0, 8)),
+                            _mm_add_epi16(_mm_and_si128(b0, mask),
+                                          _mm_srli_epi16(b0, 8)));
+         hi = _mm_add_epi16(_mm_add_epi16(_mm_and_si128(a1, mask),
+                                          _mm_srli_epi16(a1, 8)),
+                            _mm_add_epi16(_mm_and_si128(b1, mask),
+                                          _mm_srli_epi16(b1, 8)));
+         lo = _mm_srli_epi16(lo, 2);
+         hi = _mm_srli_epi16(hi, 2);
+
+         _mm_storeu_si128((__m128i *) (dst + i), _mm_packus_epi16(lo, hi));
+      }
+   }
+
+   for (; i < dstWidth; i++) {
+      for (c = 0; c < comps; c++) {
+         dst[i * comps + c] = (rowA[(2 * i) * comps + c] +
+                               rowA[(2 * i + 1) * comps + c] +
+                               rowB[(2 * i) * comps + c] +
+                               rowB[(2 * i + 1) * comps + c]) >> 2;
+      }
+   }
+}
+
+#endif /* __SSE2__ */
+
+
 /**
  * Average together two rows of a source image to produce a single new
  * row in the dest image.  It's legal for the two source rows to point
@@ -160,6 +250,14 @@ do_row(GLenum datatype, GLuint comps, GLint srcWidth,
    assert(srcWidth == dstWidth || srcWidth == 2 * dstWidth);
    */
 
+#if defined(__SSE2__)
+   if (datatype == GL_UNSIGNED_BYTE && (comps == 4 || comps == 1) &&
+       srcWidth != dstWidth) {
+      do_row_ubyte_sse2(comps, srcRowA, srcRowB, dstWidth, dstRow);
+      return;
+   }
+#endif
+
    if (datatype == GL_UNSIGNED_BYTE && comps == 4) {
       GLuint i, j, k;
       const GLubyte(*rowA)[4] = (const GLubyte(*)[4]) srcRowA;
@@ -1441,6 +1539,128 @@ make_1d_mipmap(GLenum datatype, GLuint comps, GLint border,
 }
 
 
+/**
+ * Levels with at least this many destination bytes are split by rows
+ * across several threads.
+ */
+#define MIPMAP_THREAD_MIN_BYTES (256 * 1024)
+
+#define MIPMAP_MAX_THREADS 16
+
+
+/**
+ * A band of destination rows of a 2D mipmap level.
+ */
+struct mipmap_rows
+{
+   GLenum datatype;
+   GLuint comps;
+   GLint srcWidth, dstWidth;
+   const GLubyte *srcA, *srcB;
+   GLint srcStride;   /**< bytes between the source rows of two dest rows */
+   GLubyte *dst;
+   GLint dstStride;
+   GLint rows;
+};
+
+
+static int
+make_2d_rows(void *data)
+{
+   const struct mipmap_rows *band = (const struct mipmap_rows *) data;
+   const GLubyte *srcA = band->srcA, *srcB = band->srcB;
+   GLubyte *dst = band->dst;
+   GLint row;
+
+   for (row = 0; row < band->rows; row++) {
+      do_row(band->datatype, band->comps, band->srcWidth, srcA, srcB,
+             band->dstWidth, dst);
+      srcA += band->srcStride;
+      srcB += band->srcStride;
+      dst += band->dstStride;
+   }
+
+   return 0;
+}
+
+
+/**
+ * Number of threads to use for large mipmap levels, from the
+ * MESA_MIPMAP_THREADS environment variable.  The threads are created for
+ * each level, so this is off by default.
+ */
+static GLint
+mipmap_thread_count(void)
+{
+   static GLint count = 0;
+
+   if (count == 0) {
+      const char *env = _mesa_getenv("MESA_MIPMAP_THREADS");
+      GLint n = env ? atoi(env) : 1;
+
+      count = CLAMP(n, 1, MIPMAP_MAX_THREADS);
+   }
+
+   return count;
+}
+
+
+/**
+ * Filter the given rows, splitting them into bands handled by worker
+ * threads when the level is big enough to be worth it.  The calling
+ * thread does the first band itself.
+ */
+static void
+make_2d_rows_threaded(const struct mipmap_rows *rows)
+{
+   struct mipmap_rows bands[MIPMAP_MAX_THREADS];
+   thrd_t threads[MIPMAP_MAX_THREADS];
+   GLboolean started[MIPMAP_MAX_THREADS];
+   const GLint rowBytes = rows->dstWidth * bytes_per_pixel(rows->datatype,
+                                                           rows->comps);
+   GLint numBands = mipmap_thread_count();
+   GLint i, first;
+
+   if (numBands > 1 && rowBytes * rows->rows >= MIPMAP_THREAD_MIN_BYTES) {
+      /* keep at least a few rows per band */
+      numBands = MIN2(numBands, rows->rows / 4);
+   }
+   else {
+      numBands = 1;
+   }
+
+   if (numBands <= 1) {
+      make_2d_rows((void *) rows);
+      return;
+   }
+
+   for (i = 0, first = 0; i < numBands; i++) {
+      const GLint last = rows->rows * (i + 1) / numBands;
+
+      bands[i] = *rows;
+      bands[i].srcA += first * rows->srcStride;
+      bands[i].srcB += first * rows->srcStride;
+      bands[i].dst += first * rows->dstStride;
+      bands[i].rows = last - first;
+      first = last;
+   }
+
+   for (i = 1; i < numBands; i++) {
+      started[i] = thrd_create(&threads[i], make_2d_rows, &bands[i]) ==
+                   thrd_success;
+   }
+
+   make_2d_rows(&bands[0]);
+
+   for (i = 1; i < numBands; i++) {
+      if (started[i])
+         thrd_join(threads[i], NULL);
+      else
+         make_2d_rows(&bands[i]);
+   }
+}
+
+
 static void
 make_2d_mipmap(GLenum datatype, GLuint comps, GLint border,
                GLint srcWidth, GLint srcHeight,
@@ -1471,12 +1691,21 @@ make_2d_mipmap(GLenum datatype, GLuint comps, GLint border,
 
    dst = dstPtr + border * ((dstWidth + 1) * bpt);
 
-   for (row = 0; row < dstHeightNB; row++) {
-      do_row(datatype, comps, srcWidthNB, srcA, srcB,
-             dstWidthNB, dst);
-      srcA += srcRowStep * srcRowStride;
-      srcB += srcRowStep * srcRowStride;
-      dst += dstRowStride;
+   {
+      struct mipmap_rows rows;
+
+      rows.datatype = datatype;
+      rows.comps = comps;
+      rows.srcWidth = srcWidthNB;
+      rows.dstWidth = dstWidthNB;
+      rows.srcA = srcA;
+      rows.srcB = srcB;
+      rows.srcStride = srcRowStep * srcRowStride;
+      rows.dst = dst;
+      rows.dstStride = dstRowStride;
+      rows.rows = dstHeightNB;
+
+      make_2d_rows_threaded(&rows);
    }
 
    /* This is ugly but probably won't be used much */
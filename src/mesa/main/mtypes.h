@@ -81,9 +81,11 @@ struct st_context;
 struct gl_uniform_storage;
 struct prog_instruction;
 struct gl_program_parameter_list;
+struct hash_table;
 struct set;
 struct set_entry;
 struct vbo_context;
+struct glthread_state;
 /*@}*/
 
 
@@ -1460,9 +1462,22 @@ struct gl_buffer_object
    GLintptr Offset;     /**< Mapped offset */
    GLsizeiptr Length;   /**< Mapped length */
    /*@}*/
+   GLboolean Immutable;    /**< GL_ARB_buffer_storage */
+   GLbitfield StorageFlags; /**< GL_MAP_PERSISTENT_BIT, etc. */
    GLboolean DeletePending;   /**< true if buffer object is removed from the hash */
    GLboolean Written;   /**< Ever written to? (for debugging) */
    GLboolean Purgeable; /**< Is the buffer purgeable under memory pressure? */
+
+   /**
+    * \name Index ranges cached by vbo_get_minmax_indices()
+    * Protected by Mutex.
+    */
+   /*@{*/
+   struct hash_table *MinMaxCache;
+   GLuint MinMaxCacheHits;         /**< since the cache was created */
+   GLuint MinMaxCacheWasted;       /**< caches in a row deleted unused */
+   GLboolean MinMaxCacheDisabled;  /**< may be written by the GPU, etc. */
+   /*@}*/
 };
 
 
@@ -3384,6 +3399,7 @@ struct gl_extensions
    GLboolean ARB_arrays_of_arrays;
    GLboolean ARB_base_instance;
    GLboolean ARB_blend_func_extended;
+   GLboolean ARB_buffer_storage;
    GLboolean ARB_color_buffer_float;
    GLboolean ARB_conservative_depth;
    GLboolean ARB_depth_buffer_float;
@@ -3406,6 +3422,7 @@ struct gl_extensions
    GLboolean ARB_instanced_arrays;
    GLboolean ARB_internalformat_query;
    GLboolean ARB_map_buffer_range;
+   GLboolean ARB_multi_draw_indirect;
    GLboolean ARB_occlusion_query;
    GLboolean ARB_occlusion_query2;
    GLboolean ARB_point_sprite;
@@ -3652,6 +3669,7 @@ struct gl_dlist_state
    struct gl_display_list *CurrentList; /**< List currently being compiled */
    union gl_dlist_node *CurrentBlock; /**< Pointer to current block of nodes */
    GLuint CurrentPos;		/**< Index into current block of nodes */
+   GLuint LastInstSize;		/**< Size of the last instruction, in nodes */
 
    GLvertexformat ListVtxfmt;
 
@@ -3917,8 +3935,16 @@ struct gl_context
     * re-set on glXMakeCurrent().
     */
    struct _glapi_table *CurrentDispatch;
+   /**
+    * The table of marshalling functions installed instead of CurrentDispatch
+    * on the application's thread when GL calls are run by a GL thread.
+    */
+   struct _glapi_table *MarshalExec;
    /*@}*/
 
+   /** Threaded dispatch state, NULL unless enabled, see marshal.h */
+   struct glthread_state *GLThread;
+
    struct gl_config Visual;
    struct gl_framebuffer *DrawBuffer;	/**< buffer for writing */
    struct gl_framebuffer *ReadBuffer;	/**< buffer for reading */
@@ -24,6 +24,7 @@
 
 #include "glheader.h"
 #include "imports.h"
+#include "macros.h"
 #include "blend.h"
 #include "bufferobj.h"
 #include "context.h"
@@ -31,6 +32,7 @@
 #include "readpix.h"
 #include "framebuffer.h"
 #include "formats.h"
+#include "format_pack.h"
 #include "format_unpack.h"
 #include "image.h"
 #include "mtypes.h"
@@ -406,8 +408,64 @@ read_stencil_pixels( struct gl_context *ctx,
 }
 
 
+/** Pixels converted at a time by read_rgba_pixels_swizzle() */
+#define SWIZZLE_CHUNK 256
+
+
+/**
+ * Return the four byte per pixel RGBA format laid out like format and type
+ * in memory, or MESA_FORMAT_NONE if there's none.
+ */
+static mesa_format
+get_rgba8_format(GLenum format, GLenum type, GLboolean swapBytes)
+{
+   static const mesa_format formats[] = {
+      MESA_FORMAT_R8G8B8A8_UNORM,
+      MESA_FORMAT_B8G8R8A8_UNORM,
+      MESA_FORMAT_A8B8G8R8_UNORM,
+      MESA_FORMAT_A8R8G8B8_UNORM
+   };
+   unsigned i;
+
+   for (i = 0; i < Elements(formats); i++) {
+      if (_mesa_format_matches_format_and_type(formats[i], format, type,
+                                               swapBytes))
+         return formats[i];
+   }
+
+   return MESA_FORMAT_NONE;
+}
+
+
+/**
+ * Whether the format is one of the four byte per pixel RGBA/RGBX formats
+ * _mesa_unpack_ubyte_rgba_row() swizzles with plain byte shuffles.
+ */
+static GLboolean
+is_rgba8_format(mesa_format format)
+{
+   switch (format) {
+   case MESA_FORMAT_A8B8G8R8_UNORM:
+   case MESA_FORMAT_R8G8B8A8_UNORM:
+   case MESA_FORMAT_B8G8R8A8_UNORM:
+   case MESA_FORMAT_A8R8G8B8_UNORM:
+   case MESA_FORMAT_X8B8G8R8_UNORM:
+   case MESA_FORMAT_R8G8B8X8_UNORM:
+   case MESA_FORMAT_B8G8R8X8_UNORM:
+   case MESA_FORMAT_X8R8G8B8_UNORM:
+      return GL_TRUE;
+   default:
+      return GL_FALSE;
+   }
+}
+
+
 /**
  * Try to do glReadPixels of RGBA data using swizzle.
+ * This covers reading any of the 8-bit RGBA/RGBX renderbuffer formats as
+ * GL_RGBA or GL_BGRA bytes, e.g. GL_RGBA/GL_UNSIGNED_BYTE from a BGRA
+ * window, by going through a small RGBA ubyte buffer.  Both steps are byte
+ * shuffles, SIMD ones when built with SSE2.
  * \return GL_TRUE if successful, GL_FALSE otherwise (use the slow path)
  */
 static GLboolean
@@ -419,24 +477,18 @@ read_rgba_pixels_swizzle(struct gl_context *ctx,
                          const struct gl_pixelstore_attrib *packing)
 {
    struct gl_renderbuffer *rb = ctx->ReadBuffer->_ColorReadBuffer;
+   GLubyte rgba[SWIZZLE_CHUNK][4];
    GLubyte *dst, *map;
    int dstStride, stride, j;
-   GLboolean swizzle_rb = GL_FALSE, copy_xrgb = GL_FALSE;
-
-   /* XXX we could check for other swizzle/special cases here as needed */
-   if (rb->Format == MESA_FORMAT_R8G8B8A8_UNORM &&
-       format == GL_BGRA &&
-       type == GL_UNSIGNED_INT_8_8_8_8_REV &&
-       !ctx->Pack.SwapBytes) {
-      swizzle_rb = GL_TRUE;
-   }
-   else if (rb->Format == MESA_FORMAT_B8G8R8X8_UNORM &&
-       format == GL_BGRA &&
-       type == GL_UNSIGNED_INT_8_8_8_8_REV &&
-       !ctx->Pack.SwapBytes) {
-      copy_xrgb = GL_TRUE;
+   mesa_format dstFormat;
+
+   if (!is_rgba8_format(rb->Format) ||
+       rb->_BaseFormat != _mesa_get_format_base_format(rb->Format)) {
+      return GL_FALSE;
    }
-   else {
+
+   dstFormat = get_rgba8_format(format, type, packing->SwapBytes);
+   if (dstFormat == MESA_FORMAT_NONE) {
       return GL_FALSE;
    }
 
@@ -451,31 +503,16 @@ read_rgba_pixels_swizzle(struct gl_context *ctx,
       return GL_TRUE;  /* don't bother trying the slow path */
    }
 
-   if (swizzle_rb) {
-      /* swap R/B */
-      for (j = 0; j < height; j++) {
-         int i;
-         for (i = 0; i < width; i++) {
-            GLuint *dst4 = (GLuint *) dst, *map4 = (GLuint *) map;
-            GLuint pixel = map4[i];
-            dst4[i] = (pixel & 0xff00ff00)
-                   | ((pixel & 0x00ff0000) >> 16)
-                   | ((pixel & 0x000000ff) << 16);
-         }
-         dst += dstStride;
-         map += stride;
-      }
-   } else if (copy_xrgb) {
-      /* convert xrgb -> argb */
-      for (j = 0; j < height; j++) {
-         GLuint *dst4 = (GLuint *) dst, *map4 = (GLuint *) map;
-         int i;
-         for (i = 0; i < width; i++) {
-            dst4[i] = map4[i] | 0xff000000;  /* set A=0xff */
-         }
-         dst += dstStride;
-         map += stride;
+   for (j = 0; j < height; j++) {
+      int i;
+      for (i = 0; i < width; i += SWIZZLE_CHUNK) {
+         const GLuint n = MIN2(width - i, SWIZZLE_CHUNK);
+         _mesa_unpack_ubyte_rgba_row(rb->Format, n, map + i * 4, rgba);
+         _mesa_pack_ubyte_rgba_row(dstFormat, n,
+                                   (const GLubyte (*)[4]) rgba, dst + i * 4);
       }
+      dst += dstStride;
+      map += stride;
    }
 
    ctx->Driver.UnmapRenderbuffer(ctx, rb);
@@ -1033,7 +1070,7 @@ _mesa_ReadnPixelsARB( GLint x, GLint y, GLsizei width, GLsizei height,
    }
 
    if (_mesa_is_bufferobj(ctx->Pack.BufferObj) &&
-       _mesa_bufferobj_mapped(ctx->Pack.BufferObj)) {
+       _mesa_check_disallowed_mapping(ctx->Pack.BufferObj)) {
       /* buffer is mapped - that's an error */
       _mesa_error(ctx, GL_INVALID_OPERATION, "glReadPixels(PBO is mapped)");
       return;
@@ -0,0 +1,266 @@
+/*
+ * Copyright © 2014 VMware, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * Checks the map requests glMapBuffer() and glMapBufferRange() accept for
+ * mutable and immutable (GL_ARB_buffer_storage) buffers, and the calls
+ * allowed while a buffer is mapped persistently, using Mesa's software
+ * buffer objects.
+ */
+
+#include <gtest/gtest.h>
+#include <string.h>
+
+extern "C" {
+#include "main/mtypes.h"
+#include "main/bufferobj.h"
+#include "main/hash.h"
+#include "glapi/glapi.h"
+}
+
+#define BUFFER_SIZE 256
+
+
+class Buffer_storage_test : public ::testing::Test {
+public:
+   virtual void SetUp();
+   virtual void TearDown();
+
+   /** Return and clear the GL error */
+   GLenum error();
+
+   struct gl_context ctx;
+   struct gl_shared_state shared;
+   struct gl_array_object array_obj;
+   struct gl_transform_feedback_object xfb_obj;
+   GLuint buffer;
+};
+
+void
+Buffer_storage_test::SetUp()
+{
+   memset(&ctx, 0, sizeof(ctx));
+   memset(&shared, 0, sizeof(shared));
+   memset(&array_obj, 0, sizeof(array_obj));
+   memset(&xfb_obj, 0, sizeof(xfb_obj));
+
+   ctx.API = API_OPENGL_CORE;
+   ctx.Version = 44;
+   ctx.Extensions.ARB_buffer_storage = GL_TRUE;
+   ctx.Extensions.ARB_map_buffer_range = GL_TRUE;
+   ctx.Const.MinMapBufferAlignment = 64;
+   _mesa_init_buffer_object_functions(&ctx.Driver);
+   ctx.Driver.CurrentExecPrimitive = PRIM_OUTSIDE_BEGIN_END;
+
+   shared.BufferObjects = _mesa_NewHashTable();
+   shared.NullBufferObj = ctx.Driver.NewBufferObject(&ctx, 0, 0);
+   ctx.Shared = &shared;
+   ctx.Array.ArrayObj = &array_obj;
+   ctx.TransformFeedback.CurrentObject = &xfb_obj;
+   _mesa_init_buffer_objects(&ctx);
+
+   _glapi_set_context(&ctx);
+
+   _mesa_GenBuffers(1, &buffer);
+   _mesa_BindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+   ASSERT_EQ((GLenum) GL_NO_ERROR, error());
+}
+
+void
+Buffer_storage_test::TearDown()
+{
+   _mesa_DeleteBuffers(1, &buffer);
+   _mesa_free_buffer_objects(&ctx);
+   _mesa_reference_buffer_object(&ctx, &shared.NullBufferObj, NULL);
+   _mesa_DeleteHashTable(shared.BufferObjects);
+
+   _glapi_set_context(NULL);
+}
+
+GLenum
+Buffer_storage_test::error()
+{
+   GLenum error = ctx.ErrorValue;
+
+   ctx.ErrorValue = GL_NO_ERROR;
+   return error;
+}
+
+
+TEST_F(Buffer_storage_test, mutable_buffer)
+{
+   void *map;
+
+   _mesa_BufferData(GL_COPY_WRITE_BUFFER, BUFFER_SIZE, NULL, GL_STATIC_DRAW);
+   ASSERT_EQ((GLenum) GL_NO_ERROR, error());
+
+   map = _mesa_MapBufferRange(GL_COPY_WRITE_BUFFER, 0, BUFFER_SIZE,
+                              GL_MAP_READ_BIT | GL_MAP_WRITE_BIT);
+   EXPECT_TRUE(map != NULL);
+   EXPECT_EQ((GLenum) GL_NO_ERROR, error());
+   EXPECT_TRUE(_mesa_UnmapBuffer(GL_COPY_WRITE_BUFFER));
+
+   map = _mesa_MapBuffer(GL_COPY_WRITE_BUFFER, GL_READ_WRITE);
+   EXPECT_TRUE(map != NULL);
+   EXPECT_EQ((GLenum) GL_NO_ERROR, error());
+   EXPECT_TRUE(_mesa_UnmapBuffer(GL_COPY_WRITE_BUFFER));
+
+   /* Only storage allocated by glBufferStorage() can be */
+   map = _mesa_MapBufferRange(GL_COPY_WRITE_BUFFER, 0, BUFFER_SIZE,
+                              GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT);
+   EXPECT_TRUE(map == NULL);
+   EXPECT_EQ((GLenum) GL_INVALID_OPERATION, error());
+}
+
+
+/**
+ * Buffers which never got any storage have no storage flags, which must
+ * not turn the map requests into GL_INVALID_OPERATION.
+ */
+TEST_F(Buffer_storage_test, no_storage)
+{
+   void *map;
+
+   map = _mesa_MapBufferRange(GL_COPY_WRITE_BUFFER, 0, 0, GL_MAP_READ_BIT);
+   EXPECT_TRUE(map == NULL);
+   EXPECT_EQ((GLenum) GL_OUT_OF_MEMORY, error());
+
+   map = _mesa_MapBuffer(GL_COPY_WRITE_BUFFER, GL_WRITE_ONLY);
+   EXPECT_TRUE(map == NULL);
+   EXPECT_EQ((GLenum) GL_OUT_OF_MEMORY, error());
+}
+
+
+TEST_F(Buffer_storage_test, immutable_buffer)
+{
+   void *map;
+
+   _mesa_BufferStorage(GL_COPY_WRITE_BUFFER, BUFFER_SIZE, NULL,
+                       GL_MAP_WRITE_BIT);
+   ASSERT_EQ((GLenum) GL_NO_ERROR, error());
+
+   map = _mesa_MapBufferRange(GL_COPY_WRITE_BUFFER, 0, BUFFER_SIZE,
+                              GL_MAP_READ_BIT);
+   EXPECT_TRUE(map == NULL);
+   EXPECT_EQ((GLenum) GL_INVALID_OPERATION, error());
+
+   map = _mesa_MapBuffer(GL_COPY_WRITE_BUFFER, GL_READ_ONLY);
+   EXPECT_TRUE(map == NULL);
+   EXPECT_EQ((GLenum) GL_INVALID_OPERATION, error());
+
+   map = _mesa_MapBufferRange(GL_COPY_WRITE_BUFFER, 0, BUFFER_SIZE,
+                              GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT);
+   EXPECT_TRUE(map == NULL);
+   EXPECT_EQ((GLenum) GL_INVALID_OPERATION, error());
+
+   map = _mesa_MapBufferRange(GL_COPY_WRITE_BUFFER, 0, BUFFER_SIZE,
+                              GL_MAP_WRITE_BIT);
+   EXPECT_TRUE(map != NULL);
+   EXPECT_EQ((GLenum) GL_NO_ERROR, error());
+   EXPECT_TRUE(_mesa_UnmapBuffer(GL_COPY_WRITE_BUFFER));
+
+   /* Immutable */
+   _mesa_BufferData(GL_COPY_WRITE_BUFFER, BUFFER_SIZE, NULL, GL_STATIC_DRAW);
+   EXPECT_EQ((GLenum) GL_INVALID_OPERATION, error());
+   _mesa_BufferStorage(GL_COPY_WRITE_BUFFER, BUFFER_SIZE, NULL,
+                       GL_MAP_WRITE_BIT);
+   EXPECT_EQ((GLenum) GL_INVALID_OPERATION, error());
+}
+
+
+TEST_F(Buffer_storage_test, persistent_map)
+{
+   const GLubyte data[4] = { 1, 2, 3, 4 };
+   GLubyte *map;
+
+   _mesa_BufferStorage(GL_COPY_WRITE_BUFFER, BUFFER_SIZE, NULL,
+                       GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT |
+                       GL_DYNAMIC_STORAGE_BIT);
+   ASSERT_EQ((GLenum) GL_NO_ERROR, error());
+
+   /* The storage doesn't allow coherent maps */
+   map = (GLubyte *)
+      _mesa_MapBufferRange(GL_COPY_WRITE_BUFFER, 0, BUFFER_SIZE,
+                           GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT |
+                           GL_MAP_COHERENT_BIT);
+   EXPECT_TRUE(map == NULL);
+   EXPECT_EQ((GLenum) GL_INVALID_OPERATION, error());
+
+   map = (GLubyte *)
+      _mesa_MapBufferRange(GL_COPY_WRITE_BUFFER, 0, BUFFER_SIZE,
+                           GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT);
+   ASSERT_TRUE(map != NULL);
+   EXPECT_EQ((GLenum) GL_NO_ERROR, error());
+
+   /* Updating the buffer through the GL is allowed while it's mapped
+    * persistently, and shows through the mapping.
+    */
+   _mesa_BufferSubData(GL_COPY_WRITE_BUFFER, 16, sizeof(data), data);
+   EXPECT_EQ((GLenum) GL_NO_ERROR, error());
+   EXPECT_EQ(0, memcmp(map + 16, data, sizeof(data)));
+
+   /* Mapping it again isn't */
+   EXPECT_TRUE(_mesa_MapBufferRange(GL_COPY_WRITE_BUFFER, 0, BUFFER_SIZE,
+                                    GL_MAP_WRITE_BIT) == NULL);
+   EXPECT_EQ((GLenum) GL_INVALID_OPERATION, error());
+
+   EXPECT_TRUE(_mesa_UnmapBuffer(GL_COPY_WRITE_BUFFER));
+   EXPECT_EQ((GLenum) GL_NO_ERROR, error());
+
+   /* Without PERSISTENT, the mapping forbids updates */
+   map = (GLubyte *)
+      _mesa_MapBufferRange(GL_COPY_WRITE_BUFFER, 0, BUFFER_SIZE,
+                           GL_MAP_WRITE_BIT);
+   ASSERT_TRUE(map != NULL);
+   _mesa_BufferSubData(GL_COPY_WRITE_BUFFER, 16, sizeof(data), data);
+   EXPECT_EQ((GLenum) GL_INVALID_OPERATION, error());
+   EXPECT_TRUE(_mesa_UnmapBuffer(GL_COPY_WRITE_BUFFER));
+}
+
+
+TEST_F(Buffer_storage_test, coherent_map)
+{
+   void *map;
+
+   _mesa_BufferStorage(GL_COPY_WRITE_BUFFER, BUFFER_SIZE, NULL,
+                       GL_MAP_READ_BIT | GL_MAP_WRITE_BIT |
+                       GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT);
+   ASSERT_EQ((GLenum) GL_NO_ERROR, error());
+
+   /* COHERENT needs PERSISTENT */
+   map = _mesa_MapBufferRange(GL_COPY_WRITE_BUFFER, 0, BUFFER_SIZE,
+                              GL_MAP_WRITE_BIT | GL_MAP_COHERENT_BIT);
+   EXPECT_TRUE(map == NULL);
+   EXPECT_EQ((GLenum) GL_INVALID_OPERATION, error());
+
+   map = _mesa_MapBufferRange(GL_COPY_WRITE_BUFFER, 0, BUFFER_SIZE,
+                              GL_MAP_READ_BIT | GL_MAP_WRITE_BIT |
+                              GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT);
+   EXPECT_TRUE(map != NULL);
+   EXPECT_EQ((GLenum) GL_NO_ERROR, error());
+   EXPECT_TRUE(_mesa_UnmapBuffer(GL_COPY_WRITE_BUFFER));
+
+   /* Without DYNAMIC_STORAGE, only maps can update the buffer */
+   _mesa_BufferSubData(GL_COPY_WRITE_BUFFER, 0, 4, "abc");
+   EXPECT_EQ((GLenum) GL_INVALID_OPERATION, error());
+}
@@ -896,6 +896,9 @@ const struct function gl_core_functions_possible[] = {
    /* GL_ARB_internalformat_query */
    { "glGetInternalformativ", 30, -1 },
 
+   /* GL_ARB_buffer_storage */
+   { "glBufferStorage", 43, -1 },
+
    /* GL_KHR_debug */
    { "glPushDebugGroup", 11, -1 },
    { "glPopDebugGroup", 11, -1 },
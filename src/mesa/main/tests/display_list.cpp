@@ -0,0 +1,350 @@
+/*
+ * Copyright © 2014 VMware, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * Compiles display lists with immediate mode drawing into a context whose
+ * vbo draw function records the vertices drawn, and checks that playing
+ * the lists back draws the same vertices, with the same colors, as
+ * executing them directly: when vbo merges adjacent vertex lists, when
+ * lists are replayed through the loopback path, and when dlist collapses
+ * attribute changes.
+ */
+
+#include <gtest/gtest.h>
+#include <string.h>
+#include <vector>
+
+extern "C" {
+#include "GL/gl.h"
+#include "GL/glext.h"
+#include "main/compiler.h"
+#include "main/api_exec.h"
+#include "main/bufferobj.h"
+#include "main/context.h"
+#include "main/framebuffer.h"
+#include "main/vtxfmt.h"
+#include "glapi/glapi.h"
+#include "drivers/common/driverfuncs.h"
+#include "vbo/vbo.h"
+
+#ifndef GLAPIENTRYP
+#define GLAPIENTRYP GL_APIENTRYP
+#endif
+
+#include "main/dispatch.h"
+}
+
+struct vertex {
+   GLfloat pos[4];
+   GLfloat color[4];
+
+   bool operator==(const vertex &v) const
+   {
+      return memcmp(pos, v.pos, sizeof(pos)) == 0 &&
+             memcmp(color, v.color, sizeof(color)) == 0;
+   }
+};
+
+static std::vector<vertex> drawn;
+static unsigned num_draws;
+
+
+static void
+fetch_attrib(const struct gl_client_array *array, GLuint i, GLfloat *dst)
+{
+   const GLubyte *base = _mesa_is_bufferobj(array->BufferObj)
+      ? (const GLubyte *) array->BufferObj->Data : NULL;
+   const GLfloat *src =
+      (const GLfloat *) (base + (uintptr_t) array->Ptr + i * array->StrideB);
+   static const GLfloat defaults[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
+
+   for (GLint c = 0; c < 4; c++)
+      dst[c] = c < array->Size ? src[c] : defaults[c];
+}
+
+
+static void
+record_draw(struct gl_context *ctx,
+            const struct _mesa_prim *prims, GLuint nr_prims,
+            const struct _mesa_index_buffer *ib,
+            GLboolean index_bounds_valid,
+            GLuint min_index, GLuint max_index,
+            struct gl_transform_feedback_object *tfb_vertcount,
+            struct gl_buffer_object *indirect)
+{
+   const struct gl_client_array **arrays = ctx->Array._DrawArrays;
+
+   for (GLuint p = 0; p < nr_prims; p++) {
+      for (GLuint i = 0; i < prims[p].count; i++) {
+         struct vertex v;
+
+         fetch_attrib(arrays[VERT_ATTRIB_POS], prims[p].start + i, v.pos);
+         fetch_attrib(arrays[VERT_ATTRIB_COLOR0], prims[p].start + i,
+                      v.color);
+         drawn.push_back(v);
+      }
+   }
+
+   num_draws++;
+}
+
+
+static void
+update_state(struct gl_context *ctx, GLuint new_state)
+{
+   _vbo_InvalidateState(ctx, new_state);
+}
+
+
+class Display_list_test : public ::testing::Test {
+public:
+   virtual void SetUp();
+   virtual void TearDown();
+
+   void triangles(GLuint first, GLuint count, bool color);
+   std::vector<vertex> flush();
+
+   struct gl_config visual;
+   struct dd_function_table driver_functions;
+   struct gl_context ctx;
+   struct gl_framebuffer *fb;
+   struct _glapi_table *dispatch;
+};
+
+void
+Display_list_test::SetUp()
+{
+   memset(&visual, 0, sizeof(visual));
+   memset(&driver_functions, 0, sizeof(driver_functions));
+   memset(&ctx, 0, sizeof(ctx));
+
+   _mesa_init_driver_functions(&driver_functions);
+   driver_functions.UpdateState = update_state;
+   _mesa_initialize_context(&ctx, API_OPENGL_COMPAT, &visual, NULL,
+                            &driver_functions);
+   _vbo_CreateContext(&ctx);
+   vbo_set_draw_func(&ctx, record_draw);
+
+   ctx.Version = 21;
+   _mesa_initialize_dispatch_tables(&ctx);
+   _mesa_initialize_vbo_vtxfmt(&ctx);
+
+   fb = _mesa_create_framebuffer(&visual);
+   _mesa_make_current(&ctx, fb, fb);
+   dispatch = _glapi_get_dispatch();
+
+   drawn.clear();
+   num_draws = 0;
+}
+
+void
+Display_list_test::TearDown()
+{
+   EXPECT_EQ((GLenum) GL_NO_ERROR, CALL_GetError(dispatch, ()));
+
+   _mesa_make_current(NULL, NULL, NULL);
+   _mesa_reference_framebuffer(&fb, NULL);
+}
+
+/**
+ * Draw 'count' separate triangles, with colors that differ from one
+ * triangle to the next when 'color' is set.
+ */
+void
+Display_list_test::triangles(GLuint first, GLuint count, bool color)
+{
+   for (GLuint t = first; t < first + count; t++) {
+      CALL_Begin(_glapi_get_dispatch(), (GL_TRIANGLES));
+      if (color)
+         CALL_Color4f(_glapi_get_dispatch(), (t / 256.0f, 0.0f, 1.0f, 1.0f));
+      for (GLuint v = 0; v < 3; v++)
+         CALL_Vertex3f(_glapi_get_dispatch(), ((GLfloat) t, (GLfloat) v, 0));
+      CALL_End(_glapi_get_dispatch(), ());
+   }
+}
+
+/**
+ * Return the vertices drawn so far, and forget them.
+ */
+std::vector<vertex>
+Display_list_test::flush()
+{
+   std::vector<vertex> vertices;
+
+   CALL_Flush(_glapi_get_dispatch(), ());
+   vertices.swap(drawn);
+   num_draws = 0;
+
+   return vertices;
+}
+
+
+/**
+ * The glBegin/glEnd pairs of a list overflowing the primitive store end up
+ * in vertex lists of their own, which are merged at glEndList.  With
+ * GL_COMPILE_AND_EXECUTE the lists are drawn as they're compiled, before
+ * being merged, and the merged list must draw the same.
+ */
+TEST_F(Display_list_test, compile_and_execute_merge)
+{
+   std::vector<vertex> immediate, executed, replayed;
+   const GLuint list = CALL_GenLists(dispatch, (1));
+
+   triangles(0, 300, true);
+   immediate = flush();
+   ASSERT_EQ(900u, immediate.size());
+
+   CALL_NewList(dispatch, (list, GL_COMPILE_AND_EXECUTE));
+   triangles(0, 300, true);
+   CALL_EndList(_glapi_get_dispatch(), ());
+   executed = flush();
+   EXPECT_TRUE(executed == immediate);
+
+   CALL_Color4f(dispatch, (0.0f, 0.0f, 0.0f, 0.0f));
+   CALL_CallList(dispatch, (list));
+   EXPECT_EQ(1u, num_draws);
+   replayed = flush();
+   EXPECT_TRUE(replayed == immediate);
+
+   /* The current color is the one of the last vertex */
+   EXPECT_EQ(299 / 256.0f, ctx.Current.Attrib[VERT_ATTRIB_COLOR0][0]);
+
+   CALL_DeleteLists(dispatch, (list, 1));
+}
+
+
+/**
+ * Vertex lists merged from more than one vertex store are copied into a
+ * buffer of their own.
+ */
+TEST_F(Display_list_test, merge_across_vertex_stores)
+{
+   std::vector<vertex> immediate, replayed;
+   const GLuint list = CALL_GenLists(dispatch, (1));
+
+   triangles(0, 3000, true);
+   immediate = flush();
+
+   CALL_NewList(dispatch, (list, GL_COMPILE));
+   triangles(0, 3000, true);
+   CALL_EndList(_glapi_get_dispatch(), ());
+   EXPECT_EQ(0u, num_draws);
+
+   CALL_CallList(dispatch, (list));
+   EXPECT_EQ(1u, num_draws);
+   replayed = flush();
+   EXPECT_TRUE(replayed == immediate);
+
+   CALL_DeleteLists(dispatch, (list, 1));
+}
+
+
+/**
+ * A color first set in the middle of a primitive applies to the vertices
+ * before it as well, with the current color at playback time.  The vertex
+ * list recording them is replayed by the loopback path, along with the
+ * vertex lists merged into the one following it.
+ */
+TEST_F(Display_list_test, dangling_attr_refs)
+{
+   std::vector<vertex> replayed;
+   const GLuint list = CALL_GenLists(dispatch, (1));
+
+   CALL_NewList(dispatch, (list, GL_COMPILE));
+   CALL_Begin(_glapi_get_dispatch(), (GL_TRIANGLES));
+   CALL_Vertex3f(_glapi_get_dispatch(), (-1.0f, 0.0f, 0.0f));
+   CALL_Vertex3f(_glapi_get_dispatch(), (-1.0f, 1.0f, 0.0f));
+   CALL_Color4f(_glapi_get_dispatch(), (1.0f, 0.0f, 0.0f, 1.0f));
+   CALL_Vertex3f(_glapi_get_dispatch(), (-1.0f, 2.0f, 0.0f));
+   CALL_End(_glapi_get_dispatch(), ());
+   triangles(0, 300, true);
+   CALL_EndList(_glapi_get_dispatch(), ());
+   EXPECT_EQ(0u, num_draws);
+
+   for (GLuint pass = 0; pass < 2; pass++) {
+      const GLfloat green = pass ? 1.0f : 0.5f;
+
+      CALL_Color4f(dispatch, (0.0f, green, 0.0f, 1.0f));
+      CALL_CallList(dispatch, (list));
+      replayed = flush();
+
+      ASSERT_EQ(903u, replayed.size());
+      EXPECT_EQ(green, replayed[0].color[1]);
+      EXPECT_EQ(green, replayed[1].color[1]);
+      EXPECT_EQ(1.0f, replayed[2].color[0]);
+      EXPECT_EQ(0.0f, replayed[2].color[1]);
+
+      triangles(0, 300, true);
+      EXPECT_TRUE(std::vector<vertex>(replayed.begin() + 3, replayed.end()) ==
+                  flush());
+   }
+
+   CALL_DeleteLists(dispatch, (list, 1));
+}
+
+
+/**
+ * An attribute set twice in a row is only compiled once, wherever the
+ * first instruction falls in the blocks of the display list, and the
+ * value drawn with is the last one.
+ */
+TEST_F(Display_list_test, attrib_collapse_across_blocks)
+{
+   /* Enough fillers to cross more than a block of the list */
+   for (GLuint fillers = 0; fillers < 120; fillers++) {
+      const GLuint list = CALL_GenLists(dispatch, (1));
+      std::vector<vertex> replayed;
+      union gl_dlist_node *block;
+      GLuint pos;
+
+      CALL_NewList(dispatch, (list, GL_COMPILE));
+      for (GLuint i = 0; i < fillers; i++)
+         CALL_Normal3f(_glapi_get_dispatch(), ((GLfloat) i, 0.0f, 1.0f));
+      CALL_Color4f(_glapi_get_dispatch(), (1.0f, 0.0f, 0.0f, 1.0f));
+
+      block = ctx.ListState.CurrentBlock;
+      pos = ctx.ListState.CurrentPos;
+      CALL_Color4f(_glapi_get_dispatch(), (0.0f, 1.0f, 0.0f, 1.0f));
+      EXPECT_EQ(block, ctx.ListState.CurrentBlock);
+      EXPECT_EQ(pos, ctx.ListState.CurrentPos);
+
+      triangles(0, 1, false);
+      CALL_Color4f(_glapi_get_dispatch(), (0.0f, 0.0f, 1.0f, 1.0f));
+      CALL_EndList(_glapi_get_dispatch(), ());
+
+      CALL_Color4f(dispatch, (1.0f, 1.0f, 1.0f, 1.0f));
+      CALL_CallList(dispatch, (list));
+      replayed = flush();
+
+      ASSERT_EQ(3u, replayed.size());
+      EXPECT_EQ(0.0f, replayed[0].color[0]);
+      EXPECT_EQ(1.0f, replayed[0].color[1]);
+      EXPECT_EQ(0.0f, ctx.Current.Attrib[VERT_ATTRIB_COLOR0][1]);
+      EXPECT_EQ(1.0f, ctx.Current.Attrib[VERT_ATTRIB_COLOR0][2]);
+      if (fillers > 0) {
+         EXPECT_EQ(fillers - 1.0f, ctx.Current.Attrib[VERT_ATTRIB_NORMAL][0]);
+      }
+
+      CALL_DeleteLists(dispatch, (list, 1));
+   }
+}
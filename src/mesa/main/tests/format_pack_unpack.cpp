@@ -0,0 +1,265 @@
+/*
+ * Copyright © 2014 VMware, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * Checks the row pack/unpack functions of the common color formats against
+ * a per-pixel reference.  The disabled throughput test reports the rate of
+ * each in GB/s, run it with --gtest_also_run_disabled_tests.
+ */
+
+#include <gtest/gtest.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+
+extern "C" {
+#include "main/formats.h"
+#include "main/format_pack.h"
+#include "main/format_unpack.h"
+#include "main/macros.h"
+}
+
+#define ROW_PIXELS   4096
+#define BENCH_USECS  (20 * 1000)
+
+/**
+ * Location of each of the R, G, B, A bytes of a pixel in memory,
+ * or -1 for components the format doesn't store.
+ */
+struct format_layout {
+   mesa_format format;
+   int bytes;
+   int comp[4];
+};
+
+static const struct format_layout layouts[] = {
+   { MESA_FORMAT_A8B8G8R8_UNORM, 4, {  3,  2,  1,  0 } },
+   { MESA_FORMAT_R8G8B8A8_UNORM, 4, {  0,  1,  2,  3 } },
+   { MESA_FORMAT_B8G8R8A8_UNORM, 4, {  2,  1,  0,  3 } },
+   { MESA_FORMAT_A8R8G8B8_UNORM, 4, {  1,  2,  3,  0 } },
+   { MESA_FORMAT_X8B8G8R8_UNORM, 4, {  3,  2,  1, -1 } },
+   { MESA_FORMAT_R8G8B8X8_UNORM, 4, {  0,  1,  2, -1 } },
+   { MESA_FORMAT_B8G8R8X8_UNORM, 4, {  2,  1,  0, -1 } },
+   { MESA_FORMAT_X8R8G8B8_UNORM, 4, {  1,  2,  3, -1 } },
+   { MESA_FORMAT_B5G6R5_UNORM,   2, { -1, -1, -1, -1 } },
+};
+
+
+static void
+reference_unpack(const struct format_layout *layout, const GLubyte *src,
+                 GLubyte dst[4])
+{
+   if (layout->format == MESA_FORMAT_B5G6R5_UNORM) {
+      GLushort p = src[0] | (src[1] << 8);
+      GLubyte r = p >> 11, g = (p >> 5) & 0x3f, b = p & 0x1f;
+      dst[0] = (r << 3) | (r >> 2);
+      dst[1] = (g << 2) | (g >> 4);
+      dst[2] = (b << 3) | (b >> 2);
+      dst[3] = 0xff;
+      return;
+   }
+
+   for (int c = 0; c < 4; c++)
+      dst[c] = layout->comp[c] >= 0 ? src[layout->comp[c]] : 0xff;
+}
+
+
+static void
+fill_random(void *data, unsigned size)
+{
+   GLubyte *p = (GLubyte *) data;
+
+   for (unsigned i = 0; i < size; i++)
+      p[i] = rand() & 0xff;
+}
+
+
+static double
+now_usecs(void)
+{
+   struct timeval tv;
+   gettimeofday(&tv, NULL);
+   return tv.tv_sec * 1000000.0 + tv.tv_usec;
+}
+
+
+class format_pack_unpack : public ::testing::Test {
+public:
+   virtual void SetUp();
+
+   GLubyte packed[ROW_PIXELS * 4 + 64];
+   GLubyte expected[ROW_PIXELS * 4 + 64];
+   GLubyte rgba[ROW_PIXELS + 16][4];
+   GLubyte ubyte_out[ROW_PIXELS + 16][4];
+   GLfloat float_out[ROW_PIXELS + 16][4];
+};
+
+void
+format_pack_unpack::SetUp()
+{
+   /* This is normally filled in when the first context is created. */
+   for (unsigned i = 0; i < 256; i++)
+      _mesa_ubyte_to_float_color_tab[i] = (float) i / 255.0F;
+}
+
+
+TEST_F(format_pack_unpack, unpack_ubyte_rgba_row)
+{
+   for (unsigned f = 0; f < Elements(layouts); f++) {
+      const struct format_layout *layout = &layouts[f];
+
+      for (unsigned n = 1; n <= ROW_PIXELS; n = n < 64 ? n + 1 : n * 4) {
+         fill_random(packed, sizeof packed);
+         memset(ubyte_out, 0xcd, sizeof ubyte_out);
+
+         _mesa_unpack_ubyte_rgba_row(layout->format, n, packed, ubyte_out);
+
+         for (unsigned i = 0; i < n; i++) {
+            GLubyte ref[4];
+            reference_unpack(layout, packed + i * layout->bytes, ref);
+            ASSERT_EQ(0, memcmp(ref, ubyte_out[i], 4))
+               << _mesa_get_format_name(layout->format)
+               << ", pixel " << i << " of " << n;
+         }
+         EXPECT_EQ(0xcd, ubyte_out[n][0]);
+      }
+   }
+}
+
+
+TEST_F(format_pack_unpack, unpack_rgba_row)
+{
+   for (unsigned f = 0; f < Elements(layouts); f++) {
+      const struct format_layout *layout = &layouts[f];
+
+      /* Only the 8888 formats use exact ubyte to float conversion. */
+      if (layout->bytes != 4)
+         continue;
+
+      for (unsigned n = 1; n <= ROW_PIXELS; n = n < 64 ? n + 1 : n * 4) {
+         fill_random(packed, sizeof packed);
+
+         _mesa_unpack_rgba_row(layout->format, n, packed, float_out);
+
+         for (unsigned i = 0; i < n; i++) {
+            GLubyte ref[4];
+            reference_unpack(layout, packed + i * layout->bytes, ref);
+            for (unsigned c = 0; c < 4; c++) {
+               ASSERT_EQ((float) ref[c] / 255.0F, float_out[i][c])
+                  << _mesa_get_format_name(layout->format)
+                  << ", pixel " << i << " of " << n;
+            }
+         }
+      }
+   }
+}
+
+
+TEST_F(format_pack_unpack, pack_ubyte_rgba_row)
+{
+   for (unsigned f = 0; f < Elements(layouts); f++) {
+      const struct format_layout *layout = &layouts[f];
+      gl_pack_ubyte_rgba_func pack =
+         _mesa_get_pack_ubyte_rgba_function(layout->format);
+      const unsigned bytes = layout->bytes;
+
+      for (unsigned n = 1; n <= ROW_PIXELS; n = n < 64 ? n + 1 : n * 4) {
+         fill_random(rgba, sizeof rgba);
+         memset(packed, 0xcd, sizeof packed);
+
+         _mesa_pack_ubyte_rgba_row(layout->format, n, rgba, packed);
+
+         for (unsigned i = 0; i < n; i++) {
+            pack(rgba[i], expected + i * bytes);
+
+            for (unsigned b = 0; b < bytes; b++) {
+               /* The row functions are free to store anything in X. */
+               if (bytes == 4 && layout->comp[3] < 0 &&
+                   b != (unsigned) layout->comp[0] &&
+                   b != (unsigned) layout->comp[1] &&
+                   b != (unsigned) layout->comp[2])
+                  continue;
+
+               ASSERT_EQ(expected[i * bytes + b], packed[i * bytes + b])
+                  << _mesa_get_format_name(layout->format)
+                  << ", pixel " << i << " of " << n;
+            }
+         }
+         EXPECT_EQ(0xcd, packed[n * bytes]);
+      }
+   }
+}
+
+
+/**
+ * Not a correctness test: prints the rate at which rows are converted,
+ * counting both the bytes read and written.
+ */
+TEST_F(format_pack_unpack, DISABLED_throughput)
+{
+   fill_random(packed, sizeof packed);
+   fill_random(rgba, sizeof rgba);
+
+   for (unsigned f = 0; f < Elements(layouts); f++) {
+      const struct format_layout *layout = &layouts[f];
+      const double row_bytes = ROW_PIXELS * layout->bytes;
+      double start, elapsed, rates[3];
+      unsigned iterations;
+
+      iterations = 0;
+      start = now_usecs();
+      do {
+         _mesa_unpack_ubyte_rgba_row(layout->format, ROW_PIXELS,
+                                     packed, ubyte_out);
+         iterations++;
+         elapsed = now_usecs() - start;
+      } while (elapsed < BENCH_USECS);
+      rates[0] = (row_bytes + ROW_PIXELS * 4) * iterations / elapsed / 1e3;
+
+      iterations = 0;
+      start = now_usecs();
+      do {
+         _mesa_unpack_rgba_row(layout->format, ROW_PIXELS,
+                               packed, float_out);
+         iterations++;
+         elapsed = now_usecs() - start;
+      } while (elapsed < BENCH_USECS);
+      rates[1] = (row_bytes + ROW_PIXELS * 16) * iterations / elapsed / 1e3;
+
+      iterations = 0;
+      start = now_usecs();
+      do {
+         _mesa_pack_ubyte_rgba_row(layout->format, ROW_PIXELS,
+                                   rgba, packed);
+         iterations++;
+         elapsed = now_usecs() - start;
+      } while (elapsed < BENCH_USECS);
+      rates[2] = (row_bytes + ROW_PIXELS * 4) * iterations / elapsed / 1e3;
+
+      printf("%-24s unpack ubyte %6.2f GB/s, unpack float %6.2f GB/s, "
+             "pack ubyte %6.2f GB/s\n",
+             _mesa_get_format_name(layout->format),
+             rates[0], rates[1], rates[2]);
+   }
+}
@@ -0,0 +1,260 @@
+/*
+ * Copyright © 2014 VMware, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * Checks _mesa_HashLookup(), alone and from several threads while the
+ * table is modified, as happens when shared contexts create and bind
+ * objects.  The disabled throughput test reports how many lookups per second
+ * threads sharing a table get, compared with taking a lock around each; run
+ * it with --gtest_also_run_disabled_tests.
+ */
+
+#include <gtest/gtest.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <sys/time.h>
+
+extern "C" {
+#include "c11/threads.h"
+#include "main/hash.h"
+}
+
+#define NUM_OBJECTS    1000
+#define MAX_THREADS    4
+#define BENCH_LOOKUPS  4000000
+
+
+static double
+now_usecs(void)
+{
+   struct timeval tv;
+   gettimeofday(&tv, NULL);
+   return tv.tv_sec * 1000000.0 + tv.tv_usec;
+}
+
+
+/** The value stored for a key */
+static void *
+object(GLuint key)
+{
+   return (void *) (uintptr_t) (key * 16);
+}
+
+
+static void
+nop_callback(GLuint key, void *data, void *userData)
+{
+}
+
+
+struct lookup_thread {
+   struct _mesa_HashTable *table;
+   /** Lock taken around each lookup, if any */
+   mtx_t *mutex;
+   unsigned lookups;
+   volatile bool *stop;
+   unsigned errors;
+};
+
+
+/** Look up the stable keys until told to stop, checking the values */
+static int
+check_thread(void *data)
+{
+   struct lookup_thread *t = (struct lookup_thread *) data;
+
+   while (!*t->stop) {
+      for (GLuint key = 1; key <= NUM_OBJECTS; key++) {
+         if (_mesa_HashLookup(t->table, key) != object(key))
+            t->errors++;
+      }
+   }
+
+   return 0;
+}
+
+
+/** Look up the keys like a loop of glBind*() calls would */
+static int
+bind_thread(void *data)
+{
+   struct lookup_thread *t = (struct lookup_thread *) data;
+   GLuint key = 1;
+
+   for (unsigned i = 0; i < t->lookups; i++) {
+      void *obj;
+
+      if (t->mutex)
+         mtx_lock(t->mutex);
+      obj = _mesa_HashLookup(t->table, key);
+      if (t->mutex)
+         mtx_unlock(t->mutex);
+
+      if (obj != object(key))
+         t->errors++;
+
+      key = key % NUM_OBJECTS + 1;
+   }
+
+   return 0;
+}
+
+
+class Hash_lookup_test : public ::testing::Test {
+public:
+   virtual void SetUp();
+   virtual void TearDown();
+
+   double bench(unsigned num_threads, mtx_t *mutex);
+
+   struct _mesa_HashTable *table;
+};
+
+void
+Hash_lookup_test::SetUp()
+{
+   table = _mesa_NewHashTable();
+   ASSERT_TRUE(table != NULL);
+
+   for (GLuint key = 1; key <= NUM_OBJECTS; key++)
+      _mesa_HashInsert(table, key, object(key));
+}
+
+void
+Hash_lookup_test::TearDown()
+{
+   _mesa_HashDeleteAll(table, nop_callback, NULL);
+   _mesa_DeleteHashTable(table);
+}
+
+/**
+ * Run num_threads threads looking up BENCH_LOOKUPS keys in total, and
+ * return the lookups per second.
+ */
+double
+Hash_lookup_test::bench(unsigned num_threads, mtx_t *mutex)
+{
+   struct lookup_thread threads[MAX_THREADS];
+   thrd_t handles[MAX_THREADS];
+   double start, elapsed;
+
+   start = now_usecs();
+
+   for (unsigned i = 0; i < num_threads; i++) {
+      threads[i].table = table;
+      threads[i].mutex = mutex;
+      threads[i].lookups = BENCH_LOOKUPS / num_threads;
+      threads[i].stop = NULL;
+      threads[i].errors = 0;
+      EXPECT_EQ(thrd_success,
+                thrd_create(&handles[i], bind_thread, &threads[i]));
+   }
+
+   for (unsigned i = 0; i < num_threads; i++) {
+      thrd_join(handles[i], NULL);
+      EXPECT_EQ(0u, threads[i].errors);
+   }
+
+   elapsed = now_usecs() - start;
+
+   return BENCH_LOOKUPS * 1e6 / elapsed;
+}
+
+
+TEST_F(Hash_lookup_test, lookup)
+{
+   /* Beyond the dense array */
+   _mesa_HashInsert(table, 1000000, object(1000000));
+
+   _mesa_HashRemove(table, 7);
+   _mesa_HashInsert(table, 8, object(9));
+
+   EXPECT_EQ(object(1), _mesa_HashLookup(table, 1));
+   EXPECT_EQ(NULL, _mesa_HashLookup(table, 7));
+   EXPECT_EQ(object(9), _mesa_HashLookup(table, 8));
+   EXPECT_EQ(object(NUM_OBJECTS), _mesa_HashLookup(table, NUM_OBJECTS));
+   EXPECT_EQ(NULL, _mesa_HashLookup(table, NUM_OBJECTS + 1));
+   EXPECT_EQ(object(1000000), _mesa_HashLookup(table, 1000000));
+   EXPECT_EQ(NULL, _mesa_HashLookup(table, 999999));
+   EXPECT_EQ((GLuint) NUM_OBJECTS, _mesa_HashNumEntries(table));
+
+   _mesa_HashDeleteAll(table, nop_callback, NULL);
+   EXPECT_EQ(NULL, _mesa_HashLookup(table, 1));
+   EXPECT_EQ(NULL, _mesa_HashLookup(table, 1000000));
+   EXPECT_EQ(0u, _mesa_HashNumEntries(table));
+}
+
+
+/**
+ * Readers must always find the objects they look up while the table grows
+ * and other objects come and go.
+ */
+TEST_F(Hash_lookup_test, concurrent_updates)
+{
+   struct lookup_thread threads[MAX_THREADS];
+   thrd_t handles[MAX_THREADS];
+   volatile bool stop = false;
+
+   for (unsigned i = 0; i < MAX_THREADS; i++) {
+      threads[i].table = table;
+      threads[i].mutex = NULL;
+      threads[i].stop = &stop;
+      threads[i].errors = 0;
+      ASSERT_EQ(thrd_success,
+                thrd_create(&handles[i], check_thread, &threads[i]));
+   }
+
+   for (GLuint key = NUM_OBJECTS + 1; key < 100000; key++) {
+      _mesa_HashInsert(table, key, object(key));
+      if (key % 3 == 0)
+         _mesa_HashRemove(table, key);
+   }
+
+   stop = true;
+
+   for (unsigned i = 0; i < MAX_THREADS; i++) {
+      thrd_join(handles[i], NULL);
+      EXPECT_EQ(0u, threads[i].errors);
+   }
+
+   EXPECT_EQ(object(99998), _mesa_HashLookup(table, 99998));
+   EXPECT_EQ(NULL, _mesa_HashLookup(table, 99999));
+}
+
+
+TEST_F(Hash_lookup_test, DISABLED_throughput)
+{
+   mtx_t mutex;
+
+   mtx_init(&mutex, mtx_plain);
+
+   for (unsigned n = 1; n <= MAX_THREADS; n *= 2) {
+      double locked = bench(n, &mutex);
+      double lock_free = bench(n, NULL);
+
+      printf("%u thread(s): locked %10.0f lookups/s, "
+             "lock-free %10.0f lookups/s\n", n, locked, lock_free);
+   }
+
+   mtx_destroy(&mutex);
+}
@@ -0,0 +1,295 @@
+/*
+ * Copyright © 2014 VMware, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * Runs GL calls through the marshalling dispatch table of main/marshal.c,
+ * into a dispatch table of stubs standing in for the driver, and checks
+ * they're executed in order with the right parameters, and that draws wait
+ * for the GL thread exactly when they may read client memory.
+ *
+ * Marshal_test.DISABLED_throughput reports how many draw calls per second an
+ * application gets without and with the GL thread (MESA_GLTHREAD off and on),
+ * when both the application and the driver do some work for each.  Run it
+ * with --gtest_also_run_disabled_tests.
+ */
+
+#include <gtest/gtest.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/time.h>
+
+extern "C" {
+#include "GL/gl.h"
+#include "GL/glext.h"
+#include "main/compiler.h"
+#include "main/api_exec.h"
+#include "main/context.h"
+#include "main/marshal.h"
+#include "glapi/glapi.h"
+#include "drivers/common/driverfuncs.h"
+#include "vbo/vbo.h"
+
+#ifndef GLAPIENTRYP
+#define GLAPIENTRYP GL_APIENTRYP
+#endif
+
+#include "main/dispatch.h"
+}
+
+#define BENCH_DRAWS   200000
+#define WORK          300
+
+
+static unsigned num_draws;
+static GLint last_first;
+static GLuint deleted_sum;
+static volatile unsigned sink;
+
+
+static void
+busy_work(unsigned seed)
+{
+   for (unsigned i = 0; i < WORK; i++)
+      sink += i * seed;
+}
+
+
+static void GLAPIENTRY
+stub_DrawArrays(GLenum mode, GLint first, GLsizei count)
+{
+   /* Pretend to validate state */
+   busy_work(mode);
+
+   /* Draws must run in order */
+   if (first == last_first + 1)
+      last_first = first;
+   num_draws++;
+}
+
+
+static void GLAPIENTRY
+stub_DeleteTextures(GLsizei n, const GLuint *textures)
+{
+   for (GLsizei i = 0; i < n; i++)
+      deleted_sum += textures[i];
+}
+
+
+static GLenum GLAPIENTRY
+stub_GetError(void)
+{
+   return num_draws;
+}
+
+
+static double
+now_usecs(void)
+{
+   struct timeval tv;
+   gettimeofday(&tv, NULL);
+   return tv.tv_sec * 1000000.0 + tv.tv_usec;
+}
+
+
+class Marshal_test : public ::testing::Test {
+public:
+   virtual void SetUp();
+   virtual void TearDown();
+
+   struct gl_config visual;
+   struct dd_function_table driver_functions;
+   struct gl_context ctx;
+   struct _glapi_table *stubs;
+   struct _glapi_table *saved_dispatch;
+};
+
+void
+Marshal_test::SetUp()
+{
+   memset(&visual, 0, sizeof(visual));
+   memset(&driver_functions, 0, sizeof(driver_functions));
+   memset(&ctx, 0, sizeof(ctx));
+
+   _mesa_init_driver_functions(&driver_functions);
+   _mesa_initialize_context(&ctx, API_OPENGL_COMPAT, &visual, NULL,
+                            &driver_functions);
+   _vbo_CreateContext(&ctx);
+
+   stubs = _mesa_alloc_dispatch_table();
+   SET_DrawArrays(stubs, stub_DrawArrays);
+   SET_DeleteTextures(stubs, stub_DeleteTextures);
+   SET_GetError(stubs, stub_GetError);
+
+   saved_dispatch = ctx.CurrentDispatch;
+   ctx.CurrentDispatch = stubs;
+
+   _glapi_set_context(&ctx);
+
+   num_draws = 0;
+   last_first = -1;
+   deleted_sum = 0;
+}
+
+void
+Marshal_test::TearDown()
+{
+   _mesa_glthread_destroy(&ctx);
+   ctx.CurrentDispatch = saved_dispatch;
+   _glapi_set_context(NULL);
+   _glapi_set_dispatch(NULL);
+   free(stubs);
+}
+
+
+TEST_F(Marshal_test, ordering)
+{
+   _mesa_glthread_init(&ctx);
+   ASSERT_TRUE(ctx.GLThread != NULL);
+   ASSERT_TRUE(ctx.MarshalExec != NULL);
+
+   /* Enough to fill several batches */
+   for (GLint i = 0; i < 10000; i++)
+      CALL_DrawArrays(ctx.MarshalExec, (GL_TRIANGLES, i, 3));
+
+   /* The array must be copied, not referenced */
+   for (GLuint i = 1; i <= 100; i++) {
+      GLuint textures[2] = { i, 1000 * i };
+      CALL_DeleteTextures(ctx.MarshalExec, (2, textures));
+      textures[0] = textures[1] = 0;
+   }
+
+   /* Waits for everything before it */
+   EXPECT_EQ(10000u, (unsigned) CALL_GetError(ctx.MarshalExec, ()));
+   EXPECT_EQ(9999, last_first);
+   EXPECT_EQ(5050u * 1001, deleted_sum);
+}
+
+
+TEST_F(Marshal_test, DISABLED_throughput)
+{
+   double start, direct, threaded;
+
+   start = now_usecs();
+   for (GLint i = 0; i < BENCH_DRAWS; i++) {
+      busy_work(i);
+      CALL_DrawArrays(stubs, (GL_TRIANGLES, i, 3));
+   }
+   EXPECT_EQ((GLenum) BENCH_DRAWS, CALL_GetError(stubs, ()));
+   direct = now_usecs() - start;
+
+   num_draws = 0;
+   last_first = -1;
+
+   _mesa_glthread_init(&ctx);
+   ASSERT_TRUE(ctx.GLThread != NULL);
+
+   start = now_usecs();
+   for (GLint i = 0; i < BENCH_DRAWS; i++) {
+      busy_work(i);
+      CALL_DrawArrays(ctx.MarshalExec, (GL_TRIANGLES, i, 3));
+   }
+   EXPECT_EQ((GLenum) BENCH_DRAWS, CALL_GetError(ctx.MarshalExec, ()));
+   threaded = now_usecs() - start;
+   EXPECT_EQ(BENCH_DRAWS - 1, last_first);
+
+   printf("MESA_GLTHREAD=0 %10.0f draws/s\n", BENCH_DRAWS * 1e6 / direct);
+   printf("MESA_GLTHREAD=1 %10.0f draws/s\n", BENCH_DRAWS * 1e6 / threaded);
+}
+
+
+TEST_F(Marshal_test, client_arrays)
+{
+   static const GLfloat vertices[3 * 3] = { 0 };
+   GLuint buffer = 1;
+
+   _mesa_glthread_init(&ctx);
+   ASSERT_TRUE(ctx.GLThread != NULL);
+
+   /* Disabled arrays aren't read */
+   CALL_VertexPointer(ctx.MarshalExec, (3, GL_FLOAT, 0, vertices));
+   EXPECT_FALSE(_mesa_glthread_draw_needs_sync(&ctx, GL_FALSE));
+
+   CALL_EnableClientState(ctx.MarshalExec, (GL_VERTEX_ARRAY));
+   EXPECT_TRUE(_mesa_glthread_draw_needs_sync(&ctx, GL_FALSE));
+
+   /* Respecified from a buffer */
+   CALL_BindBuffer(ctx.MarshalExec, (GL_ARRAY_BUFFER, buffer));
+   CALL_VertexPointer(ctx.MarshalExec, (3, GL_FLOAT, 0, NULL));
+   EXPECT_FALSE(_mesa_glthread_draw_needs_sync(&ctx, GL_FALSE));
+
+   /* Deleting the buffer leaves the array in client memory */
+   CALL_DeleteBuffers(ctx.MarshalExec, (1, &buffer));
+   EXPECT_TRUE(_mesa_glthread_draw_needs_sync(&ctx, GL_FALSE));
+
+   CALL_Disable(ctx.MarshalExec, (GL_VERTEX_ARRAY));
+   EXPECT_FALSE(_mesa_glthread_draw_needs_sync(&ctx, GL_FALSE));
+
+   /* Texture coordinate arrays follow the client active texture */
+   CALL_ClientActiveTexture(ctx.MarshalExec, (GL_TEXTURE1));
+   CALL_TexCoordPointer(ctx.MarshalExec, (2, GL_FLOAT, 0, vertices));
+   CALL_EnableClientState(ctx.MarshalExec, (GL_TEXTURE_COORD_ARRAY));
+   CALL_ClientActiveTexture(ctx.MarshalExec, (GL_TEXTURE0));
+   CALL_DisableClientState(ctx.MarshalExec, (GL_TEXTURE_COORD_ARRAY));
+   EXPECT_TRUE(_mesa_glthread_draw_needs_sync(&ctx, GL_FALSE));
+
+   CALL_ClientActiveTexture(ctx.MarshalExec, (GL_TEXTURE1));
+   CALL_DisableClientState(ctx.MarshalExec, (GL_TEXTURE_COORD_ARRAY));
+   EXPECT_FALSE(_mesa_glthread_draw_needs_sync(&ctx, GL_FALSE));
+
+   /* Generic attribs */
+   CALL_VertexAttribPointer(ctx.MarshalExec,
+                            (3, 4, GL_FLOAT, GL_FALSE, 0, vertices));
+   CALL_EnableVertexAttribArray(ctx.MarshalExec, (3));
+   EXPECT_TRUE(_mesa_glthread_draw_needs_sync(&ctx, GL_FALSE));
+   CALL_DisableVertexAttribArray(ctx.MarshalExec, (3));
+   EXPECT_FALSE(_mesa_glthread_draw_needs_sync(&ctx, GL_FALSE));
+
+   /* Indices */
+   EXPECT_TRUE(_mesa_glthread_draw_needs_sync(&ctx, GL_TRUE));
+   CALL_BindBuffer(ctx.MarshalExec, (GL_ELEMENT_ARRAY_BUFFER, 2));
+   EXPECT_FALSE(_mesa_glthread_draw_needs_sync(&ctx, GL_TRUE));
+}
+
+
+static void GLAPIENTRY
+debug_callback(GLenum source, GLenum type, GLuint id, GLenum severity,
+               GLsizei length, const GLchar *message, const void *userParam)
+{
+}
+
+
+TEST_F(Marshal_test, debug_callback)
+{
+   _mesa_glthread_init(&ctx);
+   ASSERT_TRUE(ctx.GLThread != NULL);
+   _glapi_set_dispatch(ctx.MarshalExec);
+
+   /* Once installed, GL calls must be made on the application's thread */
+   CALL_DebugMessageCallback(ctx.MarshalExec, (debug_callback, NULL));
+   EXPECT_TRUE(ctx.GLThread->sync);
+   EXPECT_EQ(ctx.CurrentDispatch, _glapi_get_dispatch());
+
+   CALL_DrawArrays(_glapi_get_dispatch(), (GL_TRIANGLES, 0, 3));
+   EXPECT_EQ(1u, num_draws);
+   EXPECT_EQ(0, last_first);
+}
@@ -0,0 +1,234 @@
+/*
+ * Copyright © 2014 VMware, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * Checks vbo_get_minmax_index_mapped() against a plain loop, for all the
+ * index types, with and without primitive restart and at any alignment.
+ * The disabled throughput test reports how many indices per second it scans;
+ * run it with --gtest_also_run_disabled_tests.
+ */
+
+#include <gtest/gtest.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+
+extern "C" {
+#include "main/macros.h"
+#include "main/mtypes.h"
+#include "vbo/vbo.h"
+}
+
+#define MAX_COUNT     1000
+#define BENCH_COUNT   (1024 * 1024)
+#define BENCH_USECS   (50 * 1000)
+
+
+static double
+now_usecs(void)
+{
+   struct timeval tv;
+   gettimeofday(&tv, NULL);
+   return tv.tv_sec * 1000000.0 + tv.tv_usec;
+}
+
+
+static GLuint
+get_index(const void *indices, GLuint index_size, GLuint i)
+{
+   switch (index_size) {
+   case 1:
+      return ((const GLubyte *) indices)[i];
+   case 2:
+      return ((const GLushort *) indices)[i];
+   default:
+      return ((const GLuint *) indices)[i];
+   }
+}
+
+
+static void
+set_index(void *indices, GLuint index_size, GLuint i, GLuint value)
+{
+   switch (index_size) {
+   case 1:
+      ((GLubyte *) indices)[i] = value;
+      break;
+   case 2:
+      ((GLushort *) indices)[i] = value;
+      break;
+   default:
+      ((GLuint *) indices)[i] = value;
+      break;
+   }
+}
+
+
+static void
+reference_minmax(GLuint count, GLuint index_size,
+                 GLuint restart_index, GLboolean restart,
+                 const void *indices, GLuint *min_index, GLuint *max_index)
+{
+   *min_index = ~0U;
+   *max_index = 0;
+
+   for (GLuint i = 0; i < count; i++) {
+      GLuint index = get_index(indices, index_size, i);
+
+      if (restart && index == restart_index)
+         continue;
+      *min_index = MIN2(*min_index, index);
+      *max_index = MAX2(*max_index, index);
+   }
+}
+
+
+/**
+ * Random indices, spread over the whole range of the type or not, with
+ * some restart indices.
+ */
+static void
+fill_indices(void *indices, GLuint index_size, GLuint count,
+             GLuint restart_index, bool full_range)
+{
+   const GLuint mask = index_size == 4 ? ~0U : (1U << (index_size * 8)) - 1;
+
+   for (GLuint i = 0; i < count; i++) {
+      GLuint value = ((GLuint) rand() << 16) ^ rand();
+
+      if (!full_range)
+         value = 100 + value % 50;
+      if (rand() % 8 == 0)
+         value = restart_index;
+
+      set_index(indices, index_size, i, value & mask);
+   }
+}
+
+
+static void
+check(GLuint count, GLuint index_size, GLuint restart_index,
+      GLboolean restart, const void *indices)
+{
+   GLuint min_index, max_index, ref_min, ref_max;
+
+   vbo_get_minmax_index_mapped(count, index_size, restart_index, restart,
+                               indices, &min_index, &max_index);
+   reference_minmax(count, index_size, restart_index, restart, indices,
+                    &ref_min, &ref_max);
+
+   EXPECT_EQ(ref_min, min_index)
+      << "size " << index_size << " count " << count
+      << " restart " << (int) restart << " index " << restart_index;
+   EXPECT_EQ(ref_max, max_index)
+      << "size " << index_size << " count " << count
+      << " restart " << (int) restart << " index " << restart_index;
+}
+
+
+TEST(MinMaxIndex, random)
+{
+   static const GLuint index_sizes[] = { 1, 2, 4 };
+   GLuint buffer[MAX_COUNT + 4];
+
+   for (unsigned s = 0; s < Elements(index_sizes); s++) {
+      const GLuint index_size = index_sizes[s];
+      const GLuint max_value = index_size == 4 ?
+         ~0U : (1U << (index_size * 8)) - 1;
+      const GLuint restart_indices[] = { max_value, 0, 120, max_value + 1 };
+
+      for (unsigned r = 0; r < Elements(restart_indices); r++) {
+         const GLuint restart_index = restart_indices[r];
+
+         for (int pass = 0; pass < 40; pass++) {
+            const GLuint count = pass < 20 ? pass : rand() % MAX_COUNT;
+            const GLuint offset = rand() % 4;
+            GLubyte *indices = (GLubyte *) buffer + offset * index_size;
+
+            fill_indices(indices, index_size, count, restart_index,
+                         pass % 2 == 0);
+
+            check(count, index_size, restart_index, GL_FALSE, indices);
+            check(count, index_size, restart_index, GL_TRUE, indices);
+         }
+      }
+   }
+}
+
+
+TEST(MinMaxIndex, all_restart)
+{
+   GLuint indices[100];
+   GLuint min_index, max_index;
+
+   memset(indices, 0xff, sizeof(indices));
+
+   for (GLuint index_size = 1; index_size <= 4; index_size *= 2) {
+      const GLuint count = sizeof(indices) / index_size;
+      const GLuint max_value = index_size == 4 ?
+         ~0U : (1U << (index_size * 8)) - 1;
+
+      vbo_get_minmax_index_mapped(count, index_size, max_value, GL_TRUE,
+                                  indices, &min_index, &max_index);
+      EXPECT_EQ(~0U, min_index);
+      EXPECT_EQ(0u, max_index);
+
+      vbo_get_minmax_index_mapped(count, index_size, max_value, GL_FALSE,
+                                  indices, &min_index, &max_index);
+      EXPECT_EQ(max_value, min_index);
+      EXPECT_EQ(max_value, max_index);
+   }
+}
+
+
+TEST(MinMaxIndex, DISABLED_throughput)
+{
+   GLuint *buffer = (GLuint *) malloc(BENCH_COUNT * sizeof(GLuint));
+
+   ASSERT_TRUE(buffer != NULL);
+
+   for (GLuint index_size = 1; index_size <= 4; index_size *= 2) {
+      for (int restart = 0; restart < 2; restart++) {
+         GLuint min_index, max_index;
+         double start, elapsed;
+         unsigned n = 0;
+
+         fill_indices(buffer, index_size, BENCH_COUNT, 0, true);
+
+         start = now_usecs();
+         do {
+            vbo_get_minmax_index_mapped(BENCH_COUNT, index_size, 0, restart,
+                                        buffer, &min_index, &max_index);
+            n++;
+            elapsed = now_usecs() - start;
+         } while (elapsed < BENCH_USECS);
+
+         printf("%u-byte indices, restart %s: %8.0f Mindices/s\n",
+                index_size, restart ? "on " : "off",
+                (double) n * BENCH_COUNT / elapsed);
+      }
+   }
+
+   free(buffer);
+}
@@ -0,0 +1,178 @@
+/*
+ * Copyright © 2014 VMware, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * Checks the 2D box filter of _mesa_generate_mipmap_level() for unsigned
+ * byte images against a reference.  The disabled throughput test reports
+ * the rate at which levels are generated for the common pixel types, in MB
+ * of source per second; run it with --gtest_also_run_disabled_tests.
+ */
+
+#include <gtest/gtest.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+
+extern "C" {
+#include "main/mipmap.h"
+}
+
+#define BENCH_SIZE   2048
+#define BENCH_USECS  (50 * 1000)
+
+
+static void
+fill_random(GLubyte *data, unsigned size)
+{
+   for (unsigned i = 0; i < size; i++)
+      data[i] = rand() & 0xff;
+}
+
+
+static double
+now_usecs(void)
+{
+   struct timeval tv;
+   gettimeofday(&tv, NULL);
+   return tv.tv_sec * 1000000.0 + tv.tv_usec;
+}
+
+
+static void
+next_size(GLint width, GLint height, GLint *dstWidth, GLint *dstHeight)
+{
+   GLint depth;
+   _mesa_next_mipmap_level_size(GL_TEXTURE_2D, 0, width, height, 1,
+                                dstWidth, dstHeight, &depth);
+}
+
+
+static void
+check_ubyte_level(GLuint comps, GLint width, GLint height)
+{
+   const GLint srcStride = width * comps + 3;
+   GLint dstWidth, dstHeight;
+   next_size(width, height, &dstWidth, &dstHeight);
+   const GLint dstStride = dstWidth * comps + 5;
+   GLubyte *src = new GLubyte[srcStride * height];
+   GLubyte *dst = new GLubyte[dstStride * dstHeight + 1];
+   const GLubyte *srcData[1] = { src };
+   GLubyte *dstData[1] = { dst };
+
+   fill_random(src, srcStride * height);
+   memset(dst, 0xcd, dstStride * dstHeight + 1);
+
+   _mesa_generate_mipmap_level(GL_TEXTURE_2D, GL_UNSIGNED_BYTE, comps, 0,
+                               width, height, 1, srcData, srcStride,
+                               dstWidth, dstHeight, 1, dstData, dstStride);
+
+   for (GLint y = 0; y < dstHeight; y++) {
+      const GLubyte *rowA = src + (height > 1 ? 2 * y : y) * srcStride;
+      const GLubyte *rowB = height > 1 ? rowA + srcStride : rowA;
+
+      for (GLint x = 0; x < dstWidth; x++) {
+         const GLint j = width > 1 ? 2 * x : x;
+         const GLint k = width > 1 ? 2 * x + 1 : x;
+
+         for (GLuint c = 0; c < comps; c++) {
+            const GLubyte expected = (rowA[j * comps + c] +
+                                      rowA[k * comps + c] +
+                                      rowB[j * comps + c] +
+                                      rowB[k * comps + c]) / 4;
+            ASSERT_EQ(expected, dst[y * dstStride + x * comps + c])
+               << comps << " components, " << width << "x" << height
+               << ", pixel " << x << "," << y;
+         }
+      }
+   }
+   EXPECT_EQ(0xcd, dst[dstStride * dstHeight]);
+
+   delete [] src;
+   delete [] dst;
+}
+
+
+TEST(mipmap, box_filter_ubyte)
+{
+   static const GLint sizes[][2] = {
+      { 2, 2 }, { 8, 1 }, { 1, 8 }, { 34, 6 }, { 64, 64 }, { 66, 10 },
+      { 130, 3 }, { 1024, 512 }
+   };
+
+   for (GLuint comps = 1; comps <= 4; comps++) {
+      for (unsigned i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++)
+         check_ubyte_level(comps, sizes[i][0], sizes[i][1]);
+   }
+}
+
+
+/**
+ * Not a correctness test: prints how fast a BENCH_SIZE x BENCH_SIZE level
+ * is filtered down for a few of the pixel types.
+ */
+TEST(mipmap, DISABLED_throughput)
+{
+   static const struct {
+      const char *name;
+      GLenum datatype;
+      GLuint comps;
+      GLuint bpp;
+   } types[] = {
+      { "GL_UNSIGNED_BYTE x4", GL_UNSIGNED_BYTE, 4, 4 },
+      { "GL_UNSIGNED_BYTE x3", GL_UNSIGNED_BYTE, 3, 3 },
+      { "GL_UNSIGNED_BYTE x1", GL_UNSIGNED_BYTE, 1, 1 },
+      { "GL_UNSIGNED_SHORT x4", GL_UNSIGNED_SHORT, 4, 8 },
+      { "GL_FLOAT x4", GL_FLOAT, 4, 16 },
+   };
+   GLubyte *src = new GLubyte[BENCH_SIZE * BENCH_SIZE * 16];
+   GLubyte *dst = new GLubyte[BENCH_SIZE * BENCH_SIZE * 4];
+   const GLubyte *srcData[1] = { src };
+   GLubyte *dstData[1] = { dst };
+
+   memset(src, 0x3c, BENCH_SIZE * BENCH_SIZE * 16);
+
+   for (unsigned t = 0; t < sizeof(types) / sizeof(types[0]); t++) {
+      const GLint srcStride = BENCH_SIZE * types[t].bpp;
+      unsigned iterations = 0;
+      double start, elapsed;
+
+      start = now_usecs();
+      do {
+         _mesa_generate_mipmap_level(GL_TEXTURE_2D, types[t].datatype,
+                                     types[t].comps, 0,
+                                     BENCH_SIZE, BENCH_SIZE, 1,
+                                     srcData, srcStride,
+                                     BENCH_SIZE / 2, BENCH_SIZE / 2, 1,
+                                     dstData, srcStride / 2);
+         iterations++;
+         elapsed = now_usecs() - start;
+      } while (elapsed < BENCH_USECS);
+
+      printf("%-22s %8.1f MB/s\n", types[t].name,
+             (double) srcStride * BENCH_SIZE * iterations / elapsed);
+   }
+
+   delete [] src;
+   delete [] dst;
+}
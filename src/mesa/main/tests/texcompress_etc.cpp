@@ -0,0 +1,258 @@
+/*
+ * Copyright © 2014 VMware, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * Checks the block decoders behind _mesa_etc1_unpack_rgba8888() and
+ * _mesa_unpack_etc2_format() against the single texel fetch functions on
+ * random blocks, which hit every ETC2 mode.  The disabled throughput test
+ * reports how many blocks per second each format decodes at; run it with
+ * --gtest_also_run_disabled_tests.
+ */
+
+#include <gtest/gtest.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+
+extern "C" {
+#include "main/texcompress_etc.h"
+#include "main/macros.h"
+}
+
+/* Not a multiple of the block size, to exercise partial blocks. */
+#define TEST_WIDTH   37
+#define TEST_HEIGHT  23
+#define GUARD        0xcd
+
+#define BENCH_SIZE   1024
+#define BENCH_USECS  (50 * 1000)
+
+struct etc_format {
+   mesa_format format;
+   unsigned block_size;
+   unsigned texel_size;
+   /* the format decoding to the same values in RGBA order, for sRGB */
+   mesa_format linear;
+};
+
+static const struct etc_format formats[] = {
+   { MESA_FORMAT_ETC1_RGB8,                   8, 4, MESA_FORMAT_NONE },
+   { MESA_FORMAT_ETC2_RGB8,                   8, 4, MESA_FORMAT_NONE },
+   { MESA_FORMAT_ETC2_SRGB8,                  8, 4, MESA_FORMAT_ETC2_RGB8 },
+   { MESA_FORMAT_ETC2_RGBA8_EAC,             16, 4, MESA_FORMAT_NONE },
+   { MESA_FORMAT_ETC2_SRGB8_ALPHA8_EAC,      16, 4,
+     MESA_FORMAT_ETC2_RGBA8_EAC },
+   { MESA_FORMAT_ETC2_R11_EAC,                8, 2, MESA_FORMAT_NONE },
+   { MESA_FORMAT_ETC2_RG11_EAC,              16, 4, MESA_FORMAT_NONE },
+   { MESA_FORMAT_ETC2_SIGNED_R11_EAC,         8, 2, MESA_FORMAT_NONE },
+   { MESA_FORMAT_ETC2_SIGNED_RG11_EAC,       16, 4, MESA_FORMAT_NONE },
+   { MESA_FORMAT_ETC2_RGB8_PUNCHTHROUGH_ALPHA1, 8, 4, MESA_FORMAT_NONE },
+   { MESA_FORMAT_ETC2_SRGB8_PUNCHTHROUGH_ALPHA1, 8, 4,
+     MESA_FORMAT_ETC2_RGB8_PUNCHTHROUGH_ALPHA1 },
+};
+
+
+static void
+fill_random(GLubyte *data, unsigned size)
+{
+   for (unsigned i = 0; i < size; i++)
+      data[i] = rand() & 0xff;
+}
+
+
+static double
+now_usecs(void)
+{
+   struct timeval tv;
+   gettimeofday(&tv, NULL);
+   return tv.tv_sec * 1000000.0 + tv.tv_usec;
+}
+
+
+static void
+unpack(mesa_format format, GLubyte *dst, unsigned dst_stride,
+       const GLubyte *src, unsigned src_stride,
+       unsigned width, unsigned height)
+{
+   if (format == MESA_FORMAT_ETC1_RGB8)
+      _mesa_etc1_unpack_rgba8888(dst, dst_stride, src, src_stride,
+                                 width, height);
+   else
+      _mesa_unpack_etc2_format(dst, dst_stride, src, src_stride,
+                               width, height, format);
+}
+
+
+/**
+ * Turn a texel fetched as floats back into the bytes the unpack functions
+ * write, which are 8-bit RGBA, or 16-bit R and RG.
+ */
+static void
+texel_to_bytes(const struct etc_format *f, const GLfloat texel[4],
+               GLubyte *dst)
+{
+   GLushort c[2];
+
+   switch (f->format) {
+   case MESA_FORMAT_ETC2_R11_EAC:
+   case MESA_FORMAT_ETC2_RG11_EAC:
+      c[0] = (GLushort) lrintf(texel[0] * 65535.0f);
+      c[1] = (GLushort) lrintf(texel[1] * 65535.0f);
+      memcpy(dst, c, f->texel_size);
+      break;
+   case MESA_FORMAT_ETC2_SIGNED_R11_EAC:
+   case MESA_FORMAT_ETC2_SIGNED_RG11_EAC:
+      c[0] = (GLshort) lrintf((texel[0] * 65535.0f - 1.0f) / 2.0f);
+      c[1] = (GLshort) lrintf((texel[1] * 65535.0f - 1.0f) / 2.0f);
+      memcpy(dst, c, f->texel_size);
+      break;
+   default:
+      for (unsigned c = 0; c < 4; c++)
+         dst[c] = (GLubyte) lrintf(texel[c] * 255.0f);
+      break;
+   }
+}
+
+
+class etc : public ::testing::Test {
+protected:
+   virtual void SetUp()
+   {
+      /* Normally filled in on the first context creation. */
+      for (unsigned i = 0; i < 256; i++)
+         _mesa_ubyte_to_float_color_tab[i] = (float) i / 255.0F;
+   }
+};
+
+
+TEST_F(etc, unpack_matches_fetch)
+{
+   const unsigned blocks_x = (TEST_WIDTH + 3) / 4;
+   const unsigned blocks_y = (TEST_HEIGHT + 3) / 4;
+
+   srand(4);
+
+   for (unsigned n = 0; n < sizeof(formats) / sizeof(formats[0]); n++) {
+      const struct etc_format *f = &formats[n];
+      const unsigned src_stride = blocks_x * f->block_size;
+      /* Leave some room past every row to catch overruns. */
+      const unsigned dst_stride = TEST_WIDTH * f->texel_size + 12;
+      GLubyte *src = new GLubyte[src_stride * blocks_y];
+      GLubyte *dst = new GLubyte[dst_stride * (TEST_HEIGHT + 1)];
+      GLubyte *ref = new GLubyte[dst_stride * TEST_HEIGHT];
+      compressed_fetch_func fetch =
+         _mesa_get_etc_fetch_func(f->linear != MESA_FORMAT_NONE ?
+                                  f->linear : f->format);
+
+      fill_random(src, src_stride * blocks_y);
+      memset(dst, GUARD, dst_stride * (TEST_HEIGHT + 1));
+
+      unpack(f->format, dst, dst_stride, src, src_stride,
+             TEST_WIDTH, TEST_HEIGHT);
+
+      for (unsigned y = 0; y < TEST_HEIGHT; y++) {
+         for (unsigned x = 0; x < TEST_WIDTH; x++) {
+            GLubyte *expected = ref + y * dst_stride + x * f->texel_size;
+            GLfloat texel[4];
+
+            fetch(src, TEST_WIDTH, x, y, texel);
+            texel_to_bytes(f, texel, expected);
+
+            /* The sRGB formats unpack to B8G8R8A8 */
+            if (f->linear != MESA_FORMAT_NONE) {
+               const GLubyte tmp = expected[0];
+               expected[0] = expected[2];
+               expected[2] = tmp;
+            }
+         }
+
+         ASSERT_EQ(0, memcmp(ref + y * dst_stride, dst + y * dst_stride,
+                             TEST_WIDTH * f->texel_size))
+            << _mesa_get_format_name(f->format) << ", row " << y;
+
+         for (unsigned x = TEST_WIDTH * f->texel_size; x < dst_stride; x++)
+            ASSERT_EQ(GUARD, dst[y * dst_stride + x])
+               << _mesa_get_format_name(f->format) << ", row " << y;
+      }
+
+      for (unsigned x = 0; x < dst_stride; x++)
+         ASSERT_EQ(GUARD, dst[TEST_HEIGHT * dst_stride + x])
+            << _mesa_get_format_name(f->format);
+
+      delete [] src;
+      delete [] dst;
+      delete [] ref;
+   }
+}
+
+
+/**
+ * Not a correctness test: prints how many blocks per second each format
+ * decodes over a BENCH_SIZE x BENCH_SIZE image, a whole block at a time and
+ * through the single texel fetch.
+ */
+TEST_F(etc, DISABLED_throughput)
+{
+   const unsigned blocks = (BENCH_SIZE / 4) * (BENCH_SIZE / 4);
+   GLubyte *src = new GLubyte[blocks * 16];
+   GLubyte *dst = new GLubyte[BENCH_SIZE * BENCH_SIZE * 4];
+
+   fill_random(src, blocks * 16);
+
+   for (unsigned n = 0; n < sizeof(formats) / sizeof(formats[0]); n++) {
+      const struct etc_format *f = &formats[n];
+      const unsigned src_stride = BENCH_SIZE / 4 * f->block_size;
+      compressed_fetch_func fetch = _mesa_get_etc_fetch_func(f->format);
+      unsigned iterations = 0, fetches = 0;
+      double start, elapsed, fetch_elapsed;
+      GLfloat texel[4];
+
+      start = now_usecs();
+      do {
+         unpack(f->format, dst, BENCH_SIZE * f->texel_size, src, src_stride,
+                BENCH_SIZE, BENCH_SIZE);
+         iterations++;
+         elapsed = now_usecs() - start;
+      } while (elapsed < BENCH_USECS);
+
+      start = now_usecs();
+      do {
+         for (unsigned y = 0; y < BENCH_SIZE; y++) {
+            for (unsigned x = 0; x < BENCH_SIZE; x++)
+               fetch(src, BENCH_SIZE, x, y, texel);
+         }
+         fetches++;
+         fetch_elapsed = now_usecs() - start;
+      } while (fetch_elapsed < BENCH_USECS);
+
+      printf("%-42s unpack %6.1f Mblocks/s, fetch %6.1f Mblocks/s\n",
+             _mesa_get_format_name(f->format),
+             (double) blocks * iterations / elapsed,
+             (double) blocks * fetches / fetch_elapsed);
+   }
+
+   delete [] src;
+   delete [] dst;
+}
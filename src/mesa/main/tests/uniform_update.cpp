@@ -0,0 +1,221 @@
+/*
+ * Copyright © 2014 VMware, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * Checks that glUniform calls taking the fast path of _mesa_uniform() reach
+ * the driver storage, padded or not, and that the other ones still take
+ * the general path.  The disabled throughput test reports how many updates
+ * per second the fast path and the general path do; run it with
+ * --gtest_also_run_disabled_tests.
+ */
+
+#include <gtest/gtest.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/time.h>
+
+#include "main/mtypes.h"
+#include "main/uniforms.h"
+#include "glsl_types.h"
+#include "ir_uniform.h"
+
+#define BASE_SCALE    256
+#define VEC3_ELEMENTS 8
+#define BENCH_UPDATES 1000000
+
+
+static double
+now_usecs(void)
+{
+   struct timeval tv;
+   gettimeofday(&tv, NULL);
+   return tv.tv_sec * 1000000.0 + tv.tv_usec;
+}
+
+
+class Uniform_update_test : public ::testing::Test {
+public:
+   virtual void SetUp();
+   virtual void TearDown();
+
+   void bench(const char *name, GLint location, GLsizei count,
+              const GLvoid *values, GLenum type);
+
+   enum {
+      VEC4,
+      VEC3_ARRAY,
+      BOOL,
+      NUM_UNIFORMS
+   };
+
+   struct gl_context ctx;
+   struct gl_shader_program prog;
+   struct gl_uniform_storage uniforms[NUM_UNIFORMS];
+
+   /** Mesa's storage */
+   union gl_constant_value vec4_storage[4];
+   union gl_constant_value vec3_storage[3 * VEC3_ELEMENTS];
+   union gl_constant_value bool_storage[1];
+
+   /** What a driver with vec4 slots would have */
+   GLfloat vec4_driver[4];
+   GLfloat vec3_driver[VEC3_ELEMENTS][4];
+   GLint bool_driver[4];
+};
+
+void
+Uniform_update_test::SetUp()
+{
+   memset(&ctx, 0, sizeof(ctx));
+   memset(&prog, 0, sizeof(prog));
+   memset(uniforms, 0, sizeof(uniforms));
+   memset(vec4_storage, 0, sizeof(vec4_storage));
+   memset(vec3_storage, 0, sizeof(vec3_storage));
+   memset(bool_storage, 0, sizeof(bool_storage));
+   memset(vec4_driver, 0, sizeof(vec4_driver));
+   memset(vec3_driver, 0, sizeof(vec3_driver));
+   memset(bool_driver, 0, sizeof(bool_driver));
+
+   prog.LinkStatus = GL_TRUE;
+   prog.UniformLocationBaseScale = BASE_SCALE;
+   prog.NumUserUniformStorage = NUM_UNIFORMS;
+   prog.UniformStorage = uniforms;
+
+   uniforms[VEC4].name = (char *) "v";
+   uniforms[VEC4].type = glsl_type::vec4_type;
+   uniforms[VEC4].storage = vec4_storage;
+   _mesa_uniform_attach_driver_storage(&uniforms[VEC4], 16, 16,
+                                       uniform_native, vec4_driver);
+
+   uniforms[VEC3_ARRAY].name = (char *) "a";
+   uniforms[VEC3_ARRAY].type = glsl_type::vec3_type;
+   uniforms[VEC3_ARRAY].array_elements = VEC3_ELEMENTS;
+   uniforms[VEC3_ARRAY].storage = vec3_storage;
+   _mesa_uniform_attach_driver_storage(&uniforms[VEC3_ARRAY], 16, 16,
+                                       uniform_native, vec3_driver);
+
+   uniforms[BOOL].name = (char *) "b";
+   uniforms[BOOL].type = glsl_type::bool_type;
+   uniforms[BOOL].storage = bool_storage;
+   _mesa_uniform_attach_driver_storage(&uniforms[BOOL], 16, 16,
+                                       uniform_native, bool_driver);
+}
+
+void
+Uniform_update_test::TearDown()
+{
+   for (unsigned i = 0; i < NUM_UNIFORMS; i++)
+      _mesa_uniform_detach_all_driver_storage(&uniforms[i]);
+}
+
+void
+Uniform_update_test::bench(const char *name, GLint location, GLsizei count,
+                           const GLvoid *values, GLenum type)
+{
+   double start, elapsed;
+
+   start = now_usecs();
+   for (unsigned i = 0; i < BENCH_UPDATES; i++)
+      _mesa_uniform(&ctx, &prog, location, count, values, type);
+   elapsed = now_usecs() - start;
+
+   printf("%-10s %10.0f updates/s\n", name, BENCH_UPDATES * 1e6 / elapsed);
+}
+
+
+TEST_F(Uniform_update_test, fast_path_types)
+{
+   EXPECT_EQ((unsigned) GL_FLOAT_VEC4, uniforms[VEC4].fast_path.type);
+   EXPECT_EQ(16u, uniforms[VEC4].fast_path.element_size);
+   EXPECT_EQ((unsigned) GL_FLOAT_VEC3, uniforms[VEC3_ARRAY].fast_path.type);
+   EXPECT_EQ(12u, uniforms[VEC3_ARRAY].fast_path.element_size);
+
+   /* Booleans are converted */
+   EXPECT_EQ(0u, uniforms[BOOL].fast_path.type);
+
+   /* So is anything else once some driver storage isn't native */
+   _mesa_uniform_attach_driver_storage(&uniforms[VEC4], 16, 16,
+                                       uniform_int_float, vec4_driver);
+   EXPECT_EQ(0u, uniforms[VEC4].fast_path.type);
+}
+
+
+TEST_F(Uniform_update_test, vector)
+{
+   const GLfloat v[4] = { 1.0f, 2.0f, 3.0f, 4.0f };
+
+   _mesa_uniform(&ctx, &prog, VEC4 * BASE_SCALE, 1, v, GL_FLOAT_VEC4);
+
+   EXPECT_EQ(0, memcmp(vec4_storage, v, sizeof(v)));
+   EXPECT_EQ(0, memcmp(vec4_driver, v, sizeof(v)));
+   EXPECT_TRUE(uniforms[VEC4].initialized);
+}
+
+
+TEST_F(Uniform_update_test, padded_array)
+{
+   GLfloat v[VEC3_ELEMENTS][3];
+
+   for (unsigned i = 0; i < VEC3_ELEMENTS; i++) {
+      for (unsigned j = 0; j < 3; j++)
+         v[i][j] = i * 3 + j + 1;
+   }
+
+   /* Starts at element 2, and runs past the end of the array */
+   _mesa_uniform(&ctx, &prog, VEC3_ARRAY * BASE_SCALE + 2, VEC3_ELEMENTS,
+                 v, GL_FLOAT_VEC3);
+
+   for (unsigned i = 0; i < VEC3_ELEMENTS; i++) {
+      for (unsigned j = 0; j < 3; j++) {
+         const GLfloat expected = i < 2 ? 0.0f : v[i - 2][j];
+
+         EXPECT_EQ(expected, vec3_storage[i * 3 + j].f);
+         EXPECT_EQ(expected, vec3_driver[i][j]);
+      }
+
+      /* The padding must be left alone */
+      EXPECT_EQ(0.0f, vec3_driver[i][3]);
+   }
+}
+
+
+TEST_F(Uniform_update_test, slow_path)
+{
+   const GLint b = 42;
+
+   _mesa_uniform(&ctx, &prog, BOOL * BASE_SCALE, 1, &b, GL_INT);
+
+   EXPECT_EQ(1, bool_storage[0].i);
+   EXPECT_EQ(1, bool_driver[0]);
+}
+
+
+TEST_F(Uniform_update_test, DISABLED_throughput)
+{
+   const GLfloat v[VEC3_ELEMENTS * 4] = { 0.0f };
+   const GLint b = 1;
+
+   bench("vec4", VEC4 * BASE_SCALE, 1, v, GL_FLOAT_VEC4);
+   bench("vec3[8]", VEC3_ARRAY * BASE_SCALE, VEC3_ELEMENTS, v, GL_FLOAT_VEC3);
+   bench("bool", BOOL * BASE_SCALE, 1, &b, GL_INT);
+}
@@ -561,14 +561,12 @@ etc2_alpha8_fetch_texel(const struct etc2_block *block,
    dst[3] = etc2_clamp(alpha);
 }
 
-static void
-etc2_r11_fetch_texel(const struct etc2_block *block,
-                     int x, int y, uint8_t *dst)
+static GLushort
+etc2_r11_decode(const struct etc2_block *block, int idx)
 {
-   GLint modifier, idx;
+   GLint modifier;
    GLshort color;
-   /* Get pixel index */
-   idx = etc2_get_pixel_index(block, x, y);
+
    modifier = etc2_modifier_tables[block->table_index][idx];
 
    if (block->multiplier != 0)
@@ -584,22 +582,19 @@ etc2_r11_fetch_texel(const struct etc2_block *block,
     * 11 bits."
     */
    color = (color << 5) | (color >> 6);
-   ((GLushort *)dst)[0] = color;
+   return color;
 }
 
-static void
-etc2_signed_r11_fetch_texel(const struct etc2_block *block,
-                            int x, int y, uint8_t *dst)
+static GLshort
+etc2_signed_r11_decode(const struct etc2_block *block, int idx)
 {
-   GLint modifier, idx;
+   GLint modifier;
    GLshort color;
    GLbyte base_codeword = (GLbyte) block->base_codeword;
 
    if (base_codeword == -128)
       base_codeword = -127;
 
-   /* Get pixel index */
-   idx = etc2_get_pixel_index(block, x, y);
    modifier = etc2_modifier_tables[block->table_index][idx];
 
    if (block->multiplier != 0)
@@ -622,7 +617,27 @@ etc2_signed_r11_fetch_texel(const struct etc2_block *block,
       color = (color << 5) | (color >> 5);
       color = -color;
    }
-   ((GLshort *)dst)[0] = color;
+   return color;
+}
+
+static void
+etc2_r11_fetch_texel(const struct etc2_block *block,
+                     int x, int y, uint8_t *dst)
+{
+   /* Get pixel index */
+   int idx = etc2_get_pixel_index(block, x, y);
+
+   ((GLushort *)dst)[0] = etc2_r11_decode(block, idx);
+}
+
+static void
+etc2_signed_r11_fetch_texel(const struct etc2_block *block,
+                            int x, int y, uint8_t *dst)
+{
+   /* Get pixel index */
+   int idx = etc2_get_pixel_index(block, x, y);
+
+   ((GLshort *)dst)[0] = etc2_signed_r11_decode(block, idx);
 }
 
 static void
@@ -665,6 +680,127 @@ etc2_rgba8_fetch_texel(const struct etc2_block *block,
    etc2_alpha8_fetch_texel(block, x, y, dst);
 }
 
+/**
+ * Decode the w x h top-left texels of an RGB8 block to RGBA rows, swapping
+ * red and blue when bgra is set.  The four colors of each subblock, or the
+ * four paint colors, are resolved once and the texels are then looked up.
+ */
+static void
+etc2_rgb8_unpack_block(const struct etc2_block *block,
+                       uint8_t *dst, unsigned dst_stride,
+                       unsigned w, unsigned h,
+                       GLboolean punchthrough_alpha, GLboolean bgra)
+{
+   uint8_t palette[2][4][4];
+   unsigned i, j, k;
+
+   if (block->is_planar_mode) {
+      for (j = 0; j < h; j++) {
+         uint8_t *row = dst + j * dst_stride;
+
+         for (i = 0; i < w; i++) {
+            etc2_rgb8_fetch_texel(block, i, j, row + i * 4,
+                                  punchthrough_alpha);
+            if (bgra) {
+               const uint8_t tmp = row[i * 4];
+               row[i * 4] = row[i * 4 + 2];
+               row[i * 4 + 2] = tmp;
+            }
+            row[i * 4 + 3] = 255;
+         }
+      }
+      return;
+   }
+
+   if (block->is_ind_mode || block->is_diff_mode) {
+      etc1_subblock_palette(block->base_colors[0],
+                            block->modifier_tables[0], palette[0]);
+      etc1_subblock_palette(block->base_colors[1],
+                            block->modifier_tables[1], palette[1]);
+   }
+   else {
+      /* T and H modes index the paint colors for the whole block */
+      for (k = 0; k < 4; k++) {
+         palette[0][k][0] = block->paint_colors[k][0];
+         palette[0][k][1] = block->paint_colors[k][1];
+         palette[0][k][2] = block->paint_colors[k][2];
+         palette[0][k][3] = 255;
+      }
+      memcpy(palette[1], palette[0], sizeof(palette[0]));
+   }
+
+   for (k = 0; k < 8; k++) {
+      uint8_t *color = palette[k / 4][k % 4];
+
+      if (bgra) {
+         const uint8_t tmp = color[0];
+         color[0] = color[2];
+         color[2] = tmp;
+      }
+      if (punchthrough_alpha && !block->opaque && k % 4 == 2)
+         color[0] = color[1] = color[2] = color[3] = 0;
+   }
+
+   etc1_write_block((const uint8_t (*)[4][4]) palette,
+                    (uint32_t) block->pixel_indices[0],
+                    block->is_t_mode || block->is_h_mode ?
+                    0 : block->flipped,
+                    dst, dst_stride, w, h);
+}
+
+/**
+ * Decode the w x h top-left alphas of an EAC block into the fourth byte of
+ * RGBA rows.
+ */
+static void
+etc2_alpha8_unpack_block(const struct etc2_block *block,
+                         uint8_t *dst, unsigned dst_stride,
+                         unsigned w, unsigned h)
+{
+   const int *modifiers = etc2_modifier_tables[block->table_index];
+   uint8_t palette[8];
+   unsigned i, j;
+
+   for (i = 0; i < 8; i++)
+      palette[i] = etc2_clamp(block->base_codeword +
+                              modifiers[i] * block->multiplier);
+
+   for (j = 0; j < h; j++) {
+      uint8_t *row = dst + j * dst_stride;
+
+      for (i = 0; i < w; i++)
+         row[i * 4 + 3] = palette[etc2_get_pixel_index(block, i, j)];
+   }
+}
+
+/**
+ * Decode the w x h top-left texels of an R11 block into the first 16-bit
+ * channel of texels texel_size bytes apart, unsigned or signed.
+ */
+static void
+etc2_r11_unpack_block(const struct etc2_block *block,
+                      uint8_t *dst, unsigned dst_stride,
+                      unsigned texel_size,
+                      unsigned w, unsigned h,
+                      GLboolean is_signed)
+{
+   uint16_t palette[8];
+   unsigned i, j;
+
+   for (i = 0; i < 8; i++) {
+      palette[i] = is_signed ? (uint16_t) etc2_signed_r11_decode(block, i) :
+                               etc2_r11_decode(block, i);
+   }
+
+   for (j = 0; j < h; j++) {
+      uint8_t *row = dst + j * dst_stride;
+
+      for (i = 0; i < w; i++)
+         memcpy(row + i * texel_size,
+                &palette[etc2_get_pixel_index(block, i, j)], 2);
+   }
+}
+
 static void
 etc2_unpack_rgb8(uint8_t *dst_row,
                  unsigned dst_stride,
@@ -675,25 +811,19 @@ etc2_unpack_rgb8(uint8_t *dst_row,
 {
    const unsigned bw = 4, bh = 4, bs = 8, comps = 4;
    struct etc2_block block;
-   unsigned x, y, i, j;
+   unsigned x, y;
 
    for (y = 0; y < height; y += bh) {
       const uint8_t *src = src_row;
+      uint8_t *dst = dst_row + y * dst_stride;
 
       for (x = 0; x < width; x+= bw) {
          etc2_rgb8_parse_block(&block, src,
                                false /* punchthrough_alpha */);
-
-         for (j = 0; j < bh; j++) {
-            uint8_t *dst = dst_row + (y + j) * dst_stride + x * comps;
-            for (i = 0; i < bw; i++) {
-               etc2_rgb8_fetch_texel(&block, i, j, dst,
-                                     false /* punchthrough_alpha */);
-               dst[3] = 255;
-               dst += comps;
-            }
-         }
-
+         etc2_rgb8_unpack_block(&block, dst + x * comps, dst_stride,
+                                MIN2(bw, width - x), MIN2(bh, height - y),
+                                false /* punchthrough_alpha */,
+                                false /* bgra */);
          src += bs;
       }
 
@@ -711,30 +841,20 @@ etc2_unpack_srgb8(uint8_t *dst_row,
 {
    const unsigned bw = 4, bh = 4, bs = 8, comps = 4;
    struct etc2_block block;
-   unsigned x, y, i, j;
-   uint8_t tmp;
+   unsigned x, y;
 
    for (y = 0; y < height; y += bh) {
       const uint8_t *src = src_row;
+      uint8_t *dst = dst_row + y * dst_stride;
 
       for (x = 0; x < width; x+= bw) {
          etc2_rgb8_parse_block(&block, src,
                                false /* punchthrough_alpha */);
-
-         for (j = 0; j < bh; j++) {
-            uint8_t *dst = dst_row + (y + j) * dst_stride + x * comps;
-            for (i = 0; i < bw; i++) {
-               etc2_rgb8_fetch_texel(&block, i, j, dst,
-                                     false /* punchthrough_alpha */);
-               /* Convert to MESA_FORMAT_B8G8R8A8_SRGB */
-               tmp = dst[0];
-               dst[0] = dst[2];
-               dst[2] = tmp;
-               dst[3] = 255;
-
-               dst += comps;
-            }
-         }
+         /* Convert to MESA_FORMAT_B8G8R8A8_SRGB */
+         etc2_rgb8_unpack_block(&block, dst + x * comps, dst_stride,
+                                MIN2(bw, width - x), MIN2(bh, height - y),
+                                false /* punchthrough_alpha */,
+                                true /* bgra */);
          src += bs;
       }
 
@@ -756,21 +876,20 @@ etc2_unpack_rgba8(uint8_t *dst_row,
    */
    const unsigned bw = 4, bh = 4, bs = 16, comps = 4;
    struct etc2_block block;
-   unsigned x, y, i, j;
+   unsigned x, y;
 
    for (y = 0; y < height; y += bh) {
       const uint8_t *src = src_row;
+      uint8_t *dst = dst_row + y * dst_stride;
 
       for (x = 0; x < width; x+= bw) {
-         etc2_rgba8_parse_block(&block, src);
+         const unsigned w = MIN2(bw, width - x), h = MIN2(bh, height - y);
 
-         for (j = 0; j < bh; j++) {
-            uint8_t *dst = dst_row + (y + j) * dst_stride + x * comps;
-            for (i = 0; i < bw; i++) {
-               etc2_rgba8_fetch_texel(&block, i, j, dst);
-               dst += comps;
-            }
-         }
+         etc2_rgba8_parse_block(&block, src);
+         etc2_rgb8_unpack_block(&block, dst + x * comps, dst_stride, w, h,
+                                false /* punchthrough_alpha */,
+                                false /* bgra */);
+         etc2_alpha8_unpack_block(&block, dst + x * comps, dst_stride, w, h);
          src += bs;
       }
 
@@ -792,29 +911,21 @@ etc2_unpack_srgb8_alpha8(uint8_t *dst_row,
     */
    const unsigned bw = 4, bh = 4, bs = 16, comps = 4;
    struct etc2_block block;
-   unsigned x, y, i, j;
-   uint8_t tmp;
+   unsigned x, y;
 
    for (y = 0; y < height; y += bh) {
       const uint8_t *src = src_row;
+      uint8_t *dst = dst_row + y * dst_stride;
 
       for (x = 0; x < width; x+= bw) {
-         etc2_rgba8_parse_block(&block, src);
+         const unsigned w = MIN2(bw, width - x), h = MIN2(bh, height - y);
 
-         for (j = 0; j < bh; j++) {
-            uint8_t *dst = dst_row + (y + j) * dst_stride + x * comps;
-            for (i = 0; i < bw; i++) {
-               etc2_rgba8_fetch_texel(&block, i, j, dst);
-
-               /* Convert to MESA_FORMAT_B8G8R8A8_SRGB */
-               tmp = dst[0];
-               dst[0] = dst[2];
-               dst[2] = tmp;
-               dst[3] = dst[3];
-
-               dst += comps;
-            }
-         }
+         etc2_rgba8_parse_block(&block, src);
+         /* Convert to MESA_FORMAT_B8G8R8A8_SRGB */
+         etc2_rgb8_unpack_block(&block, dst + x * comps, dst_stride, w, h,
+                                false /* punchthrough_alpha */,
+                                true /* bgra */);
+         etc2_alpha8_unpack_block(&block, dst + x * comps, dst_stride, w, h);
          src += bs;
       }
 
@@ -835,21 +946,18 @@ etc2_unpack_r11(uint8_t *dst_row,
    */
    const unsigned bw = 4, bh = 4, bs = 8, comps = 1, comp_size = 2;
    struct etc2_block block;
-   unsigned x, y, i, j;
+   unsigned x, y;
 
    for (y = 0; y < height; y += bh) {
       const uint8_t *src = src_row;
+      uint8_t *dst = dst_row + y * dst_stride;
 
       for (x = 0; x < width; x+= bw) {
          etc2_r11_parse_block(&block, src);
-
-         for (j = 0; j < bh; j++) {
-            uint8_t *dst = dst_row + (y + j) * dst_stride + x * comps * comp_size;
-            for (i = 0; i < bw; i++) {
-               etc2_r11_fetch_texel(&block, i, j, dst);
-               dst += comps * comp_size;
-            }
-         }
+         etc2_r11_unpack_block(&block, dst + x * comps * comp_size,
+                               dst_stride, comps * comp_size,
+                               MIN2(bw, width - x), MIN2(bh, height - y),
+                               false /* is_signed */);
          src += bs;
       }
 
@@ -870,34 +978,25 @@ etc2_unpack_rg11(uint8_t *dst_row,
    */
    const unsigned bw = 4, bh = 4, bs = 16, comps = 2, comp_size = 2;
    struct etc2_block block;
-   unsigned x, y, i, j;
+   unsigned x, y;
 
    for (y = 0; y < height; y += bh) {
       const uint8_t *src = src_row;
+      uint8_t *dst = dst_row + y * dst_stride;
 
       for (x = 0; x < width; x+= bw) {
+         const unsigned w = MIN2(bw, width - x), h = MIN2(bh, height - y);
+
          /* red component */
          etc2_r11_parse_block(&block, src);
-
-         for (j = 0; j < bh; j++) {
-            uint8_t *dst = dst_row + (y + j) * dst_stride +
-                           x * comps * comp_size;
-            for (i = 0; i < bw; i++) {
-               etc2_r11_fetch_texel(&block, i, j, dst);
-               dst += comps * comp_size;
-            }
-         }
+         etc2_r11_unpack_block(&block, dst + x * comps * comp_size,
+                               dst_stride, comps * comp_size, w, h,
+                               false /* is_signed */);
          /* green component */
          etc2_r11_parse_block(&block, src + 8);
-
-         for (j = 0; j < bh; j++) {
-            uint8_t *dst = dst_row + (y + j) * dst_stride +
-                           x * comps * comp_size;
-            for (i = 0; i < bw; i++) {
-               etc2_r11_fetch_texel(&block, i, j, dst + comp_size);
-               dst += comps * comp_size;
-            }
-         }
+         etc2_r11_unpack_block(&block, dst + x * comps * comp_size + comp_size,
+                               dst_stride, comps * comp_size, w, h,
+                               false /* is_signed */);
          src += bs;
       }
 
@@ -918,22 +1017,18 @@ etc2_unpack_signed_r11(uint8_t *dst_row,
    */
    const unsigned bw = 4, bh = 4, bs = 8, comps = 1, comp_size = 2;
    struct etc2_block block;
-   unsigned x, y, i, j;
+   unsigned x, y;
 
    for (y = 0; y < height; y += bh) {
       const uint8_t *src = src_row;
+      uint8_t *dst = dst_row + y * dst_stride;
 
       for (x = 0; x < width; x+= bw) {
          etc2_r11_parse_block(&block, src);
-
-         for (j = 0; j < bh; j++) {
-            uint8_t *dst = dst_row + (y + j) * dst_stride +
-                           x * comps * comp_size;
-            for (i = 0; i < bw; i++) {
-               etc2_signed_r11_fetch_texel(&block, i, j, dst);
-               dst += comps * comp_size;
-            }
-         }
+         etc2_r11_unpack_block(&block, dst + x * comps * comp_size,
+                               dst_stride, comps * comp_size,
+                               MIN2(bw, width - x), MIN2(bh, height - y),
+                               true /* is_signed */);
          src += bs;
       }
 
@@ -954,34 +1049,25 @@ etc2_unpack_signed_rg11(uint8_t *dst_row,
    */
    const unsigned bw = 4, bh = 4, bs = 16, comps = 2, comp_size = 2;
    struct etc2_block block;
-   unsigned x, y, i, j;
+   unsigned x, y;
 
    for (y = 0; y < height; y += bh) {
       const uint8_t *src = src_row;
+      uint8_t *dst = dst_row + y * dst_stride;
 
       for (x = 0; x < width; x+= bw) {
+         const unsigned w = MIN2(bw, width - x), h = MIN2(bh, height - y);
+
          /* red component */
          etc2_r11_parse_block(&block, src);
-
-         for (j = 0; j < bh; j++) {
-            uint8_t *dst = dst_row + (y + j) * dst_stride +
-                          x * comps * comp_size;
-            for (i = 0; i < bw; i++) {
-               etc2_signed_r11_fetch_texel(&block, i, j, dst);
-               dst += comps * comp_size;
-            }
-         }
+         etc2_r11_unpack_block(&block, dst + x * comps * comp_size,
+                               dst_stride, comps * comp_size, w, h,
+                               true /* is_signed */);
          /* green component */
          etc2_r11_parse_block(&block, src + 8);
-
-         for (j = 0; j < bh; j++) {
-            uint8_t *dst = dst_row + (y + j) * dst_stride +
-                           x * comps * comp_size;
-            for (i = 0; i < bw; i++) {
-               etc2_signed_r11_fetch_texel(&block, i, j, dst + comp_size);
-               dst += comps * comp_size;
-            }
-         }
+         etc2_r11_unpack_block(&block, dst + x * comps * comp_size + comp_size,
+                               dst_stride, comps * comp_size, w, h,
+                               true /* is_signed */);
          src += bs;
       }
 
@@ -999,23 +1085,19 @@ etc2_unpack_rgb8_punchthrough_alpha1(uint8_t *dst_row,
 {
    const unsigned bw = 4, bh = 4, bs = 8, comps = 4;
    struct etc2_block block;
-   unsigned x, y, i, j;
+   unsigned x, y;
 
    for (y = 0; y < height; y += bh) {
       const uint8_t *src = src_row;
+      uint8_t *dst = dst_row + y * dst_stride;
 
       for (x = 0; x < width; x+= bw) {
          etc2_rgb8_parse_block(&block, src,
                                true /* punchthrough_alpha */);
-         for (j = 0; j < bh; j++) {
-            uint8_t *dst = dst_row + (y + j) * dst_stride + x * comps;
-            for (i = 0; i < bw; i++) {
-               etc2_rgb8_fetch_texel(&block, i, j, dst,
-                                     true /* punchthrough_alpha */);
-               dst += comps;
-            }
-         }
-
+         etc2_rgb8_unpack_block(&block, dst + x * comps, dst_stride,
+                                MIN2(bw, width - x), MIN2(bh, height - y),
+                                true /* punchthrough_alpha */,
+                                false /* bgra */);
          src += bs;
       }
 
@@ -1033,30 +1115,20 @@ etc2_unpack_srgb8_punchthrough_alpha1(uint8_t *dst_row,
 {
    const unsigned bw = 4, bh = 4, bs = 8, comps = 4;
    struct etc2_block block;
-   unsigned x, y, i, j;
-   uint8_t tmp;
+   unsigned x, y;
 
    for (y = 0; y < height; y += bh) {
       const uint8_t *src = src_row;
+      uint8_t *dst = dst_row + y * dst_stride;
 
       for (x = 0; x < width; x+= bw) {
          etc2_rgb8_parse_block(&block, src,
                                true /* punchthrough_alpha */);
-         for (j = 0; j < bh; j++) {
-            uint8_t *dst = dst_row + (y + j) * dst_stride + x * comps;
-            for (i = 0; i < bw; i++) {
-               etc2_rgb8_fetch_texel(&block, i, j, dst,
-                                     true /* punchthrough_alpha */);
-               /* Convert to MESA_FORMAT_B8G8R8A8_SRGB */
-               tmp = dst[0];
-               dst[0] = dst[2];
-               dst[2] = tmp;
-               dst[3] = dst[3];
-
-               dst += comps;
-            }
-         }
-
+         /* Convert to MESA_FORMAT_B8G8R8A8_SRGB */
+         etc2_rgb8_unpack_block(&block, dst + x * comps, dst_stride,
+                                MIN2(bw, width - x), MIN2(bh, height - y),
+                                true /* punchthrough_alpha */,
+                                true /* bgra */);
          src += bs;
       }
 
@@ -25,6 +25,12 @@
  * Included by texcompress_etc1 and gallium to define ETC1 decoding routines.
  */
 
+#include <string.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 struct TAG(etc1_block) {
    uint32_t pixel_indices;
    int flipped;
@@ -135,6 +141,93 @@ TAG(etc1_fetch_texel)(const struct TAG(etc1_block) *block,
    dst[2] = TAG(etc1_clamp)(base_color[2], modifier);
 }
 
+/**
+ * Resolve the four colors of a subblock, as RGBA with opaque alpha.
+ */
+static void
+TAG(etc1_subblock_palette)(const UINT8_TYPE *base_color,
+                           const int *modifiers,
+                           UINT8_TYPE palette[4][4])
+{
+#if defined(__SSE2__)
+   /* The modifiers are at most 183 in magnitude, so clamp(base + modifier)
+    * is a saturating add of the positive part followed by a saturating
+    * subtract of the negative part, for all four entries at once.
+    */
+   int pos[4], neg[4];
+   unsigned k;
+   __m128i v;
+
+   for (k = 0; k < 4; k++) {
+      pos[k] = (modifiers[k] > 0 ? modifiers[k] : 0) * 0x010101;
+      neg[k] = (modifiers[k] < 0 ? -modifiers[k] : 0) * 0x010101;
+   }
+
+   v = _mm_set1_epi32((int) (base_color[0] |
+                             (base_color[1] << 8) |
+                             (base_color[2] << 16) |
+                             (0xffu << 24)));
+   v = _mm_adds_epu8(v, _mm_setr_epi32(pos[0], pos[1], pos[2], pos[3]));
+   v = _mm_subs_epu8(v, _mm_setr_epi32(neg[0], neg[1], neg[2], neg[3]));
+   _mm_storeu_si128((__m128i *) palette, v);
+#else
+   unsigned k;
+
+   for (k = 0; k < 4; k++) {
+      palette[k][0] = TAG(etc1_clamp)(base_color[0], modifiers[k]);
+      palette[k][1] = TAG(etc1_clamp)(base_color[1], modifiers[k]);
+      palette[k][2] = TAG(etc1_clamp)(base_color[2], modifiers[k]);
+      palette[k][3] = 255;
+   }
+#endif
+}
+
+/**
+ * Write the w x h top-left texels of a block, given the palettes of its
+ * two subblocks and the ETC1 style pixel indices, to RGBA rows.
+ */
+static void
+TAG(etc1_write_block)(const UINT8_TYPE palette[2][4][4],
+                      uint32_t pixel_indices, int flipped,
+                      UINT8_TYPE *dst, unsigned dst_stride,
+                      unsigned w, unsigned h)
+{
+   unsigned i, j;
+
+   for (j = 0; j < h; j++) {
+      UINT8_TYPE *row = dst + j * dst_stride;
+
+      for (i = 0; i < w; i++) {
+         const unsigned bit = j + i * 4;
+         const unsigned idx = ((pixel_indices >> (15 + bit)) & 0x2) |
+                              ((pixel_indices >>      (bit)) & 0x1);
+         const unsigned blk = flipped ? (j >= 2) : (i >= 2);
+
+         memcpy(row + i * 4, palette[blk][idx], 4);
+      }
+   }
+}
+
+/**
+ * Decode the w x h top-left texels of a block to RGBA rows, w, h <= 4.
+ */
+static void
+TAG(etc1_unpack_block)(const struct TAG(etc1_block) *block,
+                       UINT8_TYPE *dst, unsigned dst_stride,
+                       unsigned w, unsigned h)
+{
+   UINT8_TYPE palette[2][4][4];
+
+   TAG(etc1_subblock_palette)(block->base_colors[0],
+                              block->modifier_tables[0], palette[0]);
+   TAG(etc1_subblock_palette)(block->base_colors[1],
+                              block->modifier_tables[1], palette[1]);
+
+   TAG(etc1_write_block)((const UINT8_TYPE (*)[4][4]) palette,
+                         block->pixel_indices, block->flipped,
+                         dst, dst_stride, w, h);
+}
+
 static void
 etc1_unpack_rgba8888(uint8_t *dst_row,
                      unsigned dst_stride,
@@ -145,23 +238,16 @@ etc1_unpack_rgba8888(uint8_t *dst_row,
 {
    const unsigned bw = 4, bh = 4, bs = 8, comps = 4;
    struct etc1_block block;
-   unsigned x, y, i, j;
+   unsigned x, y;
 
    for (y = 0; y < height; y += bh) {
       const uint8_t *src = src_row;
+      uint8_t *dst = dst_row + y * dst_stride;
 
       for (x = 0; x < width; x+= bw) {
          etc1_parse_block(&block, src);
-
-         for (j = 0; j < MIN2(bh, height - y); j++) {
-            uint8_t *dst = dst_row + (y + j) * dst_stride + x * comps;
-            for (i = 0; i < MIN2(bw, width - x); i++) {
-               etc1_fetch_texel(&block, i, j, dst);
-               dst[3] = 255;
-               dst += comps;
-            }
-         }
-
+         etc1_unpack_block(&block, dst + x * comps, dst_stride,
+                           MIN2(bw, width - x), MIN2(bh, height - y));
          src += bs;
       }
 
@@ -0,0 +1,494 @@
+/*
+ * Mesa 3-D graphics library
+ *
+ * Copyright (c) 2014 VMware, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * Built-in DXT1/DXT3/DXT5 decoder and compressor, included by
+ * texcompress_s3tc.c and by gallium's u_format_s3tc.c.
+ *
+ * The decoder reproduces libtxc_dxtn's arithmetic exactly, so textures look
+ * the same whether or not that library is installed.  Whole blocks are
+ * decoded by computing the block's palette once and looking up all 16
+ * texels in it; the single texel fetches only compute the entry they need.
+ *
+ * The compressor fits the endpoints to the bounding box of the block's
+ * colors and quantizes every texel's position along the line between them.
+ * It is much faster than libtxc_dxtn's endpoint search, at some cost in
+ * quality.
+ *
+ * dxt_type is 0 for DXT1 RGB, 1 for DXT1 RGBA, 2 for DXT3 and 3 for DXT5,
+ * the same order as the GL_COMPRESSED_*_S3TC_DXT*_EXT enums.
+ */
+
+#define DXTN_EXP5TO8R(c) ((((c) >> 8) & 0xf8) | (((c) >> 13) & 0x7))
+#define DXTN_EXP6TO8G(c) ((((c) >> 3) & 0xfc) | (((c) >>  9) & 0x3))
+#define DXTN_EXP5TO8B(c) ((((c) << 3) & 0xf8) | (((c) >>  2) & 0x7))
+
+
+/**
+ * Decode color number code (0-3) of a color block with the given
+ * endpoints.
+ */
+static INLINE void
+dxtn_decode_color(unsigned color0, unsigned color1, unsigned code,
+                  unsigned dxt_type, uint8_t *rgba)
+{
+   const unsigned r0 = DXTN_EXP5TO8R(color0);
+   const unsigned g0 = DXTN_EXP6TO8G(color0);
+   const unsigned b0 = DXTN_EXP5TO8B(color0);
+   const unsigned r1 = DXTN_EXP5TO8R(color1);
+   const unsigned g1 = DXTN_EXP6TO8G(color1);
+   const unsigned b1 = DXTN_EXP5TO8B(color1);
+   const int four_color = dxt_type > 1 || color0 > color1;
+
+   rgba[3] = 255;
+
+   switch (code) {
+   case 0:
+      rgba[0] = r0;
+      rgba[1] = g0;
+      rgba[2] = b0;
+      break;
+   case 1:
+      rgba[0] = r1;
+      rgba[1] = g1;
+      rgba[2] = b1;
+      break;
+   case 2:
+      if (four_color) {
+         rgba[0] = (r0 * 2 + r1) / 3;
+         rgba[1] = (g0 * 2 + g1) / 3;
+         rgba[2] = (b0 * 2 + b1) / 3;
+      }
+      else {
+         rgba[0] = (r0 + r1) / 2;
+         rgba[1] = (g0 + g1) / 2;
+         rgba[2] = (b0 + b1) / 2;
+      }
+      break;
+   default:
+      if (four_color) {
+         rgba[0] = (r0 + r1 * 2) / 3;
+         rgba[1] = (g0 + g1 * 2) / 3;
+         rgba[2] = (b0 + b1 * 2) / 3;
+      }
+      else {
+         rgba[0] = 0;
+         rgba[1] = 0;
+         rgba[2] = 0;
+         if (dxt_type == 1)
+            rgba[3] = 0;
+      }
+      break;
+   }
+}
+
+
+/**
+ * Decode alpha number code (0-7) of a DXT5 alpha block.
+ */
+static INLINE unsigned
+dxtn_decode_alpha(unsigned alpha0, unsigned alpha1, unsigned code)
+{
+   if (code == 0)
+      return alpha0;
+   else if (code == 1)
+      return alpha1;
+   else if (alpha0 > alpha1)
+      return (alpha0 * (8 - code) + alpha1 * (code - 1)) / 7;
+   else if (code < 6)
+      return (alpha0 * (6 - code) + alpha1 * (code - 1)) / 5;
+   else if (code == 6)
+      return 0;
+   else
+      return 255;
+}
+
+
+static INLINE void
+dxtn_decode_color_block(const uint8_t *src, unsigned dxt_type,
+                        uint8_t dst[16][4])
+{
+   const unsigned color0 = src[0] | (src[1] << 8);
+   const unsigned color1 = src[2] | (src[3] << 8);
+   uint32_t bits = src[4] | (src[5] << 8) | (src[6] << 16) |
+                   ((uint32_t)src[7] << 24);
+   uint8_t palette[4][4];
+   unsigned k;
+
+   for (k = 0; k < 4; ++k)
+      dxtn_decode_color(color0, color1, k, dxt_type, palette[k]);
+
+   for (k = 0; k < 16; ++k) {
+      memcpy(dst[k], palette[bits & 3], 4);
+      bits >>= 2;
+   }
+}
+
+
+/*
+ * Whole block decoders.  dst receives the 16 texels in row-major order.
+ */
+
+static INLINE void
+dxt1_rgb_decode_block(const uint8_t *src, uint8_t dst[16][4])
+{
+   dxtn_decode_color_block(src, 0, dst);
+}
+
+static INLINE void
+dxt1_rgba_decode_block(const uint8_t *src, uint8_t dst[16][4])
+{
+   dxtn_decode_color_block(src, 1, dst);
+}
+
+static INLINE void
+dxt3_rgba_decode_block(const uint8_t *src, uint8_t dst[16][4])
+{
+   unsigned k;
+
+   dxtn_decode_color_block(src + 8, 2, dst);
+
+   for (k = 0; k < 16; ++k) {
+      const unsigned nibble = (src[k / 2] >> (4 * (k & 1))) & 0xf;
+      dst[k][3] = nibble | (nibble << 4);
+   }
+}
+
+static INLINE void
+dxt5_rgba_decode_block(const uint8_t *src, uint8_t dst[16][4])
+{
+   uint64_t bits = (uint64_t)src[2] |
+                   (uint64_t)src[3] << 8 |
+                   (uint64_t)src[4] << 16 |
+                   (uint64_t)src[5] << 24 |
+                   (uint64_t)src[6] << 32 |
+                   (uint64_t)src[7] << 40;
+   uint8_t palette[8];
+   unsigned k;
+
+   dxtn_decode_color_block(src + 8, 3, dst);
+
+   for (k = 0; k < 8; ++k)
+      palette[k] = dxtn_decode_alpha(src[0], src[1], k);
+
+   for (k = 0; k < 16; ++k) {
+      dst[k][3] = palette[bits & 7];
+      bits >>= 3;
+   }
+}
+
+
+/*
+ * Single texel fetches, with the interface of libtxc_dxtn's
+ * fetch_2d_texel_*() functions: src_stride is the image width in texels.
+ */
+
+static INLINE const uint8_t *
+dxtn_block_address(int src_stride, const uint8_t *src, int i, int j,
+                   unsigned block_size)
+{
+   return src + ((src_stride + 3) / 4 * (j / 4) + (i / 4)) * block_size;
+}
+
+static INLINE void
+dxtn_fetch_color(const uint8_t *blk, unsigned k, unsigned dxt_type,
+                 uint8_t *rgba)
+{
+   const unsigned color0 = blk[0] | (blk[1] << 8);
+   const unsigned color1 = blk[2] | (blk[3] << 8);
+   const unsigned code = (blk[4 + k / 4] >> (2 * (k & 3))) & 3;
+
+   dxtn_decode_color(color0, color1, code, dxt_type, rgba);
+}
+
+static INLINE void
+dxt1_rgb_fetch_texel(int src_stride, const uint8_t *src, int i, int j,
+                     uint8_t *rgba)
+{
+   const uint8_t *blk = dxtn_block_address(src_stride, src, i, j, 8);
+   dxtn_fetch_color(blk, (j & 3) * 4 + (i & 3), 0, rgba);
+}
+
+static INLINE void
+dxt1_rgba_fetch_texel(int src_stride, const uint8_t *src, int i, int j,
+                      uint8_t *rgba)
+{
+   const uint8_t *blk = dxtn_block_address(src_stride, src, i, j, 8);
+   dxtn_fetch_color(blk, (j & 3) * 4 + (i & 3), 1, rgba);
+}
+
+static INLINE void
+dxt3_rgba_fetch_texel(int src_stride, const uint8_t *src, int i, int j,
+                      uint8_t *rgba)
+{
+   const uint8_t *blk = dxtn_block_address(src_stride, src, i, j, 16);
+   const unsigned k = (j & 3) * 4 + (i & 3);
+   const unsigned nibble = (blk[k / 2] >> (4 * (k & 1))) & 0xf;
+
+   dxtn_fetch_color(blk + 8, k, 2, rgba);
+   rgba[3] = nibble | (nibble << 4);
+}
+
+static INLINE void
+dxt5_rgba_fetch_texel(int src_stride, const uint8_t *src, int i, int j,
+                      uint8_t *rgba)
+{
+   const uint8_t *blk = dxtn_block_address(src_stride, src, i, j, 16);
+   const unsigned k = (j & 3) * 4 + (i & 3);
+   const unsigned bit_pos = k * 3;
+   const unsigned code =
+      ((blk[2 + bit_pos / 8] | (blk[3 + bit_pos / 8] << 8)) >>
+       (bit_pos & 7)) & 7;
+
+   dxtn_fetch_color(blk + 8, k, 3, rgba);
+   rgba[3] = dxtn_decode_alpha(blk[0], blk[1], code);
+}
+
+
+/*
+ * Compressor.
+ */
+
+static INLINE unsigned
+dxtn_rgb_to_565(const unsigned rgb[3])
+{
+   return (((rgb[0] * 31 + 127) / 255) << 11) |
+          (((rgb[1] * 63 + 127) / 255) << 5) |
+          ((rgb[2] * 31 + 127) / 255);
+}
+
+static INLINE void
+dxtn_encode_color_block(const uint8_t texels[16][4], unsigned dxt_type,
+                        uint8_t *dst)
+{
+   unsigned lo[3] = { 255, 255, 255 };
+   unsigned hi[3] = { 0, 0, 0 };
+   static const unsigned step_to_code4[4] = { 0, 2, 3, 1 };
+   static const unsigned step_to_code3[3] = { 0, 2, 1 };
+   unsigned color0, color1, ref, c, k;
+   int transparent = 0, opaque = 0;
+   int dir[3], len2 = 0, steps;
+   float scale;
+   uint8_t end0[4], end1[4];
+   uint32_t bits = 0;
+
+   for (k = 0; k < 16; ++k) {
+      if (dxt_type == 1 && texels[k][3] < 128) {
+         transparent = 1;
+         continue;
+      }
+      opaque = 1;
+      for (c = 0; c < 3; ++c) {
+         lo[c] = MIN2(lo[c], texels[k][c]);
+         hi[c] = MAX2(hi[c], texels[k][c]);
+      }
+   }
+
+   if (!opaque) {
+      /* Three color mode with every texel transparent black. */
+      memset(dst, 0, 4);
+      memset(dst + 4, 0xff, 4);
+      return;
+   }
+
+   /*
+    * Of the bounding box diagonals, pick the one that follows the colors:
+    * swap the extremes of any channel that goes down while the channel with
+    * the widest range goes up.
+    */
+   ref = 0;
+   for (c = 1; c < 3; ++c) {
+      if (hi[c] - lo[c] > hi[ref] - lo[ref])
+         ref = c;
+   }
+   for (c = 0; c < 3; ++c) {
+      int cov = 0;
+
+      if (c == ref)
+         continue;
+
+      for (k = 0; k < 16; ++k) {
+         if (dxt_type == 1 && texels[k][3] < 128)
+            continue;
+         cov += (2 * texels[k][ref] - (int)(lo[ref] + hi[ref])) *
+                (2 * texels[k][c] - (int)(lo[c] + hi[c]));
+      }
+
+      if (cov < 0) {
+         const unsigned tmp = lo[c];
+         lo[c] = hi[c];
+         hi[c] = tmp;
+      }
+   }
+
+   color0 = dxtn_rgb_to_565(hi);
+   color1 = dxtn_rgb_to_565(lo);
+
+   /* Transparent texels need the three color mode, where color0 <= color1. */
+   if (transparent ? color0 > color1 : color0 < color1) {
+      const unsigned tmp = color0;
+      color0 = color1;
+      color1 = tmp;
+   }
+
+   dxtn_decode_color(color0, color1, 0, dxt_type, end0);
+   dxtn_decode_color(color0, color1, 1, dxt_type, end1);
+   for (c = 0; c < 3; ++c) {
+      dir[c] = end1[c] - end0[c];
+      len2 += dir[c] * dir[c];
+   }
+
+   /*
+    * Rather than searching the palette, project every texel on the line
+    * between the endpoints and round to the nearest of the steps along it.
+    * Four color blocks have two colors in between the endpoints, three
+    * color ones one.
+    */
+   steps = (color0 > color1 || dxt_type > 1) ? 3 : 2;
+   scale = len2 > 0 ? (float)steps / len2 : 0.0f;
+
+   for (k = 0; k < 16; ++k) {
+      unsigned code = 3;
+
+      if (dxt_type != 1 || texels[k][3] >= 128) {
+         int dot = 0, s = 0;
+
+         for (c = 0; c < 3; ++c)
+            dot += (texels[k][c] - end0[c]) * dir[c];
+
+         if (dot > 0)
+            s = MIN2((int)(dot * scale + 0.5f), steps);
+
+         code = steps == 3 ? step_to_code4[s] : step_to_code3[s];
+      }
+
+      bits |= code << (2 * k);
+   }
+
+   dst[0] = color0 & 0xff;
+   dst[1] = color0 >> 8;
+   dst[2] = color1 & 0xff;
+   dst[3] = color1 >> 8;
+   dst[4] = bits & 0xff;
+   dst[5] = (bits >> 8) & 0xff;
+   dst[6] = (bits >> 16) & 0xff;
+   dst[7] = bits >> 24;
+}
+
+static INLINE void
+dxt3_encode_alpha_block(const uint8_t texels[16][4], uint8_t *dst)
+{
+   unsigned k;
+
+   memset(dst, 0, 8);
+   for (k = 0; k < 16; ++k) {
+      const unsigned nibble = (texels[k][3] * 15 + 127) / 255;
+      dst[k / 2] |= nibble << (4 * (k & 1));
+   }
+}
+
+static INLINE void
+dxt5_encode_alpha_block(const uint8_t texels[16][4], uint8_t *dst)
+{
+   unsigned lo = 255, hi = 0, k;
+   uint64_t bits = 0;
+
+   for (k = 0; k < 16; ++k) {
+      lo = MIN2(lo, texels[k][3]);
+      hi = MAX2(hi, texels[k][3]);
+   }
+
+   /*
+    * With alpha0 > alpha1, codes 2 to 7 step from alpha0 to alpha1 in
+    * sevenths, so the nearest code follows from the distance to alpha0.
+    */
+   if (hi > lo) {
+      const float scale = 7.0f / (hi - lo);
+
+      for (k = 0; k < 16; ++k) {
+         const unsigned s = (unsigned)((hi - texels[k][3]) * scale + 0.5f);
+         const unsigned code = s == 0 ? 0 : s == 7 ? 1 : s + 1;
+
+         bits |= (uint64_t)code << (3 * k);
+      }
+   }
+
+   dst[0] = hi;
+   dst[1] = lo;
+   for (k = 0; k < 6; ++k)
+      dst[2 + k] = (bits >> (8 * k)) & 0xff;
+}
+
+
+/**
+ * Compress a width x height image with src_comps (3 or 4) bytes per pixel,
+ * with the interface of libtxc_dxtn's tx_compress_dxtn().  dst_stride is the
+ * distance between rows of blocks, or 0 if they are packed.  Blocks that
+ * overhang the image repeat its last row and column.
+ */
+static INLINE void
+dxtn_compress(int src_comps, int width, int height, const uint8_t *src,
+              unsigned dxt_type, uint8_t *dst, int dst_stride)
+{
+   const unsigned block_size = dxt_type < 2 ? 8 : 16;
+   int x, y, i, j, c;
+
+   if (dst_stride <= 0)
+      dst_stride = (width + 3) / 4 * block_size;
+
+   for (y = 0; y < height; y += 4) {
+      uint8_t *blk = dst + (y / 4) * dst_stride;
+
+      for (x = 0; x < width; x += 4) {
+         uint8_t texels[16][4];
+
+         for (j = 0; j < 4; ++j) {
+            for (i = 0; i < 4; ++i) {
+               const uint8_t *p = src + (MIN2(y + j, height - 1) * width +
+                                         MIN2(x + i, width - 1)) * src_comps;
+               for (c = 0; c < 3; ++c)
+                  texels[j * 4 + i][c] = p[c];
+               texels[j * 4 + i][3] = src_comps == 4 ? p[3] : 255;
+            }
+         }
+
+         switch (dxt_type) {
+         case 0:
+         case 1:
+            dxtn_encode_color_block(texels, dxt_type, blk);
+            break;
+         case 2:
+            dxt3_encode_alpha_block(texels, blk);
+            dxtn_encode_color_block(texels, dxt_type, blk + 8);
+            break;
+         default:
+            dxt5_encode_alpha_block(texels, blk);
+            dxtn_encode_color_block(texels, dxt_type, blk + 8);
+            break;
+         }
+
+         blk += block_size;
+      }
+   }
+}
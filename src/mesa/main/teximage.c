@@ -51,6 +51,7 @@
 #include "textureview.h"
 #include "mtypes.h"
 #include "glformats.h"
+#include "vbo/vbo.h"
 
 
 /**
@@ -4226,6 +4227,10 @@ texbufferrange(struct gl_context *ctx, GLenum target, GLenum internalFormat,
       return;
    }
 
+   /* Shader image stores can write the buffer */
+   if (bufObj)
+      vbo_disable_minmax_cache(bufObj);
+
    texObj = _mesa_get_current_tex_object(ctx, target);
 
    _mesa_lock_texture(ctx, texObj);
@@ -583,6 +583,75 @@ _mesa_propagate_uniforms_to_driver_storage(struct gl_uniform_storage *uni,
    }
 }
 
+/**
+ * Work out whether glUniform calls for the uniform can take the fast path
+ * of _mesa_uniform(), which is the case of float and integer scalars and
+ * vectors whose driver storage needs no conversion.  Booleans are
+ * converted, and samplers need the texture units updated.
+ *
+ * Called whenever the driver storage of the uniform changes.
+ */
+extern "C" void
+_mesa_uniform_update_fast_path(struct gl_uniform_storage *uni)
+{
+   const glsl_type *const type = uni->type;
+   unsigned i;
+
+   uni->fast_path.type = 0;
+   uni->fast_path.element_size = 0;
+
+   if (type->base_type != GLSL_TYPE_FLOAT &&
+       type->base_type != GLSL_TYPE_INT &&
+       type->base_type != GLSL_TYPE_UINT)
+      return;
+
+   if (!type->is_scalar() && !type->is_vector())
+      return;
+
+   for (i = 0; i < uni->num_driver_storage; i++) {
+      if (uni->driver_storage[i].format != uniform_native)
+         return;
+   }
+
+   uni->fast_path.type = type->gl_type;
+   uni->fast_path.element_size =
+      type->vector_elements * sizeof(uni->storage[0]);
+}
+
+/**
+ * Store count array elements of a uniform taking the fast path, starting
+ * at element offset.
+ */
+static void
+copy_uniform_values(struct gl_context *ctx, struct gl_uniform_storage *uni,
+                    unsigned offset, unsigned count, const GLvoid *values)
+{
+   const unsigned size = uni->fast_path.element_size;
+   unsigned i, j;
+
+   FLUSH_VERTICES(ctx, _NEW_PROGRAM_CONSTANTS);
+
+   memcpy((uint8_t *) uni->storage + offset * size, values, size * count);
+   uni->initialized = true;
+
+   for (i = 0; i < uni->num_driver_storage; i++) {
+      const struct gl_uniform_driver_storage *store = &uni->driver_storage[i];
+      uint8_t *dst = (uint8_t *) store->data + offset * store->element_stride;
+
+      if (count == 1 || store->element_stride == size) {
+         memcpy(dst, values, size * count);
+      } else {
+         const uint8_t *src = (const uint8_t *) values;
+
+         for (j = 0; j < count; j++) {
+            memcpy(dst, src, size);
+            src += size;
+            dst += store->element_stride;
+         }
+      }
+   }
+}
+
 /**
  * Called via glUniform*() functions.
  */
@@ -597,6 +666,32 @@ _mesa_uniform(struct gl_context *ctx, struct gl_shader_program *shProg,
    enum glsl_base_type basicType;
    struct gl_uniform_storage *uni;
 
+   /* Fast path: a valid call with values which only need copying.  Errors
+    * and everything else are left to the code below.
+    */
+   if (likely(shProg && shProg->LinkStatus && location >= 0 && count > 0 &&
+              !(ctx->Shader.Flags & GLSL_UNIFORMS))) {
+      _mesa_uniform_split_location_offset(shProg, location, &loc, &offset);
+
+      if (loc < shProg->NumUserUniformStorage) {
+         uni = &shProg->UniformStorage[loc];
+
+         if (uni->fast_path.type == type) {
+            if (uni->array_elements == 0) {
+               if (offset == 0 && count == 1) {
+                  copy_uniform_values(ctx, uni, 0, 1, values);
+                  return;
+               }
+            }
+            else if (offset < uni->array_elements) {
+               count = MIN2(count, (int) (uni->array_elements - offset));
+               copy_uniform_values(ctx, uni, offset, count, values);
+               return;
+            }
+         }
+      }
+   }
+
    if (!validate_uniform_parameters(ctx, shProg, location, count,
 				    &loc, &offset, "glUniform", false))
       return;
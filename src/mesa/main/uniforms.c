@@ -116,6 +116,8 @@ _mesa_uniform_attach_driver_storage(struct gl_uniform_storage *uni,
    uni->driver_storage[uni->num_driver_storage].data = data;
 
    uni->num_driver_storage++;
+
+   _mesa_uniform_update_fast_path(uni);
 }
 
 /**
@@ -131,6 +133,8 @@ _mesa_uniform_detach_all_driver_storage(struct gl_uniform_storage *uni)
    free(uni->driver_storage);
    uni->driver_storage = NULL;
    uni->num_driver_storage = 0;
+
+   _mesa_uniform_update_fast_path(uni);
 }
 
 void GLAPIENTRY
@@ -205,6 +205,9 @@ _mesa_uniform_attach_driver_storage(struct gl_uniform_storage *,
 extern void
 _mesa_uniform_detach_all_driver_storage(struct gl_uniform_storage *uni);
 
+extern void
+_mesa_uniform_update_fast_path(struct gl_uniform_storage *uni);
+
 extern void
 _mesa_propagate_uniforms_to_driver_storage(struct gl_uniform_storage *uni,
 					   unsigned array_index,
@@ -30,9 +30,12 @@
 #include "main/context.h"
 
 #include "pipe/p_defines.h"
+#include "os/os_time.h"
+#include "util/u_math.h"
 #include "st_context.h"
 #include "st_atom.h"
 #include "st_cb_bitmap.h"
+#include "st_debug.h"
 #include "st_program.h"
 #include "st_manager.h"
 
@@ -74,42 +77,111 @@ static const struct st_tracked_state *atoms[] =
 };
 
 
+/**
+ * Per-atom counters, kept with ST_DEBUG=atoms.
+ */
+struct st_atom_stats
+{
+   uint64_t calls;
+   int64_t nsecs;
+};
+
+
+/**
+ * Build the tables of the atoms depending on each state flag.
+ */
 void st_init_atoms( struct st_context *st )
 {
-   /* no-op */
+   GLuint i;
+
+   STATIC_ASSERT(Elements(atoms) <= 32);
+
+   memset(st->atoms_by_mesa_flag, 0, sizeof(st->atoms_by_mesa_flag));
+   memset(st->atoms_by_st_flag, 0, sizeof(st->atoms_by_st_flag));
+
+   for (i = 0; i < Elements(atoms); i++) {
+      const struct st_tracked_state *atom = atoms[i];
+      unsigned mask;
+
+      if (!(atom->dirty.mesa || atom->dirty.st) || !atom->update) {
+         debug_printf("malformed atom %s\n", atom->name);
+         assert(0);
+      }
+
+      mask = atom->dirty.mesa;
+      while (mask)
+         st->atoms_by_mesa_flag[u_bit_scan(&mask)] |= 1 << i;
+
+      mask = atom->dirty.st;
+      while (mask)
+         st->atoms_by_st_flag[u_bit_scan(&mask)] |= 1 << i;
+   }
+
+   if (ST_DEBUG & DEBUG_ATOMS)
+      st->atom_stats = calloc(Elements(atoms), sizeof(*st->atom_stats));
 }
 
 
 void st_destroy_atoms( struct st_context *st )
 {
-   /* no-op */
+   GLuint i;
+
+   if (!st->atom_stats)
+      return;
+
+   debug_printf("%-28s %10s %12s %10s\n", "atom", "calls", "total usecs",
+                "nsecs/call");
+   for (i = 0; i < Elements(atoms); i++) {
+      const struct st_atom_stats *stats = &st->atom_stats[i];
+
+      debug_printf("%-28s %10llu %12.0f %10.0f\n", atoms[i]->name,
+                   (unsigned long long) stats->calls,
+                   stats->nsecs / 1000.0,
+                   stats->calls ? (double) stats->nsecs / stats->calls : 0.0);
+   }
+
+   free(st->atom_stats);
+   st->atom_stats = NULL;
 }
 
 
 /***********************************************************************
  */
 
-static GLboolean check_state( const struct st_state_flags *a,
-			      const struct st_state_flags *b )
+/**
+ * Return the mask of the atoms depending on any of the flags.
+ */
+static GLuint atoms_for_state( const struct st_context *st,
+                               const struct st_state_flags *flags )
 {
-   return ((a->mesa & b->mesa) ||
-	   (a->st & b->st));
-}
+   GLuint result = 0;
+   unsigned mask;
 
-static void accumulate_state( struct st_state_flags *a,
-			      const struct st_state_flags *b )
-{
-   a->mesa |= b->mesa;
-   a->st |= b->st;
+   mask = flags->mesa;
+   while (mask)
+      result |= st->atoms_by_mesa_flag[u_bit_scan(&mask)];
+
+   mask = flags->st;
+   while (mask)
+      result |= st->atoms_by_st_flag[u_bit_scan(&mask)];
+
+   return result;
 }
 
 
-static void xor_states( struct st_state_flags *result,
-			     const struct st_state_flags *a,
-			      const struct st_state_flags *b )
+static void update_atom( struct st_context *st, GLuint i )
 {
-   result->mesa = a->mesa ^ b->mesa;
-   result->st = a->st ^ b->st;
+   if (unlikely(st->atom_stats)) {
+      int64_t start = os_time_get_nano();
+
+      atoms[i]->update( st );
+
+      st->atom_stats[i].calls++;
+      st->atom_stats[i].nsecs += os_time_get_nano() - start;
+   }
+   else {
+      atoms[i]->update( st );
+   }
 }
 
 
@@ -153,7 +225,7 @@ static void check_attrib_edgeflag(struct st_context *st)
 void st_validate_state( struct st_context *st )
 {
    struct st_state_flags *state = &st->dirty;
-   GLuint i;
+   GLuint pending, i;
 
    /* Get Mesa driver state. */
    st->dirty.st |= st->ctx->NewDriverState;
@@ -173,53 +245,28 @@ void st_validate_state( struct st_context *st )
 
    /*printf("%s %x/%x\n", __FUNCTION__, state->mesa, state->st);*/
 
-#ifdef DEBUG
-   if (1) {
-#else
-   if (0) {
-#endif
-      /* Debug version which enforces various sanity checks on the
-       * state flags which are generated and checked to help ensure
-       * state atoms are ordered correctly in the list.
-       */
-      struct st_state_flags examined, prev;      
-      memset(&examined, 0, sizeof(examined));
-      prev = *state;
-
-      for (i = 0; i < Elements(atoms); i++) {	 
-	 const struct st_tracked_state *atom = atoms[i];
-	 struct st_state_flags generated;
-	 
-	 /*printf("atom %s %x/%x\n", atom->name, atom->dirty.mesa, atom->dirty.st);*/
-
-	 if (!(atom->dirty.mesa || atom->dirty.st) ||
-	     !atom->update) {
-	    printf("malformed atom %s\n", atom->name);
-	    assert(0);
-	 }
-
-	 if (check_state(state, &atom->dirty)) {
-	    atoms[i]->update( st );
-	    /*printf("after: %x\n", atom->dirty.mesa);*/
-	 }
-
-	 accumulate_state(&examined, &atom->dirty);
-
-	 /* generated = (prev ^ state)
-	  * if (examined & generated)
-	  *     fail;
-	  */
-	 xor_states(&generated, &prev, state);
-	 assert(!check_state(&examined, &generated));
-	 prev = *state;
-      }
-      /*printf("\n");*/
+   /* Only visit the atoms depending on the dirty flags, in order.  Atoms
+    * may dirty more state for the atoms after them, so look again at the
+    * flags after each update.
+    */
+   pending = atoms_for_state(st, state);
 
-   }
-   else {
-      for (i = 0; i < Elements(atoms); i++) {	 
-	 if (check_state(state, &atoms[i]->dirty))
-	    atoms[i]->update( st );
+   while (pending) {
+      struct st_state_flags prev = *state, generated;
+
+      i = u_bit_scan(&pending);
+      update_atom(st, i);
+
+      generated.mesa = prev.mesa ^ state->mesa;
+      generated.st = prev.st ^ state->st;
+      if (generated.mesa | generated.st) {
+         GLuint needed = atoms_for_state(st, &generated);
+         GLuint done;
+
+         /* Make sure the atoms are ordered correctly in the list. */
+         done = (2u << i) - 1;
+         assert(!(needed & done));
+         pending |= needed & ~done;
       }
    }
 
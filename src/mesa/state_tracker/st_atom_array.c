@@ -537,15 +537,127 @@ setup_non_interleaved_attribs(struct st_context *st,
    return TRUE;
 }
 
+/**
+ * Is the vertex state cached in the array object what we'd derive from
+ * the arrays for the current vertex shader?  It is if the inputs are fed
+ * by the same arrays of the array object as when it was cached.
+ */
+static GLboolean
+is_cached_vertex_state_valid(const struct st_array_object *arrayObj,
+                             const struct st_vertex_program *vp,
+                             const struct st_vp_variant *vpv,
+                             const struct gl_client_array **arrays)
+{
+   GLuint attr;
+
+   if (!arrayObj->vertex_state_valid ||
+       arrayObj->num_inputs != vpv->num_inputs)
+      return GL_FALSE;
+
+   for (attr = 0; attr < vpv->num_inputs; attr++) {
+      const GLuint mesaAttr = vp->index_to_input[attr];
+
+      if (arrayObj->input[attr] != mesaAttr ||
+          arrays[mesaAttr] !=
+          &arrayObj->Base._VertexAttrib[arrayObj->input_array[attr]])
+         return GL_FALSE;
+   }
+
+   return GL_TRUE;
+}
+
+/**
+ * Save the vertex state derived from the arrays in the array object, if
+ * all the inputs come from its arrays.  Inputs fed by the current vertex
+ * attribute values or by the VBO module's own arrays (glBegin/End,
+ * display lists, split draws) are not cached.
+ */
+static void
+cache_vertex_state(struct st_array_object *arrayObj,
+                   const struct st_vertex_program *vp,
+                   const struct st_vp_variant *vpv,
+                   const struct gl_client_array **arrays,
+                   GLboolean interleaved,
+                   const struct pipe_vertex_buffer vbuffer[],
+                   unsigned num_vbuffers,
+                   const struct pipe_vertex_element velements[],
+                   unsigned num_velements)
+{
+   const struct gl_client_array *first = &arrayObj->Base._VertexAttrib[0];
+   GLuint attr, i;
+
+   arrayObj->vertex_state_valid = GL_FALSE;
+
+   for (attr = 0; attr < vpv->num_inputs; attr++) {
+      const GLuint mesaAttr = vp->index_to_input[attr];
+      const struct gl_client_array *array = arrays[mesaAttr];
+
+      if (array < first || array >= first + VERT_ATTRIB_MAX)
+         return;
+
+      arrayObj->input[attr] = mesaAttr;
+      arrayObj->input_array[attr] = array - first;
+   }
+   arrayObj->num_inputs = vpv->num_inputs;
+
+   for (i = 0; i < num_vbuffers; i++) {
+      arrayObj->vbuffer[i] = vbuffer[i];
+      arrayObj->vbuffer[i].buffer = NULL;
+      arrayObj->vbuffer_array[i] =
+         arrayObj->input_array[interleaved ? 0 : i];
+   }
+   arrayObj->num_vbuffers = num_vbuffers;
+
+   memcpy(arrayObj->velements, velements,
+          sizeof(struct pipe_vertex_element) * num_velements);
+   arrayObj->num_velements = num_velements;
+   arrayObj->velements_hash = cso_hash_vertex_elements(num_velements,
+                                                       velements);
+
+   arrayObj->vertex_state_valid = GL_TRUE;
+}
+
+/**
+ * Set up the vertex buffers from the vertex state cached in the array
+ * object, with the current storage of the buffer objects.
+ * \param vbuffer  returns vertex buffer info
+ */
+static boolean
+setup_cached_attribs(const struct st_array_object *arrayObj,
+                     struct pipe_vertex_buffer vbuffer[])
+{
+   unsigned i;
+
+   for (i = 0; i < arrayObj->num_vbuffers; i++) {
+      const struct gl_client_array *array =
+         &arrayObj->Base._VertexAttrib[arrayObj->vbuffer_array[i]];
+
+      vbuffer[i] = arrayObj->vbuffer[i];
+
+      if (_mesa_is_bufferobj(array->BufferObj)) {
+         struct st_buffer_object *stobj = st_buffer_object(array->BufferObj);
+
+         if (!stobj->buffer) {
+            return FALSE; /* out-of-memory error probably */
+         }
+
+         vbuffer[i].buffer = stobj->buffer;
+      }
+   }
+   return TRUE;
+}
+
 static void update_array(struct st_context *st)
 {
    struct gl_context *ctx = st->ctx;
    const struct gl_client_array **arrays = ctx->Array._DrawArrays;
+   struct st_array_object *arrayObj = st_array_object(ctx->Array.ArrayObj);
    const struct st_vertex_program *vp;
    const struct st_vp_variant *vpv;
    struct pipe_vertex_buffer vbuffer[PIPE_MAX_SHADER_INPUTS];
    struct pipe_vertex_element velements[PIPE_MAX_ATTRIBS];
    unsigned num_vbuffers, num_velements;
+   GLboolean interleaved;
 
    st->vertex_array_out_of_memory = FALSE;
 
@@ -557,31 +669,48 @@ static void update_array(struct st_context *st)
    vp = st->vp;
    vpv = st->vp_variant;
 
-   memset(velements, 0, sizeof(struct pipe_vertex_element) * vpv->num_inputs);
-
-   /*
-    * Setup the vbuffer[] and velements[] arrays.
-    */
-   if (is_interleaved_arrays(vp, vpv, arrays)) {
-      if (!setup_interleaved_attribs(vp, vpv, arrays, vbuffer, velements)) {
+   if (is_cached_vertex_state_valid(arrayObj, vp, vpv, arrays)) {
+      /* Only the buffers may have a new storage since it was cached */
+      if (!setup_cached_attribs(arrayObj, vbuffer)) {
          st->vertex_array_out_of_memory = TRUE;
          return;
       }
 
-      num_vbuffers = 1;
-      num_velements = vpv->num_inputs;
-      if (num_velements == 0)
-         num_vbuffers = 0;
+      num_vbuffers = arrayObj->num_vbuffers;
    }
    else {
-      if (!setup_non_interleaved_attribs(st, vp, vpv, arrays, vbuffer,
-                                         velements)) {
-         st->vertex_array_out_of_memory = TRUE;
-         return;
+      memset(velements, 0,
+             sizeof(struct pipe_vertex_element) * vpv->num_inputs);
+
+      /*
+       * Setup the vbuffer[] and velements[] arrays.
+       */
+      interleaved = is_interleaved_arrays(vp, vpv, arrays);
+      if (interleaved) {
+         if (!setup_interleaved_attribs(vp, vpv, arrays, vbuffer,
+                                        velements)) {
+            st->vertex_array_out_of_memory = TRUE;
+            return;
+         }
+
+         num_vbuffers = 1;
+         num_velements = vpv->num_inputs;
+         if (num_velements == 0)
+            num_vbuffers = 0;
+      }
+      else {
+         if (!setup_non_interleaved_attribs(st, vp, vpv, arrays, vbuffer,
+                                            velements)) {
+            st->vertex_array_out_of_memory = TRUE;
+            return;
+         }
+
+         num_vbuffers = vpv->num_inputs;
+         num_velements = vpv->num_inputs;
       }
 
-      num_vbuffers = vpv->num_inputs;
-      num_velements = vpv->num_inputs;
+      cache_vertex_state(arrayObj, vp, vpv, arrays, interleaved,
+                         vbuffer, num_vbuffers, velements, num_velements);
    }
 
    cso_set_vertex_buffers(st->cso_context, 0, num_vbuffers, vbuffer);
@@ -591,7 +720,14 @@ static void update_array(struct st_context *st)
                              st->last_num_vbuffers - num_vbuffers, NULL);
    }
    st->last_num_vbuffers = num_vbuffers;
-   cso_set_vertex_elements(st->cso_context, num_velements, velements);
+
+   if (arrayObj->vertex_state_valid)
+      cso_set_vertex_elements_hashed(st->cso_context,
+                                     arrayObj->num_velements,
+                                     arrayObj->velements,
+                                     arrayObj->velements_hash);
+   else
+      cso_set_vertex_elements(st->cso_context, num_velements, velements);
 }
 
 
@@ -48,6 +48,47 @@
 #include "st_program.h"
 #include "st_cb_bufferobjects.h"
 
+/**
+ * Whether the constants bound to the stage are the same as params.
+ * glUniform and state changes flag the constants of all the stages as
+ * dirty, so most of the time only one stage really changed.
+ */
+static boolean
+constants_unchanged(const struct st_context *st,
+                    const struct gl_program_parameter_list *params,
+                    unsigned shader_type, unsigned paramBytes)
+{
+   return st->state.constants[shader_type].ptr == params->ParameterValues &&
+          st->state.constants[shader_type].size == paramBytes &&
+          st->state.constants[shader_type].shadow_size >= paramBytes &&
+          memcmp(st->state.constants[shader_type].shadow,
+                 params->ParameterValues, paramBytes) == 0;
+}
+
+
+/**
+ * Remember the constants bound to the stage.
+ */
+static void
+update_shadow(struct st_context *st,
+              const struct gl_program_parameter_list *params,
+              unsigned shader_type, unsigned paramBytes)
+{
+   void *shadow = st->state.constants[shader_type].shadow;
+
+   if (st->state.constants[shader_type].shadow_size < paramBytes) {
+      free(shadow);
+      shadow = malloc(paramBytes);
+      st->state.constants[shader_type].shadow = shadow;
+      st->state.constants[shader_type].shadow_size = shadow ? paramBytes : 0;
+   }
+
+   /* Without a copy, every update uploads */
+   if (shadow)
+      memcpy(shadow, params->ParameterValues, paramBytes);
+}
+
+
 /**
  * Pass the given program parameters to the graphics pipe as a
  * constant buffer.
@@ -73,6 +114,9 @@ void st_upload_constants( struct st_context *st,
        */
       _mesa_load_state_parameters(st->ctx, params);
 
+      if (constants_unchanged(st, params, shader_type, paramBytes))
+         return;
+
       /* We always need to get a new buffer, to keep the drivers simple and
        * avoid gratuitous rendering synchronization.
        * Let's use a user buffer to avoid an unnecessary copy.
@@ -100,6 +144,7 @@ void st_upload_constants( struct st_context *st,
       cso_set_constant_buffer(st->cso_context, shader_type, 0, &cb);
       pipe_resource_reference(&cb.buffer, NULL);
 
+      update_shadow(st, params, shader_type, paramBytes);
       st->state.constants[shader_type].ptr = params->ParameterValues;
       st->state.constants[shader_type].size = paramBytes;
    }
@@ -181,9 +181,9 @@ st_bufferobj_data(struct gl_context *ctx,
    struct st_context *st = st_context(ctx);
    struct pipe_context *pipe = st->pipe;
    struct st_buffer_object *st_obj = st_buffer_object(obj);
-   unsigned bind, pipe_usage;
+   unsigned bind, pipe_usage, pipe_flags = 0;
 
-   if (size && data && st_obj->buffer &&
+   if (size && data && st_obj->buffer && !obj->Immutable &&
        st_obj->Base.Size == size && st_obj->Base.Usage == usage) {
       /* Just discard the old contents and write new data.
        * This should be the same as creating a new buffer, but we avoid
@@ -245,6 +245,16 @@ st_bufferobj_data(struct gl_context *ctx,
       pipe_usage = PIPE_USAGE_DEFAULT;
    }
 
+   /* glBufferStorage() */
+   if (obj->Immutable) {
+      if (obj->StorageFlags & GL_CLIENT_STORAGE_BIT)
+         pipe_usage = PIPE_USAGE_STAGING;
+      if (obj->StorageFlags & GL_MAP_PERSISTENT_BIT)
+         pipe_flags |= PIPE_RESOURCE_FLAG_MAP_PERSISTENT;
+      if (obj->StorageFlags & GL_MAP_COHERENT_BIT)
+         pipe_flags |= PIPE_RESOURCE_FLAG_MAP_COHERENT;
+   }
+
    pipe_resource_reference( &st_obj->buffer, NULL );
 
    if (ST_DEBUG & DEBUG_BUFFER) {
@@ -252,8 +262,20 @@ st_bufferobj_data(struct gl_context *ctx,
    }
 
    if (size != 0) {
-      st_obj->buffer = pipe_buffer_create(pipe->screen, bind,
-                                          pipe_usage, size);
+      struct pipe_resource buffer;
+
+      memset(&buffer, 0, sizeof buffer);
+      buffer.target = PIPE_BUFFER;
+      buffer.format = PIPE_FORMAT_R8_UNORM; /* want TYPELESS or similar */
+      buffer.bind = bind;
+      buffer.usage = pipe_usage;
+      buffer.flags = pipe_flags;
+      buffer.width0 = size;
+      buffer.height0 = 1;
+      buffer.depth0 = 1;
+      buffer.array_size = 1;
+
+      st_obj->buffer = pipe->screen->resource_create(pipe->screen, &buffer);
 
       if (!st_obj->buffer) {
          /* out of memory */
@@ -272,6 +294,25 @@ st_bufferobj_data(struct gl_context *ctx,
 }
 
 
+/**
+ * Make the persistent mapping put aside by st_bufferobj_map_range() the
+ * current one again.
+ */
+static void
+restore_saved_map(struct st_buffer_object *st_obj)
+{
+   struct gl_buffer_object *obj = &st_obj->Base;
+
+   st_obj->transfer = st_obj->saved_map.transfer;
+   obj->Pointer = st_obj->saved_map.Pointer;
+   obj->Offset = st_obj->saved_map.Offset;
+   obj->Length = st_obj->saved_map.Length;
+   obj->AccessFlags = st_obj->saved_map.AccessFlags;
+
+   memset(&st_obj->saved_map, 0, sizeof(st_obj->saved_map));
+}
+
+
 /**
  * Called via glMapBufferRange().
  */
@@ -306,6 +347,12 @@ st_bufferobj_map_range(struct gl_context *ctx,
    if (access & GL_MAP_UNSYNCHRONIZED_BIT)
       flags |= PIPE_TRANSFER_UNSYNCHRONIZED;
 
+   if (access & GL_MAP_PERSISTENT_BIT)
+      flags |= PIPE_TRANSFER_PERSISTENT;
+
+   if (access & GL_MAP_COHERENT_BIT)
+      flags |= PIPE_TRANSFER_COHERENT;
+
    /* ... other flags ...
     */
 
@@ -317,6 +364,22 @@ st_bufferobj_map_range(struct gl_context *ctx,
    assert(offset < obj->Size);
    assert(offset + length <= obj->Size);
 
+   if (obj->Pointer) {
+      /* Only a persistent mapping may be in place here, while Mesa reads
+       * or writes the buffer (index range scan, PBO, etc.).  Gallium is
+       * fine with several transfers of a resource, so just put it aside
+       * until this mapping goes away.
+       */
+      assert(obj->AccessFlags & GL_MAP_PERSISTENT_BIT);
+      assert(!st_obj->saved_map.Pointer);
+
+      st_obj->saved_map.transfer = st_obj->transfer;
+      st_obj->saved_map.Pointer = obj->Pointer;
+      st_obj->saved_map.Offset = obj->Offset;
+      st_obj->saved_map.Length = obj->Length;
+      st_obj->saved_map.AccessFlags = obj->AccessFlags;
+   }
+
    obj->Pointer = pipe_buffer_map_range(pipe,
                                         st_obj->buffer,
                                         offset, length,
@@ -326,12 +389,15 @@ st_bufferobj_map_range(struct gl_context *ctx,
       obj->Offset = offset;
       obj->Length = length;
       obj->AccessFlags = access;
+      return obj->Pointer;
    }
-   else {
-      st_obj->transfer = NULL;
-   }
 
-   return obj->Pointer;
+   st_obj->transfer = NULL;
+
+   if (st_obj->saved_map.Pointer)
+      restore_saved_map(st_obj);
+
+   return NULL;
 }
 
 
@@ -369,6 +435,12 @@ st_bufferobj_unmap(struct gl_context *ctx, struct gl_buffer_object *obj)
    if (obj->Length)
       pipe_buffer_unmap(pipe, st_obj->transfer);
 
+   if (st_obj->saved_map.Pointer) {
+      /* Back to the application's persistent mapping */
+      restore_saved_map(st_obj);
+      return GL_TRUE;
+   }
+
    st_obj->transfer = NULL;
    obj->Pointer = NULL;
    obj->Offset = 0;
@@ -396,8 +468,8 @@ st_copy_buffer_subdata(struct gl_context *ctx,
       return;
 
    /* buffer should not already be mapped */
-   assert(!src->Pointer);
-   assert(!dst->Pointer);
+   assert(!_mesa_check_disallowed_mapping(src));
+   assert(!_mesa_check_disallowed_mapping(dst));
 
    u_box_1d(readOffset, size, &box);
 
@@ -419,6 +491,23 @@ st_bufferobj_validate_usage(struct st_context *st,
 }
 
 
+/**
+ * Called via ctx->Driver.NewArrayObject()
+ */
+static struct gl_array_object *
+st_arrayobj_alloc(struct gl_context *ctx, GLuint name)
+{
+   struct st_array_object *st_obj = ST_CALLOC_STRUCT(st_array_object);
+
+   if (!st_obj)
+      return NULL;
+
+   _mesa_initialize_array_object(ctx, &st_obj->Base, name);
+
+   return &st_obj->Base;
+}
+
+
 void
 st_init_bufferobject_functions(struct dd_function_table *functions)
 {
@@ -436,6 +525,6 @@ st_init_bufferobject_functions(struct dd_function_table *functions)
    functions->CopyBufferSubData = st_copy_buffer_subdata;
 
    /* For GL_APPLE_vertex_array_object */
-   functions->NewArrayObject = _mesa_new_array_object;
+   functions->NewArrayObject = st_arrayobj_alloc;
    functions->DeleteArrayObject = _mesa_delete_array_object;
 }
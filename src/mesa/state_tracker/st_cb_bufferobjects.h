@@ -30,6 +30,7 @@
 
 #include "main/compiler.h"
 #include "main/mtypes.h"
+#include "pipe/p_state.h"
 
 struct dd_function_table;
 struct pipe_resource;
@@ -44,6 +45,18 @@ struct st_buffer_object
    struct gl_buffer_object Base;
    struct pipe_resource *buffer;     /* GPU storage */
    struct pipe_transfer *transfer; /* In-progress map information */
+
+   /**
+    * The application's persistent mapping (GL_ARB_buffer_storage), put
+    * aside while Mesa maps the buffer once more for its own use.
+    */
+   struct {
+      struct pipe_transfer *transfer;
+      GLvoid *Pointer;
+      GLintptr Offset;
+      GLsizeiptr Length;
+      GLbitfield AccessFlags;
+   } saved_map;
 };
 
 
@@ -55,6 +68,47 @@ st_buffer_object(struct gl_buffer_object *obj)
 }
 
 
+/**
+ * State_tracker vertex array object, derived from Mesa's gl_array_object.
+ * Caches the gallium vertex state st_update_array derived from it, so
+ * switching between array objects doesn't rebuild it.
+ */
+struct st_array_object
+{
+   struct gl_array_object Base;
+
+   /** Is the vertex state below up to date with the array object? */
+   GLboolean vertex_state_valid;
+
+   /** VERT_ATTRIB_x of each vertex shader input */
+   GLubyte input[PIPE_MAX_SHADER_INPUTS];
+   /** Index of the _VertexAttrib[] array feeding each input */
+   GLubyte input_array[PIPE_MAX_SHADER_INPUTS];
+   GLuint num_inputs;
+
+   /**
+    * Vertex buffers, without the buffer resources which are looked up
+    * from _VertexAttrib[vbuffer_array[i]] at bind time.
+    */
+   struct pipe_vertex_buffer vbuffer[PIPE_MAX_ATTRIBS];
+   GLubyte vbuffer_array[PIPE_MAX_ATTRIBS];
+   unsigned num_vbuffers;
+
+   struct pipe_vertex_element velements[PIPE_MAX_ATTRIBS];
+   unsigned num_velements;
+   /** cso_hash_vertex_elements() of velements */
+   unsigned velements_hash;
+};
+
+
+/** cast wrapper */
+static INLINE struct st_array_object *
+st_array_object(struct gl_array_object *obj)
+{
+   return (struct st_array_object *) obj;
+}
+
+
 extern void
 st_bufferobj_validate_usage(struct st_context *st,
 			    struct st_buffer_object *obj,
@@ -43,6 +43,141 @@
 #include "state_tracker/st_format.h"
 #include "state_tracker/st_texture.h"
 
+#if HAVE_LLVM
+#include "gallivm/lp_bld_format_translate.h"
+#endif
+
+
+#if HAVE_LLVM
+/**
+ * Read the renderbuffer directly with a row converter compiled by gallivm,
+ * for drivers which don't do texture transfers with blits.  Only used when
+ * ST_JIT_TRANSFERS is set.
+ *
+ * \return GL_TRUE if the pixels were read.
+ */
+static GLboolean
+try_jit_readpixels(struct gl_context *ctx, GLint x, GLint y,
+                   GLsizei width, GLsizei height,
+                   GLenum format, GLenum type,
+                   const struct gl_pixelstore_attrib *pack,
+                   GLvoid *pixels)
+{
+   struct st_context *st = st_context(ctx);
+   struct gl_renderbuffer *rb =
+         _mesa_get_read_renderbuffer_for_format(ctx, format);
+   struct st_renderbuffer *strb = st_renderbuffer(rb);
+   struct pipe_context *pipe = st->pipe;
+   struct pipe_screen *screen = pipe->screen;
+   struct gl_pixelstore_attrib clippedPacking = *pack;
+   struct pipe_resource *src;
+   struct pipe_transfer *tex_xfer;
+   enum pipe_format dst_format, src_format;
+   lp_format_translate_func translate;
+   GLint stride;
+   GLubyte *map;
+   GLuint row;
+
+   if (!st->format_translate_cache) {
+      return GL_FALSE;
+   }
+
+   if (!strb || !strb->texture || !strb->surface ||
+       pack->SwapBytes || pack->Invert) {
+      return GL_FALSE;
+   }
+
+   src = strb->texture;
+
+   switch (rb->_BaseFormat) {
+   case GL_RGBA:
+   case GL_RGB:
+   case GL_RG:
+   case GL_RED:
+   case GL_ALPHA:
+      break;
+   default:
+      return GL_FALSE;
+   }
+
+   if (rb->_BaseFormat != _mesa_get_format_base_format(rb->Format) ||
+       _mesa_format_matches_format_and_type(rb->Format, format, type,
+                                            GL_FALSE) ||
+       _mesa_readpixels_needs_slow_path(ctx, format, type, GL_TRUE)) {
+      return GL_FALSE;
+   }
+
+   src_format = util_format_linear(src->format);
+   dst_format = st_choose_matching_format(screen, PIPE_BIND_TRANSFER_READ,
+                                          format, type, GL_FALSE);
+   if (!dst_format ||
+       util_format_is_luminance(dst_format) ||
+       util_format_is_luminance_alpha(dst_format) ||
+       util_format_is_intensity(dst_format) ||
+       !lp_format_translate_supported(dst_format, src_format)) {
+      return GL_FALSE;
+   }
+
+   /* Byte swizzles between the 8-bit RGBA layouts are left to core Mesa,
+    * which does them with SIMD shuffles rather than a float round trip.
+    */
+   if (util_format_is_rgba8_variant(util_format_description(dst_format)) &&
+       util_format_is_rgba8_variant(util_format_description(src_format))) {
+      return GL_FALSE;
+   }
+
+   translate = lp_get_format_translate_func(st->format_translate_cache,
+                                            dst_format, src_format);
+   if (!translate) {
+      return GL_FALSE;
+   }
+
+   /* Only read what is inside the framebuffer, skipping the pixels and
+    * rows of the destination which are outside. */
+   if (!_mesa_clip_readpixels(ctx, &x, &y, &width, &height,
+                              &clippedPacking)) {
+      return GL_TRUE;
+   }
+
+   if (st_fb_orientation(ctx->ReadBuffer) == Y_0_TOP) {
+      y = rb->Height - y - height;
+   }
+
+   map = pipe_transfer_map(pipe, src, strb->surface->u.tex.level,
+                           strb->surface->u.tex.first_layer,
+                           PIPE_TRANSFER_READ, x, y, width, height,
+                           &tex_xfer);
+   if (!map) {
+      return GL_FALSE;
+   }
+
+   /* GL's rows go bottom to top. */
+   stride = tex_xfer->stride;
+   if (st_fb_orientation(ctx->ReadBuffer) == Y_0_TOP) {
+      map += (height - 1) * stride;
+      stride = -stride;
+   }
+
+   pixels = _mesa_map_pbo_dest(ctx, &clippedPacking, pixels);
+   if (!pixels) {
+      pipe_transfer_unmap(pipe, tex_xfer);
+      return GL_FALSE;
+   }
+
+   for (row = 0; row < (unsigned) height; row++) {
+      GLvoid *dest = _mesa_image_address2d(&clippedPacking, pixels,
+                                           width, height,
+                                           format, type, row, 0);
+      translate(dest, map, width);
+      map += stride;
+   }
+
+   pipe_transfer_unmap(pipe, tex_xfer);
+   _mesa_unmap_pbo_dest(ctx, &clippedPacking);
+   return GL_TRUE;
+}
+#endif
+
 
 /**
  * This uses a blit to copy the read buffer to a texture format which matches
@@ -84,6 +219,12 @@ st_readpixels(struct gl_context *ctx, GLint x, GLint y,
    st_flush_bitmap_cache(st);
 
    if (!st->prefer_blit_based_texture_transfer) {
+#if HAVE_LLVM
+      if (try_jit_readpixels(ctx, x, y, width, height,
+                             format, type, pack, pixels)) {
+         return;
+      }
+#endif
       goto fallback;
    }
 
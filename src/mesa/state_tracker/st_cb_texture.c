@@ -64,6 +64,10 @@
 #include "util/u_math.h"
 #include "util/u_box.h"
 
+#if HAVE_LLVM
+#include "gallivm/lp_bld_format_translate.h"
+#endif
+
 #define DBG if (0) printf
 
 
@@ -585,6 +589,190 @@ st_get_blit_mask(GLenum srcFormat, GLenum dstFormat)
 }
 
 
+/**
+ * Upload from a pixel unpack buffer whose contents already have the
+ * texture's format: map the buffer and the whole destination box once and
+ * copy straight across, instead of going through texstore and mapping
+ * the texture a slice at a time.
+ *
+ * \return GL_TRUE if the upload was done (or a GL error was recorded).
+ */
+static GLboolean
+try_pbo_upload_memcpy(struct gl_context *ctx, GLuint dims,
+                      struct gl_texture_image *texImage,
+                      GLint xoffset, GLint yoffset, GLint zoffset,
+                      GLint width, GLint height, GLint depth,
+                      GLenum format, GLenum type, const void *pixels,
+                      const struct gl_pixelstore_attrib *unpack)
+{
+   struct st_context *st = st_context(ctx);
+   struct st_texture_image *stImage = st_texture_image(texImage);
+   const GLubyte *src;
+   GLint row_stride, image_stride;
+   GLubyte *map;
+
+   if (!stImage->pt) {
+      return GL_FALSE;
+   }
+
+   /* GL keeps the layers of 1D arrays in y, gallium in z. */
+   if (texImage->TexObject->Target == GL_TEXTURE_1D_ARRAY) {
+      return GL_FALSE;
+   }
+
+   if (!_mesa_format_matches_format_and_type(texImage->TexFormat, format,
+                                             type, unpack->SwapBytes) ||
+       !_mesa_texstore_can_use_memcpy(ctx, texImage->_BaseFormat,
+                                      texImage->TexFormat, format, type,
+                                      unpack)) {
+      return GL_FALSE;
+   }
+
+   src = _mesa_validate_pbo_teximage(ctx, dims, width, height, depth,
+                                     format, type, pixels, unpack,
+                                     "glTexSubImage");
+   if (!src) {
+      /* This is a GL error. */
+      return GL_TRUE;
+   }
+
+   row_stride = _mesa_image_row_stride(unpack, width, format, type);
+   image_stride = _mesa_image_image_stride(unpack, width, height,
+                                           format, type);
+   src = _mesa_image_address(dims, unpack, src, width, height,
+                             format, type, 0, 0, 0);
+
+   map = st_texture_image_map(st, stImage,
+                              PIPE_TRANSFER_WRITE | PIPE_TRANSFER_DISCARD_RANGE,
+                              xoffset, yoffset, zoffset,
+                              width, height, depth);
+   if (!map) {
+      _mesa_unmap_teximage_pbo(ctx, unpack);
+      return GL_FALSE;
+   }
+
+   util_copy_box(map, stImage->pt->format,
+                 stImage->transfer->stride, stImage->transfer->layer_stride,
+                 0, 0, 0, width, height, depth,
+                 src, row_stride, image_stride, 0, 0, 0);
+
+   st_texture_image_unmap(st, stImage);
+   _mesa_unmap_teximage_pbo(ctx, unpack);
+   return GL_TRUE;
+}
+
+
+#if HAVE_LLVM
+/**
+ * Upload with a row converter compiled by gallivm, for the format and type
+ * combinations texstore would otherwise convert a texel at a time through
+ * floats.  Only used when ST_JIT_TRANSFERS is set.
+ *
+ * The converters round to nearest.  texstore truncates when it packs 8-bit
+ * data into 5- and 6-bit channels, so those texels may come out one unit
+ * higher than without the converters.
+ *
+ * \return GL_TRUE if the upload was done (or a GL error was recorded).
+ */
+static GLboolean
+try_jit_upload(struct gl_context *ctx, GLuint dims,
+               struct gl_texture_image *texImage,
+               GLint xoffset, GLint yoffset, GLint zoffset,
+               GLint width, GLint height, GLint depth,
+               GLenum format, GLenum type, const void *pixels,
+               const struct gl_pixelstore_attrib *unpack)
+{
+   struct st_context *st = st_context(ctx);
+   struct st_texture_image *stImage = st_texture_image(texImage);
+   struct pipe_screen *screen = st->pipe->screen;
+   enum pipe_format src_format, dst_format;
+   lp_format_translate_func translate;
+   const GLubyte *src;
+   GLubyte *map;
+   GLint img, row;
+
+   if (!st->format_translate_cache) {
+      return GL_FALSE;
+   }
+
+   if (!stImage->pt ||
+       (!pixels && !_mesa_is_bufferobj(unpack->BufferObj))) {
+      return GL_FALSE;
+   }
+
+   /* GL keeps the layers of 1D arrays in y, gallium in z. */
+   if (texImage->TexObject->Target == GL_TEXTURE_1D_ARRAY) {
+      return GL_FALSE;
+   }
+
+   if (ctx->_ImageTransferState || unpack->SwapBytes) {
+      return GL_FALSE;
+   }
+
+   /* Leave the memcpy and the cases needing the texstore rules for
+    * filling in missing components to texstore. */
+   if (texImage->_BaseFormat !=
+       _mesa_get_format_base_format(texImage->TexFormat) ||
+       _mesa_format_matches_format_and_type(texImage->TexFormat, format,
+                                            type, GL_FALSE)) {
+      return GL_FALSE;
+   }
+
+   /* texstore already swizzles bytes into these without going to float. */
+   dst_format = util_format_linear(stImage->pt->format);
+   if (type == GL_UNSIGNED_BYTE &&
+       util_format_is_rgba8_variant(util_format_description(dst_format))) {
+      return GL_FALSE;
+   }
+
+   src_format = st_choose_matching_format(screen, PIPE_BIND_TRANSFER_WRITE,
+                                          format, type, GL_FALSE);
+   if (!src_format ||
+       !lp_format_translate_supported(dst_format, src_format)) {
+      return GL_FALSE;
+   }
+
+   translate = lp_get_format_translate_func(st->format_translate_cache,
+                                            dst_format, src_format);
+   if (!translate) {
+      return GL_FALSE;
+   }
+
+   src = _mesa_validate_pbo_teximage(ctx, dims, width, height, depth,
+                                     format, type, pixels, unpack,
+                                     "glTexSubImage");
+   if (!src) {
+      /* This is a GL error. */
+      return GL_TRUE;
+   }
+
+   map = st_texture_image_map(st, stImage,
+                              PIPE_TRANSFER_WRITE | PIPE_TRANSFER_DISCARD_RANGE,
+                              xoffset, yoffset, zoffset,
+                              width, height, depth);
+   if (!map) {
+      _mesa_unmap_teximage_pbo(ctx, unpack);
+      return GL_FALSE;
+   }
+
+   for (img = 0; img < depth; img++) {
+      for (row = 0; row < height; row++) {
+         const GLubyte *src_row =
+            _mesa_image_address(dims, unpack, src, width, height,
+                                format, type, img, row, 0);
+
+         translate(map + img * stImage->transfer->layer_stride +
+                   row * stImage->transfer->stride, src_row, width);
+      }
+   }
+
+   st_texture_image_unmap(st, stImage);
+   _mesa_unmap_teximage_pbo(ctx, unpack);
+   return GL_TRUE;
+}
+#endif
+
+
 static void
 st_TexSubImage(struct gl_context *ctx, GLuint dims,
                struct gl_texture_image *texImage,
@@ -609,7 +797,21 @@ st_TexSubImage(struct gl_context *ctx, GLuint dims,
    unsigned bind;
    GLubyte *map;
 
+   if (_mesa_is_bufferobj(unpack->BufferObj) &&
+       try_pbo_upload_memcpy(ctx, dims, texImage, xoffset, yoffset, zoffset,
+                             width, height, depth, format, type, pixels,
+                             unpack)) {
+      return;
+   }
+
    if (!st->prefer_blit_based_texture_transfer) {
+#if HAVE_LLVM
+      if (try_jit_upload(ctx, dims, texImage, xoffset, yoffset, zoffset,
+                         width, height, depth, format, type, pixels,
+                         unpack)) {
+         return;
+      }
+#endif
       goto fallback;
    }
 
@@ -826,6 +1028,186 @@ st_CompressedTexImage(struct gl_context *ctx, GLuint dims,
 
 
 
+/**
+ * The glGetTexImage counterpart of try_pbo_upload_memcpy(): read the whole
+ * image into a pixel pack buffer with a single map of each side when no
+ * conversion is needed.  Unlike the core memcpy path this also covers 3D
+ * and array textures.
+ *
+ * \return GL_TRUE if the download was done.
+ */
+static GLboolean
+try_pbo_download_memcpy(struct gl_context *ctx,
+                        GLenum format, GLenum type, GLvoid *pixels,
+                        struct gl_texture_image *texImage)
+{
+   struct st_context *st = st_context(ctx);
+   struct st_texture_image *stImage = st_texture_image(texImage);
+   const struct gl_pixelstore_attrib *pack = &ctx->Pack;
+   const GLuint dims =
+      _mesa_get_texture_dimensions(texImage->TexObject->Target);
+   GLuint width = texImage->Width;
+   GLuint height = texImage->Height;
+   GLuint depth = texImage->Depth;
+   GLint row_stride, image_stride;
+   GLubyte *dst, *map;
+
+   if (!stImage->pt) {
+      return GL_FALSE;
+   }
+
+   /* GL_MESA_pack_invert flips the rows, util_copy_box() can't. */
+   if (pack->Invert) {
+      return GL_FALSE;
+   }
+
+   /* GL keeps the layers of 1D arrays in y, gallium in z. */
+   if (texImage->TexObject->Target == GL_TEXTURE_1D_ARRAY) {
+      return GL_FALSE;
+   }
+
+   if (texImage->_BaseFormat !=
+       _mesa_get_format_base_format(texImage->TexFormat) ||
+       !_mesa_format_matches_format_and_type(texImage->TexFormat, format,
+                                             type, pack->SwapBytes)) {
+      return GL_FALSE;
+   }
+
+   dst = _mesa_map_pbo_dest(ctx, pack, pixels);
+   if (!dst) {
+      return GL_FALSE;
+   }
+
+   map = st_texture_image_map(st, stImage, PIPE_TRANSFER_READ,
+                              0, 0, 0, width, height, depth);
+   if (!map) {
+      _mesa_unmap_pbo_dest(ctx, pack);
+      return GL_FALSE;
+   }
+
+   row_stride = _mesa_image_row_stride(pack, width, format, type);
+   image_stride = _mesa_image_image_stride(pack, width, height,
+                                           format, type);
+   dst = _mesa_image_address(dims, pack, dst, width, height,
+                             format, type, 0, 0, 0);
+
+   util_copy_box(dst, stImage->pt->format, row_stride, image_stride,
+                 0, 0, 0, width, height, depth,
+                 map, stImage->transfer->stride,
+                 stImage->transfer->layer_stride, 0, 0, 0);
+
+   st_texture_image_unmap(st, stImage);
+   _mesa_unmap_pbo_dest(ctx, pack);
+   return GL_TRUE;
+}
+
+
+#if HAVE_LLVM
+/**
+ * The glGetTexImage counterpart of try_jit_upload().
+ *
+ * Luminance and intensity are left to _mesa_get_teximage, as they don't
+ * read back the way they unpack.
+ *
+ * \return GL_TRUE if the download was done.
+ */
+static GLboolean
+try_jit_download(struct gl_context *ctx,
+                 GLenum format, GLenum type, GLvoid *pixels,
+                 struct gl_texture_image *texImage)
+{
+   struct st_context *st = st_context(ctx);
+   struct st_texture_image *stImage = st_texture_image(texImage);
+   struct pipe_screen *screen = st->pipe->screen;
+   const struct gl_pixelstore_attrib *pack = &ctx->Pack;
+   const GLuint dims =
+      _mesa_get_texture_dimensions(texImage->TexObject->Target);
+   GLuint width = texImage->Width;
+   GLuint height = texImage->Height;
+   GLuint depth = texImage->Depth;
+   enum pipe_format src_format, dst_format;
+   lp_format_translate_func translate;
+   GLubyte *dst, *map;
+   GLuint img, row;
+
+   if (!st->format_translate_cache || !stImage->pt) {
+      return GL_FALSE;
+   }
+
+   /* GL keeps the layers of 1D arrays in y, gallium in z. */
+   if (texImage->TexObject->Target == GL_TEXTURE_1D_ARRAY) {
+      return GL_FALSE;
+   }
+
+   if (ctx->_ImageTransferState || pack->SwapBytes || pack->Invert) {
+      return GL_FALSE;
+   }
+
+   switch (texImage->_BaseFormat) {
+   case GL_RGBA:
+   case GL_RGB:
+   case GL_RG:
+   case GL_RED:
+   case GL_ALPHA:
+      break;
+   default:
+      return GL_FALSE;
+   }
+
+   if (texImage->_BaseFormat !=
+       _mesa_get_format_base_format(texImage->TexFormat) ||
+       _mesa_format_matches_format_and_type(texImage->TexFormat, format,
+                                            type, GL_FALSE)) {
+      return GL_FALSE;
+   }
+
+   src_format = util_format_linear(stImage->pt->format);
+   dst_format = st_choose_matching_format(screen, PIPE_BIND_TRANSFER_READ,
+                                          format, type, GL_FALSE);
+   if (!dst_format ||
+       util_format_is_luminance(dst_format) ||
+       util_format_is_luminance_alpha(dst_format) ||
+       util_format_is_intensity(dst_format) ||
+       !lp_format_translate_supported(dst_format, src_format)) {
+      return GL_FALSE;
+   }
+
+   translate = lp_get_format_translate_func(st->format_translate_cache,
+                                            dst_format, src_format);
+   if (!translate) {
+      return GL_FALSE;
+   }
+
+   dst = _mesa_map_pbo_dest(ctx, pack, pixels);
+   if (!dst) {
+      return GL_FALSE;
+   }
+
+   map = st_texture_image_map(st, stImage, PIPE_TRANSFER_READ,
+                              0, 0, 0, width, height, depth);
+   if (!map) {
+      _mesa_unmap_pbo_dest(ctx, pack);
+      return GL_FALSE;
+   }
+
+   for (img = 0; img < depth; img++) {
+      for (row = 0; row < height; row++) {
+         GLubyte *dst_row =
+            _mesa_image_address(dims, pack, dst, width, height,
+                                format, type, img, row, 0);
+
+         translate(dst_row, map + img * stImage->transfer->layer_stride +
+                   row * stImage->transfer->stride, width);
+      }
+   }
+
+   st_texture_image_unmap(st, stImage);
+   _mesa_unmap_pbo_dest(ctx, pack);
+   return GL_TRUE;
+}
+#endif
+
+
 /**
  * Called via ctx->Driver.GetTexImage()
  *
@@ -865,8 +1247,18 @@ st_GetTexImage(struct gl_context * ctx,
    ubyte *map = NULL;
    boolean done = FALSE;
 
+   if (_mesa_is_bufferobj(ctx->Pack.BufferObj) &&
+       try_pbo_download_memcpy(ctx, format, type, pixels, texImage)) {
+      return;
+   }
+
    if (!st->prefer_blit_based_texture_transfer &&
        !_mesa_is_format_compressed(texImage->TexFormat)) {
+#if HAVE_LLVM
+      if (try_jit_download(ctx, format, type, pixels, texImage)) {
+         return;
+      }
+#endif
       /* Try to avoid the fallback if we're doing texture decompression here */
       goto fallback;
    }
@@ -71,8 +71,15 @@
 #include "util/u_upload_mgr.h"
 #include "cso_cache/cso_context.h"
 
+#if HAVE_LLVM
+#include "gallivm/lp_bld_format_translate.h"
+#endif
+
 
 DEBUG_GET_ONCE_BOOL_OPTION(mesa_mvp_dp4, "MESA_MVP_DP4", FALSE)
+#if HAVE_LLVM
+DEBUG_GET_ONCE_BOOL_OPTION(st_jit_transfers, "ST_JIT_TRANSFERS", FALSE)
+#endif
 
 
 /**
@@ -93,6 +100,12 @@ void st_invalidate_state(struct gl_context * ctx, GLuint new_state)
       st->dirty.st |= ST_NEW_VERTEX_PROGRAM;
    }
 
+   /* The cached vertex state of the array object is stale if its arrays
+    * changed.
+    */
+   if ((new_state & _NEW_ARRAY) && ctx->Array.ArrayObj->NewArrays)
+      st_array_object(ctx->Array.ArrayObj)->vertex_state_valid = GL_FALSE;
+
    st->dirty.mesa |= new_state;
    st->dirty.st |= ST_NEW_MESA;
 
@@ -190,6 +203,11 @@ st_create_context_priv( struct gl_context *ctx, struct pipe_context *pipe,
    st->has_shader_model3 = screen->get_param(screen, PIPE_CAP_SM3);
    st->prefer_blit_based_texture_transfer = screen->get_param(screen,
                               PIPE_CAP_PREFER_BLIT_BASED_TEXTURE_TRANSFER);
+#if HAVE_LLVM
+   if (!st->prefer_blit_based_texture_transfer &&
+       debug_get_option_st_jit_transfers())
+      st->format_translate_cache = lp_format_translate_cache_create();
+#endif
 
    st->needs_texcoord_semantic =
       screen->get_param(screen, PIPE_CAP_TGSI_TEXCOORD);
@@ -257,6 +275,9 @@ static void st_destroy_context_priv( struct st_context *st )
    st_destroy_bitmap(st);
    st_destroy_drawpix(st);
    st_destroy_drawtex(st);
+#if HAVE_LLVM
+   lp_format_translate_cache_destroy(st->format_translate_cache);
+#endif
 
    for (shader = 0; shader < Elements(st->state.sampler_views); shader++) {
       for (i = 0; i < Elements(st->state.sampler_views[0]); i++) {
@@ -277,6 +298,9 @@ static void st_destroy_context_priv( struct st_context *st )
    if (st->constbuf_uploader) {
       u_upload_destroy(st->constbuf_uploader);
    }
+   for (shader = 0; shader < Elements(st->state.constants); shader++) {
+      free(st->state.constants[shader].shadow);
+   }
    free( st );
 }
 
@@ -38,6 +38,7 @@ struct dd_function_table;
 struct draw_context;
 struct draw_stage;
 struct gen_mipmap_state;
+struct lp_format_translate_cache;
 struct st_context;
 struct st_fragment_program;
 struct u_upload_mgr;
@@ -88,6 +89,10 @@ struct st_context
    boolean has_shader_model3;
    boolean prefer_blit_based_texture_transfer;
 
+   /** JIT compiled row converters for texture transfers, or NULL when
+    * they're not used (ST_JIT_TRANSFERS) */
+   struct lp_format_translate_cache *format_translate_cache;
+
    boolean needs_texcoord_semantic;
    boolean apply_texture_swizzle_to_border_color;
 
@@ -113,6 +118,9 @@ struct st_context
       struct {
          void *ptr;
          unsigned size;
+         /** Copy of the constants last bound, to skip unchanged uploads */
+         void *shadow;
+         unsigned shadow_size;
       } constants[PIPE_SHADER_TYPES];
       struct pipe_framebuffer_state framebuffer;
       struct pipe_scissor_state scissor;
@@ -129,6 +137,16 @@ struct st_context
 
    struct st_state_flags dirty;
 
+   /**
+    * For each bit of st_state_flags::mesa and ::st, the mask of the state
+    * atoms depending on it (bit i for atom i), see st_atom.c.
+    */
+   GLuint atoms_by_mesa_flag[32];
+   GLuint atoms_by_st_flag[32];
+
+   /** Atom call counters and timings, with ST_DEBUG=atoms */
+   struct st_atom_stats *atom_stats;
+
    GLboolean missing_textures;
    GLboolean vertdata_edgeflags;
 
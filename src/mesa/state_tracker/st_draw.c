@@ -197,6 +197,10 @@ st_draw_vbo(struct gl_context *ctx,
    struct st_context *st = st_context(ctx);
    struct pipe_index_buffer ibuffer = {0};
    struct pipe_draw_info info;
+   struct pipe_draw_info draws[ST_MAX_MULTI_DRAWS];
+   unsigned num_draws = 0;
+   struct pipe_transfer *indirect_transfer = NULL;
+   const GLubyte *indirect_data = NULL;
    const struct gl_client_array **arrays = ctx->Array._DrawArrays;
    unsigned i;
 
@@ -254,14 +258,54 @@ st_draw_vbo(struct gl_context *ctx,
       }
    }
 
+   /* GL_ARB_draw_indirect: read the draw parameters back, the buffers of
+    * the drivers exposing it live in host memory.
+    */
+   if (indirect) {
+      struct st_buffer_object *st_obj = st_buffer_object(indirect);
+
+      if (st_obj->buffer)
+         indirect_data = pipe_buffer_map(st->pipe, st_obj->buffer,
+                                         PIPE_TRANSFER_READ,
+                                         &indirect_transfer);
+      if (!indirect_data) {
+         _mesa_error(ctx, GL_OUT_OF_MEMORY, "glDraw*Indirect");
+         goto out;
+      }
+   }
+
    /* do actual drawing */
    for (i = 0; i < nr_prims; i++) {
       info.mode = translate_prim(ctx, prims[i].mode);
-      info.start = prims[i].start;
-      info.count = prims[i].count;
-      info.start_instance = prims[i].base_instance;
-      info.instance_count = prims[i].num_instances;
-      info.index_bias = prims[i].basevertex;
+
+      if (prims[i].is_indirect) {
+         /* DrawArraysIndirectCommand or DrawElementsIndirectCommand */
+         const GLuint *params = (const GLuint *)
+            (indirect_data + prims[i].indirect_offset);
+
+         info.count = params[0];
+         info.instance_count = params[1];
+         info.start = params[2];
+         if (ib) {
+            info.index_bias = (GLint) params[3];
+            info.start_instance = params[4];
+         }
+         else {
+            info.index_bias = 0;
+            info.start_instance = params[3];
+         }
+
+         if (!info.count || !info.instance_count)
+            continue;
+      }
+      else {
+         info.start = prims[i].start;
+         info.count = prims[i].count;
+         info.start_instance = prims[i].base_instance;
+         info.instance_count = prims[i].num_instances;
+         info.index_bias = prims[i].basevertex;
+      }
+
       if (!ib) {
          info.min_index = info.start;
          info.max_index = info.start + info.count - 1;
@@ -275,18 +319,26 @@ st_draw_vbo(struct gl_context *ctx,
                       info.indexed);
       }
 
-      if (info.count_from_stream_output) {
-         cso_draw_vbo(st->cso_context, &info);
-      }
-      else if (info.primitive_restart) {
-         /* don't trim, restarts might be inside index list */
-         cso_draw_vbo(st->cso_context, &info);
-      }
-      else if (u_trim_pipe_prim(prims[i].mode, &info.count)) {
-         cso_draw_vbo(st->cso_context, &info);
+      /* Don't trim with restarts, they might be inside index list */
+      if (info.count_from_stream_output ||
+          info.primitive_restart ||
+          u_trim_pipe_prim(prims[i].mode, &info.count)) {
+         /* Consecutive draws go down to the driver in one go */
+         draws[num_draws++] = info;
+         if (num_draws == ST_MAX_MULTI_DRAWS) {
+            cso_multi_draw_vbo(st->cso_context, draws, num_draws);
+            num_draws = 0;
+         }
       }
    }
 
+   if (num_draws)
+      cso_multi_draw_vbo(st->cso_context, draws, num_draws);
+
+   if (indirect_transfer)
+      pipe_buffer_unmap(st->pipe, indirect_transfer);
+
+out:
    if (ib && st->indexbuf_uploader && !_mesa_is_bufferobj(ib->obj)) {
       pipe_resource_reference(&ibuffer.buffer, NULL);
    }
@@ -43,6 +43,9 @@ struct gl_client_array;
 struct gl_context;
 struct st_context;
 
+/** Max number of draws handed to cso_multi_draw_vbo() at once */
+#define ST_MAX_MULTI_DRAWS 32
+
 void st_init_draw( struct st_context *st );
 
 void st_destroy_draw( struct st_context *st );
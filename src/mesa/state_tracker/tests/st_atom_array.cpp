@@ -0,0 +1,500 @@
+/*
+ * Copyright © 2014 VMware, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * Checks the vertex state st_update_array caches in the vertex array
+ * objects: it must follow the array object bound, the storage of the
+ * buffers it sources, and the vertex formats set by glVertexAttribPointer().
+ * The arrays are set up through the GL entry points with the state
+ * tracker's buffer and array object functions, against a pipe context
+ * which only records the vertex buffers and elements bound.
+ */
+
+#include <gtest/gtest.h>
+#include <stdlib.h>
+#include <string.h>
+
+extern "C" {
+#include "main/compiler.h"
+#include "main/mtypes.h"
+#include "main/api_arrayelt.h"
+#include "main/arrayobj.h"
+#include "main/bufferobj.h"
+#include "main/dd.h"
+#include "main/hash.h"
+#include "main/varray.h"
+#include "vbo/vbo_context.h"
+#include "glapi/glapi.h"
+#include "pipe/p_context.h"
+#include "pipe/p_format.h"
+#include "pipe/p_screen.h"
+#include "pipe/p_state.h"
+#include "util/u_inlines.h"
+#include "cso_cache/cso_context.h"
+#include "state_tracker/st_atom.h"
+#include "state_tracker/st_cb_bufferobjects.h"
+#include "state_tracker/st_context.h"
+#include "state_tracker/st_program.h"
+}
+
+
+/** Vertex elements state object created by the recorder */
+struct recorded_velems {
+   unsigned count;
+   struct pipe_vertex_element velems[PIPE_MAX_ATTRIBS];
+};
+
+/** Pipe context recording the vertex state bound */
+struct vertex_recorder {
+   struct pipe_context base;
+   struct pipe_screen screen;
+
+   struct pipe_vertex_buffer vbuffers[PIPE_MAX_ATTRIBS];
+   const struct recorded_velems *velems;
+
+   /** Number of vertex elements state objects created */
+   unsigned num_velems_created;
+};
+
+static struct vertex_recorder *
+vertex_recorder(struct pipe_context *pipe)
+{
+   return (struct vertex_recorder *) pipe;
+}
+
+static int
+recorder_get_param(struct pipe_screen *screen, enum pipe_cap param)
+{
+   /* Everything u_vbuf would otherwise be installed for is supported */
+   return param == PIPE_CAP_USER_VERTEX_BUFFERS;
+}
+
+static int
+recorder_get_shader_param(struct pipe_screen *screen, unsigned shader,
+                          enum pipe_shader_cap param)
+{
+   return 0;
+}
+
+static boolean
+recorder_is_format_supported(struct pipe_screen *screen,
+                             enum pipe_format format,
+                             enum pipe_texture_target target,
+                             unsigned sample_count,
+                             unsigned bindings)
+{
+   return TRUE;
+}
+
+static struct pipe_resource *
+recorder_resource_create(struct pipe_screen *screen,
+                         const struct pipe_resource *templat)
+{
+   struct pipe_resource *res =
+      (struct pipe_resource *) calloc(1, sizeof(*res));
+
+   *res = *templat;
+   pipe_reference_init(&res->reference, 1);
+   res->screen = screen;
+   return res;
+}
+
+static void
+recorder_resource_destroy(struct pipe_screen *screen,
+                          struct pipe_resource *res)
+{
+   free(res);
+}
+
+static void
+recorder_set_vertex_buffers(struct pipe_context *pipe,
+                            unsigned start_slot, unsigned count,
+                            const struct pipe_vertex_buffer *buffers)
+{
+   struct vertex_recorder *rec = vertex_recorder(pipe);
+
+   if (buffers)
+      memcpy(&rec->vbuffers[start_slot], buffers, count * sizeof(*buffers));
+   else
+      memset(&rec->vbuffers[start_slot], 0, count * sizeof(*buffers));
+}
+
+static void *
+recorder_create_vertex_elements_state(struct pipe_context *pipe,
+                                      unsigned count,
+                                      const struct pipe_vertex_element *velems)
+{
+   struct vertex_recorder *rec = vertex_recorder(pipe);
+   struct recorded_velems *state =
+      (struct recorded_velems *) calloc(1, sizeof(*state));
+
+   state->count = count;
+   memcpy(state->velems, velems, count * sizeof(*velems));
+   rec->num_velems_created++;
+   return state;
+}
+
+static void
+recorder_bind_vertex_elements_state(struct pipe_context *pipe, void *state)
+{
+   vertex_recorder(pipe)->velems = (const struct recorded_velems *) state;
+}
+
+static void
+recorder_delete_vertex_elements_state(struct pipe_context *pipe, void *state)
+{
+   free(state);
+}
+
+
+class St_array_test : public ::testing::Test {
+public:
+   virtual void SetUp();
+   virtual void TearDown();
+
+   GLuint create_buffer(GLsizeiptr size);
+   GLuint create_array_object();
+   void set_array(GLuint index, GLuint buffer, GLint size, GLenum type,
+                  GLboolean normalized, GLsizei stride, GLintptr offset);
+   void validate();
+
+   struct st_array_object *array_object(GLuint name);
+   struct pipe_resource *buffer_storage(GLuint name);
+   const struct pipe_vertex_element *bound_velems();
+
+   struct gl_context ctx;
+   struct gl_shared_state shared;
+   struct gl_transform_feedback_object xfb_obj;
+   struct vbo_context vbo;
+   struct st_context st;
+   struct st_vertex_program vp;
+   struct st_vp_variant vpv;
+   struct vertex_recorder pipe;
+
+   /** What the VBO module would feed the vertex shader inputs from */
+   const struct gl_client_array *inputs[VERT_ATTRIB_MAX];
+};
+
+void
+St_array_test::SetUp()
+{
+   memset(&ctx, 0, sizeof(ctx));
+   memset(&shared, 0, sizeof(shared));
+   memset(&xfb_obj, 0, sizeof(xfb_obj));
+   memset(&vbo, 0, sizeof(vbo));
+   memset(&st, 0, sizeof(st));
+   memset(&vp, 0, sizeof(vp));
+   memset(&vpv, 0, sizeof(vpv));
+   memset(&pipe, 0, sizeof(pipe));
+
+   pipe.screen.get_param = recorder_get_param;
+   pipe.screen.get_shader_param = recorder_get_shader_param;
+   pipe.screen.is_format_supported = recorder_is_format_supported;
+   pipe.screen.resource_create = recorder_resource_create;
+   pipe.screen.resource_destroy = recorder_resource_destroy;
+   pipe.base.screen = &pipe.screen;
+   pipe.base.set_vertex_buffers = recorder_set_vertex_buffers;
+   pipe.base.create_vertex_elements_state =
+      recorder_create_vertex_elements_state;
+   pipe.base.bind_vertex_elements_state = recorder_bind_vertex_elements_state;
+   pipe.base.delete_vertex_elements_state =
+      recorder_delete_vertex_elements_state;
+
+   ctx.API = API_OPENGL_CORE;
+   ctx.Version = 33;
+   ctx.Const.Program[MESA_SHADER_VERTEX].MaxAttribs = 16;
+   ctx.Extensions.ARB_half_float_vertex = GL_TRUE;
+   ctx.Driver.CurrentExecPrimitive = PRIM_OUTSIDE_BEGIN_END;
+   st_init_bufferobject_functions(&ctx.Driver);
+   ctx.vbo_context = &vbo;
+   _ae_create_context(&ctx);
+
+   ctx.st = &st;
+   st.ctx = &ctx;
+   st.pipe = &pipe.base;
+   st.cso_context = cso_create_context(&pipe.base);
+   ASSERT_TRUE(st.cso_context != NULL);
+
+   /* A vertex shader with two generic inputs */
+   vp.index_to_input[0] = VERT_ATTRIB_GENERIC0;
+   vp.index_to_input[1] = VERT_ATTRIB_GENERIC1;
+   vpv.num_inputs = 2;
+   st.vp = &vp;
+   st.vp_variant = &vpv;
+
+   shared.BufferObjects = _mesa_NewHashTable();
+   shared.NullBufferObj = ctx.Driver.NewBufferObject(&ctx, 0, 0);
+   ctx.Shared = &shared;
+   ctx.TransformFeedback.CurrentObject = &xfb_obj;
+   _mesa_init_buffer_objects(&ctx);
+   _mesa_init_varray(&ctx);
+
+   _glapi_set_context(&ctx);
+}
+
+void
+St_array_test::TearDown()
+{
+   EXPECT_EQ((GLenum) GL_NO_ERROR, ctx.ErrorValue);
+
+   _mesa_reference_array_object(&ctx, &ctx.Array.ArrayObj, NULL);
+   _mesa_reference_array_object(&ctx, &ctx.Array.DefaultArrayObj, NULL);
+   _mesa_free_buffer_objects(&ctx);
+   _mesa_free_varray_data(&ctx);
+   _mesa_reference_buffer_object(&ctx, &shared.NullBufferObj, NULL);
+   _mesa_DeleteHashTable(shared.BufferObjects);
+
+   cso_destroy_context(st.cso_context);
+   _ae_destroy_context(&ctx);
+
+   _glapi_set_context(NULL);
+}
+
+GLuint
+St_array_test::create_buffer(GLsizeiptr size)
+{
+   GLuint name;
+
+   _mesa_GenBuffers(1, &name);
+   _mesa_BindBuffer(GL_ARRAY_BUFFER, name);
+   _mesa_BufferData(GL_ARRAY_BUFFER, size, NULL, GL_STATIC_DRAW);
+   return name;
+}
+
+GLuint
+St_array_test::create_array_object()
+{
+   GLuint name;
+
+   _mesa_GenVertexArrays(1, &name);
+   _mesa_BindVertexArray(name);
+   return name;
+}
+
+void
+St_array_test::set_array(GLuint index, GLuint buffer, GLint size,
+                         GLenum type, GLboolean normalized, GLsizei stride,
+                         GLintptr offset)
+{
+   _mesa_BindBuffer(GL_ARRAY_BUFFER, buffer);
+   _mesa_VertexAttribPointer(index, size, type, normalized, stride,
+                             (const GLvoid *) offset);
+   _mesa_EnableVertexAttribArray(index);
+}
+
+/**
+ * Do what a draw call does: update the state, point the inputs at the
+ * arrays of the bound array object and update the vertex arrays.
+ */
+void
+St_array_test::validate()
+{
+   GLbitfield new_state = ctx.NewState;
+   GLuint i;
+
+   if (new_state & _NEW_ARRAY)
+      _mesa_update_array_object_client_arrays(&ctx, ctx.Array.ArrayObj);
+   ctx.NewState = 0;
+   st_invalidate_state(&ctx, new_state);
+   ctx.Array.ArrayObj->NewArrays = 0;
+
+   for (i = 0; i < VERT_ATTRIB_MAX; i++)
+      inputs[i] = &ctx.Array.ArrayObj->_VertexAttrib[i];
+   ctx.Array._DrawArrays = inputs;
+
+   st_update_array.update(&st);
+   ASSERT_FALSE(st.vertex_array_out_of_memory);
+}
+
+struct st_array_object *
+St_array_test::array_object(GLuint name)
+{
+   return st_array_object(_mesa_lookup_arrayobj(&ctx, name));
+}
+
+struct pipe_resource *
+St_array_test::buffer_storage(GLuint name)
+{
+   return st_buffer_object(_mesa_lookup_bufferobj(&ctx, name))->buffer;
+}
+
+const struct pipe_vertex_element *
+St_array_test::bound_velems()
+{
+   return pipe.velems ? pipe.velems->velems : NULL;
+}
+
+
+/**
+ * Switching between array objects binds the vertex state of each,
+ * reusing what was cached for them.
+ */
+TEST_F(St_array_test, array_object_rebind)
+{
+   GLuint buf = create_buffer(1024);
+   GLuint colors = create_buffer(256);
+   GLuint a, b;
+   const struct recorded_velems *a_velems, *b_velems;
+
+   /* Interleaved position and normal */
+   a = create_array_object();
+   set_array(0, buf, 3, GL_FLOAT, GL_FALSE, 24, 0);
+   set_array(1, buf, 3, GL_FLOAT, GL_FALSE, 24, 12);
+
+   /* Separate position and color buffers */
+   b = create_array_object();
+   set_array(0, buf, 2, GL_FLOAT, GL_FALSE, 8, 64);
+   set_array(1, colors, 4, GL_UNSIGNED_BYTE, GL_TRUE, 4, 0);
+
+   _mesa_BindVertexArray(a);
+   validate();
+   a_velems = pipe.velems;
+   EXPECT_TRUE(array_object(a)->vertex_state_valid);
+   EXPECT_EQ(2u, a_velems->count);
+   EXPECT_EQ(PIPE_FORMAT_R32G32B32_FLOAT, a_velems->velems[0].src_format);
+   EXPECT_EQ(12u, a_velems->velems[1].src_offset);
+   EXPECT_EQ(buffer_storage(buf), pipe.vbuffers[0].buffer);
+   EXPECT_EQ(24u, pipe.vbuffers[0].stride);
+
+   _mesa_BindVertexArray(b);
+   validate();
+   b_velems = pipe.velems;
+   EXPECT_TRUE(array_object(b)->vertex_state_valid);
+   EXPECT_NE(a_velems, b_velems);
+   EXPECT_EQ(PIPE_FORMAT_R32G32_FLOAT, b_velems->velems[0].src_format);
+   EXPECT_EQ(PIPE_FORMAT_R8G8B8A8_UNORM, b_velems->velems[1].src_format);
+   EXPECT_EQ(1u, b_velems->velems[1].vertex_buffer_index);
+   EXPECT_EQ(buffer_storage(buf), pipe.vbuffers[0].buffer);
+   EXPECT_EQ(64u, pipe.vbuffers[0].buffer_offset);
+   EXPECT_EQ(buffer_storage(colors), pipe.vbuffers[1].buffer);
+
+   /* Back to the first one, from its cache */
+   _mesa_BindVertexArray(a);
+   validate();
+   EXPECT_TRUE(array_object(a)->vertex_state_valid);
+   EXPECT_EQ(a_velems, pipe.velems);
+   EXPECT_EQ(buffer_storage(buf), pipe.vbuffers[0].buffer);
+   EXPECT_EQ(0u, pipe.vbuffers[0].buffer_offset);
+   EXPECT_EQ(24u, pipe.vbuffers[0].stride);
+   EXPECT_EQ(NULL, pipe.vbuffers[1].buffer);
+   EXPECT_EQ(2u, pipe.num_velems_created);
+
+   _mesa_BindVertexArray(b);
+   validate();
+   EXPECT_EQ(b_velems, pipe.velems);
+   EXPECT_EQ(buffer_storage(colors), pipe.vbuffers[1].buffer);
+   EXPECT_EQ(2u, pipe.num_velems_created);
+}
+
+/**
+ * The cached vertex state picks up the new storage of a buffer
+ * respecified with glBufferData().
+ */
+TEST_F(St_array_test, buffer_respecification)
+{
+   GLuint buf = create_buffer(1024);
+   struct pipe_resource *old_storage;
+   const struct recorded_velems *velems;
+   GLuint a;
+
+   a = create_array_object();
+   set_array(0, buf, 4, GL_FLOAT, GL_FALSE, 0, 0);
+   set_array(1, buf, 2, GL_SHORT, GL_TRUE, 0, 512);
+
+   validate();
+   velems = pipe.velems;
+   old_storage = buffer_storage(buf);
+   EXPECT_EQ(old_storage, pipe.vbuffers[0].buffer);
+   EXPECT_EQ(old_storage, pipe.vbuffers[1].buffer);
+
+   _mesa_BindBuffer(GL_ARRAY_BUFFER, buf);
+   _mesa_BufferData(GL_ARRAY_BUFFER, 2048, NULL, GL_DYNAMIC_DRAW);
+   ASSERT_NE(old_storage, buffer_storage(buf));
+
+   validate();
+   EXPECT_TRUE(array_object(a)->vertex_state_valid);
+   EXPECT_EQ(velems, pipe.velems);
+   EXPECT_EQ(buffer_storage(buf), pipe.vbuffers[0].buffer);
+   EXPECT_EQ(buffer_storage(buf), pipe.vbuffers[1].buffer);
+   EXPECT_EQ(512u, pipe.vbuffers[1].buffer_offset);
+}
+
+/**
+ * Changing the format of an array drops the cached vertex state, whether
+ * the array object is drawn with right away or only after being bound
+ * again.
+ */
+TEST_F(St_array_test, vertex_format_change)
+{
+   GLuint buf = create_buffer(1024);
+   GLuint a, b;
+
+   a = create_array_object();
+   set_array(0, buf, 3, GL_FLOAT, GL_FALSE, 16, 0);
+   set_array(1, buf, 4, GL_UNSIGNED_BYTE, GL_TRUE, 16, 12);
+   validate();
+   EXPECT_EQ(PIPE_FORMAT_R32G32B32_FLOAT, bound_velems()[0].src_format);
+
+   set_array(0, buf, 2, GL_HALF_FLOAT, GL_FALSE, 16, 0);
+   validate();
+   EXPECT_EQ(PIPE_FORMAT_R16G16_FLOAT, bound_velems()[0].src_format);
+   EXPECT_EQ(PIPE_FORMAT_R8G8B8A8_UNORM, bound_velems()[1].src_format);
+
+   /* Changed, then another array object is drawn with before this one */
+   set_array(1, buf, 4, GL_UNSIGNED_BYTE, GL_FALSE, 16, 12);
+   b = create_array_object();
+   set_array(0, buf, 1, GL_FLOAT, GL_FALSE, 0, 0);
+   set_array(1, buf, 1, GL_FLOAT, GL_FALSE, 0, 4);
+   validate();
+   EXPECT_EQ(PIPE_FORMAT_R32_FLOAT, bound_velems()[1].src_format);
+
+   _mesa_BindVertexArray(a);
+   validate();
+   EXPECT_TRUE(array_object(a)->vertex_state_valid);
+   EXPECT_EQ(PIPE_FORMAT_R16G16_FLOAT, bound_velems()[0].src_format);
+   EXPECT_EQ(PIPE_FORMAT_R8G8B8A8_USCALED, bound_velems()[1].src_format);
+   (void) b;
+}
+
+/**
+ * A vertex shader reading other attributes doesn't use the vertex state
+ * cached for the previous one.
+ */
+TEST_F(St_array_test, vertex_program_change)
+{
+   GLuint buf = create_buffer(1024);
+
+   create_array_object();
+   set_array(0, buf, 3, GL_FLOAT, GL_FALSE, 0, 0);
+   set_array(1, buf, 2, GL_FLOAT, GL_FALSE, 0, 256);
+   validate();
+   EXPECT_EQ(2u, pipe.velems->count);
+
+   vp.index_to_input[0] = VERT_ATTRIB_GENERIC1;
+   vpv.num_inputs = 1;
+   st.dirty.st |= ST_NEW_VERTEX_PROGRAM;
+   validate();
+   EXPECT_EQ(1u, pipe.velems->count);
+   EXPECT_EQ(PIPE_FORMAT_R32G32_FLOAT, bound_velems()[0].src_format);
+   EXPECT_EQ(256u, pipe.vbuffers[0].buffer_offset);
+}
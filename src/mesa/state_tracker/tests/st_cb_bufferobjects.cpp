@@ -0,0 +1,305 @@
+/*
+ * Copyright © 2014 VMware, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * Checks that Mesa can map a buffer for its own use (index range scan,
+ * PBO source) while the application holds a persistent mapping of it, and
+ * that the application's mapping is back in place afterwards.  The pipe
+ * context maps the buffer into plain memory and keeps track of the
+ * transfers in flight.
+ */
+
+#include <gtest/gtest.h>
+#include <string.h>
+
+extern "C" {
+#include "main/mtypes.h"
+#include "main/bufferobj.h"
+#include "main/pbo.h"
+#include "vbo/vbo.h"
+#include "state_tracker/st_context.h"
+#include "state_tracker/st_cb_bufferobjects.h"
+#include "pipe/p_context.h"
+#include "pipe/p_state.h"
+}
+
+#define BUFFER_SIZE 256
+#define MAX_TRANSFERS 4
+
+#define PERSISTENT_ACCESS (GL_MAP_READ_BIT | GL_MAP_WRITE_BIT | \
+                           GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT)
+
+
+/** Pipe context mapping buffers into memory */
+struct map_recorder {
+   struct pipe_context base;
+
+   GLubyte storage[BUFFER_SIZE];
+
+   struct pipe_transfer transfers[MAX_TRANSFERS];
+   bool mapped[MAX_TRANSFERS];
+   unsigned num_maps;
+
+   /** Fail the next transfer_map() */
+   bool fail;
+};
+
+static struct map_recorder *
+map_recorder(struct pipe_context *pipe)
+{
+   return (struct map_recorder *) pipe;
+}
+
+static void *
+recorder_transfer_map(struct pipe_context *pipe,
+                      struct pipe_resource *resource,
+                      unsigned level,
+                      unsigned usage,
+                      const struct pipe_box *box,
+                      struct pipe_transfer **out_transfer)
+{
+   struct map_recorder *rec = map_recorder(pipe);
+   unsigned i;
+
+   if (rec->fail) {
+      rec->fail = false;
+      return NULL;
+   }
+
+   for (i = 0; i < MAX_TRANSFERS; i++) {
+      if (!rec->mapped[i]) {
+         rec->mapped[i] = true;
+         rec->num_maps++;
+         rec->transfers[i].resource = resource;
+         rec->transfers[i].usage = (enum pipe_transfer_usage) usage;
+         rec->transfers[i].box = *box;
+         *out_transfer = &rec->transfers[i];
+         return rec->storage + box->x;
+      }
+   }
+
+   return NULL;
+}
+
+static void
+recorder_transfer_unmap(struct pipe_context *pipe,
+                        struct pipe_transfer *transfer)
+{
+   struct map_recorder *rec = map_recorder(pipe);
+   unsigned i = transfer - rec->transfers;
+
+   ASSERT_LT(i, (unsigned) MAX_TRANSFERS);
+   ASSERT_TRUE(rec->mapped[i]);
+   rec->mapped[i] = false;
+   rec->num_maps--;
+}
+
+
+class St_bufferobj_test : public ::testing::Test {
+public:
+   virtual void SetUp();
+   virtual void TearDown();
+
+   void map_persistent(GLintptr offset, GLsizeiptr length);
+   void expect_persistent_map();
+
+   struct gl_context ctx;
+   struct st_context st;
+   struct map_recorder pipe;
+
+   struct st_buffer_object st_obj;
+   struct pipe_resource res;
+
+   /** The application's mapping */
+   void *map;
+   struct pipe_transfer *transfer;
+   GLintptr offset;
+   GLsizeiptr length;
+};
+
+void
+St_bufferobj_test::SetUp()
+{
+   memset(&ctx, 0, sizeof(ctx));
+   memset(&st, 0, sizeof(st));
+   memset(&pipe, 0, sizeof(pipe));
+   memset(&st_obj, 0, sizeof(st_obj));
+   memset(&res, 0, sizeof(res));
+
+   pipe.base.transfer_map = recorder_transfer_map;
+   pipe.base.transfer_unmap = recorder_transfer_unmap;
+
+   ctx.st = &st;
+   st.ctx = &ctx;
+   st.pipe = &pipe.base;
+   st_init_bufferobject_functions(&ctx.Driver);
+
+   res.width0 = BUFFER_SIZE;
+   st_obj.buffer = &res;
+   st_obj.Base.Name = 1;
+   st_obj.Base.Size = BUFFER_SIZE;
+   st_obj.Base.Immutable = GL_TRUE;
+   st_obj.Base.StorageFlags = PERSISTENT_ACCESS;
+   /* The application may change the contents at any time */
+   st_obj.Base.MinMaxCacheDisabled = GL_TRUE;
+
+   map = NULL;
+   transfer = NULL;
+}
+
+void
+St_bufferobj_test::TearDown()
+{
+   EXPECT_EQ(0u, pipe.num_maps);
+}
+
+void
+St_bufferobj_test::map_persistent(GLintptr offset, GLsizeiptr length)
+{
+   map = ctx.Driver.MapBufferRange(&ctx, offset, length, PERSISTENT_ACCESS,
+                                   &st_obj.Base);
+   ASSERT_TRUE(map != NULL);
+   EXPECT_EQ(pipe.storage + offset, map);
+   EXPECT_EQ(1u, pipe.num_maps);
+
+   transfer = st_obj.transfer;
+   this->offset = offset;
+   this->length = length;
+}
+
+/**
+ * Nothing but the application's mapping is left, with its parameters.
+ */
+void
+St_bufferobj_test::expect_persistent_map()
+{
+   EXPECT_EQ(1u, pipe.num_maps);
+   EXPECT_EQ(transfer, st_obj.transfer);
+   EXPECT_EQ(map, st_obj.Base.Pointer);
+   EXPECT_EQ(offset, st_obj.Base.Offset);
+   EXPECT_EQ(length, st_obj.Base.Length);
+   EXPECT_EQ((GLbitfield) PERSISTENT_ACCESS, st_obj.Base.AccessFlags);
+   EXPECT_TRUE(st_obj.saved_map.Pointer == NULL);
+   EXPECT_TRUE(st_obj.saved_map.transfer == NULL);
+}
+
+
+/**
+ * The index range of a draw from a persistently mapped element buffer is
+ * read through a second mapping, and sees what was written through the
+ * first one.
+ */
+TEST_F(St_bufferobj_test, index_scan_while_mapped)
+{
+   static const GLushort indices[] = { 7, 3, 12, 9, 5, 30 };
+   struct _mesa_prim prim;
+   struct _mesa_index_buffer ib;
+   GLuint min_index, max_index;
+
+   map_persistent(0, BUFFER_SIZE);
+   memcpy((GLubyte *) map + 16, indices, sizeof(indices));
+
+   memset(&prim, 0, sizeof(prim));
+   prim.mode = GL_TRIANGLES;
+   prim.indexed = 1;
+   prim.start = 1;
+   prim.count = 4;
+
+   memset(&ib, 0, sizeof(ib));
+   ib.count = 4;
+   ib.type = GL_UNSIGNED_SHORT;
+   ib.obj = &st_obj.Base;
+   ib.ptr = (const void *) 16;
+
+   vbo_get_minmax_indices(&ctx, &prim, &ib, &min_index, &max_index, 1);
+
+   EXPECT_EQ(3u, min_index);
+   EXPECT_EQ(12u, max_index);
+   expect_persistent_map();
+
+   EXPECT_TRUE(ctx.Driver.UnmapBuffer(&ctx, &st_obj.Base));
+   EXPECT_TRUE(st_obj.Base.Pointer == NULL);
+   EXPECT_TRUE(st_obj.transfer == NULL);
+}
+
+
+/**
+ * A persistently mapped buffer may be the source of a pixel transfer.
+ * While Mesa reads it, its own mapping is the current one and the
+ * application's is put aside.
+ */
+TEST_F(St_bufferobj_test, pbo_source_while_mapped)
+{
+   struct gl_pixelstore_attrib unpack;
+   const GLubyte *pixels;
+   GLuint i;
+
+   map_persistent(64, 128);
+   for (i = 0; i < BUFFER_SIZE; i++)
+      pipe.storage[i] = i;
+
+   memset(&unpack, 0, sizeof(unpack));
+   unpack.Alignment = 1;
+   unpack.BufferObj = &st_obj.Base;
+
+   pixels = (const GLubyte *)
+      _mesa_map_validate_pbo_source(&ctx, 1, &unpack, 4, 1, 1,
+                                    GL_RGBA, GL_UNSIGNED_BYTE, 0,
+                                    (const GLvoid *) 8, "glTexImage1D");
+   ASSERT_TRUE(pixels != NULL);
+   EXPECT_EQ(0u, ctx.ErrorValue);
+
+   /* The whole buffer is mapped for reading */
+   EXPECT_EQ(2u, pipe.num_maps);
+   EXPECT_EQ(8, pixels[0]);
+   EXPECT_EQ(23, pixels[15]);
+   EXPECT_NE(transfer, st_obj.transfer);
+   EXPECT_EQ(0, st_obj.Base.Offset);
+   EXPECT_EQ(BUFFER_SIZE, st_obj.Base.Length);
+   EXPECT_EQ((GLbitfield) GL_MAP_READ_BIT, st_obj.Base.AccessFlags);
+   EXPECT_EQ(transfer, st_obj.saved_map.transfer);
+   EXPECT_EQ(map, st_obj.saved_map.Pointer);
+
+   _mesa_unmap_pbo_source(&ctx, &unpack);
+   expect_persistent_map();
+
+   EXPECT_TRUE(ctx.Driver.UnmapBuffer(&ctx, &st_obj.Base));
+}
+
+
+/**
+ * When Mesa's own mapping fails, the application's mapping stays in
+ * place.
+ */
+TEST_F(St_bufferobj_test, internal_map_failure)
+{
+   map_persistent(0, BUFFER_SIZE);
+
+   pipe.fail = true;
+   EXPECT_TRUE(ctx.Driver.MapBufferRange(&ctx, 0, BUFFER_SIZE,
+                                         GL_MAP_READ_BIT,
+                                         &st_obj.Base) == NULL);
+   expect_persistent_map();
+
+   EXPECT_TRUE(ctx.Driver.UnmapBuffer(&ctx, &st_obj.Base));
+}
@@ -0,0 +1,448 @@
+/*
+ * Copyright © 2014 VMware, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * Checks how st_draw_vbo() hands the primitives of a draw call down to the
+ * driver: in batches of up to ST_MAX_MULTI_DRAWS through
+ * pipe_context::multi_draw_vbo(), one by one through draw_vbo() without
+ * it, and with the parameters of indirect draws read back from the
+ * indirect buffer.  The pipe context only records the draws.
+ */
+
+#include <gtest/gtest.h>
+#include <string.h>
+
+extern "C" {
+#include "main/mtypes.h"
+#include "vbo/vbo.h"
+#include "state_tracker/st_context.h"
+#include "state_tracker/st_cb_bufferobjects.h"
+#include "state_tracker/st_draw.h"
+#include "cso_cache/cso_context.h"
+#include "pipe/p_context.h"
+#include "pipe/p_screen.h"
+#include "pipe/p_state.h"
+}
+
+#define MAX_DRAWS (3 * ST_MAX_MULTI_DRAWS)
+#define MAX_BATCHES MAX_DRAWS
+
+
+/** Pipe context recording the draws it is given */
+struct draw_recorder {
+   struct pipe_context base;
+   struct pipe_screen screen;
+
+   struct pipe_draw_info draws[MAX_DRAWS];
+   unsigned num_draws;
+
+   /** Number of draws in each multi_draw_vbo() call */
+   unsigned batches[MAX_BATCHES];
+   unsigned num_batches;
+
+   struct pipe_transfer transfer;
+   void *map;
+   unsigned num_maps;
+};
+
+static struct draw_recorder *
+draw_recorder(struct pipe_context *pipe)
+{
+   return (struct draw_recorder *) pipe;
+}
+
+static int
+recorder_get_param(struct pipe_screen *screen, enum pipe_cap param)
+{
+   /* Everything u_vbuf would otherwise be installed for is supported */
+   return param == PIPE_CAP_USER_VERTEX_BUFFERS;
+}
+
+static int
+recorder_get_shader_param(struct pipe_screen *screen, unsigned shader,
+                          enum pipe_shader_cap param)
+{
+   return 0;
+}
+
+static boolean
+recorder_is_format_supported(struct pipe_screen *screen,
+                             enum pipe_format format,
+                             enum pipe_texture_target target,
+                             unsigned sample_count,
+                             unsigned bindings)
+{
+   return TRUE;
+}
+
+static void
+recorder_draw_vbo(struct pipe_context *pipe,
+                  const struct pipe_draw_info *info)
+{
+   struct draw_recorder *rec = draw_recorder(pipe);
+
+   ASSERT_LT(rec->num_draws, (unsigned) MAX_DRAWS);
+   rec->draws[rec->num_draws++] = *info;
+}
+
+static void
+recorder_multi_draw_vbo(struct pipe_context *pipe,
+                        const struct pipe_draw_info *info,
+                        unsigned num_draws)
+{
+   struct draw_recorder *rec = draw_recorder(pipe);
+   unsigned i;
+
+   ASSERT_LT(rec->num_batches, (unsigned) MAX_BATCHES);
+   rec->batches[rec->num_batches++] = num_draws;
+
+   for (i = 0; i < num_draws; i++)
+      recorder_draw_vbo(pipe, &info[i]);
+}
+
+static void
+recorder_set_index_buffer(struct pipe_context *pipe,
+                          const struct pipe_index_buffer *ib)
+{
+}
+
+static void *
+recorder_transfer_map(struct pipe_context *pipe,
+                      struct pipe_resource *resource,
+                      unsigned level,
+                      unsigned usage,
+                      const struct pipe_box *box,
+                      struct pipe_transfer **out_transfer)
+{
+   struct draw_recorder *rec = draw_recorder(pipe);
+
+   if (!rec->map)
+      return NULL;
+
+   rec->num_maps++;
+   *out_transfer = &rec->transfer;
+   return rec->map;
+}
+
+static void
+recorder_transfer_unmap(struct pipe_context *pipe,
+                        struct pipe_transfer *transfer)
+{
+   struct draw_recorder *rec = draw_recorder(pipe);
+
+   rec->num_maps--;
+}
+
+
+class St_draw_test : public ::testing::Test {
+public:
+   virtual void SetUp();
+   virtual void TearDown();
+
+   void draw(const struct _mesa_prim *prims, GLuint nr_prims,
+             const struct _mesa_index_buffer *ib,
+             struct gl_buffer_object *indirect);
+
+   struct gl_context ctx;
+   struct st_context st;
+   struct draw_recorder pipe;
+
+   /** Index buffer and indirect buffer */
+   struct st_buffer_object ib_obj, indirect_obj;
+   struct pipe_resource ib_res, indirect_res;
+};
+
+void
+St_draw_test::SetUp()
+{
+   memset(&ctx, 0, sizeof(ctx));
+   memset(&st, 0, sizeof(st));
+   memset(&pipe, 0, sizeof(pipe));
+   memset(&ib_obj, 0, sizeof(ib_obj));
+   memset(&indirect_obj, 0, sizeof(indirect_obj));
+   memset(&ib_res, 0, sizeof(ib_res));
+   memset(&indirect_res, 0, sizeof(indirect_res));
+
+   pipe.screen.get_param = recorder_get_param;
+   pipe.screen.get_shader_param = recorder_get_shader_param;
+   pipe.screen.is_format_supported = recorder_is_format_supported;
+   pipe.base.screen = &pipe.screen;
+   pipe.base.draw_vbo = recorder_draw_vbo;
+   pipe.base.multi_draw_vbo = recorder_multi_draw_vbo;
+   pipe.base.set_index_buffer = recorder_set_index_buffer;
+   pipe.base.transfer_map = recorder_transfer_map;
+   pipe.base.transfer_unmap = recorder_transfer_unmap;
+
+   ctx.st = &st;
+   st.ctx = &ctx;
+   st.pipe = &pipe.base;
+   st.cso_context = cso_create_context(&pipe.base);
+   ASSERT_TRUE(st.cso_context != NULL);
+
+   ib_obj.Base.Name = 1;
+   ib_obj.buffer = &ib_res;
+   indirect_obj.Base.Name = 2;
+   indirect_obj.buffer = &indirect_res;
+}
+
+void
+St_draw_test::TearDown()
+{
+   EXPECT_EQ(0u, pipe.num_maps);
+
+   cso_destroy_context(st.cso_context);
+}
+
+void
+St_draw_test::draw(const struct _mesa_prim *prims, GLuint nr_prims,
+                   const struct _mesa_index_buffer *ib,
+                   struct gl_buffer_object *indirect)
+{
+   st_draw_vbo(&ctx, prims, nr_prims, ib, GL_TRUE, ~0, ~0, NULL, indirect);
+}
+
+static void
+init_prim(struct _mesa_prim *prim, GLenum mode, GLuint start, GLuint count)
+{
+   memset(prim, 0, sizeof(*prim));
+   prim->mode = mode;
+   prim->begin = 1;
+   prim->end = 1;
+   prim->start = start;
+   prim->count = count;
+   prim->num_instances = 1;
+}
+
+
+/**
+ * Draws go down in full batches of ST_MAX_MULTI_DRAWS, the rest in a last
+ * smaller one, all in order.
+ */
+TEST_F(St_draw_test, multi_draw_batches)
+{
+   const GLuint nr_prims = 2 * ST_MAX_MULTI_DRAWS + 3;
+   struct _mesa_prim prims[2 * ST_MAX_MULTI_DRAWS + 3];
+   GLuint i;
+
+   for (i = 0; i < nr_prims; i++)
+      init_prim(&prims[i], GL_TRIANGLES, 3 * i, 3);
+
+   draw(prims, nr_prims, NULL, NULL);
+
+   ASSERT_EQ(3u, pipe.num_batches);
+   EXPECT_EQ((unsigned) ST_MAX_MULTI_DRAWS, pipe.batches[0]);
+   EXPECT_EQ((unsigned) ST_MAX_MULTI_DRAWS, pipe.batches[1]);
+   EXPECT_EQ(3u, pipe.batches[2]);
+
+   ASSERT_EQ(nr_prims, pipe.num_draws);
+   for (i = 0; i < nr_prims; i++) {
+      EXPECT_EQ((unsigned) PIPE_PRIM_TRIANGLES, pipe.draws[i].mode);
+      EXPECT_EQ(3 * i, pipe.draws[i].start);
+      EXPECT_EQ(3u, pipe.draws[i].count);
+      EXPECT_EQ(3 * i, pipe.draws[i].min_index);
+      EXPECT_EQ(3 * i + 2, pipe.draws[i].max_index);
+   }
+}
+
+/**
+ * Exactly ST_MAX_MULTI_DRAWS draws go down in a single batch, with no
+ * empty one after it.
+ */
+TEST_F(St_draw_test, multi_draw_full_batch)
+{
+   struct _mesa_prim prims[ST_MAX_MULTI_DRAWS];
+   GLuint i;
+
+   for (i = 0; i < ST_MAX_MULTI_DRAWS; i++)
+      init_prim(&prims[i], GL_POINTS, i, 1);
+
+   draw(prims, ST_MAX_MULTI_DRAWS, NULL, NULL);
+
+   ASSERT_EQ(1u, pipe.num_batches);
+   EXPECT_EQ((unsigned) ST_MAX_MULTI_DRAWS, pipe.batches[0]);
+   EXPECT_EQ((unsigned) ST_MAX_MULTI_DRAWS, pipe.num_draws);
+}
+
+/**
+ * Primitives with too few vertices to draw anything are dropped from the
+ * batch, and the others keep their (trimmed) vertex counts.
+ */
+TEST_F(St_draw_test, multi_draw_trims)
+{
+   struct _mesa_prim prims[3];
+
+   init_prim(&prims[0], GL_TRIANGLES, 0, 2);
+   init_prim(&prims[1], GL_TRIANGLES, 2, 7);
+   init_prim(&prims[2], GL_LINES, 9, 1);
+
+   draw(prims, 3, NULL, NULL);
+
+   ASSERT_EQ(1u, pipe.num_batches);
+   EXPECT_EQ(1u, pipe.batches[0]);
+   ASSERT_EQ(1u, pipe.num_draws);
+   EXPECT_EQ(2u, pipe.draws[0].start);
+   EXPECT_EQ(6u, pipe.draws[0].count);
+}
+
+/**
+ * Without pipe_context::multi_draw_vbo() the draws go down one at a time.
+ */
+TEST_F(St_draw_test, draw_without_multi_draw)
+{
+   struct _mesa_prim prims[ST_MAX_MULTI_DRAWS + 1];
+   GLuint i;
+
+   pipe.base.multi_draw_vbo = NULL;
+
+   for (i = 0; i < ST_MAX_MULTI_DRAWS + 1; i++)
+      init_prim(&prims[i], GL_POINTS, i, 1);
+
+   draw(prims, ST_MAX_MULTI_DRAWS + 1, NULL, NULL);
+
+   EXPECT_EQ(0u, pipe.num_batches);
+   ASSERT_EQ((unsigned) ST_MAX_MULTI_DRAWS + 1, pipe.num_draws);
+   for (i = 0; i < ST_MAX_MULTI_DRAWS + 1; i++)
+      EXPECT_EQ(i, pipe.draws[i].start);
+}
+
+/**
+ * glMultiDrawArraysIndirect() reads DrawArraysIndirectCommand records:
+ * count, instance count, first vertex and base instance.  Records drawing
+ * nothing are skipped.
+ */
+TEST_F(St_draw_test, indirect_arrays)
+{
+   static const GLuint commands[] = {
+      /* count, primCount, first, baseInstance */
+      6, 2, 10, 3,
+      0, 1, 0, 0,
+      9, 1, 30, 0,
+      3, 0, 40, 0,
+      4, 5, 50, 7,
+   };
+   struct _mesa_prim prims[5];
+   GLuint i;
+
+   pipe.map = (void *) commands;
+   indirect_res.width0 = sizeof(commands);
+
+   for (i = 0; i < 5; i++) {
+      init_prim(&prims[i], GL_TRIANGLES, 0, 0);
+      prims[i].is_indirect = 1;
+      prims[i].indirect_offset = i * 4 * sizeof(GLuint);
+   }
+
+   draw(prims, 5, NULL, &indirect_obj.Base);
+
+   ASSERT_EQ(1u, pipe.num_batches);
+   ASSERT_EQ(3u, pipe.num_draws);
+
+   EXPECT_EQ(6u, pipe.draws[0].count);
+   EXPECT_EQ(2u, pipe.draws[0].instance_count);
+   EXPECT_EQ(10u, pipe.draws[0].start);
+   EXPECT_EQ(3u, pipe.draws[0].start_instance);
+   EXPECT_EQ(0, pipe.draws[0].index_bias);
+   EXPECT_EQ(10u, pipe.draws[0].min_index);
+   EXPECT_EQ(15u, pipe.draws[0].max_index);
+   EXPECT_FALSE(pipe.draws[0].indexed);
+
+   EXPECT_EQ(9u, pipe.draws[1].count);
+   EXPECT_EQ(1u, pipe.draws[1].instance_count);
+   EXPECT_EQ(30u, pipe.draws[1].start);
+   EXPECT_EQ(0u, pipe.draws[1].start_instance);
+
+   /* GL_TRIANGLES with 4 vertices is trimmed to 3 */
+   EXPECT_EQ(3u, pipe.draws[2].count);
+   EXPECT_EQ(5u, pipe.draws[2].instance_count);
+   EXPECT_EQ(50u, pipe.draws[2].start);
+   EXPECT_EQ(7u, pipe.draws[2].start_instance);
+}
+
+/**
+ * glMultiDrawElementsIndirect() reads DrawElementsIndirectCommand
+ * records: count, instance count, first index, base vertex and base
+ * instance.
+ */
+TEST_F(St_draw_test, indirect_elements)
+{
+   static const GLuint commands[] = {
+      /* count, primCount, firstIndex, baseVertex, baseInstance */
+      3, 1, 0, 100, 0,
+      6, 4, 12, (GLuint) -8, 2,
+   };
+   struct _mesa_prim prims[2];
+   struct _mesa_index_buffer ib;
+
+   pipe.map = (void *) commands;
+   indirect_res.width0 = sizeof(commands);
+
+   memset(&ib, 0, sizeof(ib));
+   ib.type = GL_UNSIGNED_SHORT;
+   ib.obj = &ib_obj.Base;
+
+   init_prim(&prims[0], GL_TRIANGLES, 0, 0);
+   prims[0].indexed = 1;
+   prims[0].is_indirect = 1;
+   prims[0].indirect_offset = 0;
+   prims[1] = prims[0];
+   prims[1].indirect_offset = 5 * sizeof(GLuint);
+
+   draw(prims, 2, &ib, &indirect_obj.Base);
+
+   ASSERT_EQ(1u, pipe.num_batches);
+   ASSERT_EQ(2u, pipe.num_draws);
+
+   EXPECT_TRUE(pipe.draws[0].indexed);
+   EXPECT_EQ(3u, pipe.draws[0].count);
+   EXPECT_EQ(1u, pipe.draws[0].instance_count);
+   EXPECT_EQ(0u, pipe.draws[0].start);
+   EXPECT_EQ(100, pipe.draws[0].index_bias);
+   EXPECT_EQ(0u, pipe.draws[0].start_instance);
+
+   EXPECT_TRUE(pipe.draws[1].indexed);
+   EXPECT_EQ(6u, pipe.draws[1].count);
+   EXPECT_EQ(4u, pipe.draws[1].instance_count);
+   EXPECT_EQ(12u, pipe.draws[1].start);
+   EXPECT_EQ(-8, pipe.draws[1].index_bias);
+   EXPECT_EQ(2u, pipe.draws[1].start_instance);
+}
+
+/**
+ * An indirect buffer that can't be mapped is an out of memory error, and
+ * nothing is drawn.
+ */
+TEST_F(St_draw_test, indirect_map_failure)
+{
+   struct _mesa_prim prim;
+
+   pipe.map = NULL;
+   indirect_res.width0 = 16;
+
+   init_prim(&prim, GL_TRIANGLES, 0, 0);
+   prim.is_indirect = 1;
+
+   draw(&prim, 1, NULL, &indirect_obj.Base);
+
+   EXPECT_EQ(0u, pipe.num_draws);
+   EXPECT_EQ((GLenum) GL_OUT_OF_MEMORY, ctx.ErrorValue);
+}
@@ -159,6 +159,18 @@ vbo_get_minmax_indices(struct gl_context *ctx, const struct _mesa_prim *prim,
                        const struct _mesa_index_buffer *ib,
                        GLuint *min_index, GLuint *max_index, GLuint nr_prims);
 
+void
+vbo_get_minmax_index_mapped(GLuint count, GLuint index_size,
+                            GLuint restart_index, GLboolean restart,
+                            const void *indices,
+                            GLuint *min_index, GLuint *max_index);
+
+void
+vbo_delete_minmax_cache(struct gl_buffer_object *bufferObj);
+
+void
+vbo_disable_minmax_cache(struct gl_buffer_object *bufferObj);
+
 void vbo_use_buffer_objects(struct gl_context *ctx);
 
 void vbo_always_unmap_buffers(struct gl_context *ctx);
@@ -0,0 +1,537 @@
+/**************************************************************************
+ *
+ * Copyright 2003 VMware, Inc.
+ * Copyright 2009 VMware, Inc.
+ * Copyright 2014 VMware, Inc.
+ * All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL VMWARE AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ **************************************************************************/
+
+/**
+ * \file vbo_minmax_index.c
+ * Range of the indices of glDrawElements() calls which don't give one.
+ *
+ * The indices are scanned with SSE2 where available.  The ranges found in
+ * buffer objects are cached in the buffer object, keyed by the offset,
+ * count, type and primitive restart index, until the buffer is written.
+ * Buffers which may be written by the GPU (transform feedback, pixel pack,
+ * texture and atomic counter buffers) are never cached.
+ */
+
+#include "main/glheader.h"
+#include "main/bufferobj.h"
+#include "main/context.h"
+#include "main/hash_table.h"
+#include "main/macros.h"
+#include "main/varray.h"
+
+#include "vbo.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+
+/** Caches holding more ranges than this are cleared */
+#define MINMAX_CACHE_MAX_ENTRIES 256
+
+/**
+ * Buffers whose cache gets cleared this many times in a row without having
+ * been of any use don't get cached anymore.
+ */
+#define MINMAX_CACHE_MAX_WASTED 4
+
+
+struct minmax_cache_key {
+   GLintptr offset;
+   GLuint count;
+   GLuint index_size;
+   GLuint restart_index;
+   GLboolean restart;
+};
+
+
+struct minmax_cache_entry {
+   struct minmax_cache_key key;
+   GLuint min;
+   GLuint max;
+};
+
+
+static bool
+minmax_cache_key_equal(const void *a, const void *b)
+{
+   return memcmp(a, b, sizeof(struct minmax_cache_key)) == 0;
+}
+
+
+static void
+minmax_cache_delete_entry(struct hash_entry *entry)
+{
+   free(entry->data);
+}
+
+
+/**
+ * Free the cached index ranges of a buffer object.
+ * Called when the contents of the buffer change, or it is deleted.
+ */
+void
+vbo_delete_minmax_cache(struct gl_buffer_object *bufferObj)
+{
+   _glthread_LOCK_MUTEX(bufferObj->Mutex);
+
+   if (bufferObj->MinMaxCache) {
+      if (bufferObj->MinMaxCacheHits == 0 &&
+          ++bufferObj->MinMaxCacheWasted >= MINMAX_CACHE_MAX_WASTED)
+         bufferObj->MinMaxCacheDisabled = GL_TRUE;
+      else if (bufferObj->MinMaxCacheHits)
+         bufferObj->MinMaxCacheWasted = 0;
+
+      _mesa_hash_table_destroy(bufferObj->MinMaxCache,
+                               minmax_cache_delete_entry);
+      bufferObj->MinMaxCache = NULL;
+      bufferObj->MinMaxCacheHits = 0;
+   }
+
+   _glthread_UNLOCK_MUTEX(bufferObj->Mutex);
+}
+
+
+/**
+ * Stop caching the index ranges of a buffer object, because it may be
+ * written by the GPU.
+ */
+void
+vbo_disable_minmax_cache(struct gl_buffer_object *bufferObj)
+{
+   if (!bufferObj->MinMaxCacheDisabled) {
+      bufferObj->MinMaxCacheDisabled = GL_TRUE;
+      vbo_delete_minmax_cache(bufferObj);
+   }
+}
+
+
+static GLboolean
+minmax_cache_lookup(struct gl_buffer_object *bufferObj,
+                    const struct minmax_cache_key *key, uint32_t hash,
+                    GLuint *min_index, GLuint *max_index)
+{
+   struct hash_entry *result;
+   GLboolean found = GL_FALSE;
+
+   _glthread_LOCK_MUTEX(bufferObj->Mutex);
+
+   if (bufferObj->MinMaxCache) {
+      result = _mesa_hash_table_search(bufferObj->MinMaxCache, hash, key);
+      if (result) {
+         const struct minmax_cache_entry *entry =
+            (const struct minmax_cache_entry *) result->data;
+
+         *min_index = entry->min;
+         *max_index = entry->max;
+         bufferObj->MinMaxCacheHits++;
+         found = GL_TRUE;
+      }
+   }
+
+   _glthread_UNLOCK_MUTEX(bufferObj->Mutex);
+
+   return found;
+}
+
+
+static void
+minmax_cache_store(struct gl_buffer_object *bufferObj,
+                   const struct minmax_cache_key *key, uint32_t hash,
+                   GLuint min_index, GLuint max_index)
+{
+   struct minmax_cache_entry *entry;
+
+   entry = MALLOC_STRUCT(minmax_cache_entry);
+   if (!entry)
+      return;
+
+   entry->key = *key;
+   entry->min = min_index;
+   entry->max = max_index;
+
+   _glthread_LOCK_MUTEX(bufferObj->Mutex);
+
+   if (bufferObj->MinMaxCacheDisabled) {
+      /* Disabled while we were scanning */
+      free(entry);
+      goto out;
+   }
+
+   if (bufferObj->MinMaxCache &&
+       bufferObj->MinMaxCache->entries >= MINMAX_CACHE_MAX_ENTRIES) {
+      _mesa_hash_table_destroy(bufferObj->MinMaxCache,
+                               minmax_cache_delete_entry);
+      bufferObj->MinMaxCache = NULL;
+   }
+
+   if (!bufferObj->MinMaxCache) {
+      bufferObj->MinMaxCache =
+         _mesa_hash_table_create(NULL, minmax_cache_key_equal);
+      if (!bufferObj->MinMaxCache) {
+         free(entry);
+         goto out;
+      }
+   }
+
+   /* Another context may have stored the same range meanwhile */
+   if (_mesa_hash_table_search(bufferObj->MinMaxCache, hash, &entry->key))
+      free(entry);
+   else
+      _mesa_hash_table_insert(bufferObj->MinMaxCache, hash, &entry->key,
+                              entry);
+
+out:
+   _glthread_UNLOCK_MUTEX(bufferObj->Mutex);
+}
+
+
+/*
+ * Scalar loops, for what the SIMD loops leave over or when there's no
+ * SIMD.  The results are only updated, so several parts of the indices
+ * can be scanned into the same results.
+ */
+
+#define MINMAX_LOOP(TYPE)                                               \
+static void                                                             \
+minmax_##TYPE(const TYPE *indices, GLuint count,                        \
+              GLboolean restart, GLuint restart_index,                  \
+              GLuint *min_index, GLuint *max_index)                     \
+{                                                                       \
+   GLuint min_i = *min_index;                                           \
+   GLuint max_i = *max_index;                                           \
+   GLuint i;                                                            \
+                                                                        \
+   if (restart) {                                                       \
+      for (i = 0; i < count; i++) {                                     \
+         if (indices[i] != restart_index) {                             \
+            if (indices[i] > max_i) max_i = indices[i];                 \
+            if (indices[i] < min_i) min_i = indices[i];                 \
+         }                                                              \
+      }                                                                 \
+   }                                                                    \
+   else {                                                               \
+      for (i = 0; i < count; i++) {                                     \
+         if (indices[i] > max_i) max_i = indices[i];                    \
+         if (indices[i] < min_i) min_i = indices[i];                    \
+      }                                                                 \
+   }                                                                    \
+                                                                        \
+   *min_index = min_i;                                                  \
+   *max_index = max_i;                                                  \
+}
+
+MINMAX_LOOP(GLubyte)
+MINMAX_LOOP(GLushort)
+MINMAX_LOOP(GLuint)
+
+
+#if defined(__SSE2__)
+
+/*
+ * SSE2 loops.  They scan the indices 16 bytes at a time, replacing the
+ * restart indices with the largest value for the minimum and with zero for
+ * the maximum, and leave the last few indices to the scalar loops.
+ *
+ * SSE2 only has unsigned min/max for bytes, so 16-bit indices are biased
+ * into the signed range, and 32-bit ones are compared as signed biased
+ * values and selected with masks.
+ */
+
+static void
+minmax_GLubyte_sse2(const GLubyte *indices, GLuint count,
+                    GLboolean restart, GLuint restart_index,
+                    GLuint *min_index, GLuint *max_index)
+{
+   const __m128i restart_vec = _mm_set1_epi8((char) restart_index);
+   __m128i vmin = _mm_set1_epi8((char) 0xff);
+   __m128i vmax = _mm_setzero_si128();
+   GLubyte mins[16], maxs[16];
+   GLuint i, j;
+
+   for (i = 0; i + 16 <= count; i += 16) {
+      __m128i x = _mm_loadu_si128((const __m128i *) &indices[i]);
+
+      if (restart) {
+         __m128i eq = _mm_cmpeq_epi8(x, restart_vec);
+         vmin = _mm_min_epu8(vmin, _mm_or_si128(x, eq));
+         vmax = _mm_max_epu8(vmax, _mm_andnot_si128(eq, x));
+      }
+      else {
+         vmin = _mm_min_epu8(vmin, x);
+         vmax = _mm_max_epu8(vmax, x);
+      }
+   }
+
+   _mm_storeu_si128((__m128i *) mins, vmin);
+   _mm_storeu_si128((__m128i *) maxs, vmax);
+   for (j = 0; j < 16; j++) {
+      *min_index = MIN2(*min_index, mins[j]);
+      *max_index = MAX2(*max_index, maxs[j]);
+   }
+
+   minmax_GLubyte(indices + i, count - i, restart, restart_index,
+                  min_index, max_index);
+}
+
+
+static void
+minmax_GLushort_sse2(const GLushort *indices, GLuint count,
+                     GLboolean restart, GLuint restart_index,
+                     GLuint *min_index, GLuint *max_index)
+{
+   const __m128i restart_vec = _mm_set1_epi16((short) restart_index);
+   const __m128i bias = _mm_set1_epi16((short) 0x8000);
+   __m128i vmin = _mm_set1_epi16(0x7fff);
+   __m128i vmax = _mm_set1_epi16((short) 0x8000);
+   GLushort mins[8], maxs[8];
+   GLuint i, j;
+
+   for (i = 0; i + 8 <= count; i += 8) {
+      __m128i x = _mm_loadu_si128((const __m128i *) &indices[i]);
+      __m128i x_min = x, x_max = x;
+
+      if (restart) {
+         __m128i eq = _mm_cmpeq_epi16(x, restart_vec);
+         x_min = _mm_or_si128(x, eq);
+         x_max = _mm_andnot_si128(eq, x);
+      }
+
+      vmin = _mm_min_epi16(vmin, _mm_xor_si128(x_min, bias));
+      vmax = _mm_max_epi16(vmax, _mm_xor_si128(x_max, bias));
+   }
+
+   _mm_storeu_si128((__m128i *) mins, _mm_xor_si128(vmin, bias));
+   _mm_storeu_si128((__m128i *) maxs, _mm_xor_si128(vmax, bias));
+   for (j = 0; j < 8; j++) {
+      *min_index = MIN2(*min_index, mins[j]);
+      *max_index = MAX2(*max_index, maxs[j]);
+   }
+
+   minmax_GLushort(indices + i, count - i, restart, restart_index,
+                   min_index, max_index);
+}
+
+
+static void
+minmax_GLuint_sse2(const GLuint *indices, GLuint count,
+                   GLboolean restart, GLuint restart_index,
+                   GLuint *min_index, GLuint *max_index)
+{
+   const __m128i restart_vec = _mm_set1_epi32((int) restart_index);
+   const __m128i bias = _mm_set1_epi32((int) 0x80000000);
+   __m128i vmin = _mm_set1_epi32(0x7fffffff);
+   __m128i vmax = _mm_set1_epi32((int) 0x80000000);
+   GLuint mins[4], maxs[4];
+   GLuint i, j;
+
+   for (i = 0; i + 4 <= count; i += 4) {
+      __m128i x = _mm_loadu_si128((const __m128i *) &indices[i]);
+      __m128i x_min = x, x_max = x;
+      __m128i lt, gt;
+
+      if (restart) {
+         __m128i eq = _mm_cmpeq_epi32(x, restart_vec);
+         x_min = _mm_or_si128(x, eq);
+         x_max = _mm_andnot_si128(eq, x);
+      }
+
+      x_min = _mm_xor_si128(x_min, bias);
+      x_max = _mm_xor_si128(x_max, bias);
+
+      lt = _mm_cmplt_epi32(x_min, vmin);
+      vmin = _mm_or_si128(_mm_and_si128(lt, x_min),
+                          _mm_andnot_si128(lt, vmin));
+      gt = _mm_cmpgt_epi32(x_max, vmax);
+      vmax = _mm_or_si128(_mm_and_si128(gt, x_max),
+                          _mm_andnot_si128(gt, vmax));
+   }
+
+   _mm_storeu_si128((__m128i *) mins, _mm_xor_si128(vmin, bias));
+   _mm_storeu_si128((__m128i *) maxs, _mm_xor_si128(vmax, bias));
+   for (j = 0; j < 4; j++) {
+      *min_index = MIN2(*min_index, mins[j]);
+      *max_index = MAX2(*max_index, maxs[j]);
+   }
+
+   minmax_GLuint(indices + i, count - i, restart, restart_index,
+                 min_index, max_index);
+}
+
+#endif /* __SSE2__ */
+
+
+/**
+ * Compute the min and max of count indices in memory.  Restart indices are
+ * ignored if restart is set.  If there are no other indices, min_index is
+ * set to ~0 and max_index to 0.
+ */
+void
+vbo_get_minmax_index_mapped(GLuint count, GLuint index_size,
+                            GLuint restart_index, GLboolean restart,
+                            const void *indices,
+                            GLuint *min_index, GLuint *max_index)
+{
+   /* The restart index may not fit in smaller indices */
+   if (restart && index_size < 4 && restart_index >> (index_size * 8))
+      restart = GL_FALSE;
+
+   *min_index = ~0U;
+   *max_index = 0;
+
+   switch (index_size) {
+   case 4:
+#if defined(__SSE2__)
+      minmax_GLuint_sse2((const GLuint *) indices, count, restart,
+                         restart_index, min_index, max_index);
+#else
+      minmax_GLuint((const GLuint *) indices, count, restart,
+                    restart_index, min_index, max_index);
+#endif
+      break;
+   case 2:
+#if defined(__SSE2__)
+      minmax_GLushort_sse2((const GLushort *) indices, count, restart,
+                           restart_index, min_index, max_index);
+#else
+      minmax_GLushort((const GLushort *) indices, count, restart,
+                      restart_index, min_index, max_index);
+#endif
+      break;
+   case 1:
+#if defined(__SSE2__)
+      minmax_GLubyte_sse2((const GLubyte *) indices, count, restart,
+                          restart_index, min_index, max_index);
+#else
+      minmax_GLubyte((const GLubyte *) indices, count, restart,
+                     restart_index, min_index, max_index);
+#endif
+      break;
+   default:
+      assert(0);
+      break;
+   }
+
+   /* The SIMD loops see the masked restart indices as real ones */
+   if (*min_index > *max_index) {
+      *min_index = ~0U;
+      *max_index = 0;
+   }
+}
+
+
+/**
+ * Compute min and max elements by scanning the index buffer for
+ * glDraw[Range]Elements() calls.
+ * If primitive restart is enabled, we need to ignore restart
+ * indexes when computing min/max.
+ */
+static void
+vbo_get_minmax_index(struct gl_context *ctx,
+		     const struct _mesa_prim *prim,
+		     const struct _mesa_index_buffer *ib,
+		     GLuint *min_index, GLuint *max_index,
+		     const GLuint count)
+{
+   const GLboolean restart = ctx->Array._PrimitiveRestart;
+   const GLuint restartIndex = _mesa_primitive_restart_index(ctx, ib->type);
+   const int index_size = vbo_sizeof_ib_type(ib->type);
+   struct gl_buffer_object *bufferObj = ib->obj;
+   struct minmax_cache_key key;
+   uint32_t hash = 0;
+   const char *indices;
+   GLboolean use_cache = GL_FALSE;
+
+   indices = (char *) ib->ptr + prim->start * index_size;
+   if (_mesa_is_bufferobj(bufferObj)) {
+      GLsizeiptr size = MIN2(count * index_size, bufferObj->Size);
+
+      use_cache = !bufferObj->MinMaxCacheDisabled;
+      if (use_cache) {
+         memset(&key, 0, sizeof(key));
+         key.offset = (GLintptr) indices;
+         key.count = count;
+         key.index_size = index_size;
+         key.restart_index = restart ? restartIndex : 0;
+         key.restart = restart;
+         hash = _mesa_hash_data(&key, sizeof(key));
+
+         if (minmax_cache_lookup(bufferObj, &key, hash, min_index, max_index))
+            return;
+      }
+
+      indices = ctx->Driver.MapBufferRange(ctx, (GLintptr) indices, size,
+                                           GL_MAP_READ_BIT, bufferObj);
+   }
+
+   vbo_get_minmax_index_mapped(count, index_size, restartIndex, restart,
+                               indices, min_index, max_index);
+
+   if (_mesa_is_bufferobj(bufferObj)) {
+      ctx->Driver.UnmapBuffer(ctx, bufferObj);
+
+      if (use_cache)
+         minmax_cache_store(bufferObj, &key, hash, *min_index, *max_index);
+   }
+}
+
+/**
+ * Compute min and max elements for nr_prims
+ */
+void
+vbo_get_minmax_indices(struct gl_context *ctx,
+                       const struct _mesa_prim *prims,
+                       const struct _mesa_index_buffer *ib,
+                       GLuint *min_index,
+                       GLuint *max_index,
+                       GLuint nr_prims)
+{
+   GLuint tmp_min, tmp_max;
+   GLuint i;
+   GLuint count;
+
+   *min_index = ~0;
+   *max_index = 0;
+
+   for (i = 0; i < nr_prims; i++) {
+      const struct _mesa_prim *start_prim;
+
+      start_prim = &prims[i];
+      count = start_prim->count;
+      /* Do combination if possible to reduce map/unmap count */
+      while ((i + 1 < nr_prims) &&
+             (prims[i].start + prims[i].count == prims[i+1].start)) {
+         count += prims[i+1].count;
+         i++;
+      }
+      vbo_get_minmax_index(ctx, start_prim, ib, &tmp_min, &tmp_max, count);
+      *min_index = MIN2(*min_index, tmp_min);
+      *max_index = MAX2(*max_index, tmp_max);
+   }
+}
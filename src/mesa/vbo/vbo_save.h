@@ -80,6 +80,7 @@ struct vbo_save_vertex_list {
 
    struct _mesa_prim *prim;
    GLuint prim_count;
+   GLboolean prim_owned;        /**< prim[] was allocated by merging lists */
 
    struct vbo_save_vertex_store *vertex_store;
    struct vbo_save_primitive_store *prim_store;
@@ -119,6 +120,15 @@ struct vbo_save_primitive_store {
 };
 
 
+/* A vertex list compiled into the display list being built, see
+ * vbo_save_EndList().
+ */
+struct vbo_save_compiled_list {
+   struct vbo_save_vertex_list *node;
+   GLboolean adjacent;          /**< directly follows the previous one */
+};
+
+
 struct vbo_save_context {
    struct gl_context *ctx;
    GLvertexformat vtxfmt;
@@ -157,6 +167,13 @@ struct vbo_save_context {
    
    GLfloat *current[VBO_ATTRIB_MAX]; /* points into ctx->ListState */
    GLubyte *currentsz[VBO_ATTRIB_MAX];
+
+   /* Vertex lists of the display list being built, merged at EndList.
+    */
+   struct vbo_save_compiled_list *lists;
+   GLuint num_lists, max_lists;
+   union gl_dlist_node *lists_end_block;  /* dlist position after the */
+   GLuint lists_end_pos;                  /* last vertex list */
 };
 
 void vbo_save_init( struct gl_context *ctx );
@@ -359,6 +359,40 @@ merge_prims(struct gl_context *ctx,
    *prim_count = prev_prim - prim_list + 1;
 }
 
+/**
+ * Remember a vertex list compiled into the current display list, so that
+ * vbo_save_EndList() can merge it with its neighbours.
+ */
+static void
+record_vertex_list(struct gl_context *ctx,
+                   struct vbo_save_vertex_list *node,
+                   GLboolean adjacent)
+{
+   struct vbo_save_context *save = &vbo_context(ctx)->save;
+
+   if (save->num_lists == save->max_lists) {
+      const GLuint max_lists = MAX2(2 * save->max_lists, 16);
+      struct vbo_save_compiled_list *lists =
+         realloc(save->lists, max_lists * sizeof(*lists));
+
+      if (!lists) {
+         /* Just don't merge the lists compiled so far */
+         save->num_lists = 0;
+         return;
+      }
+
+      save->lists = lists;
+      save->max_lists = max_lists;
+   }
+
+   save->lists[save->num_lists].node = node;
+   save->lists[save->num_lists].adjacent = adjacent;
+   save->num_lists++;
+
+   save->lists_end_block = ctx->ListState.CurrentBlock;
+   save->lists_end_pos = ctx->ListState.CurrentPos;
+}
+
 /**
  * Insert the active immediate struct onto the display list currently
  * being built.
@@ -368,6 +402,11 @@ _save_compile_vertex_list(struct gl_context *ctx)
 {
    struct vbo_save_context *save = &vbo_context(ctx)->save;
    struct vbo_save_vertex_list *node;
+   /* Nothing was compiled since the previous vertex list? */
+   const GLboolean adjacent =
+      save->num_lists > 0 &&
+      ctx->ListState.CurrentBlock == save->lists_end_block &&
+      ctx->ListState.CurrentPos == save->lists_end_pos;
 
    /* Allocate space for this structure in the display list currently
     * being compiled.
@@ -378,6 +417,8 @@ _save_compile_vertex_list(struct gl_context *ctx)
    if (!node)
       return;
 
+   record_vertex_list(ctx, node, adjacent);
+
    /* Duplicate our template, increment refcounts to the storage structs:
     */
    memcpy(node->attrsz, save->attrsz, sizeof(node->attrsz));
@@ -390,6 +431,7 @@ _save_compile_vertex_list(struct gl_context *ctx)
    node->dangling_attr_ref = save->dangling_attr_ref;
    node->prim = save->prim;
    node->prim_count = save->prim_count;
+   node->prim_owned = GL_FALSE;
    node->vertex_store = save->vertex_store;
    node->prim_store = save->prim_store;
 
@@ -1424,6 +1466,204 @@ vbo_save_SaveFlushVertices(struct gl_context *ctx)
 }
 
 
+/**
+ * Can vertex list 'node', which directly follows 'prev' in the display
+ * list, be drawn together with it?
+ */
+static GLboolean
+can_merge_vertex_lists(const struct vbo_save_vertex_list *prev,
+                       const struct vbo_save_vertex_list *node)
+{
+   return prev->vertex_size == node->vertex_size &&
+          memcmp(prev->attrsz, node->attrsz, sizeof(node->attrsz)) == 0 &&
+          memcmp(prev->attrtype, node->attrtype, sizeof(node->attrtype)) == 0 &&
+          prev->count > 0 && node->count > 0 &&
+          prev->prim_count > 0 && node->prim_count > 0 &&
+          prev->prim[prev->prim_count - 1].end &&
+          node->prim[0].begin &&
+          node->wrap_count == 0 &&
+          prev->prim[0].no_current_update == node->prim[0].no_current_update &&
+          prev->vertex_store->bufferobj->Size > 0 &&
+          node->vertex_store->bufferobj->Size > 0;
+}
+
+
+/**
+ * Copy the vertices of the given lists, back to back, into a new vertex
+ * store of 'size' bytes.
+ */
+static struct vbo_save_vertex_store *
+copy_vertex_lists(struct gl_context *ctx,
+                  const struct vbo_save_compiled_list *lists, GLuint num,
+                  GLuint size)
+{
+   struct vbo_save_vertex_store *store;
+   GLubyte *data = malloc(size);
+   GLuint offset = 0, i;
+
+   if (!data)
+      return NULL;
+
+   for (i = 0; i < num; i++) {
+      const struct vbo_save_vertex_list *node = lists[i].node;
+      const GLuint bytes = node->count * node->vertex_size * sizeof(GLfloat);
+
+      ctx->Driver.GetBufferSubData(ctx, node->buffer_offset, bytes,
+                                   data + offset,
+                                   node->vertex_store->bufferobj);
+      offset += bytes;
+   }
+
+   store = CALLOC_STRUCT(vbo_save_vertex_store);
+   if (store) {
+      store->bufferobj = ctx->Driver.NewBufferObject(ctx, VBO_BUF_ID,
+                                                     GL_ARRAY_BUFFER_ARB);
+      if (!store->bufferobj ||
+          !ctx->Driver.BufferData(ctx, GL_ARRAY_BUFFER_ARB, size, data,
+                                  GL_STATIC_DRAW_ARB, store->bufferobj)) {
+         _mesa_reference_buffer_object(ctx, &store->bufferobj, NULL);
+         free(store);
+         store = NULL;
+      }
+      else {
+         store->used = size / sizeof(GLfloat);
+      }
+   }
+
+   free(data);
+   return store;
+}
+
+
+/**
+ * Fold a run of adjacent, compatible vertex lists into the first one, so
+ * that playing back the display list takes a single draw call, from a
+ * single buffer, for all of them.  The other lists are left empty.
+ */
+static void
+merge_vertex_lists(struct gl_context *ctx,
+                   const struct vbo_save_compiled_list *lists, GLuint num)
+{
+   struct vbo_save_vertex_list *head = lists[0].node;
+   struct vbo_save_vertex_list *tail = lists[num - 1].node;
+   const GLuint vertex_bytes = head->vertex_size * sizeof(GLfloat);
+   struct vbo_save_vertex_store *store = head->vertex_store;
+   GLuint buffer_offset = head->buffer_offset;
+   GLboolean contiguous = GL_TRUE;
+   GLuint count = 0, prim_count = 0, i, j;
+   struct _mesa_prim *prim;
+
+   for (i = 0; i < num; i++) {
+      const struct vbo_save_vertex_list *node = lists[i].node;
+
+      if (node->vertex_store != store ||
+          node->buffer_offset != buffer_offset + count * vertex_bytes)
+         contiguous = GL_FALSE;
+
+      count += node->count;
+      prim_count += node->prim_count;
+   }
+
+   prim = malloc(prim_count * sizeof(*prim));
+   if (!prim)
+      return;
+
+   /* Lists from different vertex stores get a buffer of their own.
+    */
+   if (!contiguous) {
+      store = copy_vertex_lists(ctx, lists, num, count * vertex_bytes);
+      if (!store) {
+         free(prim);
+         return;
+      }
+      buffer_offset = 0;
+   }
+
+   /* Rebase the primitives onto the merged vertices and join them where
+    * possible.
+    */
+   count = 0;
+   prim_count = 0;
+   for (i = 0; i < num; i++) {
+      const struct vbo_save_vertex_list *node = lists[i].node;
+
+      for (j = 0; j < node->prim_count; j++) {
+         prim[prim_count] = node->prim[j];
+         prim[prim_count].start += count;
+         prim_count++;
+      }
+      count += node->count;
+   }
+
+   merge_prims(ctx, prim, &prim_count);
+
+   /* The head draws everything, and leaves the current attributes of the
+    * last vertex behind.
+    */
+   if (head->prim_owned)
+      free(head->prim);
+   head->prim = prim;
+   head->prim_count = prim_count;
+   head->prim_owned = GL_TRUE;
+   head->count = count;
+   head->buffer_offset = buffer_offset;
+
+   free(head->current_data);
+   head->current_data = tail->current_data;
+   tail->current_data = NULL;
+
+   for (i = 0; i < num; i++) {
+      struct vbo_save_vertex_list *node = lists[i].node;
+
+      if (node->vertex_store != store) {
+         if (--node->vertex_store->refcount == 0)
+            free_vertex_store(ctx, node->vertex_store);
+         node->vertex_store = store;
+         store->refcount++;
+      }
+
+      if (node != head) {
+         head->dangling_attr_ref |= node->dangling_attr_ref;
+
+         node->count = 0;
+         node->prim_count = 0;
+         node->current_size = 0;
+         free(node->current_data);
+         node->current_data = NULL;
+      }
+   }
+}
+
+
+/**
+ * Merge the runs of vertex lists which directly follow each other in the
+ * display list just compiled, and share the same vertex format: the
+ * glBegin/glEnd pairs of an application's object drawing code each end up
+ * in a list of their own otherwise.
+ */
+static void
+merge_compiled_vertex_lists(struct gl_context *ctx)
+{
+   struct vbo_save_context *save = &vbo_context(ctx)->save;
+   GLuint first = 0, i;
+
+   for (i = 1; i <= save->num_lists; i++) {
+      if (i < save->num_lists &&
+          save->lists[i].adjacent &&
+          can_merge_vertex_lists(save->lists[i - 1].node,
+                                 save->lists[i].node))
+         continue;
+
+      if (i - first > 1)
+         merge_vertex_lists(ctx, &save->lists[first], i - first);
+
+      first = i;
+   }
+
+   save->num_lists = 0;
+}
+
+
 void
 vbo_save_NewList(struct gl_context *ctx, GLuint list, GLenum mode)
 {
@@ -1440,6 +1680,8 @@ vbo_save_NewList(struct gl_context *ctx, GLuint list, GLenum mode)
 
    save->buffer_ptr = vbo_save_map_vertex_store(ctx, save->vertex_store);
 
+   save->num_lists = 0;
+
    _save_reset_vertex(ctx);
    _save_reset_counters(ctx);
    ctx->Driver.SaveNeedFlush = GL_FALSE;
@@ -1476,6 +1718,11 @@ vbo_save_EndList(struct gl_context *ctx)
 
    vbo_save_unmap_vertex_store(ctx, save->vertex_store);
 
+   /* All the vertex stores are unmapped now, so their contents can be
+    * moved around.
+    */
+   merge_compiled_vertex_lists(ctx);
+
    assert(save->vertex_size == 0);
 }
 
@@ -1514,6 +1761,9 @@ vbo_destroy_vertex_list(struct gl_context *ctx, void *data)
    if (--node->prim_store->refcount == 0)
       free(node->prim_store);
 
+   if (node->prim_owned)
+      free(node->prim);
+
    free(node->current_data);
    node->current_data = NULL;
 }
@@ -252,6 +252,10 @@ vbo_save_playback_vertex_list(struct gl_context *ctx, void *data)
    struct vbo_save_context *save = &vbo_context(ctx)->save;
    GLboolean remap_vertex_store = GL_FALSE;
 
+   /* Merged into the vertex list before this one at EndList time */
+   if (node->prim_count == 0 && node->current_size == 0)
+      return;
+
    if (save->vertex_store && save->vertex_store->buffer) {
       /* The vertex store is currently mapped but we're about to replay
        * a display list.  This can happen when a nested display list is